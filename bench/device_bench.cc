@@ -0,0 +1,659 @@
+// Benchmark of all operations of Device.
+//
+// Measures every public operation of every available device over a grid of
+// matrix sizes and batch sizes, and prints the results as JSON or CSV so that
+// they can be compared between commits.
+// All operations are called through the abstract Device interface, or through
+// Tensor for operations that Device does not expose, so a new device is
+// benchmarked by adding it to `make_devices()`.
+//
+// Usage:
+//   device_bench [format] [min_time] [filter]
+//
+//   format ..... "json" (default) or "csv".
+//   min_time ... Minimum measurement time of each case in seconds
+//                (default: 0.1).
+//   filter ..... Only operations whose names contain this string are
+//                measured (default: all operations).
+
+#include <config.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <primitiv/primitiv.h>
+#ifdef PRIMITIV_USE_CUDA
+#include <primitiv/primitiv_cuda.h>
+#endif  // PRIMITIV_USE_CUDA
+
+using namespace primitiv;
+using namespace std;
+
+namespace {
+
+// Sizes of each dimension of the square matrices used as inputs.
+const unsigned SIZES[] = {16, 128, 512};
+
+// Batch sizes of inputs.
+const unsigned BATCH_SIZES[] = {1, 16};
+
+// Seed of the random number generator of each device.
+const unsigned RNG_SEED = 12345;
+
+// Makes all available devices.
+vector<pair<string, unique_ptr<Device>>> make_devices() {
+  vector<pair<string, unique_ptr<Device>>> devs;
+  devs.emplace_back("Naive", unique_ptr<Device>(new devices::Naive(RNG_SEED)));
+#ifdef PRIMITIV_USE_CUDA
+  for (unsigned i = 0; i < devices::CUDA::num_devices(); ++i) {
+    devs.emplace_back(
+        "CUDA:" + to_string(i),
+        unique_ptr<Device>(new devices::CUDA(i, RNG_SEED)));
+  }
+#endif  // PRIMITIV_USE_CUDA
+  return devs;
+}
+
+// Function to be measured.
+using Task = function<void()>;
+
+// Makes a Task with given device and the shape of inputs ([n, n] x batch).
+// Inputs are made in the factory and captured by the task, and only the
+// operation itself is measured.
+using TaskFactory = function<Task(Device &, unsigned n, unsigned batch)>;
+
+// Makes a random tensor. All values are positive to be valid arguments of all
+// operations (e.g. log, sqrt).
+Tensor random_input(Device &dev, const Shape &shape) {
+  return dev.random_uniform(shape, .5, 1.5);
+}
+
+// Arguments of fused optimizer updates.
+struct UpdateArgs {
+  vector<Tensor> tensors;
+  vector<const Tensor *> gs;
+  vector<Tensor *> xs;
+  vector<vector<Tensor *>> stats;
+};
+
+using UpdateFn = function<void(Device &, UpdateArgs &)>;
+
+// Makes a task of a fused optimizer update of `num` tensors of `shape`, with
+// `num_stats` kinds of statistics.
+Task make_update_task(
+    Device &dev, const Shape &shape, unsigned num, unsigned num_stats,
+    UpdateFn fn) {
+  // NOTE:
+  // Arguments are held on the heap to keep addresses of tensors.
+  auto args = make_shared<UpdateArgs>();
+  args->tensors.reserve(num * (2 + num_stats));
+  for (unsigned i = 0; i < num * (2 + num_stats); ++i) {
+    args->tensors.emplace_back(::random_input(dev, shape));
+  }
+  args->stats.resize(num_stats);
+  for (unsigned i = 0; i < num; ++i) {
+    args->gs.emplace_back(&args->tensors[i]);
+    args->xs.emplace_back(&args->tensors[num + i]);
+    for (unsigned j = 0; j < num_stats; ++j) {
+      args->stats[j].emplace_back(&args->tensors[(2 + j) * num + i]);
+    }
+  }
+  return [&dev, args, fn]() { fn(dev, *args); };
+}
+
+vector<pair<string, TaskFactory>> make_tasks() {
+  vector<pair<string, TaskFactory>> tasks;
+  auto add = [&](const string &name, TaskFactory factory) {
+    tasks.emplace_back(name, std::move(factory));
+  };
+
+  // Tensor creation.
+  add("new_tensor", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    return [&dev, n, batch]() { dev.new_tensor(Shape({n, n}, batch), 1); };
+  });
+  add("copy_tensor", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.copy_tensor(x); };
+  });
+  add("inplace_copy", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    Tensor y = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, y]() mutable { dev.inplace_copy(x, y); };
+  });
+  add("new_tensor_view", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, n, batch]() {
+      dev.new_tensor_view(x, n * n * (batch - 1), {n, n});
+    };
+  });
+  add("new_tensor_by_array",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const auto values = make_shared<vector<float>>(n * n * batch, 1);
+    return [&dev, n, batch, values]() {
+      dev.new_tensor_by_array(Shape({n, n}, batch), values->data());
+    };
+  });
+  add("new_tensor_by_vector",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const auto values = make_shared<vector<float>>(n * n * batch, 1);
+    return [&dev, n, batch, values]() {
+      dev.new_tensor_by_vector(Shape({n, n}, batch), *values);
+    };
+  });
+  add("identity", [](Device &dev, unsigned n, unsigned) -> Task {
+    return [&dev, n]() { dev.identity(n); };
+  });
+
+  // Retrieving and resetting values.
+  // These operations are called through Tensor.
+  add("tensor_to_vector", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [x]() { x.to_vector(); };
+  });
+  add("argmax", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [x]() { x.argmax(0); };
+  });
+  add("argmin", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [x]() { x.argmin(0); };
+  });
+  add("reset_tensor", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [x]() mutable { x.reset(1); };
+  });
+  add("reset_tensor_by_array",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const auto values = make_shared<vector<float>>(n * n * batch, 1);
+    return [x, values]() mutable { x.reset_by_array(values->data()); };
+  });
+  add("reset_tensor_by_vector",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const auto values = make_shared<vector<float>>(n * n * batch, 1);
+    return [x, values]() mutable { x.reset_by_vector(*values); };
+  });
+
+  // Random number generators.
+  add("random_bernoulli", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    return [&dev, n, batch]() {
+      dev.random_bernoulli(Shape({n, n}, batch), .5);
+    };
+  });
+  add("random_uniform", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    return [&dev, n, batch]() {
+      dev.random_uniform(Shape({n, n}, batch), -1, 1);
+    };
+  });
+  add("random_normal", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    return [&dev, n, batch]() {
+      dev.random_normal(Shape({n, n}, batch), 0, 1);
+    };
+  });
+  add("random_log_normal", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    return [&dev, n, batch]() {
+      dev.random_log_normal(Shape({n, n}, batch), 0, 1);
+    };
+  });
+
+  // Slicing and concatenation.
+  add("pick_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const vector<unsigned> ids(batch, n / 2);
+    return [&dev, x, ids]() { dev.pick_fw(x, ids, 0); };
+  });
+  add("pick_bw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor gy = ::random_input(dev, Shape({1, n}, batch));
+    const vector<unsigned> ids(batch, n / 2);
+    Tensor gx = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, gy, ids, gx]() mutable { dev.pick_bw(gy, ids, 0, gx); };
+  });
+  add("inplace_pick_assign",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({1, n}, batch));
+    const vector<unsigned> ids(batch, n / 2);
+    Tensor y = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, ids, y]() mutable {
+      dev.inplace_pick_assign(x, ids, 0, y);
+    };
+  });
+  add("slice_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, n]() { dev.slice_fw(x, 0, 0, n / 2); };
+  });
+  add("slice_bw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor gy = ::random_input(dev, Shape({n / 2, n}, batch));
+    Tensor gx = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, gy, gx]() mutable { dev.slice_bw(gy, 0, 0, gx); };
+  });
+  add("concat_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.concat_fw({&x, &x}, 0); };
+  });
+  add("batch_slice_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, batch]() {
+      dev.batch_slice_fw(x, 0, (batch + 1) / 2);
+    };
+  });
+  add("batch_concat_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.batch_concat_fw({&x, &x}); };
+  });
+
+  // Unary operations.
+#define ADD_FW_X(name) \
+  add(#name "_fw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch)); \
+    return [&dev, x]() { dev.name##_fw(x); }; \
+  })
+#define ADD_BW_X(name) \
+  add(#name "_bw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch)); \
+    const Tensor y = dev.name##_fw(x); \
+    const Tensor gy = ::random_input(dev, y.shape()); \
+    Tensor gx = ::random_input(dev, x.shape()); \
+    return [&dev, x, y, gy, gx]() mutable { dev.name##_bw(x, y, gy, gx); }; \
+  })
+
+  ADD_FW_X(negate);
+  ADD_FW_X(sqrt);
+  ADD_FW_X(exp);
+  ADD_FW_X(log);
+  ADD_FW_X(tanh);
+  ADD_FW_X(sigmoid);
+  ADD_FW_X(softplus);
+  ADD_FW_X(sin);
+  ADD_FW_X(cos);
+  ADD_FW_X(tan);
+  ADD_FW_X(transpose);
+
+  ADD_BW_X(sqrt);
+  ADD_BW_X(exp);
+  ADD_BW_X(log);
+  ADD_BW_X(tanh);
+  ADD_BW_X(sigmoid);
+  ADD_BW_X(softplus);
+  ADD_BW_X(sin);
+  ADD_BW_X(cos);
+  ADD_BW_X(tan);
+  ADD_BW_X(transpose);
+
+#undef ADD_FW_X
+#undef ADD_BW_X
+
+  // Operations with a constant.
+#define ADD_FW_X_CONST(name) \
+  add(#name "_fw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch)); \
+    return [&dev, x]() { dev.name##_fw(x, .5); }; \
+  })
+#define ADD_BW_X_CONST(name) \
+  add(#name "_bw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch)); \
+    const Tensor y = dev.name##_fw(x, .5); \
+    const Tensor gy = ::random_input(dev, y.shape()); \
+    Tensor gx = ::random_input(dev, x.shape()); \
+    return [&dev, x, y, gy, gx]() mutable { \
+      dev.name##_bw(x, y, gy, .5, gx); \
+    }; \
+  })
+
+  ADD_FW_X_CONST(add_const);
+  ADD_FW_X_CONST(subtract_const_r);
+  ADD_FW_X_CONST(subtract_const_l);
+  ADD_FW_X_CONST(multiply_const);
+  ADD_FW_X_CONST(divide_const_r);
+  ADD_FW_X_CONST(divide_const_l);
+  ADD_FW_X_CONST(prelu);
+  ADD_FW_X_CONST(elu);
+
+  ADD_BW_X_CONST(add_const);
+  ADD_BW_X_CONST(subtract_const_r);
+  ADD_BW_X_CONST(subtract_const_l);
+  ADD_BW_X_CONST(multiply_const);
+  ADD_BW_X_CONST(divide_const_r);
+  ADD_BW_X_CONST(divide_const_l);
+  ADD_BW_X_CONST(prelu);
+  ADD_BW_X_CONST(elu);
+
+#undef ADD_FW_X_CONST
+#undef ADD_BW_X_CONST
+
+  // Operations with a scalar.
+#define ADD_FW_X_SCALAR(name) \
+  add(#name "_fw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch)); \
+    const Tensor k = ::random_input(dev, Shape({}, batch)); \
+    return [&dev, x, k]() { dev.name##_fw(x, k); }; \
+  })
+
+  ADD_FW_X_SCALAR(add_scalar);
+  ADD_FW_X_SCALAR(subtract_scalar_r);
+  ADD_FW_X_SCALAR(subtract_scalar_l);
+  ADD_FW_X_SCALAR(multiply_scalar);
+  ADD_FW_X_SCALAR(divide_scalar_r);
+  ADD_FW_X_SCALAR(divide_scalar_l);
+
+#undef ADD_FW_X_SCALAR
+
+  // Binary operations.
+#define ADD_FW_AB(name) \
+  add(#name "_fw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor a = ::random_input(dev, Shape({n, n}, batch)); \
+    const Tensor b = ::random_input(dev, Shape({n, n}, batch)); \
+    return [&dev, a, b]() { dev.name##_fw(a, b); }; \
+  })
+#define ADD_BW_AB(name) \
+  add(#name "_bw", [](Device &dev, unsigned n, unsigned batch) -> Task { \
+    const Tensor a = ::random_input(dev, Shape({n, n}, batch)); \
+    const Tensor b = ::random_input(dev, Shape({n, n}, batch)); \
+    const Tensor y = dev.name##_fw(a, b); \
+    const Tensor gy = ::random_input(dev, y.shape()); \
+    Tensor ga = ::random_input(dev, a.shape()); \
+    Tensor gb = ::random_input(dev, b.shape()); \
+    return [&dev, a, b, y, gy, ga, gb]() mutable { \
+      dev.name##_bw(a, b, y, gy, ga, gb); \
+    }; \
+  })
+
+  ADD_FW_AB(add);
+  ADD_FW_AB(subtract);
+  ADD_FW_AB(multiply);
+  ADD_FW_AB(divide);
+  ADD_FW_AB(matmul);
+
+  ADD_BW_AB(add);
+  ADD_BW_AB(subtract);
+  ADD_BW_AB(multiply);
+  ADD_BW_AB(divide);
+  ADD_BW_AB(matmul);
+
+#undef ADD_FW_AB
+#undef ADD_BW_AB
+
+  // Fused elementwise operations: y = tanh(a * b + 1)
+  auto make_program = []() {
+    elementwise::Program prog;
+    prog.num_inputs = 2;
+    prog.code = {
+      {elementwise::MULTIPLY, 0, {0, 1}},
+      {elementwise::ADD_CONST, 1, {2, 0}},
+      {elementwise::TANH, 0, {3, 0}},
+    };
+    return prog;
+  };
+  add("elementwise_fw", [=](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor a = ::random_input(dev, Shape({n, n}, batch));
+    const Tensor b = ::random_input(dev, Shape({n, n}, batch));
+    const elementwise::Program prog = make_program();
+    return [&dev, a, b, prog]() { dev.elementwise_fw({&a, &b}, prog); };
+  });
+  add("elementwise_bw", [=](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor a = ::random_input(dev, Shape({n, n}, batch));
+    const Tensor b = ::random_input(dev, Shape({n, n}, batch));
+    const elementwise::Program prog = make_program();
+    const Tensor y = dev.elementwise_fw({&a, &b}, prog);
+    const Tensor gy = ::random_input(dev, y.shape());
+    Tensor ga = ::random_input(dev, a.shape());
+    Tensor gb = ::random_input(dev, b.shape());
+    return [&dev, a, b, prog, y, gy, ga, gb]() mutable {
+      dev.elementwise_bw({&a, &b}, y, gy, prog, {&ga, &gb});
+    };
+  });
+
+  // Dimension operations.
+  add("sum_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.sum_fw(x, 0); };
+  });
+  add("logsumexp_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.logsumexp_fw(x, 0); };
+  });
+  add("logsumexp_bw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const Tensor y = dev.logsumexp_fw(x, 0);
+    const Tensor gy = ::random_input(dev, y.shape());
+    Tensor gx = ::random_input(dev, x.shape());
+    return [&dev, x, y, gy, gx]() mutable {
+      dev.logsumexp_bw(x, y, gy, 0, gx);
+    };
+  });
+  add("broadcast_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n}, batch));
+    return [&dev, x, n]() { dev.broadcast_fw(x, 1, n); };
+  });
+  add("batch_sum_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.batch_sum_fw(x); };
+  });
+
+  // Softmax operations.
+  add("softmax_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.softmax_fw(x, 0); };
+  });
+  add("log_softmax_fw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() { dev.log_softmax_fw(x, 0); };
+  });
+  add("softmax_cross_entropy_fw",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const vector<unsigned> ids(batch, n / 2);
+    return [&dev, x, ids]() { dev.softmax_cross_entropy_fw(x, ids, 0); };
+  });
+  add("softmax_bw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const Tensor y = dev.softmax_fw(x, 0);
+    const Tensor gy = ::random_input(dev, y.shape());
+    Tensor gx = ::random_input(dev, x.shape());
+    return [&dev, x, y, gy, gx]() mutable {
+      dev.softmax_bw(x, y, gy, 0, gx);
+    };
+  });
+  add("log_softmax_bw", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const Tensor y = dev.log_softmax_fw(x, 0);
+    const Tensor gy = ::random_input(dev, y.shape());
+    Tensor gx = ::random_input(dev, x.shape());
+    return [&dev, x, y, gy, gx]() mutable {
+      dev.log_softmax_bw(x, y, gy, 0, gx);
+    };
+  });
+  add("softmax_cross_entropy_bw",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    const vector<unsigned> ids(batch, n / 2);
+    const Tensor y = dev.softmax_cross_entropy_fw(x, ids, 0);
+    const Tensor gy = ::random_input(dev, y.shape());
+    Tensor gx = ::random_input(dev, x.shape());
+    return [&dev, x, ids, y, gy, gx]() mutable {
+      dev.softmax_cross_entropy_bw(x, ids, y, gy, 0, gx);
+    };
+  });
+
+  // Inplace operations.
+  add("inplace_multiply_const",
+      [](Device &dev, unsigned n, unsigned batch) -> Task {
+    Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x]() mutable { dev.inplace_multiply_const(1, x); };
+  });
+  add("inplace_add", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    Tensor y = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, y]() mutable { dev.inplace_add(x, y); };
+  });
+  add("inplace_subtract", [](Device &dev, unsigned n, unsigned batch) -> Task {
+    const Tensor x = ::random_input(dev, Shape({n, n}, batch));
+    Tensor y = ::random_input(dev, Shape({n, n}, batch));
+    return [&dev, x, y]() mutable { dev.inplace_subtract(x, y); };
+  });
+
+  // Fused optimizer updates.
+  // NOTE:
+  // "*_update" updates one [n, n] x batch tensor, and "*_update_multi" updates
+  // n tensors of [n] x batch, which have the same number of elements in total.
+#define ADD_UPDATE(name, num_stats, ...) { \
+  const UpdateFn fn = [](Device &dev, UpdateArgs &a) { \
+    dev.name(__VA_ARGS__); \
+  }; \
+  add(#name, [=](Device &dev, unsigned n, unsigned batch) -> Task { \
+    return ::make_update_task(dev, Shape({n, n}, batch), 1, num_stats, fn); \
+  }); \
+  add(#name "_multi", [=](Device &dev, unsigned n, unsigned batch) -> Task { \
+    return ::make_update_task(dev, Shape({n}, batch), n, num_stats, fn); \
+  }); \
+}
+  ADD_UPDATE(sgd_update, 0, 1e-3, a.gs, a.xs);
+  ADD_UPDATE(momentum_sgd_update, 1, 1e-3, .9, a.gs, a.xs, a.stats[0]);
+  ADD_UPDATE(adagrad_update, 1, 1e-3, 1e-8, a.gs, a.xs, a.stats[0]);
+  ADD_UPDATE(
+      rmsprop_update, 1, 1e-3, .9, 1e-8, a.gs, a.xs, a.stats[0]);
+  ADD_UPDATE(
+      adadelta_update, 2, 1, .95, 1e-6, a.gs, a.xs, a.stats[0], a.stats[1]);
+  ADD_UPDATE(
+      adam_update, 2, 1e-3, .9, .999, 1e-8, 1,
+      a.gs, a.xs, a.stats[0], a.stats[1]);
+#undef ADD_UPDATE
+
+  // Gradient clipping by the global norm.
+  // Similarly to above, "*_multi" processes n tensors of [n] x batch.
+  // The squared norm is given as a constant slightly larger than the square
+  // of the threshold so that values are scaled but do not vanish soon.
+  using NormFn = function<void(Device &, const Tensor &, UpdateArgs &)>;
+  auto add_norm = [&](const string &name, NormFn fn) {
+    auto make = [fn](Device &dev, const Shape &shape, unsigned num) -> Task {
+      const Tensor sq_norm = dev.new_tensor({}, 1);
+      return ::make_update_task(
+          dev, shape, num, 0, [fn, sq_norm](Device &dev, UpdateArgs &a) {
+        fn(dev, sq_norm, a);
+      });
+    };
+    add(name, [make](Device &dev, unsigned n, unsigned batch) -> Task {
+      return make(dev, Shape({n, n}, batch), 1);
+    });
+    add(name + "_multi", [make](Device &dev, unsigned n, unsigned batch) {
+      return make(dev, Shape({n}, batch), n);
+    });
+  };
+  add_norm("squared_norm", [](Device &dev, const Tensor &, UpdateArgs &a) {
+    dev.squared_norm(a.gs);
+  });
+  add_norm("inplace_clip_by_norm",
+      [](Device &dev, const Tensor &sq_norm, UpdateArgs &a) {
+    dev.inplace_clip_by_norm(1 - 1e-7, sq_norm, a.xs);
+  });
+
+  return tasks;
+}
+
+// Waits for the completion of all operations queued in the device.
+// NOTE:
+// Retrieving a value from the device blocks until preceding operations finish
+// on all devices, e.g. asynchronous kernel calls of CUDA.
+void synchronize(Device &dev) {
+  dev.new_tensor({}, 0).to_float();
+}
+
+// Measures the average elapsed time of `task` in seconds.
+double measure(
+    Device &dev, const Task &task, double min_time, unsigned &trials) {
+  task();  // warm-up
+  synchronize(dev);
+  trials = 0;
+  const auto start = chrono::steady_clock::now();
+  double elapsed = 0;
+  do {
+    task();
+    ++trials;
+    if (trials % 8 == 0) synchronize(dev);
+    elapsed = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+  } while (elapsed < min_time);
+  synchronize(dev);
+  elapsed = chrono::duration<double>(
+      chrono::steady_clock::now() - start).count();
+  return elapsed / trials;
+}
+
+struct Result {
+  string device;
+  string op;
+  unsigned size;
+  unsigned batch;
+  unsigned trials;
+  double ns_per_call;
+};
+
+void print_json(const vector<Result> &results) {
+  cout << "[\n";
+  for (unsigned i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    cout << "  {\"device\": \"" << r.device
+         << "\", \"op\": \"" << r.op
+         << "\", \"size\": " << r.size
+         << ", \"batch\": " << r.batch
+         << ", \"trials\": " << r.trials
+         << ", \"ns_per_call\": " << fixed << setprecision(1) << r.ns_per_call
+         << (i + 1 < results.size() ? "},\n" : "}\n");
+  }
+  cout << "]" << endl;
+}
+
+void print_csv(const vector<Result> &results) {
+  cout << "device,op,size,batch,trials,ns_per_call\n";
+  for (const Result &r : results) {
+    cout << r.device << ',' << r.op << ',' << r.size << ',' << r.batch << ','
+         << r.trials << ',' << fixed << setprecision(1) << r.ns_per_call
+         << '\n';
+  }
+  cout << flush;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const string format = argc > 1 ? argv[1] : "json";
+  const double min_time = argc > 2 ? atof(argv[2]) : .1;
+  const string filter = argc > 3 ? argv[3] : "";
+  if (format != "json" && format != "csv") {
+    cerr << "Unknown format: " << format << endl;
+    return 1;
+  }
+
+  const auto devs = ::make_devices();
+  const auto tasks = ::make_tasks();
+  vector<Result> results;
+
+  for (const auto &dev : devs) {
+    for (const auto &task : tasks) {
+      if (task.first.find(filter) == string::npos) continue;
+      for (const unsigned n : SIZES) {
+        for (const unsigned batch : BATCH_SIZES) {
+          const Task fn = task.second(*dev.second, n, batch);
+          unsigned trials;
+          const double sec = ::measure(*dev.second, fn, min_time, trials);
+          results.emplace_back(
+              Result {dev.first, task.first, n, batch, trials, sec * 1e9});
+          cerr << dev.first << ' ' << task.first << ' '
+               << n << 'x' << n << 'x' << batch << '\r' << flush;
+        }
+      }
+    }
+  }
+  cerr << endl;
+
+  if (format == "json") ::print_json(results);
+  else ::print_csv(results);
+  return 0;
+}
@@ -0,0 +1,112 @@
+// Benchmark of the matrix multiplication on CPU.
+//
+// Compares the packed GEMM engine used by devices::Naive against the plain
+// triple loop that had been used before, with square matrices and Affine-like
+// (matrix x minibatched vector) products of typical hidden sizes.
+//
+// Usage:
+//   gemm_bench [max_reference_size]
+//
+// The triple loop is measured only for sizes up to `max_reference_size`
+// (default: 1024) because it is very slow for large matrices.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <primitiv/cpu_features.h>
+#include <primitiv/gemm.h>
+
+using namespace primitiv;
+using namespace std;
+
+namespace {
+
+// The former implementation of devices::Naive::matmul_fw_impl.
+void triple_loop(
+    unsigned d1, unsigned d2, unsigned d3,
+    const float *src_a, const float *src_b, float *dest) {
+  const unsigned dest_shift = d1 * d3;
+  for (unsigned i = 0; i < d1; ++i) {
+    for (unsigned ky = 0, kb = 0; ky < dest_shift; ky += d1, kb += d2) {
+      float tmp = 0;
+      for (unsigned ja = 0, jb = 0; jb < d2; ja += d1, ++jb) {
+        tmp += src_a[i + ja] * src_b[jb + kb];
+      }
+      dest[i + ky] = tmp;
+    }
+  }
+}
+
+// Measures the average elapsed time of `fn` in seconds.
+template<typename Fn>
+double measure(Fn fn) {
+  fn();  // warm-up
+  unsigned trials = 0;
+  const auto start = chrono::steady_clock::now();
+  double elapsed = 0;
+  do {
+    fn();
+    ++trials;
+    elapsed = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+  } while (elapsed < .5 && trials < 1000);
+  return elapsed / trials;
+}
+
+void report(
+    const char *method, unsigned m, unsigned n, unsigned k, double sec) {
+  const double gflops = 2. * m * n * k / sec * 1e-9;
+  cout << setw(10) << method
+       << setw(8) << m << setw(8) << n << setw(8) << k
+       << setw(14) << fixed << setprecision(3) << sec * 1e3 << " ms"
+       << setw(12) << setprecision(2) << gflops << " GFLOPS" << endl;
+}
+
+void run(unsigned m, unsigned n, unsigned k, unsigned max_ref_size) {
+  mt19937 rng(12345);
+  uniform_real_distribution<float> dist(-1, 1);
+  vector<float> a(m * k), b(k * n), c(m * n);
+  for (float &x : a) x = dist(rng);
+  for (float &x : b) x = dist(rng);
+
+  if (m <= max_ref_size && n <= max_ref_size && k <= max_ref_size) {
+    report("loop", m, n, k, ::measure([&]() {
+      ::triple_loop(m, k, n, a.data(), b.data(), c.data());
+    }));
+  }
+
+  for (cpu_features::Isa isa : {
+      cpu_features::ISA_GENERIC,
+      cpu_features::ISA_AVX2,
+      cpu_features::ISA_AVX512}) {
+    if (!cpu_features::supports(isa)) continue;
+    report(cpu_features::isa_name(isa), m, n, k, ::measure([&]() {
+      gemm::sgemm(
+          false, false, m, n, k, a.data(), m, b.data(), k, false, c.data(), m,
+          isa);
+    }));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const unsigned max_ref_size = argc > 1 ? atoi(argv[1]) : 1024;
+
+  cout << "Detected instruction set: "
+       << cpu_features::isa_name(cpu_features::max_isa()) << endl;
+  cout << setw(10) << "method"
+       << setw(8) << "m" << setw(8) << "n" << setw(8) << "k" << endl;
+
+  for (unsigned size : {256, 512, 1024, 2048}) {
+    // Square matrices.
+    ::run(size, size, size, max_ref_size);
+    // W . x with a minibatch of 64 vectors.
+    ::run(size, 64, size, max_ref_size);
+  }
+  return 0;
+}
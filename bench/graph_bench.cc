@@ -0,0 +1,102 @@
+// Benchmark of the scheduling overhead of Graph::forward().
+//
+// Builds long graphs of scalar operations and measures the forward time per
+// function. The same operations applied directly to Tensors are measured as
+// the baseline, and the difference is reported as the overhead of the graph.
+// The overhead also includes the cost of keeping all intermediate values,
+// which the baseline releases immediately.
+//
+// Usage:
+//   graph_bench [max_length]
+//
+// Graphs with up to `max_length` functions (default: 1000000) are measured.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <primitiv/primitiv.h>
+
+using namespace primitiv;
+using namespace std;
+
+namespace {
+
+// Returns the elapsed time of `fn` in seconds.
+template<typename Fn>
+double measure(Fn fn) {
+  const auto start = chrono::steady_clock::now();
+  fn();
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *name, unsigned n, double graph_sec, double tensor_sec) {
+  const double scale = 1e9 / n;
+  cout << setw(8) << name << setw(10) << n
+       << setw(12) << fixed << setprecision(1) << graph_sec * scale << " ns"
+       << setw(12) << tensor_sec * scale << " ns"
+       << setw(12) << (graph_sec - tensor_sec) * scale << " ns" << endl;
+}
+
+// y[i] = y[i - 1] + 1
+void run_chain(unsigned n) {
+  Graph g;
+  Graph::set_default(g);
+  Node y = operators::input<Node>({}, {0});
+  for (unsigned i = 1; i < n; ++i) y = y + 1;
+  const double graph_sec = ::measure([&]() { g.forward(y); });
+
+  Tensor t = operators::input<Tensor>({}, {0});
+  const double tensor_sec = ::measure([&]() {
+    for (unsigned i = 1; i < n; ++i) t = t + 1;
+  });
+
+  ::report("chain", n, graph_sec, tensor_sec);
+}
+
+// y[i] = y[i - 1] + y[i - 2]
+void run_ladder(unsigned n) {
+  Graph g;
+  Graph::set_default(g);
+  Node y1 = operators::input<Node>({}, {0});
+  Node y2 = operators::input<Node>({}, {1});
+  for (unsigned i = 2; i < n; ++i) {
+    Node y = y1 + y2;
+    y1 = std::move(y2);
+    y2 = std::move(y);
+  }
+  const double graph_sec = ::measure([&]() { g.forward(y2); });
+
+  Tensor t1 = operators::input<Tensor>({}, {0});
+  Tensor t2 = operators::input<Tensor>({}, {1});
+  const double tensor_sec = ::measure([&]() {
+    for (unsigned i = 2; i < n; ++i) {
+      Tensor t = t1 + t2;
+      t1 = std::move(t2);
+      t2 = std::move(t);
+    }
+  });
+
+  ::report("ladder", n, graph_sec, tensor_sec);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const unsigned max_length = argc > 1 ? atoi(argv[1]) : 1000000;
+
+  devices::Naive dev;
+  Device::set_default(dev);
+
+  cout << setw(8) << "graph" << setw(10) << "length"
+       << setw(15) << "graph/func" << setw(15) << "tensor/func"
+       << setw(15) << "overhead" << endl;
+
+  for (unsigned n = 1000; n <= max_length; n *= 10) {
+    ::run_chain(n);
+    ::run_ladder(n);
+  }
+  return 0;
+}
@@ -0,0 +1,515 @@
+// End-to-end benchmark of the example models.
+//
+// Trains the models in examples/ on synthetic data, so that no dataset is
+// required, and reports the steady-state throughput, the time of each phase of
+// one training step and the peak memory usage of the device as JSON.
+//
+//   xor ..... 2-layer perceptron of examples/xor (examples/sec).
+//   mnist ... 2-layer perceptron of examples/mnist (examples/sec).
+//   rnnlm ... LSTM language model of examples/ptb/ptb_rnnlm_lstm
+//             (tokens/sec).
+//   encdec .. LSTM encoder-decoder of examples/encdec (target tokens/sec).
+//
+// Each step is split into the following phases:
+//   build ...... Construction of the computation graph.
+//   forward .... Calculation of the loss value.
+//   backward ... Resetting and calculation of gradients.
+//   update ..... Update of parameters by the trainer.
+//
+// Usage:
+//   model_bench <model> [num_steps] [batch_size] [hidden_size] [length]
+//               [num_replicas]
+//
+//   num_steps ..... Number of measured steps (default: 10). Two more steps
+//                   are run beforehand to warm up.
+//   batch_size .... Minibatch size (default: same as the example).
+//   hidden_size ... Number of hidden units (default: same as the example).
+//   length ........ Length of each sentence of rnnlm and encdec (default: 35
+//                   and 16 respectively).
+//   num_replicas .. Number of replicas trained by DataParallelTrainer
+//                   (default: 0, which uses the Trainer directly). Each
+//                   replica has its own device and processes `batch_size`
+//                   examples at each step. Only xor and mnist are supported,
+//                   because the LSTM of examples/encdec builds nodes on the
+//                   default graph.
+//
+// Omitted or zero arguments are replaced by default values.
+// Device::set_profiling() is enabled during the benchmark to obtain the peak
+// memory and the number of floating point operations.
+
+#include <config.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <primitiv/primitiv.h>
+#ifdef PRIMITIV_USE_CUDA
+#include <primitiv/primitiv_cuda.h>
+#endif  // PRIMITIV_USE_CUDA
+
+#include "../examples/encdec/lstm.h"
+
+using namespace primitiv;
+using namespace std;
+namespace F = primitiv::operators;
+namespace I = primitiv::initializers;
+namespace T = primitiv::trainers;
+
+namespace {
+
+const unsigned NUM_WARMUP_STEPS = 2;
+const unsigned MNIST_INPUT_SIZE = 28 * 28;
+const unsigned MNIST_OUTPUT_SIZE = 10;
+const unsigned RNNLM_VOCAB_SIZE = 10000;
+const unsigned ENCDEC_SRC_VOCAB_SIZE = 4000;
+const unsigned ENCDEC_TRG_VOCAB_SIZE = 5000;
+const float DROPOUT_RATE = .5;
+
+// Hyperparameters of each model.
+struct Config {
+  unsigned batch_size;
+  unsigned hidden_size;
+  unsigned length;
+};
+
+// Same as F::dropout(), but the mask is made on the given graph instead of the
+// default one.
+Node dropout(const Node &x, Graph &g) {
+  const float p = 1. - DROPOUT_RATE;
+  return (1. / p) * x * F::random::bernoulli(x.shape(), p, x.device(), g);
+}
+
+// Interface of the benchmarked models.
+class Model {
+public:
+  virtual ~Model() = default;
+
+  // Adds all parameters to the trainer.
+  virtual void register_training(Trainer &trainer) = 0;
+
+  // Makes the next synthetic minibatch.
+  virtual void next_batch(mt19937 &rng) = 0;
+
+  // Builds the graph of the loss function over the current minibatch.
+  virtual Node loss(Device &dev, Graph &g) = 0;
+
+  // Whether the graph is built only on the given device and graph, so that
+  // replicas can be trained concurrently.
+  virtual bool supports_replicas() const { return true; }
+
+  // Number of examples or tokens in one minibatch.
+  virtual unsigned num_units() const = 0;
+
+  // Name of the unit of `num_units()`.
+  virtual const char *unit_name() const = 0;
+};
+
+// Mean squared loss of the 2-layer perceptron with tanh.
+class XOR : public Model {
+  Config cfg_;
+  Parameter pw1_, pb1_, pw2_, pb2_;
+  vector<float> inputs_, outputs_;
+
+public:
+  explicit XOR(const Config &cfg)
+    : cfg_(cfg)
+    , pw1_({cfg.hidden_size, 2}, I::XavierUniform())
+    , pb1_({cfg.hidden_size}, I::Constant(0))
+    , pw2_({1, cfg.hidden_size}, I::XavierUniform())
+    , pb2_({}, I::Constant(0)) {}
+
+  void register_training(Trainer &trainer) override {
+    trainer.add_parameter(pw1_);
+    trainer.add_parameter(pb1_);
+    trainer.add_parameter(pw2_);
+    trainer.add_parameter(pb2_);
+  }
+
+  void next_batch(mt19937 &rng) override {
+    bernoulli_distribution dist;
+    inputs_.resize(2 * cfg_.batch_size);
+    outputs_.resize(cfg_.batch_size);
+    for (unsigned i = 0; i < cfg_.batch_size; ++i) {
+      inputs_[2 * i] = dist(rng) ? 1 : -1;
+      inputs_[2 * i + 1] = dist(rng) ? 1 : -1;
+      outputs_[i] = inputs_[2 * i] * inputs_[2 * i + 1];
+    }
+  }
+
+  Node loss(Device &dev, Graph &g) override {
+    const Node x = F::input(Shape({2}, cfg_.batch_size), inputs_, dev, g);
+    const Node w1 = F::parameter(pw1_, g);
+    const Node b1 = F::parameter(pb1_, g);
+    const Node w2 = F::parameter(pw2_, g);
+    const Node b2 = F::parameter(pb2_, g);
+    const Node h = F::tanh(F::matmul(w1, x) + b1);
+    const Node y = F::matmul(w2, h) + b2;
+    const Node t = F::input(Shape({}, cfg_.batch_size), outputs_, dev, g);
+    const Node diff = t - y;
+    return F::batch::mean(diff * diff);
+  }
+
+  unsigned num_units() const override { return cfg_.batch_size; }
+  const char *unit_name() const override { return "examples"; }
+};
+
+// Softmax cross entropy of the 2-layer perceptron with ReLU and dropout.
+class MNIST : public Model {
+  Config cfg_;
+  Parameter pw1_, pb1_, pw2_, pb2_;
+  vector<float> inputs_;
+  vector<unsigned> labels_;
+
+public:
+  explicit MNIST(const Config &cfg)
+    : cfg_(cfg)
+    , pw1_({cfg.hidden_size, MNIST_INPUT_SIZE}, I::XavierUniform())
+    , pb1_({cfg.hidden_size}, I::Constant(0))
+    , pw2_({MNIST_OUTPUT_SIZE, cfg.hidden_size}, I::XavierUniform())
+    , pb2_({MNIST_OUTPUT_SIZE}, I::Constant(0)) {}
+
+  void register_training(Trainer &trainer) override {
+    trainer.add_parameter(pw1_);
+    trainer.add_parameter(pb1_);
+    trainer.add_parameter(pw2_);
+    trainer.add_parameter(pb2_);
+  }
+
+  void next_batch(mt19937 &rng) override {
+    uniform_real_distribution<float> pixel(0, 1);
+    uniform_int_distribution<unsigned> label(0, MNIST_OUTPUT_SIZE - 1);
+    inputs_.resize(MNIST_INPUT_SIZE * cfg_.batch_size);
+    labels_.resize(cfg_.batch_size);
+    for (float &x : inputs_) x = pixel(rng);
+    for (unsigned &x : labels_) x = label(rng);
+  }
+
+  Node loss(Device &dev, Graph &g) override {
+    const Node x = F::input(
+        Shape({MNIST_INPUT_SIZE}, cfg_.batch_size), inputs_, dev, g);
+    const Node w1 = F::parameter(pw1_, g);
+    const Node b1 = F::parameter(pb1_, g);
+    const Node w2 = F::parameter(pw2_, g);
+    const Node b2 = F::parameter(pb2_, g);
+    Node h = F::relu(F::matmul(w1, x) + b1);
+    h = ::dropout(h, g);
+    const Node y = F::matmul(w2, h) + b2;
+    return F::batch::mean(F::softmax_cross_entropy(y, labels_, 0));
+  }
+
+  unsigned num_units() const override { return cfg_.batch_size; }
+  const char *unit_name() const override { return "examples"; }
+};
+
+// Makes random sentences with the same length.
+vector<vector<unsigned>> random_batch(
+    unsigned vocab_size, const Config &cfg, mt19937 &rng) {
+  uniform_int_distribution<unsigned> dist(0, vocab_size - 1);
+  vector<vector<unsigned>> batch(
+      cfg.length, vector<unsigned>(cfg.batch_size));
+  for (auto &words : batch) {
+    for (unsigned &w : words) w = dist(rng);
+  }
+  return batch;
+}
+
+// LSTM language model with dropout.
+class RNNLM : public Model {
+  Config cfg_;
+  Parameter plookup_, pwhy_, pby_;
+  ::LSTM<Node> lstm_;
+  vector<vector<unsigned>> batch_;
+
+public:
+  explicit RNNLM(const Config &cfg)
+    : cfg_(cfg)
+    , plookup_({cfg.hidden_size, RNNLM_VOCAB_SIZE}, I::XavierUniform())
+    , pwhy_({RNNLM_VOCAB_SIZE, cfg.hidden_size}, I::XavierUniform())
+    , pby_({RNNLM_VOCAB_SIZE}, I::Constant(0))
+    , lstm_("lstm", cfg.hidden_size, cfg.hidden_size) {}
+
+  void register_training(Trainer &trainer) override {
+    trainer.add_parameter(plookup_);
+    trainer.add_parameter(pwhy_);
+    trainer.add_parameter(pby_);
+    lstm_.register_training(trainer);
+  }
+
+  void next_batch(mt19937 &rng) override {
+    batch_ = ::random_batch(RNNLM_VOCAB_SIZE, cfg_, rng);
+  }
+
+  Node loss(Device &, Graph &g) override {
+    const Node lookup = F::parameter(plookup_, g);
+    const Node why = F::parameter(pwhy_, g);
+    const Node by = F::parameter(pby_, g);
+    lstm_.init();
+    vector<Node> losses;
+    for (unsigned i = 0; i < batch_.size() - 1; ++i) {
+      Node x = F::pick(lookup, batch_[i], 1);
+      x = F::dropout(x, DROPOUT_RATE, true);
+      Node h = lstm_.forward(x);
+      h = F::dropout(h, DROPOUT_RATE, true);
+      const Node y = F::matmul(why, h) + by;
+      losses.emplace_back(F::softmax_cross_entropy(y, batch_[i + 1], 0));
+    }
+    return F::batch::mean(F::sum(losses));
+  }
+
+  unsigned num_units() const override {
+    return (cfg_.length - 1) * cfg_.batch_size;
+  }
+  const char *unit_name() const override { return "tokens"; }
+  bool supports_replicas() const override { return false; }
+};
+
+// LSTM encoder-decoder with dropout.
+class EncoderDecoder : public Model {
+  Config cfg_;
+  Parameter psrc_lookup_, ptrg_lookup_, pwhy_, pby_;
+  ::LSTM<Node> src_lstm_, trg_lstm_;
+  vector<vector<unsigned>> src_batch_, trg_batch_;
+
+public:
+  explicit EncoderDecoder(const Config &cfg)
+    : cfg_(cfg)
+    , psrc_lookup_({cfg.hidden_size, ENCDEC_SRC_VOCAB_SIZE}, I::XavierUniform())
+    , ptrg_lookup_({cfg.hidden_size, ENCDEC_TRG_VOCAB_SIZE}, I::XavierUniform())
+    , pwhy_({ENCDEC_TRG_VOCAB_SIZE, cfg.hidden_size}, I::XavierUniform())
+    , pby_({ENCDEC_TRG_VOCAB_SIZE}, I::Constant(0))
+    , src_lstm_("src_lstm", cfg.hidden_size, cfg.hidden_size)
+    , trg_lstm_("trg_lstm", cfg.hidden_size, cfg.hidden_size) {}
+
+  void register_training(Trainer &trainer) override {
+    trainer.add_parameter(psrc_lookup_);
+    trainer.add_parameter(ptrg_lookup_);
+    trainer.add_parameter(pwhy_);
+    trainer.add_parameter(pby_);
+    src_lstm_.register_training(trainer);
+    trg_lstm_.register_training(trainer);
+  }
+
+  void next_batch(mt19937 &rng) override {
+    src_batch_ = ::random_batch(ENCDEC_SRC_VOCAB_SIZE, cfg_, rng);
+    trg_batch_ = ::random_batch(ENCDEC_TRG_VOCAB_SIZE, cfg_, rng);
+  }
+
+  Node loss(Device &, Graph &g) override {
+    const Node src_lookup = F::parameter(psrc_lookup_, g);
+    src_lstm_.init();
+    for (auto it = src_batch_.rbegin(); it != src_batch_.rend(); ++it) {
+      Node x = F::pick(src_lookup, *it, 1);
+      x = F::dropout(x, DROPOUT_RATE, true);
+      src_lstm_.forward(x);
+    }
+
+    const Node trg_lookup = F::parameter(ptrg_lookup_, g);
+    const Node why = F::parameter(pwhy_, g);
+    const Node by = F::parameter(pby_, g);
+    trg_lstm_.init(src_lstm_.get_c(), src_lstm_.get_h());
+    vector<Node> losses;
+    for (unsigned i = 0; i < trg_batch_.size() - 1; ++i) {
+      Node x = F::pick(trg_lookup, trg_batch_[i], 1);
+      x = F::dropout(x, DROPOUT_RATE, true);
+      Node h = trg_lstm_.forward(x);
+      h = F::dropout(h, DROPOUT_RATE, true);
+      const Node y = F::matmul(why, h) + by;
+      losses.emplace_back(F::softmax_cross_entropy(y, trg_batch_[i + 1], 0));
+    }
+    return F::batch::mean(F::sum(losses));
+  }
+
+  unsigned num_units() const override {
+    return (cfg_.length - 1) * cfg_.batch_size;
+  }
+  const char *unit_name() const override { return "tokens"; }
+  bool supports_replicas() const override { return false; }
+};
+
+// Waits for the completion of all operations queued in the device.
+void synchronize(Device &dev) {
+  dev.new_tensor({}, 0).to_float();
+}
+
+// Returns the elapsed time since `start` in seconds, and resets `start`.
+double lap(chrono::steady_clock::time_point &start) {
+  const auto now = chrono::steady_clock::now();
+  const double ret = chrono::duration<double>(now - start).count();
+  start = now;
+  return ret;
+}
+
+// Makes the device of the `id`-th replica, which is the `id`-th GPU if
+// available, or the CPU otherwise.
+unique_ptr<Device> make_device(unsigned id, string &name) {
+#ifdef PRIMITIV_USE_CUDA
+  if (id < devices::CUDA::num_devices()) {
+    name = "CUDA:" + to_string(id);
+    return unique_ptr<Device>(new devices::CUDA(id));
+  }
+#endif  // PRIMITIV_USE_CUDA
+  name = "Naive";
+  return unique_ptr<Device>(new devices::Naive());
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0]
+         << " <model> [num_steps] [batch_size] [hidden_size] [length]"
+            " [num_replicas]" << endl;
+    return 1;
+  }
+  const string name = argv[1];
+  auto arg = [&](int i, unsigned def) {
+    const unsigned val = argc > i ? atoi(argv[i]) : 0;
+    return val > 0 ? val : def;
+  };
+  const unsigned num_steps = arg(2, 10);
+  const unsigned num_replicas = arg(6, 0);
+  const unsigned n = max(num_replicas, 1u);
+
+  Config cfg;
+  function<Model *()> make_model;
+  function<Trainer *()> make_trainer;
+  if (name == "xor") {
+    cfg = Config {arg(3, 4), arg(4, 8), 0};
+    make_model = [&cfg] { return new ::XOR(cfg); };
+    make_trainer = [] { return new T::SGD(.1); };
+  } else if (name == "mnist") {
+    cfg = Config {arg(3, 200), arg(4, 800), 0};
+    make_model = [&cfg] { return new ::MNIST(cfg); };
+    make_trainer = [] { return new T::SGD(.5); };
+  } else if (name == "rnnlm") {
+    cfg = Config {arg(3, 20), arg(4, 650), arg(5, 35)};
+    make_model = [&cfg] { return new ::RNNLM(cfg); };
+    make_trainer = [] { return new T::SGD(1); };
+  } else if (name == "encdec") {
+    cfg = Config {arg(3, 64), arg(4, 512), arg(5, 16)};
+    make_model = [&cfg] { return new ::EncoderDecoder(cfg); };
+    make_trainer = [] { return new T::Adam(); };
+  } else {
+    cerr << "Unknown model: " << name << endl;
+    return 1;
+  }
+  if (cfg.length == 1) {
+    cerr << "length should be greater than 1." << endl;
+    return 1;
+  }
+
+  // Each replica has its own device, graph, model and trainer.
+  vector<unique_ptr<Device>> devs;
+  vector<unique_ptr<Graph>> graphs;
+  vector<unique_ptr<Model>> models;
+  vector<unique_ptr<Trainer>> trainers;
+  string dev_names;
+  for (unsigned i = 0; i < n; ++i) {
+    string dev_name;
+    devs.emplace_back(::make_device(i, dev_name));
+    dev_names += (i > 0 ? "," : "") + dev_name;
+    devs[i]->set_profiling(true);
+    graphs.emplace_back(new Graph());
+    // Parameters of the model are made on the default device.
+    Device::set_default(*devs[i]);
+    models.emplace_back(make_model());
+    if (num_replicas > 0 && !models[i]->supports_replicas()) {
+      cerr << "num_replicas is not supported by " << name << '.' << endl;
+      return 1;
+    }
+    trainers.emplace_back(make_trainer());
+    models[i]->register_training(*trainers[i]);
+  }
+  Device::set_default(*devs[0]);
+  Graph::set_default(*graphs[0]);
+
+  unique_ptr<DataParallelTrainer> dpt;
+  if (num_replicas > 0) {
+    vector<Trainer *> ts;
+    for (const auto &trainer : trainers) ts.emplace_back(trainer.get());
+    dpt.reset(new DataParallelTrainer(ts));
+    dpt->broadcast_parameters();
+  }
+  // Calls `fn(i)` for each replica `i`.
+  auto run = [&](const function<void(unsigned)> &fn) {
+    if (dpt) dpt->run(fn);
+    else fn(0);
+  };
+
+  mt19937 rng(12345);
+  vector<Node> losses(n);
+  double build_sec = 0, forward_sec = 0, backward_sec = 0, update_sec = 0;
+
+  for (unsigned step = 0; step < NUM_WARMUP_STEPS + num_steps; ++step) {
+    if (step == NUM_WARMUP_STEPS) {
+      build_sec = forward_sec = backward_sec = update_sec = 0;
+      for (const auto &dev : devs) dev->reset_statistics();
+    }
+    for (const auto &model : models) model->next_batch(rng);
+
+    auto start = chrono::steady_clock::now();
+    run([&](unsigned i) {
+      graphs[i]->clear();
+      losses[i] = models[i]->loss(*devs[i], *graphs[i]);
+    });
+    build_sec += ::lap(start);
+
+    run([&](unsigned i) { losses[i].to_float(); });
+    forward_sec += ::lap(start);
+
+    if (dpt) dpt->reset_gradients();
+    else trainers[0]->reset_gradients();
+    run([&](unsigned i) {
+      losses[i].backward();
+      ::synchronize(*devs[i]);
+    });
+    backward_sec += ::lap(start);
+
+    if (dpt) dpt->update();
+    else trainers[0]->update();
+    run([&](unsigned i) { ::synchronize(*devs[i]); });
+    update_sec += ::lap(start);
+
+    cerr << step << '\r' << flush;
+  }
+  cerr << endl;
+
+  std::uint64_t num_flops = 0, peak_bytes = 0;
+  for (const auto &dev : devs) {
+    for (const auto &kv : dev->get_op_statistics()) {
+      num_flops += kv.second.num_flops;
+    }
+    peak_bytes += dev->get_memory_statistics().peak_bytes_in_use;
+  }
+  const double total_sec = build_sec + forward_sec + backward_sec + update_sec;
+  const double ms = 1e3 / num_steps;
+
+  cout << fixed << setprecision(3)
+       << "{\"model\": \"" << name
+       << "\", \"device\": \"" << dev_names
+       << "\", \"num_replicas\": " << num_replicas
+       << ", \"batch_size\": " << cfg.batch_size
+       << ", \"hidden_size\": " << cfg.hidden_size
+       << ", \"length\": " << cfg.length
+       << ", \"num_steps\": " << num_steps
+       << ", \"unit\": \"" << models[0]->unit_name()
+       << "\", \"units_per_sec\": "
+       << models[0]->num_units() * n * num_steps / total_sec
+       << ", \"ms_per_step\": {\"build\": " << build_sec * ms
+       << ", \"forward\": " << forward_sec * ms
+       << ", \"backward\": " << backward_sec * ms
+       << ", \"update\": " << update_sec * ms
+       << ", \"total\": " << total_sec * ms
+       << "}, \"gflops_per_sec\": " << num_flops / total_sec * 1e-9
+       << ", \"peak_memory_bytes\": " << peak_bytes
+       << "}" << endl;
+  return 0;
+}
@@ -225,6 +225,8 @@ void train(
     cout << "  train ppl = " << train_ppl << endl;
 
     // Validation.
+    // Intermediate values are discarded as soon as they are no longer used.
+    g.set_inference_mode(true);
     float valid_loss = 0;
     for (unsigned ofs = 0; ofs < num_valid_sents; ofs += BATCH_SIZE) {
       const vector<unsigned> batch_ids(
@@ -236,10 +238,17 @@ void train(
       g.clear();
       encdec.encode(src_batch, false);
       const auto loss = encdec.loss(trg_batch, false);
+      if (ofs == 0) {
+        const Graph::MemoryPlan plan = g.plan_memory(loss);
+        cout << "  activation memory = "
+             << (plan.planned_peak_bytes >> 20) << " MiB (naive: "
+             << (plan.naive_peak_bytes >> 20) << " MiB)" << endl;
+      }
       valid_loss += loss.to_float() * batch_ids.size();
 
       cout << ofs << '\r' << flush;
     }
+    g.set_inference_mode(false);
 
     const float valid_ppl = std::exp(valid_loss / num_valid_labels);
     cout << "  valid ppl = " << valid_ppl << endl;
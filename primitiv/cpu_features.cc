@@ -0,0 +1,40 @@
+#include <config.h>
+
+#include <primitiv/cpu_features.h>
+
+namespace {
+
+primitiv::cpu_features::Isa detect_isa() {
+  using namespace primitiv::cpu_features;
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return ISA_AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return ISA_AVX2;
+  }
+#endif
+  return ISA_GENERIC;
+}
+
+}  // namespace
+
+namespace primitiv {
+namespace cpu_features {
+
+Isa max_isa() {
+  static const Isa isa = ::detect_isa();
+  return isa;
+}
+
+const char *isa_name(Isa isa) {
+  switch (isa) {
+    case ISA_GENERIC: return "generic";
+    case ISA_AVX2: return "avx2";
+    case ISA_AVX512: return "avx512";
+  }
+  return "unknown";
+}
+
+}  // namespace cpu_features
+}  // namespace primitiv
@@ -0,0 +1,41 @@
+#ifndef PRIMITIV_CPU_FEATURES_H_
+#define PRIMITIV_CPU_FEATURES_H_
+
+namespace primitiv {
+namespace cpu_features {
+
+/**
+ * Instruction sets used by the CPU kernels.
+ */
+enum Isa {
+  ISA_GENERIC = 0,
+  ISA_AVX2 = 1,
+  ISA_AVX512 = 2,
+};
+
+/**
+ * Retrieves the most powerful instruction set available on the running CPU.
+ * @return An Isa value.
+ * @remarks ISA_AVX2 requires both AVX2 and FMA, and ISA_AVX512 requires
+ *          AVX-512F. The result is detected only once at the first call.
+ */
+Isa max_isa();
+
+/**
+ * Checks whether the running CPU supports the given instruction set.
+ * @param isa An Isa value.
+ * @return true if kernels of `isa` can be executed, false otherwise.
+ */
+inline bool supports(Isa isa) { return isa <= max_isa(); }
+
+/**
+ * Returns the name of the instruction set.
+ * @param isa An Isa value.
+ * @return Name of `isa`.
+ */
+const char *isa_name(Isa isa);
+
+}  // namespace cpu_features
+}  // namespace primitiv
+
+#endif  // PRIMITIV_CPU_FEATURES_H_
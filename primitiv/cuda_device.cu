@@ -3,6 +3,7 @@
 #include <cublas_v2.h>
 #include <cuda_runtime_api.h>
 #include <curand.h>
+#include <initializer_list>
 #include <iostream>
 #include <random>
 #include <primitiv/cuda_device.h>
@@ -304,27 +305,36 @@ __global__ void sum_fw_dev(
   if (tid == 0) py[bid] = temp[0];
 }
 
-__device__ float logsumexp2_fw_dev(float a, float b) {
-  return a > b
-    ? a + ::log(1.f + ::exp(b - a))
-    : b + ::log(1.f + ::exp(a - b));
+// Merges the partial statistics (m2, s2) of softmax into (m1, s1), where `m`
+// is the maximum and `s` is the sum of `exp(x - m)`.
+__device__ void softmax_merge_dev(float &m1, float &s1, float m2, float s2) {
+  const float m = ::fmaxf(m1, m2);
+  s1 = s1 * ::exp(m1 - m) + s2 * ::exp(m2 - m);
+  m1 = m;
 }
 
+// Calculates the maximum and the sum of `exp(x - max)` of `n` values in one
+// pass. Every thread in the block receives the results.
 template<unsigned BLOCK_SIZE>
-__global__ void logsumexp_fw_dev(
-    const float *px, unsigned skip, unsigned n, float *py) {
-  __shared__ float temp[BLOCK_SIZE];
-  const unsigned bid = blockIdx.x;
+__device__ void softmax_stats_dev(
+    const float *px, unsigned skip, unsigned n, float &m, float &s) {
+  __shared__ float temp_m[BLOCK_SIZE];
+  __shared__ float temp_s[BLOCK_SIZE];
   const unsigned tid = threadIdx.x;
-  px += bid % skip + (bid / skip) * skip * n;
-  temp[tid] = -1e38;  // NOTE(odashi): Near the minimum of the float.
+  float tm = -1e38;  // NOTE: Near the minimum of the float.
+  float ts = 0;
   for (unsigned i = tid; i < n; i += BLOCK_SIZE) {
-    temp[tid] = ::logsumexp2_fw_dev(temp[tid], px[i * skip]);
+    ::softmax_merge_dev(tm, ts, px[i * skip], 1);
   }
+  temp_m[tid] = tm;
+  temp_s[tid] = ts;
   __syncthreads();
 #define REDUCE(k) \
   if (BLOCK_SIZE >= k << 1) { \
-    if (tid < k) temp[tid] = ::logsumexp2_fw_dev(temp[tid], temp[tid + k]); \
+    if (tid < k) { \
+      ::softmax_merge_dev( \
+          temp_m[tid], temp_s[tid], temp_m[tid + k], temp_s[tid + k]); \
+    } \
     __syncthreads(); \
   }
   REDUCE(512)
@@ -338,7 +348,156 @@ __global__ void logsumexp_fw_dev(
   REDUCE(2)
   REDUCE(1)
 #undef REDUCE
-  if (tid == 0) py[bid] = temp[0];
+  m = temp_m[0];
+  s = temp_s[0];
+}
+
+// Calculates the sum of `val` over all threads in the block. Every thread in
+// the block receives the result.
+template<unsigned BLOCK_SIZE>
+__device__ float block_sum_dev(float val) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned tid = threadIdx.x;
+  temp[tid] = val;
+  __syncthreads();
+#define REDUCE(k) \
+  if (BLOCK_SIZE >= k << 1) { \
+    if (tid < k) temp[tid] += temp[tid + k]; \
+    __syncthreads(); \
+  }
+  REDUCE(512)
+  REDUCE(256)
+  REDUCE(128)
+  REDUCE(64)
+  REDUCE(32)
+  REDUCE(16)
+  REDUCE(8)
+  REDUCE(4)
+  REDUCE(2)
+  REDUCE(1)
+#undef REDUCE
+  return temp[0];
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void logsumexp_fw_dev(
+    const float *px, unsigned skip, unsigned n, float *py) {
+  const unsigned bid = blockIdx.x;
+  px += bid % skip + (bid / skip) * skip * n;
+  float m, s;
+  ::softmax_stats_dev<BLOCK_SIZE>(px, skip, n, m, s);
+  if (threadIdx.x == 0) py[bid] = m + ::log(s);
+}
+
+__global__ void logsumexp_bw_dev(
+    const float *px, const float *py, const float *pgy,
+    unsigned skip, unsigned n, unsigned size, float *pgx) {
+  const unsigned i = IDX;
+  if (i < size) {
+    const unsigned j = i % skip + (i / (skip * n)) * skip;
+    pgx[i] += ::exp(px[i] - py[j]) * pgy[j];
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void softmax_fw_dev(
+    const float *px, unsigned skip, unsigned n, float *py) {
+  const unsigned bid = blockIdx.x;
+  const unsigned ofs = bid % skip + (bid / skip) * skip * n;
+  px += ofs;
+  py += ofs;
+  float m, s;
+  ::softmax_stats_dev<BLOCK_SIZE>(px, skip, n, m, s);
+  const float k = 1.f / s;
+  for (unsigned i = threadIdx.x; i < n; i += BLOCK_SIZE) {
+    py[i * skip] = ::exp(px[i * skip] - m) * k;
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void log_softmax_fw_dev(
+    const float *px, unsigned skip, unsigned n, float *py) {
+  const unsigned bid = blockIdx.x;
+  const unsigned ofs = bid % skip + (bid / skip) * skip * n;
+  px += ofs;
+  py += ofs;
+  float m, s;
+  ::softmax_stats_dev<BLOCK_SIZE>(px, skip, n, m, s);
+  const float log_s = ::log(s);
+  for (unsigned i = threadIdx.x; i < n; i += BLOCK_SIZE) {
+    py[i * skip] = (px[i * skip] - m) - log_s;
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void softmax_cross_entropy_fw_dev(
+    const float *px, const unsigned *pi, unsigned skip, unsigned n,
+    unsigned repeat, unsigned sx, unsigned si, float *py) {
+  const unsigned bid = blockIdx.x;
+  const unsigned group = bid / skip;
+  const unsigned batch = group / repeat;
+  px += (batch * sx + group % repeat) * skip * n + bid % skip;
+  float m, s;
+  ::softmax_stats_dev<BLOCK_SIZE>(px, skip, n, m, s);
+  if (threadIdx.x == 0) {
+    py[bid] = (m - px[pi[batch * si] * skip]) + ::log(s);
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void softmax_bw_dev(
+    const float *py, const float *pgy, unsigned skip, unsigned n,
+    float *pgx) {
+  const unsigned bid = blockIdx.x;
+  const unsigned ofs = bid % skip + (bid / skip) * skip * n;
+  py += ofs;
+  pgy += ofs;
+  pgx += ofs;
+  float dot = 0;
+  for (unsigned i = threadIdx.x; i < n; i += BLOCK_SIZE) {
+    dot += pgy[i * skip] * py[i * skip];
+  }
+  dot = ::block_sum_dev<BLOCK_SIZE>(dot);
+  for (unsigned i = threadIdx.x; i < n; i += BLOCK_SIZE) {
+    pgx[i * skip] += py[i * skip] * (pgy[i * skip] - dot);
+  }
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void log_softmax_bw_dev(
+    const float *py, const float *pgy, unsigned skip, unsigned n,
+    float *pgx) {
+  const unsigned bid = blockIdx.x;
+  const unsigned ofs = bid % skip + (bid / skip) * skip * n;
+  py += ofs;
+  pgy += ofs;
+  pgx += ofs;
+  float sum = 0;
+  for (unsigned i = threadIdx.x; i < n; i += BLOCK_SIZE) sum += pgy[i * skip];
+  sum = ::block_sum_dev<BLOCK_SIZE>(sum);
+  for (unsigned i = threadIdx.x; i < n; i += BLOCK_SIZE) {
+    pgx[i * skip] += pgy[i * skip] - ::exp(py[i * skip]) * sum;
+  }
+}
+
+__global__ void softmax_cross_entropy_bw_dev(
+    const float *px, const unsigned *pi, const float *py, const float *pgy,
+    unsigned skip, unsigned n, unsigned sx, unsigned si, unsigned size,
+    float *pgx) {
+  const unsigned t = IDX;
+  if (t < size) {
+    const unsigned batch = blockIdx.y;
+    const unsigned k = t % skip;
+    const unsigned j = (t / skip) % n;
+    const unsigned group = t / (skip * n);
+    const unsigned id = pi[batch * si];
+    const unsigned oy = (batch * (size / n) + group * skip) + k;
+    px += batch * sx;
+    pgx += batch * sx;
+    const float lse = py[oy] + px[(group * n + id) * skip + k];
+    const float gy = pgy[oy];
+    ::atomicAdd(pgx + t, (::exp(px[t] - lse) - (j == id)) * gy);
+  }
 }
 
 template<unsigned BLOCK_SIZE>
@@ -462,9 +621,192 @@ __global__ void inplace_subtract_dev(
   if (i < size) ::atomicAdd(py + i + mby * shift, -px[i + mbx * shift]);
 }
 
+__global__ void inplace_pick_assign_dev(
+    const float *px, const unsigned *pi,
+    unsigned wy, unsigned wx, unsigned sy, unsigned si, unsigned sx,
+    float *py) {
+  const unsigned t = IDX;
+  const unsigned oy = blockIdx.y * sy + pi[blockIdx.y * si] * wx;
+  const unsigned ox = blockIdx.y * sx;
+  if (t < sx) py[oy + (t / wx) * wy + (t % wx)] = px[ox + t];
+}
+
+// Maximum number of tensors in each list processed by one kernel call.
+// The table below is passed as a kernel argument, which is limited to 4 KB.
+static const unsigned MAX_MULTI_TENSORS = 64;
+
+// Maximum number of lists of tensors, e.g., gradients, values and two kinds of
+// statistics of Adam.
+static const unsigned MAX_MULTI_TENSOR_LISTS = 4;
+
+// Data pointers and offsets of the elements of multiple tensors.
+// `ptrs[l][t]` is the data pointer of the `t`-th tensor of the `l`-th list in
+// the order of arguments of the corresponding Device method, and `offsets[t]`
+// is the index of the first element of the `t`-th tensor.
+struct MultiTensorTable {
+  unsigned n;
+  unsigned offsets[MAX_MULTI_TENSORS + 1];
+  float *ptrs[MAX_MULTI_TENSOR_LISTS][MAX_MULTI_TENSORS];
+};
+
+// Finds the tensor which holds the `k`-th element of multiple tensors.
+__device__ unsigned find_tensor_dev(const MultiTensorTable &table, unsigned k) {
+  unsigned lo = 0, hi = table.n;
+  while (hi - lo > 1) {
+    const unsigned mid = (lo + hi) >> 1;
+    if (table.offsets[mid] <= k) lo = mid;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// NOTE:
+// Following kernels update multiple tensors at once. The table is copied
+// with other arguments at each kernel call, and no device memory is used.
+#define MULTI_TENSOR_INDEX(table) \
+  const unsigned k = IDX; \
+  if (k >= table.offsets[table.n]) return; \
+  const unsigned t = ::find_tensor_dev(table, k); \
+  const unsigned i = k - table.offsets[t];
+
+__global__ void sgd_update_dev(float eta, const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float g = table.ptrs[0][t][i];
+  table.ptrs[1][t][i] -= eta * g;
+}
+
+__global__ void momentum_sgd_update_dev(
+    float eta, float momentum, const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float g = table.ptrs[0][t][i];
+  float &x = table.ptrs[1][t][i];
+  float &m = table.ptrs[2][t][i];
+  m = momentum * m - eta * g;
+  x += m;
+}
+
+__global__ void adagrad_update_dev(
+    float eta, float eps, const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float g = table.ptrs[0][t][i];
+  float &x = table.ptrs[1][t][i];
+  float &m = table.ptrs[2][t][i];
+  m += g * g;
+  x -= eta * g / (::__fsqrt_rn(m) + eps);
+}
+
+__global__ void rmsprop_update_dev(
+    float eta, float alpha, float eps, const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float g = table.ptrs[0][t][i];
+  float &x = table.ptrs[1][t][i];
+  float &m = table.ptrs[2][t][i];
+  m = alpha * m + (1 - alpha) * g * g;
+  x -= eta * g / (::__fsqrt_rn(m) + eps);
+}
+
+__global__ void adadelta_update_dev(
+    float scale, float rho, float eps, const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float g = table.ptrs[0][t][i];
+  float &x = table.ptrs[1][t][i];
+  float &m1 = table.ptrs[2][t][i];
+  float &m2 = table.ptrs[3][t][i];
+  m2 = rho * m2 + (1 - rho) * g * g;
+  const float d = ::__fsqrt_rn((m1 + eps) / (m2 + eps)) * g;
+  m1 = rho * m1 + (1 - rho) * d * d;
+  x -= scale * d;
+}
+
+__global__ void adam_update_dev(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float g = table.ptrs[0][t][i];
+  float &x = table.ptrs[1][t][i];
+  float &m1 = table.ptrs[2][t][i];
+  float &m2 = table.ptrs[3][t][i];
+  m1 = beta1 * m1 + (1 - beta1) * g;
+  m2 = beta2 * m2 + (1 - beta2) * g * g;
+  x -= alpha * (m1 / bias1) / (::__fsqrt_rn(m2 / bias2) + eps);
+}
+
+template<unsigned BLOCK_SIZE>
+__global__ void squared_norm_dev(const MultiTensorTable table, float *py) {
+  __shared__ float temp[BLOCK_SIZE];
+  const unsigned tid = threadIdx.x;
+  const unsigned size = table.offsets[table.n];
+  temp[tid] = 0;
+  for (unsigned k = IDX; k < size; k += gridDim.x * BLOCK_SIZE) {
+    const unsigned t = ::find_tensor_dev(table, k);
+    const float x = table.ptrs[0][t][k - table.offsets[t]];
+    temp[tid] += x * x;
+  }
+  __syncthreads();
+#define REDUCE(k) \
+  if (BLOCK_SIZE >= k << 1) { \
+    if (tid < k) temp[tid] += temp[tid + k]; \
+    __syncthreads(); \
+  }
+  REDUCE(512)
+  REDUCE(256)
+  REDUCE(128)
+  REDUCE(64)
+  REDUCE(32)
+  REDUCE(16)
+  REDUCE(8)
+  REDUCE(4)
+  REDUCE(2)
+  REDUCE(1)
+#undef REDUCE
+  if (tid == 0) ::atomicAdd(py, temp[0]);
+}
+
+__global__ void inplace_clip_by_norm_dev(
+    float threshold, const float *sq_norm, const MultiTensorTable table) {
+  MULTI_TENSOR_INDEX(table);
+  const float sq = *sq_norm;
+  if (sq > threshold * threshold) {
+    table.ptrs[0][t][i] *= threshold / ::__fsqrt_rn(sq);
+  }
+}
+
+#undef MULTI_TENSOR_INDEX
+
 #undef IDX
 #undef IDY
 
+// Maximum number of blocks used by reductions over multiple tensors.
+static const unsigned MAX_REDUCTION_BLOCKS = 256;
+
+// Splits lists of tensors into tables of at most `MAX_MULTI_TENSORS` tensors.
+// `xss` should have the same number of tensors as `gs`.
+std::vector<MultiTensorTable> make_multi_tensor_tables(
+    const std::vector<const primitiv::Tensor *> &gs,
+    std::initializer_list<const std::vector<primitiv::Tensor *> *> xss) {
+  std::vector<MultiTensorTable> tables;
+  for (unsigned begin = 0; begin < gs.size(); begin += MAX_MULTI_TENSORS) {
+    tables.emplace_back();
+    MultiTensorTable &table = tables.back();
+    table.n = std::min<unsigned>(gs.size() - begin, MAX_MULTI_TENSORS);
+    table.offsets[0] = 0;
+    for (unsigned t = 0; t < table.n; ++t) {
+      const primitiv::Tensor &g = *gs[begin + t];
+      table.ptrs[0][t] = const_cast<float *>(
+          static_cast<const float *>(g.data()));
+      table.offsets[t + 1] = table.offsets[t] + g.shape().size();
+    }
+    unsigned l = 1;
+    for (const std::vector<primitiv::Tensor *> *xs : xss) {
+      for (unsigned t = 0; t < table.n; ++t) {
+        table.ptrs[l][t] = static_cast<float *>((*xs)[begin + t]->data());
+      }
+      ++l;
+    }
+  }
+  return tables;
+}
+
 // Minimum requirements of the compute capability.
 static const int MIN_CC_MAJOR = 3;
 static const int MIN_CC_MINOR = 0;
@@ -1149,6 +1491,181 @@ void CUDA::logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
   }
 }
 
+void CUDA::logsumexp_bw_impl(
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = x.shape()[dim];
+  const unsigned s = y.shape().lower_volume(dim);
+  const unsigned size = x.shape().size();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  ::logsumexp_bw_dev<<<g1, dim1_x_>>>(
+      CDATA(x), CDATA(y), CDATA(gy), s, n, size, DATA(gx));
+}
+
+void CUDA::softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned r = x.shape().size() / n;
+  const unsigned s = x.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: ::softmax_fw_dev<k><<<r, k>>>(CDATA(x), s, n, DATA(y)); break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned r = x.shape().size() / n;
+  const unsigned s = x.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: ::log_softmax_fw_dev<k><<<r, k>>>(CDATA(x), s, n, DATA(y)); break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = y.shape()[dim];
+  const unsigned r = y.shape().size() / n;
+  const unsigned s = y.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: \
+      ::softmax_bw_dev<k><<<r, k>>>(CDATA(y), CDATA(gy), s, n, DATA(gx)); \
+      break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::log_softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  const unsigned n = y.shape()[dim];
+  const unsigned r = y.shape().size() / n;
+  const unsigned s = y.shape().lower_volume(dim);
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  switch (block_size) {
+#define CASE(k) \
+    case k: \
+      ::log_softmax_bw_dev<k><<<r, k>>>(CDATA(y), CDATA(gy), s, n, DATA(gx)); \
+      break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::softmax_cross_entropy_fw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned s = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().volume() / (n * s);
+  const unsigned r = y.shape().size();
+  const unsigned sx = x.shape().has_batch() * repeat;
+  const unsigned si = ids.size() > 1;
+  unsigned block_size = dim1_x_;
+  while (block_size >> 1 >= n) block_size >>= 1;
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  const unsigned *pi = static_cast<const unsigned *>(ids_ptr_.get());
+  switch (block_size) {
+#define CASE(k) \
+    case k: \
+      ::softmax_cross_entropy_fw_dev<k><<<r, k>>>( \
+          CDATA(x), pi, s, n, repeat, sx, si, DATA(y)); \
+      break
+    CASE(1024);
+    CASE(512);
+    CASE(256);
+    CASE(128);
+    CASE(64);
+    CASE(32);
+    CASE(16);
+    CASE(8);
+    CASE(4);
+    CASE(2);
+    CASE(1);
+#undef CASE
+  }
+}
+
+void CUDA::softmax_cross_entropy_bw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, const Tensor &y,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  const unsigned n = x.shape()[dim];
+  const unsigned s = x.shape().lower_volume(dim);
+  const unsigned size = x.shape().volume();
+  const unsigned g1 = GRID_SIZE(size, dim1_x_);
+  const unsigned bs = y.shape().batch();
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  ::softmax_cross_entropy_bw_dev<<<dim3(g1, bs), dim1_x_>>>(
+      CDATA(x), static_cast<const unsigned *>(ids_ptr_.get()),
+      CDATA(y), CDATA(gy), s, n, x.shape().has_batch() * size,
+      ids.size() > 1, size, DATA(gx));
+}
+
 void CUDA::broadcast_fw_impl(
     const Tensor &x, unsigned dim, unsigned size, Tensor &y) {
   const unsigned skip1 = y.shape().lower_volume(dim);
@@ -1192,5 +1709,142 @@ void CUDA::inplace_subtract_impl(const Tensor &x, Tensor &y) {
       CDATA(x), size, x.shape().has_batch(), y.shape().has_batch(), DATA(y));
 }
 
+void CUDA::inplace_pick_assign_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned wx = x.shape().lower_volume(dim);
+  const unsigned sx = x.shape().volume();
+  const unsigned g1 = GRID_SIZE(sx, dim1_x_);
+  const unsigned bs = x.shape().batch();
+
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemcpy(
+        ids_ptr_.get(), ids.data(), sizeof(unsigned) * ids.size(),
+        cudaMemcpyHostToDevice));
+  ::inplace_pick_assign_dev<<<dim3(g1, bs), dim1_x_>>>(
+      CDATA(x), static_cast<const unsigned *>(ids_ptr_.get()),
+      wx * y.shape()[dim], wx,
+      y.shape().has_batch() * y.shape().volume(), ids.size() > 1, sx,
+      DATA(y));
+}
+
+void CUDA::sgd_update_impl(
+    float eta,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table
+      : ::make_multi_tensor_tables(gs, {&xs})) {
+    ::sgd_update_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(eta, table);
+  }
+}
+
+void CUDA::momentum_sgd_update_impl(
+    float eta, float momentum,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &ms) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table
+      : ::make_multi_tensor_tables(gs, {&xs, &ms})) {
+    ::momentum_sgd_update_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(
+          eta, momentum, table);
+  }
+}
+
+void CUDA::adagrad_update_impl(
+    float eta, float eps,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &ms) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table
+      : ::make_multi_tensor_tables(gs, {&xs, &ms})) {
+    ::adagrad_update_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(eta, eps, table);
+  }
+}
+
+void CUDA::rmsprop_update_impl(
+    float eta, float alpha, float eps,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &ms) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table
+      : ::make_multi_tensor_tables(gs, {&xs, &ms})) {
+    ::rmsprop_update_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(
+          eta, alpha, eps, table);
+  }
+}
+
+void CUDA::adadelta_update_impl(
+    float scale, float rho, float eps,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table
+      : ::make_multi_tensor_tables(gs, {&xs, &m1s, &m2s})) {
+    ::adadelta_update_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(
+          scale, rho, eps, table);
+  }
+}
+
+void CUDA::adam_update_impl(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table
+      : ::make_multi_tensor_tables(gs, {&xs, &m1s, &m2s})) {
+    ::adam_update_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(
+          alpha, beta1, beta2, eps, bias1, bias2, table);
+  }
+}
+
+void CUDA::squared_norm_impl(
+    const std::vector<const Tensor *> &xs, Tensor &y) {
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  CUDA_CALL(::cudaMemsetAsync(DATA(y), 0, sizeof(float), 0));
+  for (const ::MultiTensorTable &table : ::make_multi_tensor_tables(xs, {})) {
+    // NOTE:
+    // Each block accumulates a strided part of all elements, and partial sums
+    // of blocks are added to the result atomically.
+    const unsigned size = table.offsets[table.n];
+    unsigned block_size = dim1_x_;
+    while (block_size >> 1 >= size) block_size >>= 1;
+    const unsigned g1 = std::min(
+        GRID_SIZE(size, block_size), ::MAX_REDUCTION_BLOCKS);
+    switch (block_size) {
+#define CASE(k) \
+      case k: ::squared_norm_dev<k><<<g1, k>>>(table, DATA(y)); break
+      CASE(1024);
+      CASE(512);
+      CASE(256);
+      CASE(128);
+      CASE(64);
+      CASE(32);
+      CASE(16);
+      CASE(8);
+      CASE(4);
+      CASE(2);
+      CASE(1);
+#undef CASE
+    }
+  }
+}
+
+void CUDA::inplace_clip_by_norm_impl(
+    float threshold, const Tensor &sq_norm, const std::vector<Tensor *> &xs) {
+  const std::vector<const Tensor *> cxs(xs.begin(), xs.end());
+  CUDA_CALL(::cudaSetDevice(dev_id_));
+  for (const ::MultiTensorTable &table : ::make_multi_tensor_tables(cxs, {})) {
+    ::inplace_clip_by_norm_dev<<<
+      GRID_SIZE(table.offsets[table.n], dim1_x_), dim1_x_>>>(
+          threshold, CDATA(sq_norm), table);
+  }
+}
+
 }  // namespace devices
 }  // namespace primitiv
@@ -144,10 +144,31 @@ private:
   void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) override;
   void batch_sum_fw_impl(const Tensor &x, Tensor &y) override;
 
+  void logsumexp_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+
+  void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void softmax_cross_entropy_bw_impl(const Tensor &x, const std::vector<unsigned> &ids, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
   void inplace_multiply_const_impl(float k, Tensor &x) override;
 
   void inplace_add_impl(const Tensor &x, Tensor &y) override;
   void inplace_subtract_impl(const Tensor &x, Tensor &y) override;
+  void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+
+  void sgd_update_impl(float eta, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs) override;
+  void momentum_sgd_update_impl(float eta, float momentum, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) override;
+  void adagrad_update_impl(float eta, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) override;
+  void rmsprop_update_impl(float eta, float alpha, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) override;
+  void adadelta_update_impl(float scale, float rho, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) override;
+  void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) override;
+
+  void squared_norm_impl(const std::vector<const Tensor *> &xs, Tensor &y) override;
+  void inplace_clip_by_norm_impl(float threshold, const Tensor &sq_norm, const std::vector<Tensor *> &xs) override;
 
 private:
   unsigned dev_id_;
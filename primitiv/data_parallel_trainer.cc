@@ -0,0 +1,261 @@
+#include <config.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <primitiv/data_parallel_trainer.h>
+#include <primitiv/device.h>
+#include <primitiv/error.h>
+#include <primitiv/parameter.h>
+#include <primitiv/thread_pool.h>
+#include <primitiv/trainer.h>
+
+namespace {
+
+// Makes views of elements in `[begin, end)` of the concatenation of tensors.
+std::vector<primitiv::Tensor> make_chunk(
+    const std::vector<primitiv::Tensor *> &xs,
+    std::uint64_t begin, std::uint64_t end) {
+  std::vector<primitiv::Tensor> ret;
+  std::uint64_t offset = 0;
+  for (const primitiv::Tensor *x : xs) {
+    if (offset >= end) break;
+    const std::uint64_t size = x->shape().size();
+    const std::uint64_t lo = std::max(begin, offset);
+    const std::uint64_t hi = std::min(end, offset + size);
+    if (lo < hi) {
+      ret.emplace_back(x->device().new_tensor_view(
+            *x, lo - offset, { static_cast<unsigned>(hi - lo) }));
+    }
+    offset += size;
+  }
+  return ret;
+}
+
+}  // namespace
+
+namespace primitiv {
+
+DataParallelTrainer::DataParallelTrainer(const std::vector<Trainer *> &trainers)
+: trainers_(trainers) {
+  if (trainers_.empty()) THROW_ERROR("No trainers are given.");
+  for (unsigned i = 0; i < trainers_.size(); ++i) {
+    for (unsigned j = 0; j < i; ++j) {
+      if (trainers_[i] == trainers_[j]) {
+        THROW_ERROR(
+            "Trainer '" << trainers_[i] << "' is given more than once.");
+      }
+    }
+  }
+  pool_.reset(new ThreadPool(trainers_.size()));
+}
+
+DataParallelTrainer::~DataParallelTrainer() = default;
+
+void DataParallelTrainer::check_parameters() const {
+  const unsigned n = trainers_.size();
+  const std::vector<Parameter *> &params0 = trainers_[0]->params_;
+  for (unsigned i = 1; i < n; ++i) {
+    const std::vector<Parameter *> &params = trainers_[i]->params_;
+    if (params.size() != params0.size()) {
+      THROW_ERROR(
+          "Number of parameters mismatched. replica 0: " << params0.size()
+          << " != replica " << i << ": " << params.size());
+    }
+    for (unsigned k = 0; k < params0.size(); ++k) {
+      if (params[k]->shape() != params0[k]->shape()) {
+        THROW_ERROR(
+            "Shape of the parameter " << k << " mismatched. replica 0: "
+            << params0[k]->shape().to_string() << " != replica " << i << ": "
+            << params[k]->shape().to_string());
+      }
+      // NOTE:
+      // Devices are not thread-safe, and should not be shared by replicas.
+      for (unsigned j = 0; j < i; ++j) {
+        if (&params[k]->device() == &trainers_[j]->params_[k]->device()) {
+          THROW_ERROR(
+              "Replicas " << j << " and " << i
+              << " share the device of the parameter " << k << '.');
+        }
+      }
+    }
+  }
+}
+
+void DataParallelTrainer::broadcast_parameters() {
+  check_parameters();
+  std::unordered_map<std::string, unsigned> uint_configs;
+  std::unordered_map<std::string, float> float_configs;
+  trainers_[0]->get_configs(uint_configs, float_configs);
+  const std::vector<Parameter *> &params0 = trainers_[0]->params_;
+  run([&](unsigned i) {
+    if (i == 0) return;
+    trainers_[i]->set_configs(uint_configs, float_configs);
+    const std::vector<Parameter *> &params = trainers_[i]->params_;
+    for (unsigned k = 0; k < params.size(); ++k) {
+      const Parameter &src = *params0[k];
+      Parameter &dest = *params[k];
+      Device &dev = dest.device();
+      dev.inplace_copy(src.value_, dest.value_);
+      for (const auto &kv : src.stats_) {
+        const auto it = dest.stats_.find(kv.first);
+        if (it != dest.stats_.end()) dev.inplace_copy(kv.second, it->second);
+      }
+    }
+  });
+}
+
+void DataParallelTrainer::run(const std::function<void(unsigned)> &fn) {
+  pool_->parallel_for(trainers_.size(), 1, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) fn(i);
+  });
+}
+
+void DataParallelTrainer::reset_gradients() {
+  run([this](unsigned i) { trainers_[i]->reset_gradients(); });
+}
+
+void DataParallelTrainer::reset_gradients_at_boundary() {
+  run([this](unsigned i) { trainers_[i]->reset_gradients_at_boundary(); });
+}
+
+void DataParallelTrainer::all_reduce_gradients() {
+  check_parameters();
+  const unsigned n = trainers_.size();
+  if (n == 1) return;
+
+  // NOTE:
+  // Row-sparse gradients are made to have the same rows over replicas before
+  // the summation, and become dense if some replica has a dense one.
+  const unsigned num_params = trainers_[0]->params_.size();
+  std::vector<std::vector<unsigned>> rows(num_params);
+  std::vector<bool> sparse(num_params, true);
+  for (unsigned k = 0; k < num_params; ++k) {
+    for (Trainer *trainer : trainers_) {
+      const Parameter &param = *trainer->params_[k];
+      if (!param.has_sparse_gradient()) {
+        sparse[k] = false;
+        break;
+      }
+      const std::vector<unsigned> &r = param.gradient_rows();
+      rows[k].insert(rows[k].end(), r.begin(), r.end());
+    }
+    if (sparse[k]) {
+      std::sort(rows[k].begin(), rows[k].end());
+      rows[k].erase(std::unique(rows[k].begin(), rows[k].end()), rows[k].end());
+      for (Trainer *trainer : trainers_) {
+        Parameter &param = *trainer->params_[k];
+        param.gradient(param.shape().depth() - 1, rows[k]);
+        sparse[k] = sparse[k] && param.has_sparse_gradient();
+      }
+    }
+    if (!sparse[k]) {
+      for (Trainer *trainer : trainers_) trainer->params_[k]->dense_gradient();
+    }
+  }
+
+  // NOTE:
+  // Only nonzero rows of row-sparse gradients are picked into temporary
+  // tensors and summed. Flat buffers are used only if there are no such rows
+  // and all replicas have exactly one buffer, so that chunks of all replicas
+  // consist of the same tensors.
+  bool flat = true;
+  for (unsigned k = 0; k < num_params; ++k) {
+    flat = flat && (!sparse[k] || rows[k].empty());
+  }
+  for (Trainer *trainer : trainers_) {
+    trainer->prepare_flat_buffers();
+    flat = flat && trainer->flat_ && trainer->flat_buffers_.size() == 1;
+  }
+  std::vector<std::vector<Tensor>> picked(n);
+  std::vector<std::vector<Tensor *>> grads(n);
+  run([&](unsigned i) {
+    Trainer &trainer = *trainers_[i];
+    if (flat) {
+      grads[i].emplace_back(&trainer.flat_buffers_[0].gradients);
+      return;
+    }
+    picked[i].reserve(num_params);
+    for (unsigned k = 0; k < num_params; ++k) {
+      Parameter &param = *trainer.params_[k];
+      if (!sparse[k]) {
+        grads[i].emplace_back(&param.grad_);
+      } else if (!rows[k].empty()) {
+        picked[i].emplace_back(param.device().pick_fw(
+              param.grad_, rows[k], param.shape().depth() - 1));
+        grads[i].emplace_back(&picked[i].back());
+      }
+    }
+  });
+  std::uint64_t total = 0;
+  for (const Tensor *g : grads[0]) total += g->shape().size();
+  std::vector<std::vector<std::vector<Tensor>>> chunks(n);
+  for (unsigned i = 0; i < n; ++i) {
+    for (unsigned c = 0; c < n; ++c) {
+      chunks[i].emplace_back(
+          ::make_chunk(grads[i], total * c / n, total * (c + 1) / n));
+    }
+  }
+
+  // Reduce-scatter: replica `i` accumulates the chunk `i - 1 - s` received
+  // from replica `i - 1` at each step `s`, and finally has the sum of the
+  // chunk `i + 1`.
+  for (unsigned s = 0; s + 1 < n; ++s) {
+    run([&](unsigned i) {
+      const unsigned c = (2 * n + i - 1 - s) % n;
+      const std::vector<Tensor> &src = chunks[(i + n - 1) % n][c];
+      std::vector<Tensor> &dest = chunks[i][c];
+      for (unsigned k = 0; k < dest.size(); ++k) {
+        dest[k] += dest[k].device().copy_tensor(src[k]);
+      }
+    });
+  }
+
+  run([&](unsigned i) {
+    for (Tensor &x : chunks[i][(i + 1) % n]) x *= 1.f / n;
+  });
+
+  // All-gather: replica `i` overwrites the chunk `i - s` by that of replica
+  // `i - 1` at each step `s`.
+  for (unsigned s = 0; s + 1 < n; ++s) {
+    run([&](unsigned i) {
+      const unsigned c = (n + i - s) % n;
+      const std::vector<Tensor> &src = chunks[(i + n - 1) % n][c];
+      std::vector<Tensor> &dest = chunks[i][c];
+      for (unsigned k = 0; k < dest.size(); ++k) {
+        dest[k].device().inplace_copy(src[k], dest[k]);
+      }
+    });
+  }
+
+  // Writes back picked rows.
+  run([&](unsigned i) {
+    unsigned j = 0;
+    for (unsigned k = 0; k < num_params; ++k) {
+      if (!sparse[k] || rows[k].empty()) continue;
+      Parameter &param = *trainers_[i]->params_[k];
+      param.device().inplace_pick_assign(
+          picked[i][j++], rows[k], param.shape().depth() - 1, param.grad_);
+    }
+  });
+}
+
+void DataParallelTrainer::update() {
+  const Trainer &trainer0 = *trainers_[0];
+  for (const Trainer *trainer : trainers_) {
+    if (trainer->accum_steps_ != trainer0.accum_steps_ ||
+        trainer->accum_count_ != trainer0.accum_count_) {
+      THROW_ERROR("Gradient accumulation of replicas is not synchronized.");
+    }
+  }
+  // NOTE:
+  // Gradients are averaged only before actual updates, because the average of
+  // accumulated gradients is equal to the accumulation of averages.
+  if (trainer0.accum_count_ + 1 == trainer0.accum_steps_) {
+    all_reduce_gradients();
+  }
+  run([this](unsigned i) { trainers_[i]->update(); });
+}
+
+}  // namespace primitiv
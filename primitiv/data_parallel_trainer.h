@@ -0,0 +1,107 @@
+#ifndef PRIMITIV_DATA_PARALLEL_TRAINER_H_
+#define PRIMITIV_DATA_PARALLEL_TRAINER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <primitiv/mixins.h>
+
+namespace primitiv {
+
+class ThreadPool;
+class Trainer;
+
+/**
+ * Data-parallel training with replicas of a model on multiple devices.
+ * Each replica consists of its own parameters on its own devices, and a
+ * Trainer object that manages them. Replicas calculate gradients of different
+ * minibatches concurrently, and gradients are averaged over all replicas
+ * before each update so that all replicas keep the same values.
+ */
+class DataParallelTrainer : mixins::Nonmovable<DataParallelTrainer> {
+  DataParallelTrainer() = delete;
+
+public:
+  /**
+   * Creates a new DataParallelTrainer object.
+   * @param trainers Trainers of replicas. All trainers should have the same
+   *                 configurations, and corresponding parameters of replicas
+   *                 should be registered in the same order.
+   * @throw primitiv::Error `trainers` is empty or has the same trainer twice.
+   */
+  explicit DataParallelTrainer(const std::vector<Trainer *> &trainers);
+
+  ~DataParallelTrainer();
+
+  /**
+   * Retrieves the number of replicas.
+   * @return Number of replicas.
+   */
+  unsigned num_replicas() const { return trainers_.size(); }
+
+  /**
+   * Copies configurations of the trainer, and values and statistics of
+   * parameters of the first replica to other replicas.
+   * @throw primitiv::Error Parameters of replicas are not consistent.
+   */
+  void broadcast_parameters();
+
+  /**
+   * Calls `fn(i)` for each replica `i` concurrently.
+   * @param fn Function to be called, typically calculates the loss of a part of
+   *           the minibatch and its gradients using the `i`-th replica.
+   * @remarks `fn` should use only graphs, devices and parameters of the given
+   *          replica, and should not depend on default objects. If some call
+   *          throws, the first exception is rethrown after all calls are
+   *          finished.
+   */
+  void run(const std::function<void(unsigned)> &fn);
+
+  /**
+   * Resets gradients of parameters of all replicas.
+   */
+  void reset_gradients();
+
+  /**
+   * Resets gradients of parameters of all replicas only before the first
+   * micro-batch of each update.
+   * @remarks See Trainer::reset_gradients_at_boundary().
+   */
+  void reset_gradients_at_boundary();
+
+  /**
+   * Replaces gradients of each parameter of all replicas by their average.
+   * @throw primitiv::Error Parameters of replicas are not consistent.
+   * @remarks Gradients are summed by the ring algorithm: each replica
+   *          exchanges `1 / num_replicas()` of gradients with its neighbor at
+   *          each of `2 * (num_replicas() - 1)` steps. Row-sparse gradients
+   *          remain row-sparse with the union of rows of all replicas, and
+   *          only the values of these rows are exchanged.
+   */
+  void all_reduce_gradients();
+
+  /**
+   * Averages gradients and updates parameters of all replicas.
+   * @throw primitiv::Error Parameters of replicas are not consistent, or
+   *                        trainers are at different steps of the gradient
+   *                        accumulation.
+   * @remarks While gradients are accumulated, this function only counts the
+   *          micro-batch on each trainer and does not average gradients.
+   */
+  void update();
+
+private:
+  /**
+   * Checks whether parameters of replicas are consistent.
+   * @throw primitiv::Error Numbers or shapes of parameters are mismatched, or
+   *                        some device is shared by replicas.
+   */
+  void check_parameters() const;
+
+  std::vector<Trainer *> trainers_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace primitiv
+
+#endif  // PRIMITIV_DATA_PARALLEL_TRAINER_H_
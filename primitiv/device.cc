@@ -1,5 +1,12 @@
 #include <config.h>
 
+#include <chrono>
+#include <cmath>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <primitiv/device.h>
 #include <primitiv/error.h>
 #include <primitiv/shape_ops.h>
@@ -17,46 +24,177 @@ using std::vector;
 
 namespace primitiv {
 
+/**
+ * Counters of operations and memories shared by the device and deleters of
+ * its memories.
+ */
+class Device::StatisticsRecorder {
+public:
+  StatisticsRecorder() : mem_ { 0, 0, 0, 0 } {}
+
+  void add_op(
+      const char *name, std::uint64_t elements, std::uint64_t flops,
+      std::uint64_t duration_ns) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = ops_.find(name);
+    if (it == ops_.end()) {
+      it = ops_.emplace(name, OpStatistics { 0, 0, 0, 0 }).first;
+    }
+    OpStatistics &op = it->second;
+    ++op.num_calls;
+    op.num_elements += elements;
+    op.num_flops += flops;
+    op.duration_ns += duration_ns;
+  }
+
+  void allocate(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++mem_.num_allocations;
+    mem_.bytes_allocated += bytes;
+    mem_.bytes_in_use += bytes;
+    if (mem_.bytes_in_use > mem_.peak_bytes_in_use) {
+      mem_.peak_bytes_in_use = mem_.bytes_in_use;
+    }
+  }
+
+  void free(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    mem_.bytes_in_use -= bytes;
+  }
+
+  std::map<std::string, OpStatistics> get_op_statistics() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return std::map<std::string, OpStatistics>(ops_.begin(), ops_.end());
+  }
+
+  MemoryStatistics get_memory_statistics() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return mem_;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ops_.clear();
+    mem_ = { 0, 0, mem_.bytes_in_use, mem_.bytes_in_use };
+  }
+
+private:
+  std::unordered_map<std::string, OpStatistics> ops_;
+  MemoryStatistics mem_;
+  mutable std::mutex mtx_;
+};
+
+/**
+ * Records the elapsed time of the operation in the current scope.
+ */
+class Device::OpScope {
+  OpScope(const OpScope &) = delete;
+  OpScope &operator=(const OpScope &) = delete;
+
+public:
+  OpScope(
+      StatisticsRecorder *stats, const char *name,
+      std::uint64_t elements, std::uint64_t flops)
+    : stats_(stats), name_(name), elements_(elements), flops_(flops) {
+      if (stats_) start_ = std::chrono::steady_clock::now();
+    }
+
+  ~OpScope() {
+    if (!stats_) return;
+    const auto duration = std::chrono::steady_clock::now() - start_;
+    stats_->add_op(
+        name_, elements_, flops_,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          duration).count());
+  }
+
+private:
+  StatisticsRecorder *stats_;
+  const char *name_;
+  std::uint64_t elements_;
+  std::uint64_t flops_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Records statistics of the operation if enabled.
+#define RECORD_OP(name, elements, flops) \
+  const OpScope op_scope_( \
+      profiling_ ? stats_.get() : nullptr, name, elements, flops)
+
+Device::Device() : profiling_(false), stats_(new StatisticsRecorder()) {}
+
+std::map<std::string, Device::OpStatistics> Device::get_op_statistics() const {
+  return stats_->get_op_statistics();
+}
+
+Device::MemoryStatistics Device::get_memory_statistics() const {
+  return stats_->get_memory_statistics();
+}
+
+void Device::reset_statistics() {
+  stats_->reset();
+}
+
+std::shared_ptr<void> Device::allocate(const Shape &shape) {
+  std::shared_ptr<void> handle = new_handle(shape);
+  if (!profiling_) return handle;
+
+  // NOTE:
+  // The original handle is held by the deleter of the new handle, and
+  // released after the memory is uncounted.
+  const std::uint64_t bytes = sizeof(float) * shape.size();
+  stats_->allocate(bytes);
+  std::shared_ptr<StatisticsRecorder> stats = stats_;
+  void *ptr = handle.get();
+  return std::shared_ptr<void>(ptr, [handle, stats, bytes](void *) {
+      stats->free(bytes);
+  });
+}
+
 Tensor Device::new_tensor(const Shape &shape) {
-  return Tensor(shape, *this, new_handle(shape));
+  return Tensor(shape, *this, allocate(shape));
 }
 
 Tensor Device::new_tensor(const Shape &shape, float k) {
-  Tensor ret(shape, *this, new_handle(shape));
+  Tensor ret(shape, *this, allocate(shape));
   reset_tensor(k, ret);
   return ret;
 }
 
 Tensor Device::new_tensor_by_array(const Shape &shape, const float values[]) {
-  Tensor ret(shape, *this, new_handle(shape));
+  Tensor ret(shape, *this, allocate(shape));
   reset_tensor_by_array(values, ret);
   return ret;
 }
 
 Tensor Device::new_tensor_by_vector(
     const Shape &shape, const vector<float> &values) {
-  Tensor ret(shape, *this, new_handle(shape));
+  Tensor ret(shape, *this, allocate(shape));
   reset_tensor_by_vector(values, ret);
   return ret;
 }
 
 vector<float> Device::tensor_to_vector(const Tensor &x) {
   CHECK_DEVICE(x);
+  RECORD_OP("tensor_to_vector", x.shape().size(), 0);
   return tensor_to_vector_impl(x);
 }
 
 vector<unsigned> Device::argmax(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
+  RECORD_OP("argmax", x.shape().size(), x.shape().size());
   return argmax_impl(x, dim);
 }
 
 vector<unsigned> Device::argmin(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
+  RECORD_OP("argmin", x.shape().size(), x.shape().size());
   return argmin_impl(x, dim);
 }
 
 void Device::reset_tensor(float k, Tensor &x) {
   CHECK_DEVICE(x);
+  RECORD_OP("reset_tensor", x.shape().size(), 0);
   reset_tensor_impl(k, x);
 }
 
@@ -64,6 +202,7 @@ void Device::reset_tensor_by_array(const float values[], Tensor &x) {
   // NOTE(odashi):
   // There is no method to guarantee the size of the array for now.
   CHECK_DEVICE(x);
+  RECORD_OP("reset_tensor_by_array", x.shape().size(), 0);
   reset_tensor_by_array_impl(values, x);
 }
 
@@ -75,6 +214,7 @@ void Device::reset_tensor_by_vector(const vector<float> &values, Tensor &x) {
         << " (shape: " << x.shape().to_string() << ") != actual: "
         << values.size());
   }
+  RECORD_OP("reset_tensor_by_vector", x.shape().size(), 0);
   reset_tensor_by_array_impl(values.data(), x);
 }
 
@@ -83,15 +223,45 @@ Tensor Device::copy_tensor(const Tensor &x) {
   // This function should return always different memory with x.
   if (!x.valid()) THROW_ERROR("Attempted to copy an invalid tensor.");
   Tensor y = new_tensor(x.shape());
+  RECORD_OP("copy_tensor", y.shape().size(), 0);
   copy_tensor_impl(x, y);
   return y;
 }
 
+void Device::inplace_copy(const Tensor &x, Tensor &y) {
+  if (!x.valid()) THROW_ERROR("Attempted to copy an invalid tensor.");
+  CHECK_DEVICE(y);
+  if (x.shape() != y.shape()) {
+    THROW_ERROR(
+        "Shape mismatched. x.shape(): " << x.shape().to_string()
+        << " != y.shape(): " << y.shape().to_string());
+  }
+  RECORD_OP("inplace_copy", y.shape().size(), 0);
+  copy_tensor_impl(x, y);
+}
+
+Tensor Device::new_tensor_view(
+    const Tensor &x, unsigned offset, const Shape &shape) {
+  CHECK_DEVICE(x);
+  if (offset + shape.size() > x.shape().size()) {
+    THROW_ERROR(
+        "Out of range. x.shape(): " << x.shape().to_string()
+        << ", offset: " << offset << ", shape: " << shape.to_string());
+  }
+  // NOTE:
+  // The view has its own reference counter so that writing to the view does
+  // not duplicate the memory, and holds the memory of `x` in its deleter.
+  const std::shared_ptr<void> src = x.data_;
+  void *ptr = static_cast<float *>(src.get()) + offset;
+  return Tensor(shape, *this, std::shared_ptr<void>(ptr, [src](void *) {}));
+}
+
 Tensor Device::identity(unsigned size) {
   if (size == 0) {
     THROW_ERROR("Invalid size of the identity matrix: " << size);
   }
   Tensor y = new_tensor({size, size});
+  RECORD_OP("identity", y.shape().size(), 0);
   identity_impl(y);
   return y;
 }
@@ -101,6 +271,7 @@ Tensor Device::random_bernoulli(const Shape &shape, float p) {
     THROW_ERROR("Invalid Bernoulli probability: " << p);
   }
   Tensor y = new_tensor(shape);
+  RECORD_OP("random_bernoulli", y.shape().size(), y.shape().size());
   random_bernoulli_impl(p, y);
   return y;
 }
@@ -113,6 +284,7 @@ Tensor Device::random_uniform(
         << ", upper: " << upper);
   }
   Tensor y = new_tensor(shape);
+  RECORD_OP("random_uniform", y.shape().size(), y.shape().size());
   random_uniform_impl(lower, upper, y);
   return y;
 }
@@ -124,6 +296,7 @@ Tensor Device::random_normal(const Shape &shape, float mean, float sd) {
         << ", SD: " << sd);
   }
   Tensor y = new_tensor(shape);
+  RECORD_OP("random_normal", y.shape().size(), y.shape().size());
   random_normal_impl(mean, sd, y);
   return y;
 }
@@ -135,6 +308,7 @@ Tensor Device::random_log_normal(const Shape &shape, float mean, float sd) {
         << ", SD: " << sd);
   }
   Tensor y = new_tensor(shape);
+  RECORD_OP("random_log_normal", y.shape().size(), y.shape().size());
   random_log_normal_impl(mean, sd, y);
   return y;
 }
@@ -143,6 +317,7 @@ Tensor Device::pick_fw(
     const Tensor &x, const vector<unsigned> &ids, unsigned dim) {
   CHECK_DEVICE(x);
   Tensor y = new_tensor(shape_ops::pick(x.shape(), ids, dim));
+  RECORD_OP("pick_fw", y.shape().size(), 0);
   pick_fw_impl(x, ids, dim, y);
   return y;
 }
@@ -151,6 +326,7 @@ Tensor Device::slice_fw(
     const Tensor &x, unsigned dim, unsigned lower, unsigned upper) {
   CHECK_DEVICE(x);
   Tensor y = new_tensor(shape_ops::slice(x.shape(), dim, lower, upper));
+  RECORD_OP("slice_fw", y.shape().size(), 0);
   slice_fw_impl(x, dim, lower, y);
   return y;
 }
@@ -163,10 +339,48 @@ Tensor Device::concat_fw(const vector<const Tensor *> &xs, unsigned dim) {
     shapes[i] = &xs[i]->shape();
   }
   Tensor y = new_tensor(shape_ops::concat(shapes, dim));
+  RECORD_OP("concat_fw", y.shape().size(), 0);
   concat_fw_impl(xs, dim, y);
   return y;
 }
 
+// NOTE:
+// Operations along the minibatch regard each tensor as a matrix which has the
+// minibatch as its second dimension, and reuse slice/concat implementations.
+
+Tensor Device::batch_slice_fw(const Tensor &x, unsigned lower, unsigned upper) {
+  CHECK_DEVICE(x);
+  const Shape sy = shape_ops::batch_slice(x.shape(), lower, upper);
+  const unsigned volume = sy.volume();
+  const Tensor mx(Shape({volume, x.shape().batch()}), *this, x.data_);
+  Tensor my = new_tensor(Shape({volume, upper - lower}));
+  RECORD_OP("batch_slice_fw", my.shape().size(), 0);
+  slice_fw_impl(mx, 1, lower, my);
+  return Tensor(sy, *this, std::move(my.data_));
+}
+
+Tensor Device::batch_concat_fw(const vector<const Tensor *> &xs) {
+  vector<const Shape *> shapes(xs.size());
+  for (unsigned i = 0; i < xs.size(); ++i) {
+    CHECK_DEVICE(*xs[i]);
+    shapes[i] = &xs[i]->shape();
+  }
+  const Shape sy = shape_ops::batch_concat(shapes);
+  const unsigned volume = sy.volume();
+  vector<Tensor> mxs;
+  vector<const Tensor *> mx_ptrs;
+  mxs.reserve(xs.size());
+  for (const Tensor *x : xs) {
+    mxs.emplace_back(
+        Tensor(Shape({volume, x->shape().batch()}), *this, x->data_));
+    mx_ptrs.emplace_back(&mxs.back());
+  }
+  Tensor my = new_tensor(Shape({volume, sy.batch()}));
+  RECORD_OP("batch_concat_fw", my.shape().size(), 0);
+  concat_fw_impl(mx_ptrs, 1, my);
+  return Tensor(sy, *this, std::move(my.data_));
+}
+
 void Device::pick_bw(
     const Tensor &gy, const std::vector<unsigned> &ids, unsigned dim,
     Tensor &gx) {
@@ -178,6 +392,7 @@ void Device::pick_bw(
         "Shape mismatched. gy.shape(): " << gy.shape().to_string()
         << " != expected shape: " << sy.to_string());
   }
+  RECORD_OP("pick_bw", gy.shape().size(), gy.shape().size());
   pick_bw_impl(gy, ids, dim, gx);
 }
 
@@ -194,19 +409,27 @@ void Device::slice_bw(
         << sy.to_string() << ", dim " << dim << ", offset " << offset
         << " to shape" << sx.to_string() << '.');
   }
+  RECORD_OP("slice_bw", gy.shape().size(), gy.shape().size());
   if (dim >= sx.depth()) inplace_add_impl(gy, gx);
   else slice_bw_impl(gy, dim, offset, gx);
 }
 
-#define DEV_FW_X(name, sop) \
+// NOTE:
+// `flops` is the expression of the estimated number of floating point
+// operations, using the number of elements `n` of the result (forward) or the
+// gradient of the result (backward).
+
+#define DEV_FW_X(name, sop, flops) \
 Tensor Device::name##_fw(const Tensor &x) { \
   CHECK_DEVICE(x); \
   Tensor y = new_tensor(sop(x.shape())); \
+  const std::uint64_t n = y.shape().size(); \
+  RECORD_OP(#name "_fw", n, flops); \
   name##_fw_impl(x, y); \
   return y; \
 }
 
-#define DEV_BW_X(name, sop) \
+#define DEV_BW_X(name, sop, flops) \
 void Device::name##_bw( \
     const Tensor &x, const Tensor &y, const Tensor &gy, Tensor &gx) { \
   CHECK_DEVICE(x); \
@@ -223,18 +446,22 @@ void Device::name##_bw( \
         << ", gy.shape: " << gy.shape().to_string() \
         << ", gx.shape: " << gx.shape().to_string()); \
   } \
+  const std::uint64_t n = gy.shape().size(); \
+  RECORD_OP(#name "_bw", n, flops); \
   name##_bw_impl(x, y, gy, gx); \
 }
 
-#define DEV_FW_X_CONST(name) \
+#define DEV_FW_X_CONST(name, flops) \
 Tensor Device::name##_fw(const Tensor &x, float k) { \
   CHECK_DEVICE(x); \
   Tensor y = new_tensor(x.shape()); \
+  const std::uint64_t n = y.shape().size(); \
+  RECORD_OP(#name "_fw", n, flops); \
   name##_fw_impl(x, k, y); \
   return y; \
 }
 
-#define DEV_BW_X_CONST(name) \
+#define DEV_BW_X_CONST(name, flops) \
 void Device::name##_bw( \
     const Tensor &x, const Tensor &y, const Tensor &gy, float k, Tensor &gx) { \
   CHECK_DEVICE(x); \
@@ -250,19 +477,23 @@ void Device::name##_bw( \
         << ", gy.shape: " << gy.shape().to_string() \
         << ", gx.shape: " << gx.shape().to_string()); \
   } \
+  const std::uint64_t n = gy.shape().size(); \
+  RECORD_OP(#name "_bw", n, flops); \
   name##_bw_impl(x, y, gy, k, gx); \
 }
 
-#define DEV_FW_AB(name, sop) \
+#define DEV_FW_AB(name, sop, flops) \
 Tensor Device::name##_fw(const Tensor &a, const Tensor &b) { \
   CHECK_DEVICE(a); \
   CHECK_DEVICE(b); \
   Tensor y = new_tensor(sop(a.shape(), b.shape())); \
+  const std::uint64_t n = y.shape().size(); \
+  RECORD_OP(#name "_fw", n, flops); \
   name##_fw_impl(a, b, y); \
   return y; \
 }
 
-#define DEV_BW_AB(name, sop) \
+#define DEV_BW_AB(name, sop, flops) \
 void Device::name##_bw( \
     const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy, \
     Tensor &ga, Tensor &gb) { \
@@ -285,68 +516,70 @@ void Device::name##_bw( \
         << ", ga.shape: " << ga.shape().to_string() \
         << ", gb.shape: " << gb.shape().to_string()); \
   } \
+  const std::uint64_t n = gy.shape().size(); \
+  RECORD_OP(#name "_bw", n, flops); \
   name##_bw_impl(a, b, y, gy, ga, gb); \
 }
 
-DEV_FW_X(negate, static_cast<const Shape &>);
-DEV_FW_X(sqrt, static_cast<const Shape &>);
-DEV_FW_X(exp, static_cast<const Shape &>);
-DEV_FW_X(log, static_cast<const Shape &>);
-DEV_FW_X(tanh, static_cast<const Shape &>);
-DEV_FW_X(sigmoid, static_cast<const Shape &>);
-DEV_FW_X(softplus, static_cast<const Shape &>);
-DEV_FW_X(sin, static_cast<const Shape &>);
-DEV_FW_X(cos, static_cast<const Shape &>);
-DEV_FW_X(tan, static_cast<const Shape &>);
-DEV_FW_X(transpose, shape_ops::transpose);
-
-DEV_BW_X(sqrt, static_cast<const Shape &>);
-DEV_BW_X(exp, static_cast<const Shape &>);
-DEV_BW_X(log, static_cast<const Shape &>);
-DEV_BW_X(tanh, static_cast<const Shape &>);
-DEV_BW_X(sigmoid, static_cast<const Shape &>);
-DEV_BW_X(softplus, static_cast<const Shape &>);
-DEV_BW_X(sin, static_cast<const Shape &>);
-DEV_BW_X(cos, static_cast<const Shape &>);
-DEV_BW_X(tan, static_cast<const Shape &>);
-DEV_BW_X(transpose, shape_ops::transpose);
-
-DEV_FW_X_CONST(add_const);
-DEV_FW_X_CONST(subtract_const_r);
-DEV_FW_X_CONST(subtract_const_l);
-DEV_FW_X_CONST(multiply_const);
-DEV_FW_X_CONST(divide_const_r);
-DEV_FW_X_CONST(divide_const_l);
-DEV_FW_X_CONST(prelu);
-DEV_FW_X_CONST(elu);
-
-DEV_BW_X_CONST(add_const);
-DEV_BW_X_CONST(subtract_const_r);
-DEV_BW_X_CONST(subtract_const_l);
-DEV_BW_X_CONST(multiply_const);
-DEV_BW_X_CONST(divide_const_r);
-DEV_BW_X_CONST(divide_const_l);
-DEV_BW_X_CONST(prelu);
-DEV_BW_X_CONST(elu);
-
-DEV_FW_AB(add_scalar, shape_ops::scalar_op);
-DEV_FW_AB(subtract_scalar_r, shape_ops::scalar_op);
-DEV_FW_AB(subtract_scalar_l, shape_ops::scalar_op);
-DEV_FW_AB(multiply_scalar, shape_ops::scalar_op);
-DEV_FW_AB(divide_scalar_r, shape_ops::scalar_op);
-DEV_FW_AB(divide_scalar_l, shape_ops::scalar_op);
-
-DEV_FW_AB(add, shape_ops::elementwise);
-DEV_FW_AB(subtract, shape_ops::elementwise);
-DEV_FW_AB(multiply, shape_ops::elementwise);
-DEV_FW_AB(divide, shape_ops::elementwise);
-DEV_FW_AB(matmul, shape_ops::matmul);
-
-DEV_BW_AB(add, shape_ops::elementwise);
-DEV_BW_AB(subtract, shape_ops::elementwise);
-DEV_BW_AB(multiply, shape_ops::elementwise);
-DEV_BW_AB(divide, shape_ops::elementwise);
-DEV_BW_AB(matmul, shape_ops::matmul);
+DEV_FW_X(negate, static_cast<const Shape &>, n);
+DEV_FW_X(sqrt, static_cast<const Shape &>, n);
+DEV_FW_X(exp, static_cast<const Shape &>, n);
+DEV_FW_X(log, static_cast<const Shape &>, n);
+DEV_FW_X(tanh, static_cast<const Shape &>, n);
+DEV_FW_X(sigmoid, static_cast<const Shape &>, n);
+DEV_FW_X(softplus, static_cast<const Shape &>, n);
+DEV_FW_X(sin, static_cast<const Shape &>, n);
+DEV_FW_X(cos, static_cast<const Shape &>, n);
+DEV_FW_X(tan, static_cast<const Shape &>, n);
+DEV_FW_X(transpose, shape_ops::transpose, 0);
+
+DEV_BW_X(sqrt, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(exp, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(log, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(tanh, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(sigmoid, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(softplus, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(sin, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(cos, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(tan, static_cast<const Shape &>, 2 * n);
+DEV_BW_X(transpose, shape_ops::transpose, n);
+
+DEV_FW_X_CONST(add_const, n);
+DEV_FW_X_CONST(subtract_const_r, n);
+DEV_FW_X_CONST(subtract_const_l, n);
+DEV_FW_X_CONST(multiply_const, n);
+DEV_FW_X_CONST(divide_const_r, n);
+DEV_FW_X_CONST(divide_const_l, n);
+DEV_FW_X_CONST(prelu, n);
+DEV_FW_X_CONST(elu, n);
+
+DEV_BW_X_CONST(add_const, 2 * n);
+DEV_BW_X_CONST(subtract_const_r, 2 * n);
+DEV_BW_X_CONST(subtract_const_l, 2 * n);
+DEV_BW_X_CONST(multiply_const, 2 * n);
+DEV_BW_X_CONST(divide_const_r, 2 * n);
+DEV_BW_X_CONST(divide_const_l, 2 * n);
+DEV_BW_X_CONST(prelu, 2 * n);
+DEV_BW_X_CONST(elu, 2 * n);
+
+DEV_FW_AB(add_scalar, shape_ops::scalar_op, n);
+DEV_FW_AB(subtract_scalar_r, shape_ops::scalar_op, n);
+DEV_FW_AB(subtract_scalar_l, shape_ops::scalar_op, n);
+DEV_FW_AB(multiply_scalar, shape_ops::scalar_op, n);
+DEV_FW_AB(divide_scalar_r, shape_ops::scalar_op, n);
+DEV_FW_AB(divide_scalar_l, shape_ops::scalar_op, n);
+
+DEV_FW_AB(add, shape_ops::elementwise, n);
+DEV_FW_AB(subtract, shape_ops::elementwise, n);
+DEV_FW_AB(multiply, shape_ops::elementwise, n);
+DEV_FW_AB(divide, shape_ops::elementwise, n);
+DEV_FW_AB(matmul, shape_ops::matmul, 2 * n * a.shape()[1]);
+
+DEV_BW_AB(add, shape_ops::elementwise, 2 * n);
+DEV_BW_AB(subtract, shape_ops::elementwise, 2 * n);
+DEV_BW_AB(multiply, shape_ops::elementwise, 4 * n);
+DEV_BW_AB(divide, shape_ops::elementwise, 5 * n);
+DEV_BW_AB(matmul, shape_ops::matmul, 4 * n * a.shape()[1]);
 
 #undef DEV_FW_X
 #undef DEV_BW_X
@@ -355,9 +588,280 @@ DEV_BW_AB(matmul, shape_ops::matmul);
 #undef DEV_FW_AB
 #undef DEV_BW_AB
 
+Shape Device::elementwise_fw_shape(
+    const vector<const Tensor *> &xs, const elementwise::Program &prog) {
+  vector<const Shape *> shapes;
+  shapes.reserve(xs.size());
+  for (const Tensor *x : xs) {
+    CHECK_DEVICE(*x);
+    shapes.emplace_back(&x->shape());
+  }
+  if (prog.num_inputs != xs.size() || prog.code.empty()) {
+    THROW_ERROR(
+        "Invalid program at elementwise_fw. prog.num_inputs: "
+        << prog.num_inputs << ", prog.code.size(): " << prog.code.size()
+        << ", xs.size(): " << xs.size());
+  }
+  for (unsigned i = 0; i < prog.code.size(); ++i) {
+    const elementwise::Instruction &inst = prog.code[i];
+    const unsigned bound = prog.num_inputs + i;
+    if (inst.args[0] >= bound ||
+        (elementwise::is_binary(inst.opcode) && inst.args[1] >= bound)) {
+      THROW_ERROR(
+          "Invalid program at elementwise_fw. Instruction " << i
+          << " uses an unavailable register.");
+    }
+  }
+  return shape_ops::fused_elementwise(shapes);
+}
+
+Tensor Device::elementwise_fw(
+    const vector<const Tensor *> &xs, const elementwise::Program &prog) {
+  Tensor y = new_tensor(elementwise_fw_shape(xs, prog));
+  const std::uint64_t n = y.shape().size();
+  RECORD_OP("elementwise_fw", n, n * prog.code.size());
+  elementwise_fw_impl(xs, prog, y);
+  return y;
+}
+
+void Device::elementwise_fw(
+    const vector<const Tensor *> &xs, const elementwise::Program &prog,
+    Tensor &y) {
+  CHECK_DEVICE(y);
+  const Shape sy = elementwise_fw_shape(xs, prog);
+  if (y.shape() != sy) {
+    THROW_ERROR(
+        "Shape mismatched at elementwise_fw. y.shape(): "
+        << y.shape().to_string() << " != expected shape: " << sy.to_string());
+  }
+  const std::uint64_t n = y.shape().size();
+  RECORD_OP("elementwise_fw", n, n * prog.code.size());
+  elementwise_fw_impl(xs, prog, y);
+}
+
+void Device::elementwise_bw(
+    const vector<const Tensor *> &xs, const Tensor &y, const Tensor &gy,
+    const elementwise::Program &prog, const vector<Tensor *> &gxs) {
+  CHECK_DEVICE(y);
+  CHECK_DEVICE(gy);
+  if (xs.size() != gxs.size()) {
+    THROW_ERROR(
+        "Number of tensors mismatched at elementwise_bw. xs.size(): "
+        << xs.size() << " != gxs.size(): " << gxs.size());
+  }
+  vector<const Shape *> shapes;
+  shapes.reserve(xs.size());
+  for (unsigned i = 0; i < xs.size(); ++i) {
+    CHECK_DEVICE(*xs[i]);
+    CHECK_DEVICE(*gxs[i]);
+    if (xs[i]->shape() != gxs[i]->shape()) {
+      THROW_ERROR(
+          "Shape mismatched at elementwise_bw. xs[" << i << "].shape: "
+          << xs[i]->shape().to_string() << " != gxs[" << i << "].shape: "
+          << gxs[i]->shape().to_string());
+    }
+    shapes.emplace_back(&xs[i]->shape());
+  }
+  const Shape sy = shape_ops::fused_elementwise(shapes);
+  if (y.shape() != sy || gy.shape() != sy) {
+    THROW_ERROR(
+        "Shape mismatched at elementwise_bw. y.shape: "
+        << y.shape().to_string() << ", gy.shape: " << gy.shape().to_string()
+        << ", required: " << sy.to_string());
+  }
+  if (prog.num_inputs != xs.size() || prog.code.empty()) {
+    THROW_ERROR(
+        "Invalid program at elementwise_bw. prog.num_inputs: "
+        << prog.num_inputs << ", prog.code.size(): " << prog.code.size()
+        << ", xs.size(): " << xs.size());
+  }
+  const std::uint64_t n = gy.shape().size();
+  RECORD_OP("elementwise_bw", n, 2 * n * prog.code.size());
+  elementwise_bw_impl(xs, y, gy, prog, gxs);
+}
+
+namespace {
+
+// Binary operations with broadcasting scalars.
+
+Tensor add_bcast(Device &dev, const Tensor &a, const Tensor &b) {
+  if (a.shape().is_scalar() && !b.shape().is_scalar()) {
+    return dev.add_scalar_fw(b, a);
+  }
+  if (b.shape().is_scalar() && !a.shape().is_scalar()) {
+    return dev.add_scalar_fw(a, b);
+  }
+  return dev.add_fw(a, b);
+}
+
+Tensor subtract_bcast(Device &dev, const Tensor &a, const Tensor &b) {
+  if (a.shape().is_scalar() && !b.shape().is_scalar()) {
+    return dev.subtract_scalar_l_fw(b, a);
+  }
+  if (b.shape().is_scalar() && !a.shape().is_scalar()) {
+    return dev.subtract_scalar_r_fw(a, b);
+  }
+  return dev.subtract_fw(a, b);
+}
+
+Tensor multiply_bcast(Device &dev, const Tensor &a, const Tensor &b) {
+  if (a.shape().is_scalar() && !b.shape().is_scalar()) {
+    return dev.multiply_scalar_fw(b, a);
+  }
+  if (b.shape().is_scalar() && !a.shape().is_scalar()) {
+    return dev.multiply_scalar_fw(a, b);
+  }
+  return dev.multiply_fw(a, b);
+}
+
+Tensor divide_bcast(Device &dev, const Tensor &a, const Tensor &b) {
+  if (a.shape().is_scalar() && !b.shape().is_scalar()) {
+    return dev.divide_scalar_l_fw(b, a);
+  }
+  if (b.shape().is_scalar() && !a.shape().is_scalar()) {
+    return dev.divide_scalar_r_fw(a, b);
+  }
+  return dev.divide_fw(a, b);
+}
+
+// Calculates all registers of the program.
+vector<Tensor> elementwise_registers(
+    Device &dev, const vector<const Tensor *> &xs,
+    const elementwise::Program &prog) {
+  using namespace elementwise;
+  vector<Tensor> r;
+  r.reserve(prog.num_registers());
+  for (const Tensor *x : xs) r.emplace_back(*x);
+  for (const Instruction &inst : prog.code) {
+    const Tensor &a = r[inst.args[0]];
+    const float k = inst.k;
+    switch (inst.opcode) {
+      case POSITIVE: r.emplace_back(a); break;
+      case NEGATIVE: r.emplace_back(dev.negate_fw(a)); break;
+      case SQRT: r.emplace_back(dev.sqrt_fw(a)); break;
+      case EXP: r.emplace_back(dev.exp_fw(a)); break;
+      case LOG: r.emplace_back(dev.log_fw(a)); break;
+      case TANH: r.emplace_back(dev.tanh_fw(a)); break;
+      case SIGMOID: r.emplace_back(dev.sigmoid_fw(a)); break;
+      case SOFTPLUS: r.emplace_back(dev.softplus_fw(a)); break;
+      case SIN: r.emplace_back(dev.sin_fw(a)); break;
+      case COS: r.emplace_back(dev.cos_fw(a)); break;
+      case TAN: r.emplace_back(dev.tan_fw(a)); break;
+      case ADD_CONST: r.emplace_back(dev.add_const_fw(a, k)); break;
+      case SUBTRACT_CONST_R: r.emplace_back(dev.subtract_const_r_fw(a, k)); break;
+      case SUBTRACT_CONST_L: r.emplace_back(dev.subtract_const_l_fw(a, k)); break;
+      case MULTIPLY_CONST: r.emplace_back(dev.multiply_const_fw(a, k)); break;
+      case DIVIDE_CONST_R: r.emplace_back(dev.divide_const_r_fw(a, k)); break;
+      case DIVIDE_CONST_L: r.emplace_back(dev.divide_const_l_fw(a, k)); break;
+      case PRELU: r.emplace_back(dev.prelu_fw(a, k)); break;
+      case ELU: r.emplace_back(dev.elu_fw(a, k)); break;
+      case ADD: r.emplace_back(add_bcast(dev, a, r[inst.args[1]])); break;
+      case SUBTRACT: r.emplace_back(subtract_bcast(dev, a, r[inst.args[1]])); break;
+      case MULTIPLY: r.emplace_back(multiply_bcast(dev, a, r[inst.args[1]])); break;
+      case DIVIDE: r.emplace_back(divide_bcast(dev, a, r[inst.args[1]])); break;
+    }
+  }
+  return r;
+}
+
+// Accumulates a gradient `g` with the result shape to `gx`.
+void accumulate_grad(Device &dev, const Tensor &g, bool negate, Tensor &gx) {
+  const Tensor s = gx.shape().is_scalar() && !g.shape().is_scalar()
+    ? dev.sum_fw(g.flatten(), 0) : g;
+  if (negate) dev.inplace_subtract(s, gx);
+  else dev.inplace_add(s, gx);
+}
+
+}  // namespace
+
+void Device::elementwise_fw_impl(
+    const vector<const Tensor *> &xs, const elementwise::Program &prog,
+    Tensor &y) {
+  const Tensor ret = elementwise_registers(*this, xs, prog).back();
+  if (ret.shape() == y.shape()) {
+    y = ret;
+  } else {
+    // The result is an input with the batch size 1.
+    reset_tensor(0, y);
+    inplace_add(ret, y);
+  }
+}
+
+void Device::elementwise_bw_impl(
+    const vector<const Tensor *> &xs, const Tensor &, const Tensor &gy,
+    const elementwise::Program &prog, const vector<Tensor *> &gxs) {
+  using namespace elementwise;
+  const vector<Tensor> r = elementwise_registers(*this, xs, prog);
+  vector<Tensor> g(prog.num_registers());
+  g.back() = gy;
+
+  // Returns the gradient tensor of the register.
+  auto grad = [&](unsigned reg) -> Tensor & {
+    if (reg < prog.num_inputs) return *gxs[reg];
+    if (!g[reg].valid()) g[reg] = new_tensor(r[reg].shape(), 0);
+    return g[reg];
+  };
+
+  for (unsigned i = prog.code.size(); i-- > 0; ) {
+    const Instruction &inst = prog.code[i];
+    const Tensor &gyi = g[prog.num_inputs + i];
+    if (!gyi.valid()) continue;
+    const Tensor &a = r[inst.args[0]];
+    const Tensor &yi = r[prog.num_inputs + i];
+    const float k = inst.k;
+    switch (inst.opcode) {
+      case POSITIVE: accumulate_grad(*this, gyi, false, grad(inst.args[0])); break;
+      case NEGATIVE: accumulate_grad(*this, gyi, true, grad(inst.args[0])); break;
+      case SQRT: sqrt_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case EXP: exp_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case LOG: log_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case TANH: tanh_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case SIGMOID: sigmoid_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case SOFTPLUS: softplus_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case SIN: sin_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case COS: cos_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case TAN: tan_bw(a, yi, gyi, grad(inst.args[0])); break;
+      case ADD_CONST: add_const_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case SUBTRACT_CONST_R: subtract_const_r_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case SUBTRACT_CONST_L: subtract_const_l_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case MULTIPLY_CONST: multiply_const_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case DIVIDE_CONST_R: divide_const_r_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case DIVIDE_CONST_L: divide_const_l_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case PRELU: prelu_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case ELU: elu_bw(a, yi, gyi, k, grad(inst.args[0])); break;
+      case ADD:
+        accumulate_grad(*this, gyi, false, grad(inst.args[0]));
+        accumulate_grad(*this, gyi, false, grad(inst.args[1]));
+        break;
+      case SUBTRACT:
+        accumulate_grad(*this, gyi, false, grad(inst.args[0]));
+        accumulate_grad(*this, gyi, true, grad(inst.args[1]));
+        break;
+      case MULTIPLY:
+        {
+          const Tensor &b = r[inst.args[1]];
+          accumulate_grad(
+              *this, multiply_bcast(*this, gyi, b), false, grad(inst.args[0]));
+          accumulate_grad(
+              *this, multiply_bcast(*this, gyi, a), false, grad(inst.args[1]));
+        }
+        break;
+      case DIVIDE:
+        {
+          const Tensor ga = divide_bcast(*this, gyi, r[inst.args[1]]);
+          accumulate_grad(*this, ga, false, grad(inst.args[0]));
+          accumulate_grad(
+              *this, multiply_fw(ga, yi), true, grad(inst.args[1]));
+        }
+        break;
+    }
+  }
+}
+
 Tensor Device::sum_fw(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
   Tensor y = new_tensor(x.shape().resize_dim(dim, 1));
+  RECORD_OP("sum_fw", y.shape().size(), x.shape().size());
   sum_fw_impl(x, dim, y);
   return y;
 }
@@ -365,6 +869,7 @@ Tensor Device::sum_fw(const Tensor &x, unsigned dim) {
 Tensor Device::logsumexp_fw(const Tensor &x, unsigned dim) {
   CHECK_DEVICE(x);
   Tensor y = new_tensor(x.shape().resize_dim(dim, 1));
+  RECORD_OP("logsumexp_fw", y.shape().size(), 3 * x.shape().size());
   logsumexp_fw_impl(x, dim, y);
   return y;
 }
@@ -372,6 +877,7 @@ Tensor Device::logsumexp_fw(const Tensor &x, unsigned dim) {
 Tensor Device::broadcast_fw(const Tensor &x, unsigned dim, unsigned size) {
   CHECK_DEVICE(x);
   Tensor y = new_tensor(shape_ops::broadcast(x.shape(), dim, size));
+  RECORD_OP("broadcast_fw", y.shape().size(), 0);
   broadcast_fw_impl(x, dim, size, y);
   return y;
 }
@@ -379,12 +885,112 @@ Tensor Device::broadcast_fw(const Tensor &x, unsigned dim, unsigned size) {
 Tensor Device::batch_sum_fw(const Tensor &x) {
   CHECK_DEVICE(x);
   Tensor y = new_tensor(x.shape().resize_batch(1));
+  RECORD_OP("batch_sum_fw", y.shape().size(), x.shape().size());
   batch_sum_fw_impl(x, y);
   return y;
 }
 
+void Device::logsumexp_bw(
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_DEVICE(gy);
+  CHECK_DEVICE(gx);
+  if (x.shape() != gx.shape() ||
+      y.shape() != gy.shape() ||
+      y.shape() != x.shape().resize_dim(dim, 1)) {
+    THROW_ERROR(
+        "Shape mismatched at logsumexp_bw"
+        << ". x.shape: " << x.shape().to_string()
+        << ", y.shape: " << y.shape().to_string()
+        << ", gy.shape: " << gy.shape().to_string()
+        << ", gx.shape: " << gx.shape().to_string()
+        << ", dim: " << dim);
+  }
+  RECORD_OP("logsumexp_bw", gx.shape().size(), 3 * gx.shape().size());
+  logsumexp_bw_impl(x, y, gy, dim, gx);
+}
+
+Tensor Device::softmax_fw(const Tensor &x, unsigned dim) {
+  CHECK_DEVICE(x);
+  Tensor y = new_tensor(x.shape());
+  RECORD_OP("softmax_fw", y.shape().size(), 4 * y.shape().size());
+  softmax_fw_impl(x, dim, y);
+  return y;
+}
+
+Tensor Device::log_softmax_fw(const Tensor &x, unsigned dim) {
+  CHECK_DEVICE(x);
+  Tensor y = new_tensor(x.shape());
+  RECORD_OP("log_softmax_fw", y.shape().size(), 4 * y.shape().size());
+  log_softmax_fw_impl(x, dim, y);
+  return y;
+}
+
+Tensor Device::softmax_cross_entropy_fw(
+    const Tensor &x, const vector<unsigned> &ids, unsigned dim) {
+  CHECK_DEVICE(x);
+  Tensor y = new_tensor(shape_ops::pick(x.shape(), ids, dim));
+  RECORD_OP(
+      "softmax_cross_entropy_fw", y.shape().size(),
+      3 * y.shape().size() * x.shape()[dim]);
+  softmax_cross_entropy_fw_impl(x, ids, dim, y);
+  return y;
+}
+
+#define DEV_BW_SOFTMAX(name) \
+void Device::name##_bw( \
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, \
+    Tensor &gx) { \
+  CHECK_DEVICE(x); \
+  CHECK_DEVICE(y); \
+  CHECK_DEVICE(gy); \
+  CHECK_DEVICE(gx); \
+  const Shape &s = x.shape(); \
+  if (y.shape() != s || gy.shape() != s || gx.shape() != s) { \
+    THROW_ERROR( \
+        "Shape mismatched at " #name "_bw" \
+        << ". x.shape: " << s.to_string() \
+        << ", y.shape: " << y.shape().to_string() \
+        << ", gy.shape: " << gy.shape().to_string() \
+        << ", gx.shape: " << gx.shape().to_string()); \
+  } \
+  RECORD_OP(#name "_bw", gx.shape().size(), 4 * gx.shape().size()); \
+  name##_bw_impl(x, y, gy, dim, gx); \
+}
+
+DEV_BW_SOFTMAX(softmax);
+DEV_BW_SOFTMAX(log_softmax);
+
+#undef DEV_BW_SOFTMAX
+
+void Device::softmax_cross_entropy_bw(
+    const Tensor &x, const vector<unsigned> &ids, const Tensor &y,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  CHECK_DEVICE(gy);
+  CHECK_DEVICE(gx);
+  const Shape sy = shape_ops::pick(x.shape(), ids, dim);
+  if (x.shape() != gx.shape() || y.shape() != sy || gy.shape() != sy) {
+    THROW_ERROR(
+        "Shape mismatched at softmax_cross_entropy_bw"
+        << ". x.shape: " << x.shape().to_string()
+        << ", y.shape: " << y.shape().to_string()
+        << ", gy.shape: " << gy.shape().to_string()
+        << ", gx.shape: " << gx.shape().to_string()
+        << ", expected y.shape: " << sy.to_string());
+  }
+  RECORD_OP(
+      "softmax_cross_entropy_bw", gy.shape().size(),
+      4 * gy.shape().size() * x.shape()[dim]);
+  softmax_cross_entropy_bw_impl(x, ids, y, gy, dim, gx);
+}
+
 void Device::inplace_multiply_const(float k, Tensor &x) {
   CHECK_DEVICE(x);
+  RECORD_OP("inplace_multiply_const", x.shape().size(), x.shape().size());
   inplace_multiply_const_impl(k, x);
 }
 
@@ -398,6 +1004,7 @@ void Device::inplace_add(const Tensor &x, Tensor &y) {
         "Attempted to add values of shape "
         << sx.to_string() << " to " << sy.to_string() << '.');
   }
+  RECORD_OP("inplace_add", y.shape().size(), x.shape().size());
   inplace_add_impl(x, y);
 }
 
@@ -411,7 +1018,154 @@ void Device::inplace_subtract(const Tensor &x, Tensor &y) {
         "Attempted to subtract values of shape "
         << sx.to_string() << " from " << sy.to_string() << '.');
   }
+  RECORD_OP("inplace_subtract", y.shape().size(), x.shape().size());
   inplace_subtract_impl(x, y);
 }
 
+void Device::inplace_pick_assign(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  CHECK_DEVICE(x);
+  CHECK_DEVICE(y);
+  const Shape sx = shape_ops::pick(y.shape(), ids, dim);
+  if (x.shape() != sx) {
+    THROW_ERROR(
+        "Shape mismatched. x.shape(): " << x.shape().to_string()
+        << " != expected shape: " << sx.to_string());
+  }
+  RECORD_OP("inplace_pick_assign", x.shape().size(), 0);
+  inplace_pick_assign_impl(x, ids, dim, y);
+}
+
+namespace {
+
+// Checks arguments of fused optimizer updates.
+// Returns the total number of elements to be updated.
+std::uint64_t check_update_args(
+    const Device *dev, const char *name, const vector<const Tensor *> &gs,
+    std::initializer_list<const vector<Tensor *> *> xss) {
+  for (const vector<Tensor *> *xs : xss) {
+    if (xs->size() != gs.size()) {
+      THROW_ERROR(
+          "Number of tensors mismatched at " << name << ". gs.size(): "
+          << gs.size() << " != " << xs->size());
+    }
+  }
+  std::uint64_t n = 0;
+  for (unsigned i = 0; i < gs.size(); ++i) {
+    const Shape &sg = gs[i]->shape();
+    if (&gs[i]->device() != dev) {
+      THROW_ERROR(
+          "Device mismatched at " << name << ". &gs[" << i << "]->device(): "
+          << &gs[i]->device() << " != this: " << dev);
+    }
+    for (const vector<Tensor *> *xs : xss) {
+      const Tensor &x = *(*xs)[i];
+      if (&x.device() != dev) {
+        THROW_ERROR(
+            "Device mismatched at " << name << ". &x.device(): "
+            << &x.device() << " != this: " << dev);
+      }
+      if (x.shape() != sg) {
+        THROW_ERROR(
+            "Shape mismatched at " << name << ". gs[" << i << "]->shape(): "
+            << sg.to_string() << " != " << x.shape().to_string());
+      }
+    }
+    n += sg.size();
+  }
+  return n;
+}
+
+}  // namespace
+
+void Device::sgd_update(
+    float eta, const vector<const Tensor *> &gs, const vector<Tensor *> &xs) {
+  const std::uint64_t n = check_update_args(this, "sgd_update", gs, {&xs});
+  RECORD_OP("sgd_update", n, 2 * n);
+  sgd_update_impl(eta, gs, xs);
+}
+
+void Device::momentum_sgd_update(
+    float eta, float momentum,
+    const vector<const Tensor *> &gs, const vector<Tensor *> &xs,
+    const vector<Tensor *> &ms) {
+  const std::uint64_t n = check_update_args(
+      this, "momentum_sgd_update", gs, {&xs, &ms});
+  RECORD_OP("momentum_sgd_update", n, 4 * n);
+  momentum_sgd_update_impl(eta, momentum, gs, xs, ms);
+}
+
+void Device::adagrad_update(
+    float eta, float eps,
+    const vector<const Tensor *> &gs, const vector<Tensor *> &xs,
+    const vector<Tensor *> &ms) {
+  const std::uint64_t n = check_update_args(
+      this, "adagrad_update", gs, {&xs, &ms});
+  RECORD_OP("adagrad_update", n, 7 * n);
+  adagrad_update_impl(eta, eps, gs, xs, ms);
+}
+
+void Device::rmsprop_update(
+    float eta, float alpha, float eps,
+    const vector<const Tensor *> &gs, const vector<Tensor *> &xs,
+    const vector<Tensor *> &ms) {
+  const std::uint64_t n = check_update_args(
+      this, "rmsprop_update", gs, {&xs, &ms});
+  RECORD_OP("rmsprop_update", n, 9 * n);
+  rmsprop_update_impl(eta, alpha, eps, gs, xs, ms);
+}
+
+void Device::adadelta_update(
+    float scale, float rho, float eps,
+    const vector<const Tensor *> &gs, const vector<Tensor *> &xs,
+    const vector<Tensor *> &m1s, const vector<Tensor *> &m2s) {
+  const std::uint64_t n = check_update_args(
+      this, "adadelta_update", gs, {&xs, &m1s, &m2s});
+  RECORD_OP("adadelta_update", n, 16 * n);
+  adadelta_update_impl(scale, rho, eps, gs, xs, m1s, m2s);
+}
+
+void Device::adam_update(
+    float alpha, float beta1, float beta2, float eps, unsigned epoch,
+    const vector<const Tensor *> &gs, const vector<Tensor *> &xs,
+    const vector<Tensor *> &m1s, const vector<Tensor *> &m2s) {
+  const std::uint64_t n = check_update_args(
+      this, "adam_update", gs, {&xs, &m1s, &m2s});
+  RECORD_OP("adam_update", n, 13 * n);
+  adam_update_impl(
+      alpha, beta1, beta2, eps,
+      1 - std::pow(beta1, epoch), 1 - std::pow(beta2, epoch),
+      gs, xs, m1s, m2s);
+}
+
+Tensor Device::squared_norm(const vector<const Tensor *> &xs) {
+  std::uint64_t n = 0;
+  for (const Tensor *x : xs) {
+    CHECK_DEVICE(*x);
+    n += x->shape().size();
+  }
+  Tensor y = new_tensor({});
+  RECORD_OP("squared_norm", n, 2 * n);
+  squared_norm_impl(xs, y);
+  return y;
+}
+
+void Device::inplace_clip_by_norm(
+    float threshold, const Tensor &sq_norm, const vector<Tensor *> &xs) {
+  CHECK_DEVICE(sq_norm);
+  if (sq_norm.shape() != Shape()) {
+    THROW_ERROR(
+        "sq_norm should be a scalar. sq_norm.shape(): "
+        << sq_norm.shape().to_string());
+  }
+  std::uint64_t n = 0;
+  for (const Tensor *x : xs) {
+    CHECK_DEVICE(*x);
+    n += x->shape().size();
+  }
+  RECORD_OP("inplace_clip_by_norm", n, n);
+  inplace_clip_by_norm_impl(threshold, sq_norm, xs);
+}
+
 }  // namespace primitiv
@@ -1,7 +1,11 @@
 #ifndef PRIMITIV_DEVICE_H_
 #define PRIMITIV_DEVICE_H_
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <string>
+#include <primitiv/elementwise.h>
 #include <primitiv/mixins.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
@@ -25,9 +29,101 @@ public:
     DEVICE_TYPE_CUDA = 0x10000,
   };
 
-  Device() = default;
+  /**
+   * Statistics of each operation.
+   */
+  struct OpStatistics {
+    /**
+     * Number of calls.
+     */
+    std::uint64_t num_calls;
+
+    /**
+     * Total number of elements of the results, or of the gradients in
+     * backward operations.
+     */
+    std::uint64_t num_elements;
+
+    /**
+     * Estimated number of floating point operations.
+     */
+    std::uint64_t num_flops;
+
+    /**
+     * Total elapsed time in nanoseconds.
+     */
+    std::uint64_t duration_ns;
+  };
+
+  /**
+   * Statistics of memories of tensors.
+   */
+  struct MemoryStatistics {
+    /**
+     * Number of tensors allocated.
+     */
+    std::uint64_t num_allocations;
+
+    /**
+     * Total bytes of tensors allocated.
+     */
+    std::uint64_t bytes_allocated;
+
+    /**
+     * Total bytes of tensors alive.
+     */
+    std::uint64_t bytes_in_use;
+
+    /**
+     * Maximum value of `bytes_in_use`.
+     */
+    std::uint64_t peak_bytes_in_use;
+  };
+
+  Device();
   virtual ~Device() = default;
 
+  /**
+   * Enables or disables recording statistics of operations and memories.
+   * @param enabled `true` to record statistics, `false` otherwise.
+   * @remarks Each public operation of the device is counted separately,
+   *          including operations called by other operations. `duration_ns`
+   *          is the time until the operation returns to the caller: devices
+   *          that launch kernels asynchronously, such as CUDA, report the
+   *          launch cost rather than the execution time.
+   *          Only tensors allocated while recording are counted in
+   *          `bytes_in_use`, until they are released.
+   *          While disabled, each operation only checks the flag at the
+   *          beginning and the end.
+   */
+  void set_profiling(bool enabled) { profiling_ = enabled; }
+
+  /**
+   * Returns whether statistics are recorded or not.
+   * @return `true` if statistics are recorded, `false` otherwise.
+   */
+  bool is_profiling_enabled() const { return profiling_; }
+
+  /**
+   * Retrieves statistics of operations.
+   * @return Map from names of operations (e.g., "matmul_fw") to their
+   *         statistics.
+   */
+  std::map<std::string, OpStatistics> get_op_statistics() const;
+
+  /**
+   * Retrieves statistics of memories.
+   * @return A MemoryStatistics object.
+   */
+  MemoryStatistics get_memory_statistics() const;
+
+  /**
+   * Resets all statistics.
+   * @remarks `bytes_in_use` is kept because tensors may be still alive, and
+   *          `peak_bytes_in_use` is set to `bytes_in_use`.
+   */
+  void reset_statistics();
+
   /**
    * Prints device description to stderr.
    */
@@ -81,6 +177,29 @@ public:
    */
   Tensor copy_tensor(const Tensor &x);
 
+  /**
+   * Overwrites values of a tensor on this device by another tensor.
+   * @param x A tensor to be copied. It may be on any device.
+   * @param y A tensor on this device to be updated. The shape should be equal
+   *          to that of `x`.
+   */
+  void inplace_copy(const Tensor &x, Tensor &y);
+
+  /**
+   * Provides a new Tensor object that refers to a part of the memory of
+   * another tensor.
+   * @param x A tensor on this device.
+   * @param offset Number of elements of `x` before the first element of the
+   *               new tensor.
+   * @param shape Shape of the new tensor.
+   * @return A new Tensor object.
+   * @remarks The memory of `x` is kept alive while the new tensor exists.
+   *          Writing to the new tensor changes the memory of `x` unless the
+   *          new tensor is shared with other objects, and `x` itself should
+   *          not be written directly while its views exist.
+   */
+  Tensor new_tensor_view(const Tensor &x, unsigned offset, const Shape &shape);
+
   // Provides an identity matrix.
   Tensor identity(unsigned size);
 
@@ -94,6 +213,8 @@ public:
   Tensor pick_fw(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim);
   Tensor slice_fw(const Tensor &x, unsigned dim, unsigned lower, unsigned upper);
   Tensor concat_fw(const std::vector<const Tensor *> &xs, unsigned dim);
+  Tensor batch_slice_fw(const Tensor &x, unsigned lower, unsigned upper);
+  Tensor batch_concat_fw(const std::vector<const Tensor *> &xs);
 
   void pick_bw(const Tensor &gy, const std::vector<unsigned> &ids, unsigned dim, Tensor &gx);
   void slice_bw(const Tensor &gy, unsigned dim, unsigned offset, Tensor &gx);
@@ -172,12 +293,87 @@ public:
       const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
       Tensor &ga, Tensor &gb);
 
+  // Fused elementwise operations.
+  Tensor elementwise_fw(
+      const std::vector<const Tensor *> &xs, const elementwise::Program &prog);
+
+  /**
+   * Calculates the fused elementwise operation into an existing tensor.
+   * @param xs Input tensors.
+   * @param prog Program to calculate.
+   * @param y A tensor to store the result. `y` may be one of `xs` which has
+   *          the same shape as the result, and then the operation is
+   *          calculated in place.
+   */
+  void elementwise_fw(
+      const std::vector<const Tensor *> &xs, const elementwise::Program &prog,
+      Tensor &y);
+
+  void elementwise_bw(
+      const std::vector<const Tensor *> &xs, const Tensor &y, const Tensor &gy,
+      const elementwise::Program &prog, const std::vector<Tensor *> &gxs);
+
   // Dimension operations.
   Tensor sum_fw(const Tensor &x, unsigned dim);
   Tensor logsumexp_fw(const Tensor &x, unsigned dim);
   Tensor broadcast_fw(const Tensor &x, unsigned dim, unsigned size);
   Tensor batch_sum_fw(const Tensor &x);
 
+  void logsumexp_bw(
+      const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+      Tensor &gx);
+
+  // Softmax operations.
+  // Values along the dimension are processed in one pass over the input with
+  // the running maximum and the sum of exponentials.
+
+  /**
+   * Calculates the softmax function along the dimension.
+   * @param x A tensor.
+   * @param dim Dimension to be normalized.
+   * @return `exp(x) / sum(exp(x), dim)`.
+   */
+  Tensor softmax_fw(const Tensor &x, unsigned dim);
+
+  /**
+   * Calculates the log-softmax function along the dimension.
+   * @param x A tensor.
+   * @param dim Dimension to be normalized.
+   * @return `x - logsumexp(x, dim)`.
+   */
+  Tensor log_softmax_fw(const Tensor &x, unsigned dim);
+
+  /**
+   * Calculates the softmax cross entropy with sparse labels.
+   * @param x A tensor of unnormalized scores.
+   * @param ids Label IDs. The batch size of `x` and the number of IDs should
+   *            satisfy the same condition as `pick_fw()`.
+   * @param dim Dimension of the scores.
+   * @return `logsumexp(x, dim) - pick(x, ids, dim)`.
+   */
+  Tensor softmax_cross_entropy_fw(
+      const Tensor &x, const std::vector<unsigned> &ids, unsigned dim);
+
+  void softmax_bw(
+      const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+      Tensor &gx);
+  void log_softmax_bw(
+      const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+      Tensor &gx);
+
+  /**
+   * Calculates the gradient of the softmax cross entropy with sparse labels.
+   * @param x The argument of `softmax_cross_entropy_fw()`.
+   * @param ids The argument of `softmax_cross_entropy_fw()`.
+   * @param y The result of `softmax_cross_entropy_fw()`.
+   * @param gy The gradient of `y`.
+   * @param dim The argument of `softmax_cross_entropy_fw()`.
+   * @param gx A tensor to accumulate the gradient of `x`.
+   */
+  void softmax_cross_entropy_bw(
+      const Tensor &x, const std::vector<unsigned> &ids, const Tensor &y,
+      const Tensor &gy, unsigned dim, Tensor &gx);
+
   /**
    * Directly multiplies all elements by a constant.
    * @param k A constant to multiply.
@@ -207,7 +403,159 @@ public:
    */
   void inplace_subtract(const Tensor &x, Tensor &y);
 
+  /**
+   * Directly overwrites slices of the second tensor by the first tensor.
+   * @param x A tensor to assign. The shape should be equal to
+   *          `pick(y, ids, dim)`.
+   * @param ids Indices of the slices of `y` along `dim`.
+   * @param dim Dimension of the slices.
+   * @param y A tensor to be updated.
+   * @remarks This method is the inverse of `pick_fw()`. If the same slice is
+   *          picked more than once, the resulting value of the slice is
+   *          undefined.
+   */
+  void inplace_pick_assign(
+      const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+      Tensor &y);
+
+  // Fused optimizer updates.
+  // NOTE:
+  // Each method updates all given tensors together in one operation.
+  // Tensors at the same position of each list should have the same shape, and
+  // tensors to be updated should not share their memory with each other.
+
+  /**
+   * Updates values by the stochastic gradient descent:
+   *   x -= eta * g
+   * @param eta Learning rate.
+   * @param gs Gradients.
+   * @param xs Values to be updated.
+   */
+  void sgd_update(
+      float eta,
+      const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs);
+
+  /**
+   * Updates values by the stochastic gradient descent with momentum:
+   *   m = momentum * m - eta * g
+   *   x += m
+   * @param eta Learning rate.
+   * @param momentum Decay factor of the momentum.
+   * @param gs Gradients.
+   * @param xs Values to be updated.
+   * @param ms Momentums to be updated.
+   */
+  void momentum_sgd_update(
+      float eta, float momentum,
+      const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+      const std::vector<Tensor *> &ms);
+
+  /**
+   * Updates values by AdaGrad:
+   *   m += g * g
+   *   x -= eta * g / (sqrt(m) + eps)
+   * @param eta Learning rate.
+   * @param eps Bias of power.
+   * @param gs Gradients.
+   * @param xs Values to be updated.
+   * @param ms Accumulated squares of gradients to be updated.
+   */
+  void adagrad_update(
+      float eta, float eps,
+      const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+      const std::vector<Tensor *> &ms);
+
+  /**
+   * Updates values by RMSProp:
+   *   m = alpha * m + (1 - alpha) * g * g
+   *   x -= eta * g / (sqrt(m) + eps)
+   * @param eta Learning rate.
+   * @param alpha Decay factor of moment.
+   * @param eps Bias of power.
+   * @param gs Gradients.
+   * @param xs Values to be updated.
+   * @param ms Moments to be updated.
+   */
+  void rmsprop_update(
+      float eta, float alpha, float eps,
+      const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+      const std::vector<Tensor *> &ms);
+
+  /**
+   * Updates values by AdaDelta:
+   *   m2 = rho * m2 + (1 - rho) * g * g
+   *   d = sqrt((m1 + eps) / (m2 + eps)) * g
+   *   m1 = rho * m1 + (1 - rho) * d * d
+   *   x -= scale * d
+   * @param scale Scaling factor of the update.
+   * @param rho Decay factor of RMS operation.
+   * @param eps Bias of RMS values.
+   * @param gs Gradients.
+   * @param xs Values to be updated.
+   * @param m1s Moments of updates to be updated.
+   * @param m2s Moments of gradients to be updated.
+   */
+  void adadelta_update(
+      float scale, float rho, float eps,
+      const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+      const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s);
+
+  /**
+   * Updates values by Adam:
+   *   m1 = beta1 * m1 + (1 - beta1) * g
+   *   m2 = beta2 * m2 + (1 - beta2) * g * g
+   *   x -= alpha * (m1 / (1 - beta1^t)) / (sqrt(m2 / (1 - beta2^t)) + eps)
+   * @param alpha Learning rate.
+   * @param beta1 Decay factor of momentum history.
+   * @param beta2 Decay factor of power history.
+   * @param eps Bias of power.
+   * @param epoch Number of updates including this one (t in above formula).
+   * @param gs Gradients.
+   * @param xs Values to be updated.
+   * @param m1s Momentum histories to be updated.
+   * @param m2s Power histories to be updated.
+   */
+  void adam_update(
+      float alpha, float beta1, float beta2, float eps, unsigned epoch,
+      const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+      const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s);
+
+  // Fused gradient clipping.
+  // NOTE:
+  // Following methods do not move any value between the host and the device,
+  // and the clipping is completed without waiting the device.
+
+  /**
+   * Calculates the squared L2 norm of all given tensors together:
+   *   y = sum_i sum(xs[i] * xs[i])
+   * @param xs Tensors.
+   * @return A new scalar tensor that holds the squared norm.
+   */
+  Tensor squared_norm(const std::vector<const Tensor *> &xs);
+
+  /**
+   * Scales tensors so that their global L2 norm does not exceed the
+   * threshold:
+   *   xs[i] *= min(1, threshold / sqrt(sq_norm))
+   * @param threshold Upper bound of the norm.
+   * @param sq_norm A scalar tensor that holds the squared norm of `xs`, e.g.
+   *                the result of `squared_norm()`.
+   * @param xs Tensors to be updated.
+   */
+  void inplace_clip_by_norm(
+      float threshold, const Tensor &sq_norm, const std::vector<Tensor *> &xs);
+
 private:
+  class StatisticsRecorder;
+  class OpScope;
+
+  /**
+   * Allocates a new memory for the tensor and records it.
+   * @param shape Shape of the tensor.
+   * @return Handle of the new memory.
+   */
+  std::shared_ptr<void> allocate(const Shape &shape);
+
   /**
    * Retrieves internal values of the tensor as a vector.
    * @param x A tensor.
@@ -233,6 +581,15 @@ private:
    */
   std::vector<unsigned> argmin(const Tensor &x, unsigned dim);
 
+  /**
+   * Checks arguments of the fused elementwise operation.
+   * @param xs Input tensors.
+   * @param prog Program to calculate.
+   * @return Shape of the result.
+   */
+  Shape elementwise_fw_shape(
+      const std::vector<const Tensor *> &xs, const elementwise::Program &prog);
+
 protected:
   /**
    * Reset internal values of the tensor using a constant.
@@ -359,15 +716,48 @@ private:
       const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
       Tensor &ga, Tensor &gb) = 0;
 
+  // NOTE: Default implementations calculate each instruction using
+  // other operations.
+  virtual void elementwise_fw_impl(
+      const std::vector<const Tensor *> &xs, const elementwise::Program &prog,
+      Tensor &y);
+  virtual void elementwise_bw_impl(
+      const std::vector<const Tensor *> &xs, const Tensor &y, const Tensor &gy,
+      const elementwise::Program &prog, const std::vector<Tensor *> &gxs);
+
   virtual void sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) = 0;
   virtual void logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) = 0;
   virtual void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) = 0;
   virtual void batch_sum_fw_impl(const Tensor &x, Tensor &y) = 0;
 
+  virtual void logsumexp_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+
+  virtual void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) = 0;
+  virtual void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) = 0;
+  virtual void softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) = 0;
+
+  virtual void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+  virtual void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+  virtual void softmax_cross_entropy_bw_impl(const Tensor &x, const std::vector<unsigned> &ids, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) = 0;
+
   virtual void inplace_multiply_const_impl(float k, Tensor &x) = 0;
 
   virtual void inplace_add_impl(const Tensor &x, Tensor &y) = 0;
   virtual void inplace_subtract_impl(const Tensor &x, Tensor &y) = 0;
+  virtual void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) = 0;
+
+  virtual void sgd_update_impl(float eta, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs) = 0;
+  virtual void momentum_sgd_update_impl(float eta, float momentum, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) = 0;
+  virtual void adagrad_update_impl(float eta, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) = 0;
+  virtual void rmsprop_update_impl(float eta, float alpha, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) = 0;
+  virtual void adadelta_update_impl(float scale, float rho, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) = 0;
+  virtual void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) = 0;
+
+  virtual void squared_norm_impl(const std::vector<const Tensor *> &xs, Tensor &y) = 0;
+  virtual void inplace_clip_by_norm_impl(float threshold, const Tensor &sq_norm, const std::vector<Tensor *> &xs) = 0;
+
+  bool profiling_;
+  std::shared_ptr<StatisticsRecorder> stats_;
 };
 
 }  // namespace primitiv
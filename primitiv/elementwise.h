@@ -0,0 +1,107 @@
+#ifndef PRIMITIV_ELEMENTWISE_H_
+#define PRIMITIV_ELEMENTWISE_H_
+
+#include <vector>
+
+namespace primitiv {
+
+/**
+ * Description of fused elementwise calculations.
+ *
+ * A Program is a list of Instructions which operate on virtual registers.
+ * Registers `[0, num_inputs)` hold the input values, and the `i`-th
+ * instruction writes its result to the register `num_inputs + i`. The result
+ * of the program is the value of the last register.
+ * All registers except inputs have the shape of the result. Inputs may have
+ * the batch size 1 or may be scalars, and such inputs are broadcasted.
+ */
+namespace elementwise {
+
+/**
+ * Operation of each instruction.
+ * Each operation calculates `y` from the first argument `a`, the second
+ * argument `b` and the constant `k`:
+ *   POSITIVE .......... y = a
+ *   NEGATIVE .......... y = -a
+ *   SQRT .............. y = sqrt(a)
+ *   EXP ............... y = exp(a)
+ *   LOG ............... y = log(a)
+ *   TANH .............. y = tanh(a)
+ *   SIGMOID ........... y = sigmoid(a)
+ *   SOFTPLUS .......... y = softplus(a)
+ *   SIN ............... y = sin(a)
+ *   COS ............... y = cos(a)
+ *   TAN ............... y = tan(a)
+ *   ADD_CONST ......... y = a + k
+ *   SUBTRACT_CONST_R .. y = a - k
+ *   SUBTRACT_CONST_L .. y = k - a
+ *   MULTIPLY_CONST .... y = a * k
+ *   DIVIDE_CONST_R .... y = a / k
+ *   DIVIDE_CONST_L .... y = k / a
+ *   PRELU ............. y = prelu(a, k)
+ *   ELU ............... y = elu(a, k)
+ *   ADD ............... y = a + b
+ *   SUBTRACT .......... y = a - b
+ *   MULTIPLY .......... y = a * b
+ *   DIVIDE ............ y = a / b
+ */
+enum Opcode {
+  POSITIVE,
+  NEGATIVE,
+  SQRT,
+  EXP,
+  LOG,
+  TANH,
+  SIGMOID,
+  SOFTPLUS,
+  SIN,
+  COS,
+  TAN,
+  ADD_CONST,
+  SUBTRACT_CONST_R,
+  SUBTRACT_CONST_L,
+  MULTIPLY_CONST,
+  DIVIDE_CONST_R,
+  DIVIDE_CONST_L,
+  PRELU,
+  ELU,
+  ADD,
+  SUBTRACT,
+  MULTIPLY,
+  DIVIDE,
+};
+
+/**
+ * Returns whether the operation uses the second argument or not.
+ * @param opcode An operation.
+ * @return true if the operation is binary, false otherwise.
+ */
+inline bool is_binary(Opcode opcode) { return opcode >= ADD; }
+
+/**
+ * One step of the fused calculation.
+ */
+struct Instruction {
+  Opcode opcode;
+  float k;
+  unsigned args[2];
+};
+
+/**
+ * Sequence of instructions.
+ */
+struct Program {
+  unsigned num_inputs;
+  std::vector<Instruction> code;
+
+  /**
+   * Returns the number of registers used by the program.
+   * @return Number of registers.
+   */
+  unsigned num_registers() const { return num_inputs + code.size(); }
+};
+
+}  // namespace elementwise
+}  // namespace primitiv
+
+#endif  // PRIMITIV_ELEMENTWISE_H_
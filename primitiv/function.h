@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <primitiv/elementwise.h>
 #include <primitiv/mixins.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
@@ -43,6 +44,70 @@ public:
    */
   virtual const Tensor *get_inner_value() const { return nullptr; }
 
+  /**
+   * Returns the tensor to accumulate the gradient of the function directly if
+   * the function has it.
+   * @param sink A function that uses the value of this function.
+   * @param arg Argument index of this function in `sink`.
+   * @return A pointer of the Tensor which holds the gradient, or nullptr if
+   *         the function does not have such data.
+   * @remarks If this function returns non-nullptr, Graph::backward() passes
+   *          the tensor to `sink.backward()` instead of a temporary gradient.
+   */
+  virtual Tensor *get_inner_gradient(
+      const Function &sink, unsigned arg) const { return nullptr; }
+
+  /**
+   * Retrieves the slices of an argument gradient updated by backward().
+   * @param arg Index of the argument.
+   * @param dim Updated with the dimension of the slices.
+   * @return A pointer of the list of slice indices along `dim`, or nullptr if
+   *         backward() may update any elements of the gradient.
+   */
+  virtual const std::vector<unsigned> *get_gradient_slices(
+      unsigned arg, unsigned &dim) const { return nullptr; }
+
+  /**
+   * Returns whether the function always returns the same value for the same
+   * arguments or not.
+   * @return true if the function is deterministic, false otherwise.
+   * @remarks Graph never discards the values of non-deterministic functions
+   *          because they can not be recalculated.
+   */
+  virtual bool is_deterministic() const { return true; }
+
+  /**
+   * Returns whether the function consumes its own gradient or not.
+   * @return true if the function uses the gradient for its own purpose, e.g.,
+   *         accumulating the gradient of a trainable parameter, false
+   *         otherwise.
+   * @remarks Graph::backward() propagates gradients only to the functions
+   *          which have at least one such function in their arguments or
+   *          ancestors.
+   */
+  virtual bool requires_grad() const { return false; }
+
+  /**
+   * Retrieves the elementwise operation of the function if it has it.
+   * @param inst Instruction to be updated. `inst.args` are filled by indices
+   *             of the arguments of the function.
+   * @return true if the function is an elementwise operation and `inst` is
+   *         updated, false otherwise.
+   * @remarks Graph uses this information to fuse elementwise functions.
+   */
+  virtual bool get_elementwise_instruction(
+      elementwise::Instruction &inst) const { return false; }
+
+  /**
+   * Checks whether the function can be calculated together with another
+   * function by concatenating their arguments along the minibatch.
+   * @param other Another function.
+   * @return true if both functions calculate each sample of the minibatch
+   *         independently using the same operation, false otherwise.
+   * @remarks Graph uses this information to batch functions automatically.
+   */
+  virtual bool can_batch_with(const Function &other) const { return false; }
+
   /**
    * Calculates the forward path.
    * @param args argument tensors.
@@ -58,7 +123,9 @@ public:
    * @param cur_grad The gradient of the current node.
    * @param arg_values Values of the argument nodes.
    * @param arg_grads Gradients of the argument nodes. These values are updated
-   *                  by this method.
+   *                  by this method. Each element may be nullptr if the
+   *                  gradient of the argument is not required, and at least
+   *                  one element is not nullptr.
    */
   virtual void backward(
       const Tensor &cur_value,
@@ -23,15 +23,19 @@ namespace functions {
 
 Input::Input(const Shape &shape, const vector<float> &data, Device &device)
 : shape_(shape)
-, data_(data)
 , device_(device) {
-  if (data_.size() != shape_.size()) {
+  reset_data(data);
+}
+
+void Input::reset_data(const vector<float> &data) {
+  if (data.size() != shape_.size()) {
     THROW_ERROR(
         "Data sizes mismatched."
         << " function: Input"
         << ", required: " << shape_.size() << " (" << shape_.to_string() << ")"
-        << ", actual: " << data_.size());
+        << ", actual: " << data.size());
   }
+  data_ = data;
 }
 
 Shape Input::forward_shape(const vector<const Shape *> &args) const {
@@ -63,7 +67,14 @@ Tensor ParameterInput::forward(const vector<const Tensor *> &args) {
 void ParameterInput::backward(
     const Tensor &, const Tensor &cur_grad,
     const vector<const Tensor *> &, const vector<Tensor *> &) const {
-  param_.gradient() += cur_grad;
+  param_.dense_gradient() += cur_grad;
+}
+
+Tensor *ParameterInput::get_inner_gradient(
+    const Function &sink, unsigned arg) const {
+  unsigned dim = 0;
+  const vector<unsigned> *ids = sink.get_gradient_slices(arg, dim);
+  return ids ? &param_.gradient(dim, *ids) : &param_.dense_gradient();
 }
 
 Shape Copy::forward_shape(const vector<const Shape *> &args) const {
@@ -222,9 +233,9 @@ void Concat::backward(
     const Tensor &y, const Tensor &gy,
     const vector<const Tensor *> &x, const vector<Tensor *> &gx) const {
   unsigned offset = 0;
-  for (Tensor *gxi : gx) {
-    const unsigned span = gxi->shape()[dim_];
-    *gxi += operators::slice(gy, dim_, offset, offset + span);
+  for (unsigned i = 0; i < x.size(); ++i) {
+    const unsigned span = x[i]->shape()[dim_];
+    if (gx[i]) *gx[i] += operators::slice(gy, dim_, offset, offset + span);
     offset += span;
   }
 }
@@ -290,8 +301,29 @@ FWD_SHAPE_ELEMENTWISE(Multiply);
 FWD_SHAPE_ELEMENTWISE(Divide);
 
 #undef FWD_SHAPE_UNARY
+#undef FWD_SHAPE_SCALAR
 #undef FWD_SHAPE_ELEMENTWISE
 
+Shape Elementwise::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, prog_.num_inputs);
+  return shape_;
+}
+
+std::string Elementwise::name() const {
+  static const char *OPCODE_NAMES[] = {
+    "Positive", "Negative", "Sqrt", "Exp", "Log", "Tanh", "Sigmoid",
+    "Softplus", "Sin", "Cos", "Tan", "AddConst", "SubtractConstR",
+    "SubtractConstL", "MultiplyConst", "DivideConstR", "DivideConstL", "PReLU",
+    "ELU", "Add", "Subtract", "Multiply", "Divide",
+  };
+  std::string ret = "Elementwise(";
+  for (unsigned i = 0; i < prog_.code.size(); ++i) {
+    if (i > 0) ret += ',';
+    ret += OPCODE_NAMES[prog_.code[i].opcode];
+  }
+  return ret + ')';
+}
+
 Shape Transpose::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::transpose(*args[0]);
@@ -312,6 +344,16 @@ Shape LogSumExp::forward_shape(const vector<const Shape *> &args) const {
   return args[0]->resize_dim(dim_, 1);
 }
 
+Shape Softmax::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 1);
+  return *args[0];
+}
+
+Shape LogSoftmax::forward_shape(const vector<const Shape *> &args) const {
+  CHECK_ARGNUM(args, 1);
+  return *args[0];
+}
+
 Shape Broadcast::forward_shape(const vector<const Shape *> &args) const {
   CHECK_ARGNUM(args, 1);
   return shape_ops::broadcast(*args[0], dim_, size_);
@@ -377,11 +419,15 @@ FORWARD(Subtract) { return *x[0] - *x[1]; }
 FORWARD(Multiply) { return *x[0] * *x[1]; }
 FORWARD(Divide) { return *x[0] / *x[1]; }
 
+FORWARD(Elementwise) { return x[0]->device().elementwise_fw(x, prog_); }
+
 FORWARD(Transpose) { return operators::transpose(*x[0]); }
 FORWARD(MatrixMultiply) { return operators::matmul(*x[0], *x[1]); }
 
 FORWARD(Sum) { return operators::sum(*x[0], dim_); }
 FORWARD(LogSumExp) { return operators::logsumexp(*x[0], dim_); }
+FORWARD(Softmax) { return operators::softmax(*x[0], dim_); }
+FORWARD(LogSoftmax) { return operators::log_softmax(*x[0], dim_); }
 FORWARD(Broadcast) { return operators::broadcast(*x[0], dim_, size_); }
 
 FORWARD(BatchSum) { return operators::batch::sum(*x[0]); }
@@ -390,12 +436,7 @@ FORWARD(SoftmaxCrossEntropy) {
   return operators::softmax_cross_entropy(*x[0], *x[1], dim_);
 }
 FORWARD(SparseSoftmaxCrossEntropy) {
-#ifdef PRIMITIV_USE_CACHE
-  log_softmax_x_ = operators::log_softmax(*x[0], dim_);
-  return operators::pick(-log_softmax_x_, ids_, dim_);
-#else
   return operators::softmax_cross_entropy(*x[0], ids_, dim_);
-#endif  // PRIMITIV_USE_CACHE
 }
 
 #undef FORWARD
@@ -436,45 +477,96 @@ BACKWARD(PReLU) { gy.device().prelu_bw(*x[0], y, gy, k_, *gx[0]); }
 BACKWARD(ELU) { gy.device().elu_bw(*x[0], y, gy, k_, *gx[0]); }
 
 BACKWARD(AddScalar) {
-  *gx[0] += gy;
-  *gx[1] += operators::sum(gy.flatten(), 0);
+  if (gx[0]) *gx[0] += gy;
+  if (gx[1]) *gx[1] += operators::sum(gy.flatten(), 0);
 }
 BACKWARD(SubtractScalarR) {
-  *gx[0] += gy;
-  *gx[1] -= operators::sum(gy.flatten(), 0);
+  if (gx[0]) *gx[0] += gy;
+  if (gx[1]) *gx[1] -= operators::sum(gy.flatten(), 0);
 }
 BACKWARD(SubtractScalarL) {
-  *gx[0] -= gy;
-  *gx[1] += operators::sum(gy.flatten(), 0);
+  if (gx[0]) *gx[0] -= gy;
+  if (gx[1]) *gx[1] += operators::sum(gy.flatten(), 0);
 }
 BACKWARD(MultiplyScalar) {
-  *gx[0] += *x[1] * gy;
-  *gx[1] += operators::sum((*x[0] * gy).flatten(), 0);
+  if (gx[0]) *gx[0] += *x[1] * gy;
+  if (gx[1]) *gx[1] += operators::sum((*x[0] * gy).flatten(), 0);
 }
 BACKWARD(DivideScalarR) {
   const Tensor a = gy / *x[1];
-  *gx[0] += a;
-  *gx[1] -= operators::sum((a * y).flatten(), 0);
+  if (gx[0]) *gx[0] += a;
+  if (gx[1]) *gx[1] -= operators::sum((a * y).flatten(), 0);
 }
 BACKWARD(DivideScalarL) {
   const Tensor a = gy / *x[0];
-  *gx[0] -= a * y;
-  *gx[1] += operators::sum(a.flatten(), 0);
+  if (gx[0]) *gx[0] -= a * y;
+  if (gx[1]) *gx[1] += operators::sum(a.flatten(), 0);
+}
+
+// NOTE:
+// Device kernels of binary operations calculate gradients of both arguments
+// at once. If only one of them is required, the other is calculated alone.
+// Gradients with the batch size 1 are summed up over the minibatch by +=.
+
+BACKWARD(Add) {
+  if (!gx[1]) *gx[0] += gy;
+  else if (!gx[0]) *gx[1] += gy;
+  else gy.device().add_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]);
+}
+BACKWARD(Subtract) {
+  if (!gx[1]) *gx[0] += gy;
+  else if (!gx[0]) *gx[1] -= gy;
+  else gy.device().subtract_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]);
+}
+BACKWARD(Multiply) {
+  if (!gx[1]) *gx[0] += gy * *x[1];
+  else if (!gx[0]) *gx[1] += gy * *x[0];
+  else gy.device().multiply_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]);
+}
+BACKWARD(Divide) {
+  if (!gx[1]) *gx[0] += gy / *x[1];
+  else if (!gx[0]) *gx[1] -= gy * y / *x[1];
+  else gy.device().divide_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]);
+}
+BACKWARD(MatrixMultiply) {
+  // NOTE:
+  // A single product is used if it has the shape of the required gradient.
+  // Otherwise, the product makes the gradient of each minibatch, and the
+  // device kernel is used instead to calculate the sum over the minibatch.
+  const Tensor &a = *x[0];
+  const Tensor &b = *x[1];
+  const bool has_batch = gy.shape().has_batch();
+  if (!gx[1] && (a.shape().has_batch() || !has_batch)) {
+    *gx[0] += operators::matmul(gy, operators::transpose(b));
+  } else if (!gx[0] && (b.shape().has_batch() || !has_batch)) {
+    *gx[1] += operators::matmul(operators::transpose(a), gy);
+  } else {
+    Tensor tmp;
+    if (!gx[0] || !gx[1]) tmp = gy.device().new_tensor(x[!gx[1]]->shape(), 0);
+    gy.device().matmul_bw(
+        a, b, y, gy, gx[0] ? *gx[0] : tmp, gx[1] ? *gx[1] : tmp);
+  }
 }
 
-BACKWARD(Add) { gy.device().add_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]); }
-BACKWARD(Subtract) { gy.device().subtract_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]); }
-BACKWARD(Multiply) { gy.device().multiply_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]); }
-BACKWARD(Divide) { gy.device().divide_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]); }
-BACKWARD(MatrixMultiply) { gy.device().matmul_bw(*x[0], *x[1], y, gy, *gx[0], *gx[1]); }
+BACKWARD(Elementwise) {
+  // NOTE:
+  // The fused kernel calculates gradients of all arguments in one pass.
+  // Unnecessary gradients are written to temporary tensors.
+  vector<Tensor> tmp(gx.size());
+  vector<Tensor *> gx2(gx);
+  for (unsigned i = 0; i < gx.size(); ++i) {
+    if (!gx2[i]) {
+      tmp[i] = gy.device().new_tensor(x[i]->shape(), 0);
+      gx2[i] = &tmp[i];
+    }
+  }
+  gy.device().elementwise_bw(x, y, gy, prog_, gx2);
+}
 
 BACKWARD(Sum) { *gx[0] += operators::broadcast(gy, dim_, x[0]->shape()[dim_]); }
-BACKWARD(LogSumExp) {
-  // NOTE(odashi): dy/dx = softmax(x) = exp(x - y)
-  const unsigned n = x[0]->shape()[dim_];
-  *gx[0] +=
-    operators::exp(*x[0] - operators::broadcast(y, dim_, n)) * operators::broadcast(gy, dim_, n);
-}
+BACKWARD(LogSumExp) { gy.device().logsumexp_bw(*x[0], y, gy, dim_, *gx[0]); }
+BACKWARD(Softmax) { gy.device().softmax_bw(*x[0], y, gy, dim_, *gx[0]); }
+BACKWARD(LogSoftmax) { gy.device().log_softmax_bw(*x[0], y, gy, dim_, *gx[0]); }
 BACKWARD(Broadcast) { *gx[0] += operators::sum(gy, dim_); }
 
 BACKWARD(BatchSum) { *gx[0] += gy; }
@@ -482,21 +574,13 @@ BACKWARD(BatchSum) { *gx[0] += gy; }
 BACKWARD(SoftmaxCrossEntropy) {
   const Tensor log_softmax_x = operators::log_softmax(*x[0], dim_);
   const Tensor bcast_gy = operators::broadcast(gy, dim_, x[0]->shape()[dim_]);
-  *gx[0] += (operators::exp(log_softmax_x) - *x[1]) * bcast_gy;
-  *gx[1] -= log_softmax_x * bcast_gy;
+  if (gx[0]) *gx[0] += (operators::exp(log_softmax_x) - *x[1]) * bcast_gy;
+  if (gx[1]) *gx[1] -= log_softmax_x * bcast_gy;
 }
 
 BACKWARD(SparseSoftmaxCrossEntropy) {
   // dE/dx = gy * (softmax(x) - delta(x, i))
-  //       = gy * softmax(x) - gy * delta(x, i)
-#ifdef PRIMITIV_USE_CACHE
-  *gx[0] +=
-    operators::exp(log_softmax_x_) * operators::broadcast(gy, dim_, x[0]->shape()[dim_]);
-#else
-  *gx[0] +=
-    operators::softmax(*x[0], dim_) * operators::broadcast(gy, dim_, x[0]->shape()[dim_]);
-#endif  // PRIMITIV_USE_CACHE
-  gy.device().pick_bw(-gy, ids_, dim_, *gx[0]);
+  gy.device().softmax_cross_entropy_bw(*x[0], ids_, y, gy, dim_, *gx[0]);
 }
 
 #undef BACKWARD
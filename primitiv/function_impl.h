@@ -26,12 +26,26 @@ public: \
 private: \
   name_() = delete;
 
+// `cond_` may access the other function through `o`.
+#define BATCHABLE_IF(name_, cond_) \
+public: \
+  bool can_batch_with(const Function &other) const override { \
+    const name_ *o = dynamic_cast<const name_ *>(&other); \
+    return o && (cond_); \
+  }
+
 class Input : public primitiv::Function {
   NO_CTOR_CLASS_DECL(Input);
 public:
   Input(const Shape &shape, const std::vector<float> &data, Device &device);
   Device *get_device() const override { return &device_; }
   std::string name() const override { return "Input"; }
+
+  /**
+   * Replaces the data of the input.
+   * @param data New data. The size should be equal to that of the old data.
+   */
+  void reset_data(const std::vector<float> &data);
 private:
   Shape shape_;
   std::vector<float> data_;
@@ -44,6 +58,9 @@ public:
   explicit ParameterInput(Parameter &param) : param_(param) {}
   Device *get_device() const override { return &param_.device(); }
   const Tensor *get_inner_value() const override { return &param_.value(); }
+  Tensor *get_inner_gradient(
+      const Function &sink, unsigned arg) const override;
+  bool requires_grad() const override { return !param_.is_frozen(); }
   std::string name() const override { return "ParameterInput"; }
 private:
   primitiv::Parameter &param_;
@@ -94,6 +111,7 @@ public:
   RandomBernoulli(const Shape &shape, float p, Device &device)
     : shape_(shape), p_(p), device_(device) {}
   Device *get_device() const override { return &device_; }
+  bool is_deterministic() const override { return false; }
   std::string name() const override {
     return "RandomBernoulli(" + std::to_string(p_) + ')';
   }
@@ -109,6 +127,7 @@ public:
   RandomUniform(const Shape &shape, float lower, float upper, Device &device)
     : shape_(shape), lower_(lower), upper_(upper), device_(device) {}
   Device *get_device() const override { return &device_; }
+  bool is_deterministic() const override { return false; }
   std::string name() const override {
     return
       "RandomUniform(" + std::to_string(lower_) + ',' +
@@ -127,6 +146,7 @@ public:
   RandomNormal(const Shape &shape, float mean, float sd, Device &device)
     : shape_(shape), mean_(mean), sd_(sd), device_(device) {}
   Device *get_device() const override { return &device_; }
+  bool is_deterministic() const override { return false; }
   std::string name() const override {
     return
       "RandomNormal(" + std::to_string(mean_) + ',' +
@@ -145,6 +165,7 @@ public:
   RandomLogNormal(const Shape &shape, float mean, float sd, Device &device)
     : shape_(shape), mean_(mean), sd_(sd), device_(device) {}
   Device *get_device() const override { return &device_; }
+  bool is_deterministic() const override { return false; }
   std::string name() const override {
     return
       "RandomLogNormal(" + std::to_string(mean_) + ',' +
@@ -162,6 +183,11 @@ class Pick : public primitiv::Function {
 public:
   Pick(const std::vector<unsigned> &ids, unsigned dim)
     : ids_(ids), dim_(dim) {}
+  const std::vector<unsigned> *get_gradient_slices(
+      unsigned arg, unsigned &dim) const override {
+    dim = dim_;
+    return &ids_;
+  }
   std::string name() const override {
     return "Pick(" + std::to_string(dim_) + ')';
   };
@@ -172,6 +198,8 @@ private:
 
 class Slice : public primitiv::Function {
   NO_CTOR_CLASS_DECL(Slice);
+  BATCHABLE_IF(
+      Slice, o->dim_ == dim_ && o->lower_ == lower_ && o->upper_ == upper_);
 public:
   Slice(unsigned dim, unsigned lower, unsigned upper)
     : dim_(dim), lower_(lower), upper_(upper) {}
@@ -187,6 +215,7 @@ private:
 
 class Concat : public primitiv::Function {
   NO_CTOR_CLASS_DECL(Concat);
+  BATCHABLE_IF(Concat, o->dim_ == dim_);
 public:
   Concat(unsigned dim) : dim_(dim) {}
   std::string name() const override {
@@ -198,6 +227,7 @@ private:
 
 class Reshape : public primitiv::Function {
   NO_CTOR_CLASS_DECL(Reshape);
+  BATCHABLE_IF(Reshape, o->shape_ == shape_ && !shape_.has_batch());
 public:
   explicit Reshape(const Shape &shape) : shape_(shape) {}
   std::string name() const override {
@@ -209,6 +239,7 @@ private:
 
 class Sum : public Function {
   NO_CTOR_CLASS_DECL(Sum);
+  BATCHABLE_IF(Sum, o->dim_ == dim_);
 public:
   explicit Sum(unsigned dim) : dim_(dim) {}
   std::string name() const override {
@@ -220,6 +251,7 @@ private:
 
 class LogSumExp : public Function {
   NO_CTOR_CLASS_DECL(LogSumExp);
+  BATCHABLE_IF(LogSumExp, o->dim_ == dim_);
 public:
   explicit LogSumExp(unsigned dim) : dim_(dim) {}
   std::string name() const override {
@@ -229,8 +261,33 @@ private:
   unsigned dim_;
 };
 
+class Softmax : public Function {
+  NO_CTOR_CLASS_DECL(Softmax);
+  BATCHABLE_IF(Softmax, o->dim_ == dim_);
+public:
+  explicit Softmax(unsigned dim) : dim_(dim) {}
+  std::string name() const override {
+    return "Softmax(" + std::to_string(dim_) + ')';
+  }
+private:
+  unsigned dim_;
+};
+
+class LogSoftmax : public Function {
+  NO_CTOR_CLASS_DECL(LogSoftmax);
+  BATCHABLE_IF(LogSoftmax, o->dim_ == dim_);
+public:
+  explicit LogSoftmax(unsigned dim) : dim_(dim) {}
+  std::string name() const override {
+    return "LogSoftmax(" + std::to_string(dim_) + ')';
+  }
+private:
+  unsigned dim_;
+};
+
 class Broadcast : public Function {
   NO_CTOR_CLASS_DECL(Broadcast);
+  BATCHABLE_IF(Broadcast, o->dim_ == dim_ && o->size_ == size_);
 public:
   Broadcast(unsigned dim, unsigned size) : dim_(dim), size_(size) {}
   std::string name() const override {
@@ -244,6 +301,7 @@ private:
 
 class SoftmaxCrossEntropy : public Function {
   NO_CTOR_CLASS_DECL(SoftmaxCrossEntropy);
+  BATCHABLE_IF(SoftmaxCrossEntropy, o->dim_ == dim_);
 public:
   explicit SoftmaxCrossEntropy(unsigned dim) : dim_(dim) {}
   std::string name() const override {
@@ -264,7 +322,18 @@ public:
 private:
   std::vector<unsigned> ids_;
   unsigned dim_;
-  Tensor log_softmax_x_;  // Only used when PRIMITIV_USE_CACHE=ON
+};
+
+class Elementwise : public Function {
+  NO_CTOR_CLASS_DECL(Elementwise);
+public:
+  Elementwise(const Shape &shape, const elementwise::Program &prog)
+    : shape_(shape), prog_(prog) {}
+  std::string name() const override;
+  const elementwise::Program &program() const { return prog_; }
+private:
+  Shape shape_;
+  elementwise::Program prog_;
 };
 
 // Function with no parameter.
@@ -289,51 +358,101 @@ private:
     float k_; \
   }
 
-DECL_FUNC(Flatten);
-
-DECL_FUNC(Positive);
-DECL_FUNC(Negative);
-
-DECL_FUNC_K(AddConst);
-DECL_FUNC_K(SubtractConstR);
-DECL_FUNC_K(SubtractConstL);
-DECL_FUNC_K(MultiplyConst);
-DECL_FUNC_K(DivideConstR);
-DECL_FUNC_K(DivideConstL);
-DECL_FUNC_K(PReLU);
-DECL_FUNC_K(ELU);
-
-DECL_FUNC(AddScalar);
-DECL_FUNC(SubtractScalarR);
-DECL_FUNC(SubtractScalarL);
-DECL_FUNC(MultiplyScalar);
-DECL_FUNC(DivideScalarR);
-DECL_FUNC(DivideScalarL);
-
-DECL_FUNC(Add);
-DECL_FUNC(Subtract);
-DECL_FUNC(Multiply);
-DECL_FUNC(Divide);
-
-DECL_FUNC(Transpose);
-DECL_FUNC(MatrixMultiply);
-
-DECL_FUNC(Sqrt);
-DECL_FUNC(Exp);
-DECL_FUNC(Log);
-DECL_FUNC(Tanh);
-DECL_FUNC(Sigmoid);
-DECL_FUNC(Softplus);
-DECL_FUNC(Sin);
-DECL_FUNC(Cos);
-DECL_FUNC(Tan);
-DECL_FUNC(ReLU);
-DECL_FUNC(LReLU);
+// Function with no parameter which calculates each sample independently.
+#define DECL_FUNC_B(name_) \
+  class name_ : public Function { \
+    DEFAULT_CLASS_DECL(name_); \
+    BATCHABLE_IF(name_, true); \
+  public: \
+    name_() {} \
+    std::string name() const override { return #name_; } \
+  }
+
+// Elementwise function with no parameter.
+#define DECL_FUNC_EW(name_, opcode_, k_, a_, b_) \
+  class name_ : public Function { \
+    DEFAULT_CLASS_DECL(name_); \
+    BATCHABLE_IF(name_, true); \
+  public: \
+    name_() {} \
+    std::string name() const override { return #name_; } \
+    bool get_elementwise_instruction( \
+        elementwise::Instruction &inst) const override { \
+      inst = { elementwise::opcode_, k_, { a_, b_ } }; \
+      return true; \
+    } \
+  }
+
+// Elementwise function with a constant.
+#define DECL_FUNC_K_EW(name_, opcode_) \
+  class name_ : public Function { \
+    NO_CTOR_CLASS_DECL(name_); \
+    BATCHABLE_IF(name_, o->k_ == k_); \
+  public: \
+    explicit name_(float  k) : k_(k) {} \
+    std::string name() const override { \
+      return #name_"(" + std::to_string(k_) + ')'; \
+    } \
+    bool get_elementwise_instruction( \
+        elementwise::Instruction &inst) const override { \
+      inst = { elementwise::opcode_, k_, { 0, 0 } }; \
+      return true; \
+    } \
+  private: \
+    float k_; \
+  }
+
+DECL_FUNC_B(Flatten);
+
+DECL_FUNC_EW(Positive, POSITIVE, 0, 0, 0);
+DECL_FUNC_EW(Negative, NEGATIVE, 0, 0, 0);
+
+DECL_FUNC_K_EW(AddConst, ADD_CONST);
+DECL_FUNC_K_EW(SubtractConstR, SUBTRACT_CONST_R);
+DECL_FUNC_K_EW(SubtractConstL, SUBTRACT_CONST_L);
+DECL_FUNC_K_EW(MultiplyConst, MULTIPLY_CONST);
+DECL_FUNC_K_EW(DivideConstR, DIVIDE_CONST_R);
+DECL_FUNC_K_EW(DivideConstL, DIVIDE_CONST_L);
+DECL_FUNC_K_EW(PReLU, PRELU);
+DECL_FUNC_K_EW(ELU, ELU);
+
+// NOTE: Scalar operations are elementwise operations with a
+// broadcasted scalar argument, and "L" variants swap their arguments.
+DECL_FUNC_EW(AddScalar, ADD, 0, 0, 1);
+DECL_FUNC_EW(SubtractScalarR, SUBTRACT, 0, 0, 1);
+DECL_FUNC_EW(SubtractScalarL, SUBTRACT, 0, 1, 0);
+DECL_FUNC_EW(MultiplyScalar, MULTIPLY, 0, 0, 1);
+DECL_FUNC_EW(DivideScalarR, DIVIDE, 0, 0, 1);
+DECL_FUNC_EW(DivideScalarL, DIVIDE, 0, 1, 0);
+
+DECL_FUNC_EW(Add, ADD, 0, 0, 1);
+DECL_FUNC_EW(Subtract, SUBTRACT, 0, 0, 1);
+DECL_FUNC_EW(Multiply, MULTIPLY, 0, 0, 1);
+DECL_FUNC_EW(Divide, DIVIDE, 0, 0, 1);
+
+DECL_FUNC_B(Transpose);
+DECL_FUNC_B(MatrixMultiply);
+
+DECL_FUNC_EW(Sqrt, SQRT, 0, 0, 0);
+DECL_FUNC_EW(Exp, EXP, 0, 0, 0);
+DECL_FUNC_EW(Log, LOG, 0, 0, 0);
+DECL_FUNC_EW(Tanh, TANH, 0, 0, 0);
+DECL_FUNC_EW(Sigmoid, SIGMOID, 0, 0, 0);
+DECL_FUNC_EW(Softplus, SOFTPLUS, 0, 0, 0);
+DECL_FUNC_EW(Sin, SIN, 0, 0, 0);
+DECL_FUNC_EW(Cos, COS, 0, 0, 0);
+DECL_FUNC_EW(Tan, TAN, 0, 0, 0);
+DECL_FUNC_EW(ReLU, PRELU, 0, 0, 0);
+DECL_FUNC_EW(LReLU, PRELU, .01, 0, 0);
 
 DECL_FUNC(BatchSum);
 
 #undef DECL_FUNC
 #undef DECL_FUNC_K
+#undef DECL_FUNC_B
+#undef DECL_FUNC_EW
+#undef DECL_FUNC_K_EW
+#undef BATCHABLE_IF
 #undef NO_CTOR_CLASS_DECL
 #undef DEFAULT_CLASS_DECL
 
@@ -0,0 +1,355 @@
+#include <config.h>
+
+#include <algorithm>
+#include <vector>
+#include <primitiv/error.h>
+#include <primitiv/gemm.h>
+#include <primitiv/thread_pool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PRIMITIV_GEMM_X86
+#endif
+
+/*
+ * NOTE:
+ * The blocking scheme follows the BLIS/GotoBLAS design:
+ *
+ *   for jc in [0, n) by NC:         B block (KC x NC) lives in L3
+ *     for pc in [0, k) by KC:       packs B into NR-column panels
+ *       for ic in [0, m) by MC:     A block (MC x KC) lives in L2
+ *         packs A into MR-row panels
+ *         for jr in [0, NC) by NR:  B panel (KC x NR) lives in L1
+ *           for ir in [0, MC) by MR:
+ *             micro-kernel: C[MR x NR] (+)= A panel . B panel
+ *
+ * Each micro-kernel keeps the whole MR x NR tile of C in registers.
+ */
+
+namespace {
+
+using primitiv::cpu_features::Isa;
+
+const unsigned KC = 256;
+const unsigned MC = 128;
+const unsigned NC = 4096;
+
+// Products smaller than this number of multiply-adds skip packing.
+const unsigned SMALL_GEMM_THRESHOLD = 32 * 32 * 32;
+
+// Signature of micro-kernels.
+// Calculates `C[mr x nr] (+)= A panel . B panel`, where the tile is written
+// directly when `mr == MR && nr == NR`.
+using MicroKernel = void (*)(
+    unsigned kc, const float *pa, const float *pb,
+    float *c, unsigned ldc, unsigned mr, unsigned nr, bool accumulate);
+
+struct KernelInfo {
+  unsigned mr;
+  unsigned nr;
+  MicroKernel kernel;
+};
+
+// Writes a partial tile stored in column-major order.
+inline void store_tile(
+    const float *tile, unsigned ld_tile,
+    float *c, unsigned ldc, unsigned mr, unsigned nr, bool accumulate) {
+  for (unsigned j = 0; j < nr; ++j) {
+    const float *src = tile + j * ld_tile;
+    float *dest = c + j * ldc;
+    if (accumulate) {
+      for (unsigned i = 0; i < mr; ++i) dest[i] += src[i];
+    } else {
+      for (unsigned i = 0; i < mr; ++i) dest[i] = src[i];
+    }
+  }
+}
+
+// Portable micro-kernel, vectorized by the compiler if possible.
+void kernel_generic(
+    unsigned kc, const float *pa, const float *pb,
+    float *c, unsigned ldc, unsigned mr, unsigned nr, bool accumulate) {
+  const unsigned MR = 8;
+  const unsigned NR = 4;
+  float tile[MR * NR] = {};
+  for (unsigned p = 0; p < kc; ++p) {
+    for (unsigned j = 0; j < NR; ++j) {
+      const float bj = pb[j];
+      for (unsigned i = 0; i < MR; ++i) {
+        tile[i + j * MR] += pa[i] * bj;
+      }
+    }
+    pa += MR;
+    pb += NR;
+  }
+  ::store_tile(tile, MR, c, ldc, mr, nr, accumulate);
+}
+
+#ifdef PRIMITIV_GEMM_X86
+
+// NOTE:
+// Accumulators are declared as individual variables because arrays of vector
+// registers are spilled to the stack by some compilers.
+
+#define GEMM_FMA_COLUMN(j, set1, fmadd) { \
+  const auto bj = set1(pb[j]); \
+  c0##j = fmadd(a0, bj, c0##j); \
+  c1##j = fmadd(a1, bj, c1##j); \
+}
+
+#define GEMM_STORE_COLUMN(j, loadu, storeu, add, width) { \
+  float *dest = c + j * ldc; \
+  if (accumulate) { \
+    c0##j = add(c0##j, loadu(dest)); \
+    c1##j = add(c1##j, loadu(dest + width)); \
+  } \
+  storeu(dest, c0##j); \
+  storeu(dest + width, c1##j); \
+}
+
+#define GEMM_STORE_TILE_COLUMN(j, storeu, width) { \
+  storeu(tile + j * MR, c0##j); \
+  storeu(tile + j * MR + width, c1##j); \
+}
+
+__attribute__((target("avx2,fma")))
+void kernel_avx2(
+    unsigned kc, const float *pa, const float *pb,
+    float *c, unsigned ldc, unsigned mr, unsigned nr, bool accumulate) {
+  const unsigned MR = 16;
+  const unsigned NR = 6;
+  __m256 c00 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps();
+  __m256 c01 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c02 = _mm256_setzero_ps(), c12 = _mm256_setzero_ps();
+  __m256 c03 = _mm256_setzero_ps(), c13 = _mm256_setzero_ps();
+  __m256 c04 = _mm256_setzero_ps(), c14 = _mm256_setzero_ps();
+  __m256 c05 = _mm256_setzero_ps(), c15 = _mm256_setzero_ps();
+  for (unsigned p = 0; p < kc; ++p) {
+    const __m256 a0 = _mm256_loadu_ps(pa);
+    const __m256 a1 = _mm256_loadu_ps(pa + 8);
+    GEMM_FMA_COLUMN(0, _mm256_set1_ps, _mm256_fmadd_ps);
+    GEMM_FMA_COLUMN(1, _mm256_set1_ps, _mm256_fmadd_ps);
+    GEMM_FMA_COLUMN(2, _mm256_set1_ps, _mm256_fmadd_ps);
+    GEMM_FMA_COLUMN(3, _mm256_set1_ps, _mm256_fmadd_ps);
+    GEMM_FMA_COLUMN(4, _mm256_set1_ps, _mm256_fmadd_ps);
+    GEMM_FMA_COLUMN(5, _mm256_set1_ps, _mm256_fmadd_ps);
+    pa += MR;
+    pb += NR;
+  }
+  if (mr == MR && nr == NR) {
+#define STORE(j) \
+    GEMM_STORE_COLUMN(j, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, 8)
+    STORE(0); STORE(1); STORE(2); STORE(3); STORE(4); STORE(5);
+#undef STORE
+  } else {
+    float tile[MR * NR];
+#define STORE(j) GEMM_STORE_TILE_COLUMN(j, _mm256_storeu_ps, 8)
+    STORE(0); STORE(1); STORE(2); STORE(3); STORE(4); STORE(5);
+#undef STORE
+    ::store_tile(tile, MR, c, ldc, mr, nr, accumulate);
+  }
+}
+
+__attribute__((target("avx512f")))
+void kernel_avx512(
+    unsigned kc, const float *pa, const float *pb,
+    float *c, unsigned ldc, unsigned mr, unsigned nr, bool accumulate) {
+  const unsigned MR = 32;
+  const unsigned NR = 8;
+  __m512 c00 = _mm512_setzero_ps(), c10 = _mm512_setzero_ps();
+  __m512 c01 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+  __m512 c02 = _mm512_setzero_ps(), c12 = _mm512_setzero_ps();
+  __m512 c03 = _mm512_setzero_ps(), c13 = _mm512_setzero_ps();
+  __m512 c04 = _mm512_setzero_ps(), c14 = _mm512_setzero_ps();
+  __m512 c05 = _mm512_setzero_ps(), c15 = _mm512_setzero_ps();
+  __m512 c06 = _mm512_setzero_ps(), c16 = _mm512_setzero_ps();
+  __m512 c07 = _mm512_setzero_ps(), c17 = _mm512_setzero_ps();
+  for (unsigned p = 0; p < kc; ++p) {
+    const __m512 a0 = _mm512_loadu_ps(pa);
+    const __m512 a1 = _mm512_loadu_ps(pa + 16);
+    GEMM_FMA_COLUMN(0, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(1, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(2, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(3, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(4, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(5, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(6, _mm512_set1_ps, _mm512_fmadd_ps);
+    GEMM_FMA_COLUMN(7, _mm512_set1_ps, _mm512_fmadd_ps);
+    pa += MR;
+    pb += NR;
+  }
+  if (mr == MR && nr == NR) {
+#define STORE(j) \
+    GEMM_STORE_COLUMN(j, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_add_ps, 16)
+    STORE(0); STORE(1); STORE(2); STORE(3);
+    STORE(4); STORE(5); STORE(6); STORE(7);
+#undef STORE
+  } else {
+    float tile[MR * NR];
+#define STORE(j) GEMM_STORE_TILE_COLUMN(j, _mm512_storeu_ps, 16)
+    STORE(0); STORE(1); STORE(2); STORE(3);
+    STORE(4); STORE(5); STORE(6); STORE(7);
+#undef STORE
+    ::store_tile(tile, MR, c, ldc, mr, nr, accumulate);
+  }
+}
+
+#undef GEMM_FMA_COLUMN
+#undef GEMM_STORE_COLUMN
+#undef GEMM_STORE_TILE_COLUMN
+
+#endif  // PRIMITIV_GEMM_X86
+
+KernelInfo get_kernel(Isa isa) {
+  switch (isa) {
+#ifdef PRIMITIV_GEMM_X86
+    case primitiv::cpu_features::ISA_AVX512: return { 32, 8, ::kernel_avx512 };
+    case primitiv::cpu_features::ISA_AVX2: return { 16, 6, ::kernel_avx2 };
+#endif  // PRIMITIV_GEMM_X86
+    default: return { 8, 4, ::kernel_generic };
+  }
+}
+
+// Packs `A[0:mc, 0:kc]` into MR-row panels.
+// The element (i, p) of A is `a[i * rs + p * cs]`.
+void pack_a(
+    unsigned mc, unsigned kc, const float *a, unsigned rs, unsigned cs,
+    unsigned mr, float *dest) {
+  for (unsigned i0 = 0; i0 < mc; i0 += mr) {
+    const unsigned ib = std::min(mr, mc - i0);
+    for (unsigned p = 0; p < kc; ++p) {
+      const float *src = a + i0 * rs + p * cs;
+      for (unsigned i = 0; i < ib; ++i) dest[i] = src[i * rs];
+      for (unsigned i = ib; i < mr; ++i) dest[i] = 0;
+      dest += mr;
+    }
+  }
+}
+
+// Packs `B[0:kc, 0:nc]` into NR-column panels.
+// The element (p, j) of B is `b[p * rs + j * cs]`.
+void pack_b(
+    unsigned kc, unsigned nc, const float *b, unsigned rs, unsigned cs,
+    unsigned nr, float *dest) {
+  for (unsigned j0 = 0; j0 < nc; j0 += nr) {
+    const unsigned jb = std::min(nr, nc - j0);
+    for (unsigned p = 0; p < kc; ++p) {
+      const float *src = b + p * rs + j0 * cs;
+      for (unsigned j = 0; j < jb; ++j) dest[j] = src[j * cs];
+      for (unsigned j = jb; j < nr; ++j) dest[j] = 0;
+      dest += nr;
+    }
+  }
+}
+
+// Unpacked loops for small products.
+// The element (p, j) of B is `b[p * brs + j * bcs]`.
+void sgemm_small(
+    bool trans_a, unsigned m, unsigned n, unsigned k,
+    const float *a, unsigned lda,
+    const float *b, unsigned brs, unsigned bcs,
+    bool accumulate, float *c, unsigned ldc) {
+  for (unsigned j = 0; j < n; ++j) {
+    const float *bj = b + j * bcs;
+    float *cj = c + j * ldc;
+    if (!accumulate) {
+      for (unsigned i = 0; i < m; ++i) cj[i] = 0;
+    }
+    if (trans_a) {
+      // Rows of op(A) are contiguous: dot products.
+      for (unsigned i = 0; i < m; ++i) {
+        const float *ai = a + i * lda;
+        float tmp = 0;
+        for (unsigned p = 0; p < k; ++p) tmp += ai[p] * bj[p * brs];
+        cj[i] += tmp;
+      }
+    } else {
+      // Columns of op(A) are contiguous: AXPYs.
+      for (unsigned p = 0; p < k; ++p) {
+        const float *ap = a + p * lda;
+        const float bpj = bj[p * brs];
+        for (unsigned i = 0; i < m; ++i) cj[i] += ap[i] * bpj;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+namespace primitiv {
+namespace gemm {
+
+void sgemm(
+    bool trans_a, bool trans_b,
+    unsigned m, unsigned n, unsigned k,
+    const float *a, unsigned lda,
+    const float *b, unsigned ldb,
+    bool accumulate, float *c, unsigned ldc,
+    cpu_features::Isa isa,
+    ThreadPool *pool) {
+  if (!cpu_features::supports(isa)) {
+    THROW_ERROR(
+        "Instruction set '" << cpu_features::isa_name(isa)
+        << "' is not supported on this CPU.");
+  }
+  if (m == 0 || n == 0) return;
+
+  // Strides of op(A) and op(B).
+  const unsigned ars = trans_a ? lda : 1;
+  const unsigned acs = trans_a ? 1 : lda;
+  const unsigned brs = trans_b ? ldb : 1;
+  const unsigned bcs = trans_b ? 1 : ldb;
+
+  if (static_cast<unsigned long long>(m) * n * k <= ::SMALL_GEMM_THRESHOLD) {
+    ::sgemm_small(trans_a, m, n, k, a, lda, b, brs, bcs, accumulate, c, ldc);
+    return;
+  }
+
+  const ::KernelInfo ki = ::get_kernel(isa);
+  const unsigned nc_max = (::NC / ki.nr) * ki.nr;
+
+  // NOTE:
+  // Packing buffers are reused across calls to avoid repeated allocations.
+  static thread_local std::vector<float> buf_a, buf_b;
+  buf_a.resize(::MC * ::KC);
+  buf_b.resize(::KC * nc_max);
+
+  for (unsigned jc = 0; jc < n; jc += nc_max) {
+    const unsigned nc = std::min(nc_max, n - jc);
+    for (unsigned pc = 0; pc < k; pc += ::KC) {
+      const unsigned kc = std::min(::KC, k - pc);
+      const bool acc = accumulate || pc > 0;
+      ::pack_b(
+          kc, nc, b + pc * brs + jc * bcs, brs, bcs, ki.nr, buf_b.data());
+      for (unsigned ic = 0; ic < m; ic += ::MC) {
+        const unsigned mc = std::min(::MC, m - ic);
+        ::pack_a(
+            mc, kc, a + ic * ars + pc * acs, ars, acs, ki.mr, buf_a.data());
+        const float *pa = buf_a.data();
+        const float *pb = buf_b.data();
+        // Processes B panels in [begin, end).
+        auto fn = [&](unsigned begin, unsigned end) {
+          for (unsigned jr = begin * ki.nr; jr < nc && jr < end * ki.nr;
+              jr += ki.nr) {
+            const unsigned nr = std::min(ki.nr, nc - jr);
+            for (unsigned ir = 0; ir < mc; ir += ki.mr) {
+              const unsigned mr = std::min(ki.mr, mc - ir);
+              ki.kernel(
+                  kc, pa + ir * kc, pb + jr * kc,
+                  c + (ic + ir) + (jc + jr) * ldc, ldc, mr, nr, acc);
+            }
+          }
+        };
+        const unsigned num_panels = (nc - 1) / ki.nr + 1;
+        if (pool) {
+          pool->parallel_for(num_panels, 1, fn);
+        } else {
+          fn(0, num_panels);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace gemm
+}  // namespace primitiv
@@ -0,0 +1,48 @@
+#ifndef PRIMITIV_GEMM_H_
+#define PRIMITIV_GEMM_H_
+
+#include <primitiv/cpu_features.h>
+
+namespace primitiv {
+
+class ThreadPool;
+
+namespace gemm {
+
+/**
+ * Calculates the matrix product `C (+)= op(A) . op(B)` of column-major float
+ * matrices, where `op(X)` is `X` or its transposition.
+ * @param trans_a Whether `A` is transposed or not.
+ * @param trans_b Whether `B` is transposed or not.
+ * @param m Number of rows of `op(A)` and `C`.
+ * @param n Number of columns of `op(B)` and `C`.
+ * @param k Number of columns of `op(A)` and rows of `op(B)`.
+ * @param a Pointer to the first element of `A`.
+ * @param lda Leading dimension (column stride) of `A`.
+ * @param b Pointer to the first element of `B`.
+ * @param ldb Leading dimension (column stride) of `B`.
+ * @param accumulate If true, the product is added to the current values of
+ *                   `C`. Otherwise, `C` is overwritten.
+ * @param c Pointer to the first element of `C`.
+ * @param ldc Leading dimension (column stride) of `C`.
+ * @param isa Instruction set used by the micro-kernels.
+ * @param pool Thread pool to run micro-kernels in parallel, or nullptr.
+ * @remarks Large products are calculated by cache-blocked and packed loops
+ *          with register-blocked micro-kernels. Transpositions are absorbed
+ *          by the packing and never materialized. The default `isa` is the
+ *          most powerful one available on the running CPU. The results do
+ *          not depend on `pool`.
+ */
+void sgemm(
+    bool trans_a, bool trans_b,
+    unsigned m, unsigned n, unsigned k,
+    const float *a, unsigned lda,
+    const float *b, unsigned ldb,
+    bool accumulate, float *c, unsigned ldc,
+    cpu_features::Isa isa = cpu_features::max_isa(),
+    ThreadPool *pool = nullptr);
+
+}  // namespace gemm
+}  // namespace primitiv
+
+#endif  // PRIMITIV_GEMM_H_
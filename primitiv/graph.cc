@@ -7,6 +7,8 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <functional>
 #include <iostream>
@@ -15,6 +17,7 @@
 #include <primitiv/device.h>
 #include <primitiv/error.h>
 #include <primitiv/function.h>
+#include <primitiv/function_impl.h>
 #include <primitiv/graph.h>
 
 using std::cerr;
@@ -81,50 +84,564 @@ Node Graph::add_function(
   vector<NodeInfo> rets;
   rets.emplace_back(NodeInfo {
       move(ret_shape), *ret_device, Tensor(), Tensor(), vector<unsigned>(),
+      0, 0, false, false,
   });
 
   // Updates the graph.
   const unsigned ret_fid = funcs_.size();
   for (const Address &arg_addr : arg_addrs) {
-    funcs_[arg_addr.fid].rets[arg_addr.vid].sinks.emplace_back(ret_fid);
+    NodeInfo &arg_n = funcs_[arg_addr.fid].rets[arg_addr.vid];
+    arg_n.sinks.emplace_back(ret_fid);
+    ++arg_n.num_pending_sinks;
   }
-  funcs_.emplace_back(FunctionInfo { move(func), move(arg_addrs), move(rets) });
+  funcs_.emplace_back(FunctionInfo {
+      move(func), move(arg_addrs), move(rets), false, false, 0,
+  });
 
   return Node(*this, ret_fid, 0);
 }
 
+const Tensor *Graph::get_value(unsigned fid) {
+  FunctionInfo &f = funcs_[fid];
+
+  // Try to get the inner value of the function.
+  const Tensor *inner_v = f.func->get_inner_value();
+  if (inner_v) return inner_v;
+
+  return f.rets[0].value.valid() ? &f.rets[0].value : nullptr;
+}
+
+bool Graph::is_discardable(
+    const Address &addr, unsigned checkpoint_interval) const {
+  const FunctionInfo &f = funcs_[addr.fid];
+  const NodeInfo &n = f.rets[addr.vid];
+  if (n.retained || !f.func->is_deterministic()) return false;
+  if (inference_mode_) return true;
+  if (checkpointing_mode_ == CHECKPOINTING_DISABLED || n.checkpoint) {
+    return false;
+  }
+  return checkpoint_interval == 0 || addr.fid % checkpoint_interval != 0;
+}
+
 const Tensor &Graph::forward(const Node &node) {
   CHECK_NODE(node);
+  return forward_inner(node.fid_, true);
+}
 
-  std::function<const Tensor *(unsigned)> forward_recursive = [&](
-      unsigned fid) -> const Tensor * {
-    FunctionInfo &cur_f = funcs_[fid];
-    NodeInfo &cur_n = cur_f.rets[0];
+void Graph::schedule_forward(unsigned fid) {
+  // NOTE:
+  // Functions to be calculated are collected using an explicit stack instead
+  // of recursive calls, because the depth of the graph can be very large.
+  // Each function is visited at most once in each call of this method.
+  ++num_forwards_;
+  fw_stack_.clear();
+  fw_order_.clear();
+  auto visit = [this](unsigned fid) {
+    FunctionInfo &f = funcs_[fid];
+    if (f.last_visit == num_forwards_) return;
+    f.last_visit = num_forwards_;
+    f.rets[0].num_scheduled_sinks = 0;
+    if (!get_value(fid)) fw_stack_.emplace_back(fid);
+  };
+
+  visit(fid);
+  while (!fw_stack_.empty()) {
+    const unsigned fid = fw_stack_.back();
+    fw_stack_.pop_back();
+    fw_order_.emplace_back(fid);
+    for (const Address &arg : funcs_[fid].args) visit(arg.fid);
+  }
+
+  // Function IDs are always sorted in a topological order.
+  std::sort(fw_order_.begin(), fw_order_.end());
 
-    // Try to get the inner value of the function.
-    const Tensor *inner_v = cur_f.func->get_inner_value();
-    if (inner_v) return inner_v;
+  if (elementwise_fusion_) fuse_elementwise();
+
+  for (const unsigned cur_fid : fw_order_) {
+    for (const Address &arg : funcs_[cur_fid].args) {
+      ++funcs_[arg.fid].rets[arg.vid].num_scheduled_sinks;
+    }
+  }
+}
+
+unsigned Graph::checkpoint_interval() const {
+  return checkpointing_mode_ == CHECKPOINTING_AUTO
+    ? std::ceil(std::sqrt(funcs_.size())) : 0;
+}
+
+const Tensor &Graph::forward_inner(unsigned fid, bool discard) {
+  schedule_forward(fid);
+  const unsigned checkpoint_interval = this->checkpoint_interval();
+
+  // Updates the number of sinks which are not calculated yet, and discards
+  // values which are no longer used.
+  // Values required to recalculate other values in this call are kept.
+  auto finish = [&](unsigned cur_fid) {
+    FunctionInfo &cur_f = funcs_[cur_fid];
+    if (!cur_f.forwarded) {
+      for (const Address &arg : cur_f.args) {
+        --funcs_[arg.fid].rets[arg.vid].num_pending_sinks;
+      }
+      cur_f.forwarded = true;
+    }
+    for (const Address &arg : cur_f.args) {
+      NodeInfo &arg_n = funcs_[arg.fid].rets[arg.vid];
+      --arg_n.num_scheduled_sinks;
+      if (discard &&
+          arg_n.num_pending_sinks == 0 &&
+          arg_n.num_scheduled_sinks == 0 &&
+          is_discardable(arg, checkpoint_interval)) {
+        arg_n.value = Tensor();
+      }
+    }
+  };
+
+  if (autobatch_) {
+    schedule_batches();
+    for (unsigned i = 0; i + 1 < ab_offsets_.size(); ++i) {
+      const unsigned begin = ab_offsets_[i];
+      const unsigned end = ab_offsets_[i + 1];
+      const std::uint64_t allocated =
+        profiler_ ? allocated_bytes(ab_order_[begin]) : 0;
+      const std::uint64_t start = profiler_ ? profiler_->now() : 0;
+      const bool inplace = end - begin == 1 && discard &&
+        forward_inplace(ab_order_[begin], checkpoint_interval);
+      if (!inplace) forward_batch(begin, end);
+      if (profiler_) {
+        add_event(
+            ab_order_[begin], Profiler::FORWARD, end - begin, start,
+            allocated);
+      }
+      for (unsigned j = begin; j < end; ++j) finish(ab_order_[j]);
+    }
+    return *get_value(fid);
+  }
 
-    if (!cur_n.value.valid()) {
+  for (const unsigned cur_fid : fw_order_) {
+    FunctionInfo &cur_f = funcs_[cur_fid];
+    const std::uint64_t allocated = profiler_ ? allocated_bytes(cur_fid) : 0;
+    const std::uint64_t start = profiler_ ? profiler_->now() : 0;
+    const bool inplace =
+      discard && forward_inplace(cur_fid, checkpoint_interval);
+    if (!inplace) {
       // Gathers arguments.
-      vector<const Tensor *> arg_values;
-      arg_values.reserve(cur_f.args.size());
+      fw_args_.clear();
       for (const Address &arg : cur_f.args) {
-        arg_values.emplace_back(forward_recursive(arg.fid));
+        fw_args_.emplace_back(get_value(arg.fid));
       }
 
       // Calculates the value.
-      cur_n.value = cur_f.func->forward(arg_values);
+      cur_f.rets[0].value = cur_f.func->forward(fw_args_);
     }
+    if (profiler_) {
+      add_event(cur_fid, Profiler::FORWARD, 1, start, allocated);
+    }
+    finish(cur_fid);
+  }
 
-    return &cur_n.value;
+  return *get_value(fid);
+}
+
+bool Graph::can_overwrite(
+    unsigned fid, unsigned i, unsigned checkpoint_interval) const {
+  const FunctionInfo &f = funcs_[fid];
+  const NodeInfo &n = f.rets[0];
+  const Address &arg = f.args[i];
+  const FunctionInfo &arg_f = funcs_[arg.fid];
+  const NodeInfo &arg_n = arg_f.rets[arg.vid];
+  elementwise::Instruction inst;
+  if (arg_n.shape != n.shape || &arg_n.device != &n.device ||
+      arg_f.func->get_inner_value() ||
+      !is_discardable(arg, checkpoint_interval)) return false;
+  if (!dynamic_cast<const functions::Elementwise *>(f.func.get()) &&
+      !f.func->get_elementwise_instruction(inst)) return false;
+
+  // The argument should not be used by other arguments of the function.
+  for (unsigned j = 0; j < f.args.size(); ++j) {
+    if (j != i && f.args[j].fid == arg.fid && f.args[j].vid == arg.vid) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Graph::forward_inplace(unsigned fid, unsigned checkpoint_interval) {
+  FunctionInfo &f = funcs_[fid];
+  for (unsigned i = 0; i < f.args.size(); ++i) {
+    const Address &arg = f.args[i];
+    NodeInfo &arg_n = funcs_[arg.fid].rets[arg.vid];
+    if (!arg_n.value.valid() ||
+        arg_n.num_scheduled_sinks != 1 ||
+        arg_n.num_pending_sinks != (f.forwarded ? 0u : 1u) ||
+        !can_overwrite(fid, i, checkpoint_interval)) continue;
+
+    // NOTE:
+    // The value is moved from the argument so that the memory is not shared.
+    // If the memory is still shared with other Tensor objects, the device
+    // copies it before writing and the other objects are not affected.
+    Tensor y = move(arg_n.value);
+    fw_args_.clear();
+    for (unsigned j = 0; j < f.args.size(); ++j) {
+      fw_args_.emplace_back(j == i ? &y : get_value(f.args[j].fid));
+    }
+    const functions::Elementwise *fused =
+      dynamic_cast<const functions::Elementwise *>(f.func.get());
+    if (fused) {
+      y.device().elementwise_fw(fw_args_, fused->program(), y);
+    } else {
+      elementwise::Instruction inst;
+      f.func->get_elementwise_instruction(inst);
+      fw_prog_.num_inputs = f.args.size();
+      fw_prog_.code.assign(1, inst);
+      y.device().elementwise_fw(fw_args_, fw_prog_, y);
+    }
+    f.rets[0].value = move(y);
+    return true;
+  }
+  return false;
+}
+
+Graph::MemoryPlan Graph::plan_memory(const Node &node) {
+  CHECK_NODE(node);
+  schedule_forward(node.fid_);
+  const unsigned checkpoint_interval = this->checkpoint_interval();
+
+  // NOTE:
+  // Only values calculated in this plan are assigned to slots. Counters of
+  // pending sinks are copied because they are not updated by planning.
+  MemoryPlan plan { 0, 0, 0, 0 };
+  vector<unsigned> pending(funcs_.size());
+  for (unsigned fid = 0; fid < funcs_.size(); ++fid) {
+    pending[fid] = funcs_[fid].rets[0].num_pending_sinks;
+  }
+  vector<int> slot_of(funcs_.size(), -1);
+  vector<std::uint64_t> slot_bytes;
+  vector<unsigned> free_slots;
+
+  for (const unsigned cur_fid : fw_order_) {
+    const FunctionInfo &cur_f = funcs_[cur_fid];
+    const std::uint64_t bytes = cur_f.rets[0].shape.size() * sizeof(float);
+    plan.naive_peak_bytes += bytes;
+
+    // Assigns a slot to the value.
+    int slot = -1;
+    for (unsigned i = 0; i < cur_f.args.size(); ++i) {
+      const Address &arg = cur_f.args[i];
+      if (slot_of[arg.fid] >= 0 &&
+          funcs_[arg.fid].rets[arg.vid].num_scheduled_sinks == 1 &&
+          pending[arg.fid] == (cur_f.forwarded ? 0u : 1u) &&
+          can_overwrite(cur_fid, i, checkpoint_interval)) {
+        slot = slot_of[arg.fid];
+        slot_of[arg.fid] = -1;
+        ++plan.num_inplace;
+        break;
+      }
+    }
+    if (slot < 0) {
+      const auto it = std::find_if(
+          free_slots.begin(), free_slots.end(),
+          [&](unsigned s) { return slot_bytes[s] == bytes; });
+      if (it != free_slots.end()) {
+        slot = *it;
+        free_slots.erase(it);
+      } else {
+        slot = slot_bytes.size();
+        slot_bytes.emplace_back(bytes);
+        plan.planned_peak_bytes += bytes;
+      }
+    }
+    slot_of[cur_fid] = slot;
+
+    // Releases slots of values which are no longer used.
+    for (const Address &arg : cur_f.args) {
+      NodeInfo &arg_n = funcs_[arg.fid].rets[arg.vid];
+      if (!cur_f.forwarded) --pending[arg.fid];
+      --arg_n.num_scheduled_sinks;
+      if (slot_of[arg.fid] >= 0 &&
+          pending[arg.fid] == 0 &&
+          arg_n.num_scheduled_sinks == 0 &&
+          is_discardable(arg, checkpoint_interval)) {
+        free_slots.emplace_back(slot_of[arg.fid]);
+        slot_of[arg.fid] = -1;
+      }
+    }
+  }
+
+  plan.num_slots = slot_bytes.size();
+  return plan;
+}
+
+void Graph::fuse_elementwise() {
+  // NOTE:
+  // Each group of fused functions is grown from the root function toward its
+  // arguments. An argument is absorbed into the group if all its sinks are
+  // already in the group, and otherwise it becomes an input of the group.
+  // Candidates are processed in the descending order of function IDs so that
+  // all sinks of each candidate are examined before the candidate itself.
+  elementwise::Instruction inst;
+  auto is_member = [this](unsigned fid) {
+    return std::binary_search(
+        fu_members_.begin(), fu_members_.end(), fid, std::greater<unsigned>());
   };
+  auto register_of = [this](unsigned fid) -> unsigned {
+    const auto it = std::find(fu_inputs_.begin(), fu_inputs_.end(), fid);
+    if (it != fu_inputs_.end()) return it - fu_inputs_.begin();
+    return fu_inputs_.size() + fu_members_.size() - 1 - (
+        std::lower_bound(
+          fu_members_.begin(), fu_members_.end(), fid,
+          std::greater<unsigned>()) - fu_members_.begin());
+  };
+
+  fu_absorbed_.clear();
+  for (auto it = fw_order_.rbegin(); it != fw_order_.rend(); ++it) {
+    const unsigned root_fid = *it;
+    FunctionInfo &root_f = funcs_[root_fid];
+    if (root_f.forwarded ||
+        !root_f.func->get_elementwise_instruction(inst)) continue;
+    const NodeInfo &root_n = root_f.rets[0];
+
+    fu_members_.assign(1, root_fid);
+    fu_inputs_.clear();
+    fu_candidates_.clear();
+    for (const Address &arg : root_f.args) fu_candidates_.emplace_back(arg.fid);
+    std::make_heap(fu_candidates_.begin(), fu_candidates_.end());
+
+    while (!fu_candidates_.empty()) {
+      std::pop_heap(fu_candidates_.begin(), fu_candidates_.end());
+      const unsigned fid = fu_candidates_.back();
+      fu_candidates_.pop_back();
+      if (is_member(fid) ||
+          std::find(fu_inputs_.begin(), fu_inputs_.end(), fid)
+          != fu_inputs_.end()) continue;
+
+      FunctionInfo &f = funcs_[fid];
+      const NodeInfo &n = f.rets[0];
+      bool absorbed =
+        !f.forwarded && !get_value(fid) && !n.retained && !n.checkpoint &&
+        n.shape == root_n.shape && &n.device == &root_n.device &&
+        f.func->get_elementwise_instruction(inst);
+      for (unsigned i = 0; absorbed && i < n.sinks.size(); ++i) {
+        absorbed = is_member(n.sinks[i]);
+      }
 
-  return *forward_recursive(node.fid_);
+      if (absorbed) {
+        fu_members_.emplace_back(fid);
+        for (const Address &arg : f.args) {
+          fu_candidates_.emplace_back(arg.fid);
+          std::push_heap(fu_candidates_.begin(), fu_candidates_.end());
+        }
+      } else {
+        fu_inputs_.emplace_back(fid);
+      }
+    }
+    if (fu_members_.size() < 2) continue;
+
+    // Makes the program. Members are calculated in the ascending order.
+    elementwise::Program prog { static_cast<unsigned>(fu_inputs_.size()), {} };
+    for (auto m = fu_members_.rbegin(); m != fu_members_.rend(); ++m) {
+      const FunctionInfo &f = funcs_[*m];
+      f.func->get_elementwise_instruction(inst);
+      for (unsigned &arg : inst.args) arg = register_of(f.args[arg].fid);
+      prog.code.emplace_back(inst);
+    }
+
+    // Updates the graph. Absorbed functions are regarded as calculated.
+    for (const unsigned fid : fu_members_) {
+      FunctionInfo &f = funcs_[fid];
+      for (const Address &arg : f.args) {
+        --funcs_[arg.fid].rets[arg.vid].num_pending_sinks;
+      }
+      if (fid != root_fid) {
+        f.forwarded = true;
+        f.fused = true;
+        fu_absorbed_.emplace_back(fid);
+      }
+    }
+    root_f.func.reset(new functions::Elementwise(root_n.shape, prog));
+    root_f.args.clear();
+    for (const unsigned fid : fu_inputs_) {
+      NodeInfo &n = funcs_[fid].rets[0];
+      n.sinks.emplace_back(root_fid);
+      ++n.num_pending_sinks;
+      root_f.args.emplace_back(Address { fid, 0 });
+    }
+  }
+
+  if (!fu_absorbed_.empty()) {
+    std::sort(fu_absorbed_.begin(), fu_absorbed_.end());
+    fw_order_.erase(
+        std::remove_if(
+          fw_order_.begin(), fw_order_.end(),
+          [this](unsigned fid) {
+            return std::binary_search(
+                fu_absorbed_.begin(), fu_absorbed_.end(), fid);
+          }),
+        fw_order_.end());
+  }
+}
+
+bool Graph::is_batchable(unsigned rep_fid, unsigned fid) const {
+  const FunctionInfo &rep_f = funcs_[rep_fid];
+  const FunctionInfo &f = funcs_[fid];
+  const NodeInfo &rep_n = rep_f.rets[0];
+  const NodeInfo &n = f.rets[0];
+  if (!rep_f.func->can_batch_with(*f.func) ||
+      f.args.size() != rep_f.args.size() ||
+      n.shape != rep_n.shape || &n.device != &rep_n.device) return false;
+
+  // Arguments which are not shared should have the same shapes to be
+  // concatenated, and also the same batch size as the results so that each
+  // sample of the concatenated arguments corresponds to the results.
+  for (unsigned i = 0; i < f.args.size(); ++i) {
+    const Address &rep_arg = rep_f.args[i];
+    const Address &arg = f.args[i];
+    if (arg.fid == rep_arg.fid && arg.vid == rep_arg.vid) continue;
+    const NodeInfo &rep_arg_n = funcs_[rep_arg.fid].rets[rep_arg.vid];
+    const NodeInfo &arg_n = funcs_[arg.fid].rets[arg.vid];
+    if (arg_n.shape != rep_arg_n.shape ||
+        arg_n.shape.batch() != n.shape.batch() ||
+        &arg_n.device != &rep_arg_n.device) return false;
+  }
+  return true;
+}
+
+void Graph::schedule_batches() {
+  // NOTE:
+  // Functions are grouped by their depths: the length of the longest path from
+  // available values. Functions with the same depth never depend on each other
+  // and can be calculated at once. Each group is collected greedily from the
+  // functions with the same depth in the ascending order of function IDs.
+  ab_depths_.resize(fw_order_.size());
+  ab_levels_.clear();
+  for (unsigned i = 0; i < fw_order_.size(); ++i) {
+    unsigned depth = 0;
+    for (const Address &arg : funcs_[fw_order_[i]].args) {
+      const auto it = std::lower_bound(
+          fw_order_.begin(), fw_order_.begin() + i, arg.fid);
+      if (it != fw_order_.begin() + i && *it == arg.fid) {
+        depth = std::max(depth, ab_depths_[it - fw_order_.begin()] + 1);
+      }
+    }
+    ab_depths_[i] = depth;
+    ab_levels_.emplace_back(depth, fw_order_[i]);
+  }
+  std::sort(ab_levels_.begin(), ab_levels_.end());
+
+  ab_order_.clear();
+  ab_offsets_.clear();
+  for (unsigned begin = 0; begin < ab_levels_.size(); ) {
+    const unsigned depth = ab_levels_[begin].first;
+    ab_rest_.clear();
+    for (; begin < ab_levels_.size() && ab_levels_[begin].first == depth;
+        ++begin) {
+      ab_rest_.emplace_back(ab_levels_[begin].second);
+    }
+    while (!ab_rest_.empty()) {
+      const unsigned rep_fid = ab_rest_[0];
+      ab_offsets_.emplace_back(ab_order_.size());
+      ab_order_.emplace_back(rep_fid);
+      unsigned num_rest = 0;
+      for (unsigned i = 1; i < ab_rest_.size(); ++i) {
+        if (is_batchable(rep_fid, ab_rest_[i])) {
+          ab_order_.emplace_back(ab_rest_[i]);
+        } else {
+          ab_rest_[num_rest++] = ab_rest_[i];
+        }
+      }
+      ab_rest_.resize(num_rest);
+    }
+  }
+  ab_offsets_.emplace_back(ab_order_.size());
+}
+
+void Graph::forward_batch(unsigned begin, unsigned end) {
+  FunctionInfo &rep_f = funcs_[ab_order_[begin]];
+  if (end - begin == 1) {
+    fw_args_.clear();
+    for (const Address &arg : rep_f.args) {
+      fw_args_.emplace_back(get_value(arg.fid));
+    }
+    rep_f.rets[0].value = rep_f.func->forward(fw_args_);
+    return;
+  }
+
+  // Gathers arguments. Each argument is concatenated unless all functions use
+  // the same non-minibatched value.
+  // NOTE: `ab_values_` never reallocates while gathering arguments.
+  const unsigned arg_size = rep_f.args.size();
+  ab_values_.clear();
+  ab_values_.reserve(arg_size);
+  fw_args_.clear();
+  for (unsigned i = 0; i < arg_size; ++i) {
+    const Address &rep_arg = rep_f.args[i];
+    bool shared = true;
+    ab_inputs_.clear();
+    for (unsigned j = begin; j < end; ++j) {
+      const Address &arg = funcs_[ab_order_[j]].args[i];
+      shared = shared && arg.fid == rep_arg.fid && arg.vid == rep_arg.vid;
+      ab_inputs_.emplace_back(get_value(arg.fid));
+    }
+    if (shared && !ab_inputs_[0]->shape().has_batch()) {
+      fw_args_.emplace_back(ab_inputs_[0]);
+    } else {
+      ab_values_.emplace_back(
+          ab_inputs_[0]->device().batch_concat_fw(ab_inputs_));
+      fw_args_.emplace_back(&ab_values_.back());
+    }
+  }
+
+  // Calculates and splits the values.
+  // If all arguments are shared, all functions have the same value.
+  const Tensor y = rep_f.func->forward(fw_args_);
+  const unsigned batch = rep_f.rets[0].shape.batch();
+  for (unsigned j = begin; j < end; ++j) {
+    const unsigned lower = (j - begin) * batch;
+    funcs_[ab_order_[j]].rets[0].value = y.shape().batch() == batch
+      ? y : y.device().batch_slice_fw(y, lower, lower + batch);
+  }
+  ab_values_.clear();
+}
+
+std::uint64_t Graph::allocated_bytes(unsigned fid) const {
+  const FunctionInfo &f = funcs_[fid];
+  vector<const Device *> devs { &f.rets[0].device };
+  for (const Address &arg : f.args) {
+    const Device *dev = &funcs_[arg.fid].rets[arg.vid].device;
+    if (std::find(devs.begin(), devs.end(), dev) == devs.end()) {
+      devs.emplace_back(dev);
+    }
+  }
+  std::uint64_t ret = 0;
+  for (const Device *dev : devs) {
+    ret += dev->get_memory_statistics().bytes_allocated;
+  }
+  return ret;
+}
+
+void Graph::add_event(
+    unsigned fid, Profiler::Phase phase, unsigned num_functions,
+    std::uint64_t start, std::uint64_t allocated) {
+  const FunctionInfo &f = funcs_[fid];
+  Profiler::Event event;
+  event.name = f.func->name();
+  event.phase = phase;
+  for (const Address &arg : f.args) {
+    event.arg_shapes.emplace_back(funcs_[arg.fid].rets[arg.vid].shape);
+  }
+  event.ret_shape = f.rets[0].shape;
+  event.device = &f.rets[0].device;
+  event.num_functions = num_functions;
+  event.start_ns = start;
+  event.duration_ns = profiler_->now() - start;
+  event.bytes = allocated_bytes(fid) - allocated;
+  profiler_->add_event(move(event));
 }
 
 void Graph::backward(const Node &node) {
   CHECK_NODE(node);
+  if (inference_mode_) {
+    THROW_ERROR("backward() is not available in the inference mode.");
+  }
 
   FunctionInfo &last_f = funcs_[node.fid_];
   NodeInfo &last_n = last_f.rets[node.vid_];
@@ -144,6 +661,24 @@ void Graph::backward(const Node &node) {
     }
   }
 
+  // Finds functions whose gradients are required.
+  // NOTE:
+  // The function ID is also a topological order, and every argument of a
+  // function has a smaller ID than the function.
+  bw_required_.assign(node.fid_ + 1, false);
+  for (unsigned fid = 0; fid <= node.fid_; ++fid) {
+    const FunctionInfo &f = funcs_[fid];
+    bool required = f.func->requires_grad();
+    for (const Address &arg : f.args) {
+      if (required) break;
+      required = bw_required_[arg.fid];
+    }
+    bw_required_[fid] = required;
+  }
+
+  // Nothing to do if no function requires the gradient.
+  if (!bw_required_[node.fid_]) return;
+
   // Makes the identity gradient (dx/dx = 1) at the last node.
   last_n.grad = last_n.device.new_tensor(last_v->shape(), 1.f);
 
@@ -154,38 +689,124 @@ void Graph::backward(const Node &node) {
   for (int fid = node.fid_; fid >= 0; --fid) {
     FunctionInfo &cur_f = funcs_[fid];
     NodeInfo &cur_n = cur_f.rets[0];
-    const Tensor *cur_v = cur_n.value.valid()
-      ? &cur_n.value
-      : cur_f.func->get_inner_value();
 
-    // If the gradient is invalid, this function is out of the forward path.
+    // If the gradient is invalid, this function is out of the forward path,
+    // or no function requires the gradient.
     if (!cur_n.grad.valid()) continue;
 
+    // Values discarded in the checkpointing mode are recalculated with all
+    // discarded values between them and the nearest available values.
+    const Tensor *cur_v = get_value(fid);
+    if (!cur_v) cur_v = &forward_inner(fid, false);
+
     // Gathers argument value/gradient tensors.
+    // Gradients of arguments which are not required are not allocated.
     const unsigned arg_size = cur_f.args.size();
     vector<const Tensor *> arg_values;
     vector<Tensor *> arg_grads;
     arg_values.reserve(arg_size);
     arg_grads.reserve(arg_size);
+    for (const Address &arg : cur_f.args) {
+      const Tensor *arg_v = get_value(arg.fid);
+      arg_values.emplace_back(arg_v ? arg_v : &forward_inner(arg.fid, false));
+    }
+    // NOTE: Memories of recalculated values are recorded in their own events.
+    const std::uint64_t allocated = profiler_ ? allocated_bytes(fid) : 0;
     for (unsigned i = 0; i < arg_size; ++i) {
       const Address &arg = cur_f.args[i];
       FunctionInfo &arg_f = funcs_[arg.fid];
       NodeInfo &arg_n = arg_f.rets[arg.vid];
-      const Tensor *arg_v = arg_n.value.valid()
-        ? &arg_n.value
-        : arg_f.func->get_inner_value();
-      if (!arg_n.grad.valid()) {
-        arg_n.grad = arg_n.device.new_tensor(arg_v->shape(), 0.f);
+      Tensor *inner_grad = bw_required_[arg.fid]
+        ? arg_f.func->get_inner_gradient(*cur_f.func, i) : nullptr;
+      if (inner_grad) {
+        // NOTE:
+        // The gradient is accumulated directly into the inner tensor, e.g.,
+        // the gradient of a parameter. Sparse updates such as pick_bw() then
+        // do not require any temporaries with the size of the argument.
+        arg_grads.emplace_back(inner_grad);
+      } else if (bw_required_[arg.fid]) {
+        if (!arg_n.grad.valid()) {
+          arg_n.grad = arg_n.device.new_tensor(arg_values[i]->shape(), 0.f);
+        }
+        arg_grads.emplace_back(&arg_n.grad);
+      } else {
+        arg_grads.emplace_back(nullptr);
       }
-      arg_values.emplace_back(arg_v);
-      arg_grads.emplace_back(&arg_n.grad);
     }
 
     // Propagetes the gradient from this node.
+    const std::uint64_t start = profiler_ ? profiler_->now() : 0;
     cur_f.func->backward(*cur_v, cur_n.grad, arg_values, arg_grads);
+    if (profiler_) add_event(fid, Profiler::BACKWARD, 1, start, allocated);
 
     // Deletes current gradient to suppress memory.
     cur_n.grad = Tensor();
+
+    // The current value is no longer used by remaining functions.
+    if (checkpointing_mode_ != CHECKPOINTING_DISABLED &&
+        !cur_n.retained && cur_f.func->is_deterministic()) {
+      cur_n.value = Tensor();
+    }
+  }
+}
+
+void Graph::checkpoint(const Node &node) {
+  CHECK_NODE(node);
+  ACCESS(node).checkpoint = true;
+}
+
+void Graph::retain(const Node &node) {
+  CHECK_NODE(node);
+  ACCESS(node).retained = true;
+}
+
+void Graph::set_input(const Node &node, const vector<float> &data) {
+  CHECK_NODE(node);
+  functions::Input *input =
+    dynamic_cast<functions::Input *>(funcs_[node.fid_].func.get());
+  if (!input) {
+    THROW_ERROR(
+        "The node [fid=" << node.fid_ << ", vid=" << node.vid_
+        << "] is not an input.");
+  }
+  input->reset_data(data);
+
+  // Discards values calculated from the old data.
+  // Each function is visited at most once.
+  ++num_forwards_;
+  fw_stack_.assign(1, node.fid_);
+  funcs_[node.fid_].last_visit = num_forwards_;
+  while (!fw_stack_.empty()) {
+    const unsigned fid = fw_stack_.back();
+    fw_stack_.pop_back();
+    reset_function(fid);
+    for (const unsigned sink : funcs_[fid].rets[0].sinks) {
+      FunctionInfo &sink_f = funcs_[sink];
+      if (sink_f.last_visit == num_forwards_) continue;
+      sink_f.last_visit = num_forwards_;
+      fw_stack_.emplace_back(sink);
+    }
+  }
+}
+
+void Graph::invalidate() {
+  for (unsigned fid = 0; fid < funcs_.size(); ++fid) reset_function(fid);
+}
+
+void Graph::reset_function(unsigned fid) {
+  FunctionInfo &f = funcs_[fid];
+  NodeInfo &n = f.rets[0];
+  n.value = Tensor();
+  n.grad = Tensor();
+
+  // NOTE:
+  // Functions absorbed by the fusion are always regarded as calculated because
+  // their sinks no longer use them.
+  if (f.forwarded && !f.fused) {
+    for (const Address &arg : f.args) {
+      ++funcs_[arg.fid].rets[arg.vid].num_pending_sinks;
+    }
+    f.forwarded = false;
   }
 }
 
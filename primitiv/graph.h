@@ -1,10 +1,13 @@
 #ifndef PRIMITIV_GRAPH_H_
 #define PRIMITIV_GRAPH_H_
 
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 #include <primitiv/function.h>
 #include <primitiv/mixins.h>
+#include <primitiv/profiler.h>
 #include <primitiv/shape.h>
 
 namespace primitiv {
@@ -141,7 +144,45 @@ class Graph
     : public mixins::DefaultSettable<Graph>
     , mixins::Nonmovable<Graph> {
 public:
-  Graph() = default;
+  /**
+   * Strategies to choose checkpoints in the checkpointing mode.
+   *   CHECKPOINTING_DISABLED ... All values are kept for backpropagation.
+   *   CHECKPOINTING_MANUAL ..... Only nodes specified by checkpoint() are
+   *                              kept.
+   *   CHECKPOINTING_AUTO ....... Nodes specified by checkpoint() and every
+   *                              ceil(sqrt(n))-th function of n functions are
+   *                              kept.
+   */
+  enum CheckpointingMode {
+    CHECKPOINTING_DISABLED,
+    CHECKPOINTING_MANUAL,
+    CHECKPOINTING_AUTO,
+  };
+
+  /**
+   * Result of the memory planning.
+   *   naive_peak_bytes ..... Number of bytes required when every value is
+   *                          kept in its own memory.
+   *   planned_peak_bytes ... Number of bytes required when dead values are
+   *                          discarded and their memory is reused.
+   *   num_slots ............ Number of memory blocks used in the plan.
+   *   num_inplace .......... Number of functions calculated in the memory of
+   *                          their arguments.
+   */
+  struct MemoryPlan {
+    std::uint64_t naive_peak_bytes;
+    std::uint64_t planned_peak_bytes;
+    unsigned num_slots;
+    unsigned num_inplace;
+  };
+
+  Graph()
+    : inference_mode_(false)
+    , checkpointing_mode_(CHECKPOINTING_DISABLED)
+    , elementwise_fusion_(false)
+    , autobatch_(false)
+    , profiler_(nullptr)
+    , num_forwards_(0) {}
   ~Graph() = default;
 
   /**
@@ -170,17 +211,182 @@ public:
    *          the corresponding node in the subgraph and they are re-used for
    *          future calculation. I.e., each node is calculated only once while
    *          the lifetime of the Graph object.
+   *          In the inference mode, intermediate results are discarded after
+   *          all their sinks are calculated, and the returned Tensor may be
+   *          discarded by following forward() calls unless the node is
+   *          retained. Discarded results are recalculated if required again.
    */
   const Tensor &forward(const Node &node);
 
   /**
    * Calculates the backpropagation.
    * @param node Node object specifying the output node.
+   * @throw primitiv::Error The graph is in the inference mode.
    * @remarks If `node` is not yet forwarded, this function implicitly calls
    *          `forward(node)`.
+   *          In the checkpointing mode, discarded values are recalculated
+   *          segment by segment from the nearest checkpoints, and each value
+   *          except retained ones is discarded again after the
+   *          backpropagation passes through the node.
+   *          Gradients are calculated only for nodes which depend on at least
+   *          one function that requires them, e.g., non-frozen parameters.
+   *          Other nodes are skipped without allocating their gradients.
    */
   void backward(const Node &node);
 
+  /**
+   * Plans the memory usage of values calculated by `forward(node)`.
+   * @param node Node object specifying the target node.
+   * @return Memory usage of the plan.
+   * @remarks This function does not calculate any values. Values are assigned
+   *          to memory blocks according to their lifetimes: a block is reused
+   *          by a later value of the same size after all sinks of the
+   *          previous value are calculated. The lifetimes follow the current
+   *          mode of the graph, and values are discarded only in the
+   *          inference or checkpointing mode.
+   *          Elementwise functions are calculated in the memory of an
+   *          argument if no other function uses the argument later.
+   *          The plan follows the order of function IDs regardless of the
+   *          automatic batching. Values already calculated are not counted.
+   */
+  MemoryPlan plan_memory(const Node &node);
+
+  /**
+   * Enables or disables the inference mode.
+   * @param enabled `true` to enable the inference mode, `false` otherwise.
+   * @remarks In the inference mode, the graph discards each intermediate
+   *          result as soon as all functions using it are calculated, so that
+   *          the peak memory usage depends on the width of the graph rather
+   *          than its length. Backpropagation is not available in this mode.
+   */
+  void set_inference_mode(bool enabled) { inference_mode_ = enabled; }
+
+  /**
+   * Returns whether the graph is in the inference mode or not.
+   * @return `true` if the inference mode is enabled, `false` otherwise.
+   */
+  bool is_inference_mode() const { return inference_mode_; }
+
+  /**
+   * Changes the checkpointing mode.
+   * @param mode New checkpointing mode.
+   * @remarks In the checkpointing mode, forward() discards each value except
+   *          checkpoints as soon as all functions using it are calculated.
+   *          backward() recalculates discarded values when they are required.
+   *          This reduces the memory usage for values in exchange for
+   *          additional forward calculations.
+   */
+  void set_checkpointing_mode(CheckpointingMode mode) {
+    checkpointing_mode_ = mode;
+  }
+
+  /**
+   * Returns the current checkpointing mode.
+   * @return Checkpointing mode.
+   */
+  CheckpointingMode get_checkpointing_mode() const {
+    return checkpointing_mode_;
+  }
+
+  /**
+   * Marks the node as a checkpoint.
+   * @param node Node object specifying the target node.
+   * @remarks Values of checkpoints are not discarded by forward() in the
+   *          checkpointing mode.
+   */
+  void checkpoint(const Node &node);
+
+  /**
+   * Enables or disables the fusion of elementwise functions.
+   * @param enabled `true` to enable the fusion, `false` otherwise.
+   * @remarks When the fusion is enabled, forward() replaces each chain of
+   *          elementwise functions which are not yet calculated by one fused
+   *          function, and calculates the chain in one pass without storing
+   *          intermediate results. backward() also calculates the gradients
+   *          of the chain in one pass.
+   *          Values of fused intermediate nodes are calculated only when they
+   *          are requested directly. Use retain() to keep them.
+   */
+  void set_elementwise_fusion(bool enabled) { elementwise_fusion_ = enabled; }
+
+  /**
+   * Returns whether the fusion of elementwise functions is enabled or not.
+   * @return `true` if the fusion is enabled, `false` otherwise.
+   */
+  bool is_elementwise_fusion_enabled() const { return elementwise_fusion_; }
+
+  /**
+   * Enables or disables the automatic batching of functions.
+   * @param enabled `true` to enable the automatic batching, `false` otherwise.
+   * @remarks When the automatic batching is enabled, forward() gathers
+   *          functions which are not yet calculated, do not depend on each
+   *          other, and perform the same operation with arguments of the same
+   *          shapes. Each group of such functions is calculated at once by
+   *          concatenating their arguments along the minibatch, and the
+   *          result is split into each function. Arguments shared by all
+   *          functions in the group (e.g., parameters) are not concatenated.
+   *          This mode does not affect backward().
+   */
+  void set_autobatch(bool enabled) { autobatch_ = enabled; }
+
+  /**
+   * Returns whether the automatic batching is enabled or not.
+   * @return `true` if the automatic batching is enabled, `false` otherwise.
+   */
+  bool is_autobatch_enabled() const { return autobatch_; }
+
+  /**
+   * Sets the profiler to record the calculation of each function.
+   * @param profiler Pointer of a Profiler object, or nullptr to stop
+   *                 profiling.
+   * @remarks forward() and backward() record the name, the shapes, the
+   *          device, the elapsed time and the allocated bytes of each
+   *          function. Values recalculated in the checkpointing mode are also
+   *          recorded, and each group of the automatic batching is recorded
+   *          as one event. Without the profiler, each function only tests
+   *          the pointer a few times.
+   *          Each event spans the call of the function on the host, so
+   *          kernels that a device queues without waiting are attributed to
+   *          the function that next waits for them, e.g., by retrieving
+   *          values. Allocated bytes are counted only on devices whose
+   *          statistics are enabled by Device::set_profiling().
+   */
+  void set_profiler(Profiler *profiler) { profiler_ = profiler; }
+
+  /**
+   * Retrieves the profiler.
+   * @return Pointer of the Profiler object, or nullptr if not set.
+   */
+  Profiler *get_profiler() const { return profiler_; }
+
+  /**
+   * Keeps the value of the node in the inference and checkpointing mode.
+   * @param node Node object specifying the target node.
+   * @remarks Retained values are never discarded until clear() is called,
+   *          and retained nodes are never fused into other functions.
+   */
+  void retain(const Node &node);
+
+  /**
+   * Replaces the data of an input node.
+   * @param node Node object created by `operators::input()`.
+   * @param data New data. The size should be equal to that of the old data.
+   * @throw primitiv::Error `node` is not an input node.
+   * @remarks Values calculated from the old data are discarded, and they are
+   *          recalculated by following forward() calls. This allows to
+   *          calculate the same graph repeatedly with new data without
+   *          rebuilding it.
+   */
+  void set_input(const Node &node, const std::vector<float> &data);
+
+  /**
+   * Discards all calculated values and gradients in the graph.
+   * @remarks The structure of the graph is kept, and values are recalculated
+   *          by following forward() calls. Call this method after updating
+   *          parameters to calculate the graph again with new parameters.
+   */
+  void invalidate();
+
   /**
    * Retrieves the shape of the node.
    * @param node Node object specifying the target node.
@@ -227,6 +433,10 @@ private:
     Tensor value;
     Tensor grad;
     std::vector<unsigned> sinks;
+    unsigned num_pending_sinks;
+    unsigned num_scheduled_sinks;
+    bool retained;
+    bool checkpoint;
   };
 
   /**
@@ -237,10 +447,160 @@ private:
     std::unique_ptr<Function> func;
     std::vector<Address> args;
     std::vector<NodeInfo> rets;
+    bool forwarded;
+    bool fused;
+    std::uint64_t last_visit;
   };
 
+  /**
+   * Retrieves the value of the node if available.
+   * @param fid Function ID.
+   * @return Pointer of the value, or nullptr if not yet calculated.
+   */
+  const Tensor *get_value(unsigned fid);
+
+  /**
+   * Calculates the value of given function.
+   * @param fid Function ID.
+   * @param discard Whether the intermediate values can be discarded or not.
+   * @return Calculated value.
+   */
+  const Tensor &forward_inner(unsigned fid, bool discard);
+
+  /**
+   * Collects functions required to calculate given function into
+   * `fw_order_`, and counts scheduled sinks of their arguments.
+   * @param fid Function ID.
+   */
+  void schedule_forward(unsigned fid);
+
+  /**
+   * Returns the interval of automatic checkpoints.
+   * @return Interval of automatic checkpoints, or 0 if automatic checkpoints
+   *         are not used.
+   */
+  unsigned checkpoint_interval() const;
+
+  /**
+   * Checks whether the function can overwrite the value of an argument.
+   * @param fid Function ID.
+   * @param i Index of the argument.
+   * @param checkpoint_interval Interval of automatic checkpoints, or 0 if
+   *                            automatic checkpoints are not used.
+   * @return true if the function can be calculated in the memory of the
+   *         `i`-th argument when no other function uses it, false otherwise.
+   */
+  bool can_overwrite(
+      unsigned fid, unsigned i, unsigned checkpoint_interval) const;
+
+  /**
+   * Calculates the value of the function in the memory of an argument if
+   * possible.
+   * @param fid Function ID.
+   * @param checkpoint_interval Interval of automatic checkpoints, or 0 if
+   *                            automatic checkpoints are not used.
+   * @return true if the value is calculated, false otherwise.
+   */
+  bool forward_inplace(unsigned fid, unsigned checkpoint_interval);
+
+  /**
+   * Checks whether the value of the node can be discarded or not.
+   * @param addr Address of the node.
+   * @param checkpoint_interval Interval of automatic checkpoints, or 0 if
+   *                            automatic checkpoints are not used.
+   * @return true if the value can be discarded, false otherwise.
+   */
+  bool is_discardable(const Address &addr, unsigned checkpoint_interval) const;
+
+  /**
+   * Discards the value and the gradient of the function, and regards the
+   * function as not calculated.
+   * @param fid Function ID.
+   */
+  void reset_function(unsigned fid);
+
+  /**
+   * Fuses chains of elementwise functions in `fw_order_`.
+   * @remarks Functions absorbed into other functions are removed from
+   *          `fw_order_`.
+   */
+  void fuse_elementwise();
+
+  /**
+   * Checks whether two functions can be calculated at once or not.
+   * @param rep_fid Function ID of the representative of the group.
+   * @param fid Function ID of the function to be checked.
+   * @return true if `fid` can be batched with `rep_fid`, false otherwise.
+   */
+  bool is_batchable(unsigned rep_fid, unsigned fid) const;
+
+  /**
+   * Groups functions in `fw_order_` into batches.
+   * @remarks Results are stored in `ab_order_` and `ab_offsets_`: the `i`-th
+   *          group consists of `ab_order_[ab_offsets_[i]]` to
+   *          `ab_order_[ab_offsets_[i + 1] - 1]`.
+   */
+  void schedule_batches();
+
+  /**
+   * Calculates the values of one group of functions at once.
+   * @param begin Beginning of the group in `ab_order_`.
+   * @param end End of the group in `ab_order_`.
+   */
+  void forward_batch(unsigned begin, unsigned end);
+
+  /**
+   * Retrieves the total bytes allocated on devices used by the function.
+   * @param fid Function ID.
+   * @return Sum of `bytes_allocated` of the devices of the result and the
+   *         arguments.
+   */
+  std::uint64_t allocated_bytes(unsigned fid) const;
+
+  /**
+   * Adds an event of the function to the profiler.
+   * @param fid Function ID.
+   * @param phase Phase of the calculation.
+   * @param num_functions Number of functions calculated together.
+   * @param start Start time of the calculation.
+   * @param allocated Value of `allocated_bytes(fid)` at the start.
+   */
+  void add_event(
+      unsigned fid, Profiler::Phase phase, unsigned num_functions,
+      std::uint64_t start, std::uint64_t allocated);
+
   static Graph *default_obj_;
   std::vector<FunctionInfo> funcs_;
+  bool inference_mode_;
+  CheckpointingMode checkpointing_mode_;
+  bool elementwise_fusion_;
+  bool autobatch_;
+  Profiler *profiler_;
+
+  // Scratch spaces of forward().
+  std::uint64_t num_forwards_;
+  std::vector<unsigned> fw_stack_;
+  std::vector<unsigned> fw_order_;
+  std::vector<const Tensor *> fw_args_;
+  elementwise::Program fw_prog_;
+
+  // Scratch spaces of backward().
+  std::vector<bool> bw_required_;
+
+  // Scratch spaces of fuse_elementwise().
+  std::vector<unsigned> fu_candidates_;
+  std::vector<unsigned> fu_members_;
+  std::vector<unsigned> fu_inputs_;
+  std::vector<unsigned> fu_absorbed_;
+
+  // Scratch spaces of the automatic batching.
+  std::vector<unsigned> ab_depths_;
+  std::vector<std::pair<unsigned, unsigned>> ab_levels_;
+  std::vector<unsigned> ab_rest_;
+  std::vector<unsigned> ab_order_;
+  std::vector<unsigned> ab_offsets_;
+  std::vector<const Tensor *> ab_inputs_;
+  std::vector<Tensor> ab_values_;
 };
 
 inline const Shape &Node::shape() const {
@@ -0,0 +1,177 @@
+#include <config.h>
+
+#include <cstdlib>
+#include <primitiv/error.h>
+#include <primitiv/host_memory_pool.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using std::make_pair;
+
+namespace {
+
+// Blocks smaller than 2^MIN_SCALE bytes are not distinguished.
+const unsigned MIN_SCALE = 6;
+const unsigned MAX_SCALE = 63;
+
+void *aligned_malloc(std::uint64_t size) {
+#ifdef _WIN32
+  return ::_aligned_malloc(size, primitiv::HostMemoryPool::ALIGNMENT);
+#else
+  void *ptr;
+  if (::posix_memalign(&ptr, primitiv::HostMemoryPool::ALIGNMENT, size) != 0) {
+    return nullptr;
+  }
+  return ptr;
+#endif
+}
+
+void aligned_free(void *ptr) {
+#ifdef _WIN32
+  ::_aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+}  // namespace
+
+namespace primitiv {
+
+const unsigned HostMemoryPool::ALIGNMENT;
+
+std::atomic<std::uint64_t> HostMemoryPool::next_pool_id_(0);
+
+HostMemoryPool::HostMemoryPool(std::uint64_t max_reserved_bytes)
+: pool_id_(next_pool_id_++)
+, link_(new Link())
+, max_reserved_bytes_(max_reserved_bytes)
+, reserved_(::MAX_SCALE + 1)
+, supplied_()
+, stats_() {
+  link_->pool = this;
+}
+
+HostMemoryPool::~HostMemoryPool() {
+  // Detaches this object from deleters of memories still in use.
+  std::lock_guard<std::mutex> lock(link_->mtx);
+  link_->pool = nullptr;
+
+  // NOTE:
+  // Due to GC-based languages, we chouldn't assume that all memories were
+  // disposed before arriving this code.
+  for (const auto &kv : supplied_) ::aligned_free(kv.first);
+  supplied_.clear();
+  shrink_reserved_blocks(0);
+}
+
+std::shared_ptr<void> HostMemoryPool::allocate(std::uint64_t size) {
+  unsigned scale = ::MIN_SCALE;
+  while (1ull << scale < size) {
+    if (scale == ::MAX_SCALE) {
+      THROW_ERROR(
+          "Attempted to allocate more than 2^" << ::MAX_SCALE << " bytes.");
+    }
+    ++scale;
+  }
+  const std::uint64_t block_size = 1ull << scale;
+
+  std::lock_guard<std::mutex> lock(link_->mtx);
+  void *ptr;
+  if (reserved_[scale].empty()) {
+    // Allocates a new block.
+    ptr = ::aligned_malloc(block_size);
+    if (!ptr) {
+      // Maybe out-of-memory.
+      // Release other blocks and try allocation again.
+      shrink_reserved_blocks(0);
+      ptr = ::aligned_malloc(block_size);
+      if (!ptr) {
+        THROW_ERROR("Memory allocation failed. Requested size: " << size);
+      }
+    }
+  } else {
+    // Returns an existing block.
+    ptr = reserved_[scale].back();
+    reserved_[scale].pop_back();
+    stats_.bytes_reserved -= block_size;
+    ++stats_.num_hits;
+  }
+  supplied_.insert(make_pair(ptr, scale));
+
+  ++stats_.num_allocations;
+  stats_.bytes_in_use += block_size;
+  if (stats_.bytes_in_use > stats_.peak_bytes_in_use) {
+    stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  }
+
+  return std::shared_ptr<void>(ptr, HostMemoryDeleter(link_));
+}
+
+void HostMemoryPool::free(Link &link, void *ptr) {
+  // NOTE: Only the mutex of the corresponding pool is held, which also blocks
+  // the destructor of the pool until `free_inner()` finishes.
+  std::lock_guard<std::mutex> lock(link.mtx);
+  if (link.pool) {
+    // Found a corresponding pool object, delete ptr.
+    link.pool->free_inner(ptr);
+  }
+  // Otherwise, ptr is assumed as to be deleted before calling this function.
+}
+
+void HostMemoryPool::free_inner(void *ptr) {
+  auto it = supplied_.find(ptr);
+  if (it == supplied_.end()) {
+    THROW_ERROR("Detected to dispose unknown handle: " << ptr);
+  }
+
+  const unsigned scale = it->second;
+  const std::uint64_t block_size = 1ull << scale;
+  supplied_.erase(it);
+  stats_.bytes_in_use -= block_size;
+
+  if (stats_.bytes_reserved + block_size > max_reserved_bytes_) {
+    // The pool is full.
+    ::aligned_free(ptr);
+  } else {
+    reserved_[scale].emplace_back(ptr);
+    stats_.bytes_reserved += block_size;
+  }
+}
+
+void HostMemoryPool::release_reserved_blocks() {
+  std::lock_guard<std::mutex> lock(link_->mtx);
+  shrink_reserved_blocks(0);
+}
+
+std::uint64_t HostMemoryPool::get_max_reserved_bytes() const {
+  std::lock_guard<std::mutex> lock(link_->mtx);
+  return max_reserved_bytes_;
+}
+
+void HostMemoryPool::set_max_reserved_bytes(std::uint64_t max_reserved_bytes) {
+  std::lock_guard<std::mutex> lock(link_->mtx);
+  max_reserved_bytes_ = max_reserved_bytes;
+  shrink_reserved_blocks(max_reserved_bytes_);
+}
+
+HostMemoryPool::Statistics HostMemoryPool::get_statistics() const {
+  std::lock_guard<std::mutex> lock(link_->mtx);
+  return stats_;
+}
+
+void HostMemoryPool::shrink_reserved_blocks(std::uint64_t max_reserved_bytes) {
+  // Larger blocks are released first.
+  for (unsigned scale = ::MAX_SCALE + 1; scale-- > ::MIN_SCALE; ) {
+    auto &ptrs = reserved_[scale];
+    while (!ptrs.empty() && stats_.bytes_reserved > max_reserved_bytes) {
+      ::aligned_free(ptrs.back());
+      ptrs.pop_back();
+      stats_.bytes_reserved -= 1ull << scale;
+    }
+  }
+}
+
+}  // namespace primitiv
@@ -0,0 +1,187 @@
+#ifndef PRIMITIV_HOST_MEMORY_POOL_H_
+#define PRIMITIV_HOST_MEMORY_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <primitiv/mixins.h>
+
+namespace primitiv {
+
+class HostMemoryDeleter;
+
+/**
+ * Memory manager on the host memory.
+ * Memory blocks are classified by power-of-two sizes, and released blocks are
+ * reserved in the pool to be reused by following allocations.
+ * All member functions are thread-safe.
+ */
+class HostMemoryPool : mixins::Nonmovable<HostMemoryPool> {
+  friend HostMemoryDeleter;
+
+public:
+  /**
+   * Alignment of all memory blocks in bytes.
+   */
+  static const unsigned ALIGNMENT = 64;
+
+  /**
+   * Statistics of the memory pool.
+   */
+  struct Statistics {
+    /**
+     * Number of calls of `allocate()`.
+     */
+    std::uint64_t num_allocations;
+
+    /**
+     * Number of allocations which reused reserved blocks.
+     */
+    std::uint64_t num_hits;
+
+    /**
+     * Total bytes of blocks supplied to users.
+     */
+    std::uint64_t bytes_in_use;
+
+    /**
+     * Total bytes of blocks reserved in the pool.
+     */
+    std::uint64_t bytes_reserved;
+
+    /**
+     * Maximum value of `bytes_in_use` since the pool was created.
+     */
+    std::uint64_t peak_bytes_in_use;
+
+    /**
+     * Calculates the ratio of allocations which reused reserved blocks.
+     * @return `num_hits / num_allocations`, or 0 if nothing was allocated.
+     */
+    double hit_rate() const {
+      return num_allocations > 0
+        ? static_cast<double>(num_hits) / num_allocations : 0;
+    }
+  };
+
+  /**
+   * Creates a memory pool.
+   * @param max_reserved_bytes Upper bound of the total bytes of reserved
+   *                           blocks. Released blocks exceeding this bound
+   *                           are returned to the system immediately.
+   */
+  explicit HostMemoryPool(
+      std::uint64_t max_reserved_bytes
+        = std::numeric_limits<std::uint64_t>::max());
+
+  ~HostMemoryPool();
+
+  /**
+   * Allocates a memory.
+   * @param size Size of the resulting memory.
+   * @return Shared pointer of the allocated memory, aligned to `ALIGNMENT`
+   *         bytes.
+   * @throw primitiv::Error Memory allocation failed.
+   */
+  std::shared_ptr<void> allocate(std::uint64_t size);
+
+  /**
+   * Returns all reserved memory blocks to the system.
+   */
+  void release_reserved_blocks();
+
+  /**
+   * Retrieves the upper bound of the total bytes of reserved blocks.
+   * @return Upper bound in bytes.
+   */
+  std::uint64_t get_max_reserved_bytes() const;
+
+  /**
+   * Changes the upper bound of the total bytes of reserved blocks.
+   * @param max_reserved_bytes New upper bound in bytes.
+   * @remarks Reserved blocks exceeding the new bound are released.
+   */
+  void set_max_reserved_bytes(std::uint64_t max_reserved_bytes);
+
+  /**
+   * Retrieves current statistics.
+   * @return A `Statistics` object.
+   */
+  Statistics get_statistics() const;
+
+  /**
+   * Retrieves pool ID.
+   * @return pool ID.
+   */
+  std::uint64_t get_pool_id() const { return pool_id_; }
+
+private:
+  /**
+   * Object shared by the pool and its deleters, which outlives the pool while
+   * some memory is still in use.
+   */
+  struct Link {
+    /**
+     * Mutex of all states of the pool.
+     */
+    std::mutex mtx;
+
+    /**
+     * Pointer to the pool, or `nullptr` after the pool is destroyed.
+     */
+    HostMemoryPool *pool;
+  };
+
+  /**
+   * Disposes the memory.
+   * @param link Link of the HostMemoryPool.
+   * @param ptr Handle of the memory to be disposed.
+   */
+  static void free(Link &link, void *ptr);
+
+  /**
+   * Disposes the memory managed by this pool.
+   * @param ptr Handle of the memory to be disposed.
+   * @remarks `link_->mtx` should be locked by the caller.
+   */
+  void free_inner(void *ptr);
+
+  /**
+   * Returns reserved blocks to the system until the total bytes of reserved
+   * blocks becomes less than or equal to `max_reserved_bytes`.
+   * @param max_reserved_bytes Upper bound in bytes.
+   * @remarks `link_->mtx` should be locked by the caller.
+   */
+  void shrink_reserved_blocks(std::uint64_t max_reserved_bytes);
+
+  static std::atomic<std::uint64_t> next_pool_id_;
+
+  std::uint64_t pool_id_;
+  std::shared_ptr<Link> link_;
+  std::uint64_t max_reserved_bytes_;
+  std::vector<std::vector<void *>> reserved_;
+  std::unordered_map<void *, unsigned> supplied_;
+  Statistics stats_;
+};
+
+/**
+ * Custom deleter class for host memories.
+ */
+class HostMemoryDeleter {
+  HostMemoryDeleter() = delete;
+public:
+  explicit HostMemoryDeleter(const std::shared_ptr<HostMemoryPool::Link> &link)
+    : link_(link) {}
+  void operator()(void *ptr) { HostMemoryPool::free(*link_, ptr); }
+private:
+  std::shared_ptr<HostMemoryPool::Link> link_;
+};
+
+}  // namespace primitiv
+
+#endif  // PRIMITIV_HOST_MEMORY_POOL_H_
@@ -5,27 +5,248 @@
 #include <cstring>
 #include <cmath>
 #include <iostream>
-#include <primitiv/naive_device.h>
 #include <primitiv/error.h>
+#include <primitiv/gemm.h>
+#include <primitiv/naive_device.h>
+#include <primitiv/thread_pool.h>
+#include <primitiv/vmath.h>
 
 using std::cerr;
 using std::endl;
 
+namespace {
+
+// Approximate number of operations processed by one task at least.
+const unsigned PARALLEL_GRAIN = 1 << 14;
+
+// Number of elements processed at once by fused elementwise operations.
+const unsigned ELEMENTWISE_BLOCK = 256;
+
+// Number of elements summed up by one task of reductions over many tensors.
+const unsigned REDUCTION_BLOCK = 1 << 12;
+
+// Number of independent accumulators used in reductions.
+const unsigned REDUCTION_LANES = 8;
+
+// Retrieves data pointers of all tensors before running parallel loops.
+std::vector<const float *> cdata_list(
+    const std::vector<const primitiv::Tensor *> &xs) {
+  std::vector<const float *> ret;
+  ret.reserve(xs.size());
+  for (const primitiv::Tensor *x : xs) {
+    ret.emplace_back(static_cast<const float *>(x->data()));
+  }
+  return ret;
+}
+
+std::vector<float *> data_list(const std::vector<primitiv::Tensor *> &xs) {
+  std::vector<float *> ret;
+  ret.reserve(xs.size());
+  for (primitiv::Tensor *x : xs) {
+    ret.emplace_back(static_cast<float *>(x->data()));
+  }
+  return ret;
+}
+
+// Calculates one instruction for `n` elements.
+void elementwise_fw_block(
+    const primitiv::elementwise::Instruction &inst,
+    const float *pa, const float *pb, unsigned n, float *py) {
+  using namespace primitiv::elementwise;
+  namespace vmath = primitiv::vmath;
+  const float k = inst.k;
+#define LOOP(op) for (unsigned i = 0; i < n; ++i) py[i] = (op); break;
+  switch (inst.opcode) {
+    case POSITIVE: LOOP(pa[i]);
+    case NEGATIVE: LOOP(-pa[i]);
+    case SQRT: LOOP(std::sqrt(pa[i]));
+    case EXP: vmath::exp(n, pa, py); break;
+    case LOG: vmath::log(n, pa, py); break;
+    case TANH: vmath::tanh(n, pa, py); break;
+    case SIGMOID: vmath::sigmoid(n, pa, py); break;
+    case SOFTPLUS: vmath::softplus(n, pa, py); break;
+    case SIN: LOOP(std::sin(pa[i]));
+    case COS: LOOP(std::cos(pa[i]));
+    case TAN: LOOP(std::tan(pa[i]));
+    case ADD_CONST: LOOP(pa[i] + k);
+    case SUBTRACT_CONST_R: LOOP(pa[i] - k);
+    case SUBTRACT_CONST_L: LOOP(k - pa[i]);
+    case MULTIPLY_CONST: LOOP(pa[i] * k);
+    case DIVIDE_CONST_R: LOOP(pa[i] / k);
+    case DIVIDE_CONST_L: LOOP(k / pa[i]);
+    case PRELU: LOOP(pa[i] * ((pa[i] > 0) + k * (pa[i] <= 0)));
+    case ELU:
+      LOOP(pa[i] * (pa[i] > 0) + k * (std::exp(pa[i] * (pa[i] <= 0)) - 1));
+    case ADD: LOOP(pa[i] + pb[i]);
+    case SUBTRACT: LOOP(pa[i] - pb[i]);
+    case MULTIPLY: LOOP(pa[i] * pb[i]);
+    case DIVIDE: LOOP(pa[i] / pb[i]);
+  }
+#undef LOOP
+}
+
+// Accumulates gradients of one instruction for `n` elements.
+// `tmp` is a workspace with `n` elements.
+void elementwise_bw_block(
+    const primitiv::elementwise::Instruction &inst,
+    const float *pa, const float *pb, const float *py, const float *pgy,
+    unsigned n, float *pga, float *pgb, float *tmp) {
+  using namespace primitiv::elementwise;
+  namespace vmath = primitiv::vmath;
+  const float k = inst.k;
+#define LOOP(op) for (unsigned i = 0; i < n; ++i) { op; } break;
+  switch (inst.opcode) {
+    case POSITIVE: LOOP(pga[i] += pgy[i]);
+    case NEGATIVE: LOOP(pga[i] -= pgy[i]);
+    case SQRT: LOOP(pga[i] += .5 * pgy[i] / py[i]);
+    case EXP: LOOP(pga[i] += py[i] * pgy[i]);
+    case LOG: LOOP(pga[i] += pgy[i] / pa[i]);
+    case TANH: LOOP(pga[i] += (1. - py[i] * py[i]) * pgy[i]);
+    case SIGMOID: LOOP(pga[i] += py[i] * (1. - py[i]) * pgy[i]);
+    case SOFTPLUS:
+      vmath::sigmoid(n, pa, tmp);
+      LOOP(pga[i] += tmp[i] * pgy[i]);
+    case SIN: LOOP(pga[i] += std::cos(pa[i]) * pgy[i]);
+    case COS: LOOP(pga[i] += -std::sin(pa[i]) * pgy[i]);
+    case TAN: LOOP(pga[i] += (1 + py[i] * py[i]) * pgy[i]);
+    case ADD_CONST: LOOP(pga[i] += pgy[i]);
+    case SUBTRACT_CONST_R: LOOP(pga[i] += pgy[i]);
+    case SUBTRACT_CONST_L: LOOP(pga[i] += -pgy[i]);
+    case MULTIPLY_CONST: LOOP(pga[i] += k * pgy[i]);
+    case DIVIDE_CONST_R: LOOP(pga[i] += pgy[i] / k);
+    case DIVIDE_CONST_L: LOOP(pga[i] += -py[i] * pgy[i] / pa[i]);
+    case PRELU: LOOP(pga[i] += pgy[i] * ((pa[i] > 0) + k * (pa[i] <= 0)));
+    case ELU:
+      LOOP(pga[i] += pgy[i] * ((pa[i] > 0) + (py[i] + k) * (pa[i] <= 0)));
+    case ADD: LOOP(const float g = pgy[i]; pga[i] += g; pgb[i] += g);
+    case SUBTRACT: LOOP(const float g = pgy[i]; pga[i] += g; pgb[i] -= g);
+    case MULTIPLY:
+      LOOP(const float g = pgy[i]; pga[i] += g * pb[i]; pgb[i] += g * pa[i]);
+    case DIVIDE:
+      LOOP(const float g = pgy[i] / pb[i]; pga[i] += g; pgb[i] -= g * py[i]);
+  }
+#undef LOOP
+}
+
+// Number of elements processed at once by softmax operations.
+const unsigned SOFTMAX_BLOCK = 256;
+
+// Calculates the maximum `m` and the sum of `exp(x - m)` along the dimension.
+// `px` holds `n` rows of `skip` values, and the statistics are calculated for
+// each of `skip` columns in one pass over `px`. When the maximum is updated,
+// the partial sum is rescaled by `exp(m_old - m_new)`.
+// `buf` should have `2 * SOFTMAX_BLOCK` elements.
+void softmax_stats(
+    const float *px, unsigned n, unsigned skip, float *pm, float *ps,
+    float *buf) {
+  namespace vmath = primitiv::vmath;
+  if (skip == 1) {
+    float m = px[0], sum = 0;
+    for (unsigned j = 0; j < n; j += SOFTMAX_BLOCK) {
+      const unsigned size = std::min(SOFTMAX_BLOCK, n - j);
+      const float *src = px + j;
+      float block_m = src[0];
+      for (unsigned i = 1; i < size; ++i) block_m = std::max(block_m, src[i]);
+      if (block_m > m) {
+        sum *= std::exp(m - block_m);
+        m = block_m;
+      }
+      for (unsigned i = 0; i < size; ++i) buf[i] = src[i] - m;
+      vmath::exp(size, buf, buf);
+      for (unsigned i = 0; i < size; ++i) sum += buf[i];
+    }
+    *pm = m;
+    *ps = sum;
+    return;
+  }
+
+  for (unsigned k = 0; k < skip; k += SOFTMAX_BLOCK) {
+    const unsigned size = std::min(SOFTMAX_BLOCK, skip - k);
+    float *m = pm + k;
+    float *sum = ps + k;
+    std::copy(px + k, px + k + size, m);
+    std::fill(sum, sum + size, 0);
+    for (unsigned j = 0; j < n; ++j) {
+      const float *src = px + j * skip + k;
+      for (unsigned i = 0; i < size; ++i) {
+        const float new_m = std::max(m[i], src[i]);
+        buf[i] = m[i] - new_m;
+        buf[size + i] = src[i] - new_m;
+        m[i] = new_m;
+      }
+      vmath::exp(2 * size, buf, buf);
+      for (unsigned i = 0; i < size; ++i) {
+        sum[i] = sum[i] * buf[i] + buf[size + i];
+      }
+    }
+  }
+}
+
+// Calculates `post(t, k, exp(pre(t, k)))` for `t` in `[0, size)`, where `k`
+// is the column index `t % skip`. Exponentials are calculated by blocks.
+template<typename Pre, typename Post>
+void softmax_exp_loop(unsigned size, unsigned skip, Pre pre, Post post) {
+  float buf[SOFTMAX_BLOCK];
+  for (unsigned t = 0, k0 = 0; t < size; t += SOFTMAX_BLOCK) {
+    const unsigned block_size = std::min(SOFTMAX_BLOCK, size - t);
+    for (unsigned u = 0, k = k0; u < block_size; ++u) {
+      buf[u] = pre(t + u, k);
+      if (++k == skip) k = 0;
+    }
+    primitiv::vmath::exp(block_size, buf, buf);
+    for (unsigned u = 0, k = k0; u < block_size; ++u) {
+      post(t + u, k, buf[u]);
+      if (++k == skip) k = 0;
+    }
+    k0 = (k0 + block_size) % skip;
+  }
+}
+
+}  // namespace
+
 namespace primitiv {
 namespace devices {
 
 void Naive::dump_description() const {
   cerr << "Device " << this << ':' << endl;
   cerr << "  Type: Naive" << endl;
+  cerr << "  Threads: " << num_threads() << endl;
 }
 
-std::shared_ptr<void> Naive::new_handle(const Shape &shape) {
-  const unsigned mem_size = sizeof(float) * shape.size();
-  void *data = std::malloc(mem_size);
-  if (!data) {
-    THROW_ERROR("Memory allocation failed. Requested size: " << mem_size);
+void Naive::parallel_for(
+    unsigned size, unsigned cost,
+    const std::function<void(unsigned, unsigned)> &fn) {
+  const unsigned grain = std::max(1u, ::PARALLEL_GRAIN / std::max(1u, cost));
+  if (!pool_ || size <= grain) {
+    fn(0, size);
+    return;
   }
-  return std::shared_ptr<void>(data, std::free);
+  pool_->parallel_for(size, grain, fn);
+}
+
+void Naive::multi_tensor_for(
+    const std::vector<Tensor *> &xs, unsigned cost,
+    const std::function<void(unsigned, unsigned, unsigned)> &fn) {
+  // NOTE:
+  // Small tensors are concatenated virtually to share one parallel loop.
+  std::vector<unsigned> offsets { 0 };
+  offsets.reserve(xs.size() + 1);
+  for (const Tensor *x : xs) {
+    offsets.emplace_back(offsets.back() + x->shape().size());
+  }
+  parallel_for(offsets.back(), cost, [&](unsigned begin, unsigned end) {
+    unsigned i = std::upper_bound(
+        offsets.begin(), offsets.end(), begin) - offsets.begin() - 1;
+    for (; i < xs.size() && offsets[i] < end; ++i) {
+      const unsigned lo = std::max(begin, offsets[i]) - offsets[i];
+      const unsigned hi = std::min(end, offsets[i + 1]) - offsets[i];
+      fn(i, lo, hi);
+    }
+  });
+}
+
+std::shared_ptr<void> Naive::new_handle(const Shape &shape) {
+  return memory_pool_.allocate(sizeof(float) * shape.size());
 }
 
 #define DATA(x) static_cast<float *>((x).data())
@@ -94,7 +315,9 @@ std::vector<unsigned> Naive::argmin_impl(const Tensor &x, unsigned dim) {
 void Naive::reset_tensor_impl(float k, Tensor &x) {
   float *dest = DATA(x);
   const unsigned size = x.shape().size();
-  REPEAT_OP(i, size, dest[i] = k);
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) dest[i] = k;
+  });
 }
 
 void Naive::reset_tensor_by_array_impl(const float values[], Tensor &x) {
@@ -160,14 +383,17 @@ void Naive::pick_fw_impl(
   const unsigned repeat = y.shape().volume() / base;
 
   float *dest = DATA(y);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    const float *src = CDATA(x) + batch * skip_x + base * ids[batch * skip_i];
-    for (unsigned i = 0; i < repeat; ++i) {
-      const float *sp = src;
-      REPEAT_OP(j, base, *dest++ = *sp++);
-      src += skip;
+  const float *src = CDATA(x);
+  parallel_for(bs * repeat, base, [&](unsigned begin, unsigned end) {
+    for (unsigned k = begin; k < end; ++k) {
+      const unsigned batch = k / repeat;
+      const unsigned i = k % repeat;
+      const float *sp =
+        src + batch * skip_x + base * ids[batch * skip_i] + i * skip;
+      float *dp = dest + k * base;
+      for (unsigned j = 0; j < base; ++j) dp[j] = sp[j];
     }
-  }
+  });
 }
 
 void Naive::slice_fw_impl(
@@ -179,11 +405,13 @@ void Naive::slice_fw_impl(
 
   float *dest = DATA(y);
   const float *src = CDATA(x) + base * offset;
-  for (unsigned i = 0; i < repeat; ++i) {
-    const float *sp = src;
-    REPEAT_OP(j, span, *dest++ = *sp++);
-    src += skip;
-  }
+  parallel_for(repeat, span, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const float *sp = src + i * skip;
+      float *dp = dest + i * span;
+      for (unsigned j = 0; j < span; ++j) dp[j] = sp[j];
+    }
+  });
 }
 
 void Naive::concat_fw_impl(
@@ -200,15 +428,15 @@ void Naive::concat_fw_impl(
     const unsigned b_skip = x->shape().has_batch() * span * repeat;
     float *dest = DATA(y) + offset;
     const float *src = CDATA(*x);
-    for (unsigned batch = 0; batch < new_bs; ++batch) {
-      const float *sp = src;
-      for (unsigned i = 0; i < repeat; ++i) {
-        float *dp = dest;
-        REPEAT_OP(j, span, *dp++ = *sp++);
-        dest += skip;
+    parallel_for(new_bs * repeat, span, [&](unsigned begin, unsigned end) {
+      for (unsigned k = begin; k < end; ++k) {
+        const unsigned batch = k / repeat;
+        const unsigned i = k % repeat;
+        const float *sp = src + batch * b_skip + i * span;
+        float *dp = dest + k * skip;
+        for (unsigned j = 0; j < span; ++j) dp[j] = sp[j];
       }
-      src += b_skip;
-    }
+    });
     offset += span;
   }
 }
@@ -223,14 +451,21 @@ void Naive::pick_bw_impl(
   const unsigned skip = base * gx.shape()[dim];
   const unsigned repeat = gy.shape().volume() / base;
   const float *src = CDATA(gy);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    float *dest = DATA(gx) + batch * skip_x + base * ids[batch * skip_i];
-    for (unsigned i = 0; i < repeat; ++i) {
-      float *dp = dest;
-      REPEAT_OP(j, base, *dp++ += *src++);
-      dest += skip;
+  float *dest = DATA(gx);
+  // NOTE:
+  // Multiple minibatches may be accumulated into the same row of `gx`, so the
+  // work is divided along `repeat` to keep the order of accumulation.
+  parallel_for(repeat, bs * base, [&](unsigned begin, unsigned end) {
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      float *dp = dest + batch * skip_x + base * ids[batch * skip_i];
+      const float *sp = src + batch * repeat * base;
+      for (unsigned i = begin; i < end; ++i) {
+        float *ddp = dp + i * skip;
+        const float *ssp = sp + i * base;
+        for (unsigned j = 0; j < base; ++j) ddp[j] += ssp[j];
+      }
     }
-  }
+  });
 }
 
 void Naive::slice_bw_impl(
@@ -246,17 +481,17 @@ void Naive::slice_bw_impl(
   const unsigned b_skip_s = sy.has_batch() * sy.volume();
   float *dest = DATA(gx) + base * offset;
   const float *src = CDATA(gy);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    float *dp = dest;
-    const float *sp = src;
-    for (unsigned i = 0; i < repeat; ++i) {
-      float *ddp = dp;
-      REPEAT_OP(j, span, *ddp++ += *sp++);
-      dp += skip;
-    }
-    dest += b_skip_d;
-    src += b_skip_s;
-  }
+  parallel_for(repeat, bs * span, [&](unsigned begin, unsigned end) {
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      float *dp = dest + batch * b_skip_d;
+      const float *sp = src + batch * b_skip_s;
+      for (unsigned i = begin; i < end; ++i) {
+        float *ddp = dp + i * skip;
+        const float *ssp = sp + i * span;
+        for (unsigned j = 0; j < span; ++j) ddp[j] += ssp[j];
+      }
+    }
+  });
 }
 
 #define CPUDEV_FW_X(name, op) \
@@ -264,7 +499,19 @@ void Naive::name##_fw_impl(const Tensor &x, Tensor &y) { \
   float *dest = DATA(y); \
   const float *src = CDATA(x); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, dest[i] = (op)); \
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) { \
+    for (unsigned i = begin; i < end; ++i) dest[i] = (op); \
+  }); \
+}
+
+#define CPUDEV_FW_X_VMATH(name) \
+void Naive::name##_fw_impl(const Tensor &x, Tensor &y) { \
+  float *dest = DATA(y); \
+  const float *src = CDATA(x); \
+  const unsigned size = x.shape().size(); \
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) { \
+    vmath::name(end - begin, src + begin, dest + begin); \
+  }); \
 }
 
 #define CPUDEV_BW_X(name, op) \
@@ -275,7 +522,9 @@ void Naive::name##_bw_impl( \
   const float *pgy = CDATA(gy); \
   float *pgx = DATA(gx); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, pgx[i] += (op)); \
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) { \
+    for (unsigned i = begin; i < end; ++i) pgx[i] += (op); \
+  }); \
 }
 
 #define CPUDEV_FW_X_CONST(name, op) \
@@ -283,7 +532,9 @@ void Naive::name##_fw_impl(const Tensor &x, float k, Tensor &y) { \
   float *dest = DATA(y); \
   const float *src = CDATA(x); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, dest[i] = (op)); \
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) { \
+    for (unsigned i = begin; i < end; ++i) dest[i] = (op); \
+  }); \
 }
 
 #define CPUDEV_BW_X_CONST(name, op) \
@@ -294,7 +545,9 @@ void Naive::name##_bw_impl( \
   const float *pgy = CDATA(gy); \
   float *pgx = DATA(gx); \
   const unsigned size = x.shape().size(); \
-  REPEAT_OP(i, size, pgx[i] += (op)); \
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) { \
+    for (unsigned i = begin; i < end; ++i) pgx[i] += (op); \
+  }); \
 }
 
 #define CPUDEV_FW_X_SCALAR(name, op) \
@@ -303,15 +556,20 @@ void Naive::name##_fw_impl(const Tensor &x, const Tensor &k, Tensor &y) { \
   const unsigned bs = y.shape().batch(); \
   const unsigned skip_x = x.shape().has_batch() * size; \
   const unsigned skip_k = k.shape().has_batch(); \
-  float *dest = DATA(y); \
-  const float *src_x = CDATA(x); \
-  const float *src_k = CDATA(k); \
-  for (unsigned batch = 0; batch < bs; ++batch) { \
-    REPEAT_OP(i, size, dest[i] = (op)); \
-    dest += size; \
-    src_x += skip_x; \
-    src_k += skip_k; \
-  } \
+  float *dest_y = DATA(y); \
+  const float *src_x0 = CDATA(x); \
+  const float *src_k0 = CDATA(k); \
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) { \
+    float *dest = dest_y; \
+    const float *src_x = src_x0; \
+    const float *src_k = src_k0; \
+    for (unsigned batch = 0; batch < bs; ++batch) { \
+      for (unsigned i = begin; i < end; ++i) dest[i] = (op); \
+      dest += size; \
+      src_x += skip_x; \
+      src_k += skip_k; \
+    } \
+  }); \
 }
 
 #define CPUDEV_FW_AB(name, op) \
@@ -320,27 +578,29 @@ void Naive::name##_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) { \
   const unsigned bs = y.shape().batch(); \
   const unsigned skip_a = a.shape().has_batch() * size; \
   const unsigned skip_b = b.shape().has_batch() * size; \
-  float *dest = DATA(y); \
-  const float *src_a = CDATA(a); \
-  const float *src_b = CDATA(b); \
-  for (unsigned batch = 0; batch < bs; ++batch) { \
-    REPEAT_OP(i, size, dest[i] = (op)); \
-    dest += size; \
-    src_a += skip_a; \
-    src_b += skip_b; \
-  } \
+  float *dest_y = DATA(y); \
+  const float *src_a0 = CDATA(a); \
+  const float *src_b0 = CDATA(b); \
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) { \
+    float *dest = dest_y; \
+    const float *src_a = src_a0; \
+    const float *src_b = src_b0; \
+    for (unsigned batch = 0; batch < bs; ++batch) { \
+      for (unsigned i = begin; i < end; ++i) dest[i] = (op); \
+      dest += size; \
+      src_a += skip_a; \
+      src_b += skip_b; \
+    } \
+  }); \
 }
 
 CPUDEV_FW_X(negate, -src[i]);
 CPUDEV_FW_X(sqrt, std::sqrt(src[i]));
-CPUDEV_FW_X(exp, std::exp(src[i]));
-CPUDEV_FW_X(log, std::log(src[i]));
-CPUDEV_FW_X(tanh, std::tanh(src[i]));
-CPUDEV_FW_X(sigmoid, .5 + .5 * std::tanh(.5 * src[i]));
-CPUDEV_FW_X(
-    softplus, src[i] > 0
-      ? src[i] + std::log(1 + std::exp(-src[i]))
-      : std::log(1 + std::exp(src[i])));
+CPUDEV_FW_X_VMATH(exp);
+CPUDEV_FW_X_VMATH(log);
+CPUDEV_FW_X_VMATH(tanh);
+CPUDEV_FW_X_VMATH(sigmoid);
+CPUDEV_FW_X_VMATH(softplus);
 CPUDEV_FW_X(sin, std::sin(src[i]));
 CPUDEV_FW_X(cos, std::cos(src[i]));
 CPUDEV_FW_X(tan, std::tan(src[i]));
@@ -350,7 +610,6 @@ CPUDEV_BW_X(exp, py[i] * pgy[i]);
 CPUDEV_BW_X(log, pgy[i] / px[i]);
 CPUDEV_BW_X(tanh, (1. - py[i] * py[i]) * pgy[i]);
 CPUDEV_BW_X(sigmoid, py[i] * (1. - py[i]) * pgy[i]);
-CPUDEV_BW_X(softplus, (.5 + .5 * std::tanh(.5 * px[i])) * pgy[i]);
 CPUDEV_BW_X(sin, std::cos(px[i]) * pgy[i]);
 CPUDEV_BW_X(cos, -std::sin(px[i]) * pgy[i]);
 CPUDEV_BW_X(tan, (1 + py[i] * py[i]) * pgy[i]);
@@ -387,12 +646,31 @@ CPUDEV_FW_AB(multiply, src_a[i] * src_b[i]);
 CPUDEV_FW_AB(divide, src_a[i] / src_b[i]);
 
 #undef CPUDEV_FW_X
+#undef CPUDEV_FW_X_VMATH
 #undef CPUDEV_BW_X
 #undef CPUDEV_FW_X_CONST
 #undef CPUDEV_BW_X_CONST
 #undef CPUDEV_FW_X_SCALAR
 #undef CPUDEV_FW_AB
 
+void Naive::softplus_bw_impl(
+    const Tensor &x, const Tensor &, const Tensor &gy, Tensor &gx) {
+  const float *px = CDATA(x);
+  const float *pgy = CDATA(gy);
+  float *pgx = DATA(gx);
+  const unsigned size = x.shape().size();
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) {
+    // d/dx softplus(x) = sigmoid(x), calculated for each small block.
+    const unsigned BLOCK_SIZE = 256;
+    float sig[BLOCK_SIZE];
+    for (unsigned i = begin; i < end; i += BLOCK_SIZE) {
+      const unsigned n = std::min(BLOCK_SIZE, end - i);
+      vmath::sigmoid(n, px + i, sig);
+      for (unsigned j = 0; j < n; ++j) pgx[i + j] += sig[j] * pgy[i + j];
+    }
+  });
+}
+
 void Naive::add_bw_impl(
     const Tensor &, const Tensor &, const Tensor &, const Tensor &gy,
     Tensor &ga, Tensor &gb) {
@@ -400,19 +678,24 @@ void Naive::add_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i];
-      pga[i] += k;
-      pgb[i] += k;
-    }
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *src_gy = CDATA(gy);
+  float *dest_ga = DATA(ga);
+  float *dest_gb = DATA(gb);
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    const float *pgy = src_gy;
+    float *pga = dest_ga;
+    float *pgb = dest_gb;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i];
+        pga[i] += k;
+        pgb[i] += k;
+      }
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::subtract_bw_impl(
@@ -422,19 +705,24 @@ void Naive::subtract_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i];
-      pga[i] += k;
-      pgb[i] -= k;
-    }
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *src_gy = CDATA(gy);
+  float *dest_ga = DATA(ga);
+  float *dest_gb = DATA(gb);
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    const float *pgy = src_gy;
+    float *pga = dest_ga;
+    float *pgb = dest_gb;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i];
+        pga[i] += k;
+        pgb[i] -= k;
+      }
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::multiply_bw_impl(
@@ -444,23 +732,30 @@ void Naive::multiply_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pa = CDATA(a);
-  const float *pb = CDATA(b);
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i];
-      pga[i] += k * pb[i];
-      pgb[i] += k * pa[i];
-    }
-    pa += skip_a;
-    pb += skip_b;
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
-  }
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+  const float *src_gy = CDATA(gy);
+  float *dest_ga = DATA(ga);
+  float *dest_gb = DATA(gb);
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    const float *pa = src_a;
+    const float *pb = src_b;
+    const float *pgy = src_gy;
+    float *pga = dest_ga;
+    float *pgb = dest_gb;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i];
+        pga[i] += k * pb[i];
+        pgb[i] += k * pa[i];
+      }
+      pa += skip_a;
+      pb += skip_b;
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
 }
 
 void Naive::divide_bw_impl(
@@ -470,22 +765,174 @@ void Naive::divide_bw_impl(
   const unsigned bs = gy.shape().batch();
   const unsigned skip_a = ga.shape().has_batch() * size;
   const unsigned skip_b = gb.shape().has_batch() * size;
-  const float *pb = CDATA(b);
-  const float *py = CDATA(y);
-  const float *pgy = CDATA(gy);
-  float *pga = DATA(ga);
-  float *pgb = DATA(gb);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < size; ++i) {
-      const float k = pgy[i] / pb[i];
-      pga[i] += k;
-      pgb[i] -= k * py[i];
-    }
-    pb += skip_b;
-    py += size;
-    pgy += size;
-    pga += skip_a;
-    pgb += skip_b;
+  const float *src_b = CDATA(b);
+  const float *src_y = CDATA(y);
+  const float *src_gy = CDATA(gy);
+  float *dest_ga = DATA(ga);
+  float *dest_gb = DATA(gb);
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    const float *pb = src_b;
+    const float *py = src_y;
+    const float *pgy = src_gy;
+    float *pga = dest_ga;
+    float *pgb = dest_gb;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) {
+        const float k = pgy[i] / pb[i];
+        pga[i] += k;
+        pgb[i] -= k * py[i];
+      }
+      pb += skip_b;
+      py += size;
+      pgy += size;
+      pga += skip_a;
+      pgb += skip_b;
+    }
+  });
+}
+
+void Naive::elementwise_fw_impl(
+    const std::vector<const Tensor *> &xs, const elementwise::Program &prog,
+    Tensor &y) {
+  const unsigned size = y.shape().volume();
+  const unsigned bs = y.shape().batch();
+  const unsigned num_inputs = prog.num_inputs;
+  const unsigned num_regs = prog.num_registers();
+  const unsigned last = num_regs - 1;
+
+  // NOTE:
+  // Inputs with the batch size 1 or scalar inputs are broadcasted by the
+  // following strides.
+  std::vector<const float *> src(num_inputs);
+  std::vector<bool> bcast(num_inputs);
+  std::vector<unsigned> skip(num_inputs);
+  for (unsigned j = 0; j < num_inputs; ++j) {
+    const Shape &s = xs[j]->shape();
+    src[j] = CDATA(*xs[j]);
+    bcast[j] = s.volume() != size;
+    skip[j] = s.has_batch() * s.volume();
+  }
+  float *dest = DATA(y);
+
+  const unsigned cost = bs * prog.code.size();
+  parallel_for(size, cost, [&](unsigned begin, unsigned end) {
+    const unsigned B = ::ELEMENTWISE_BLOCK;
+    std::vector<float> buf(num_regs * B);
+    std::vector<const float *> reg(num_regs);
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; i += B) {
+        const unsigned n = std::min(B, end - i);
+        for (unsigned j = 0; j < num_inputs; ++j) {
+          const float *p = src[j] + batch * skip[j];
+          if (bcast[j]) {
+            float *b = &buf[j * B];
+            std::fill(b, b + n, *p);
+            reg[j] = b;
+          } else {
+            reg[j] = p + i;
+          }
+        }
+        for (unsigned t = 0; t < prog.code.size(); ++t) {
+          const elementwise::Instruction &inst = prog.code[t];
+          const unsigned r = num_inputs + t;
+          float *out = r == last ? dest + batch * size + i : &buf[r * B];
+          ::elementwise_fw_block(
+              inst, reg[inst.args[0]], reg[inst.args[1]], n, out);
+          reg[r] = out;
+        }
+      }
+    }
+  });
+}
+
+void Naive::elementwise_bw_impl(
+    const std::vector<const Tensor *> &xs, const Tensor &y, const Tensor &gy,
+    const elementwise::Program &prog, const std::vector<Tensor *> &gxs) {
+  const unsigned size = y.shape().volume();
+  const unsigned bs = y.shape().batch();
+  const unsigned num_inputs = prog.num_inputs;
+  const unsigned num_regs = prog.num_registers();
+  const unsigned last = num_regs - 1;
+
+  // NOTE:
+  // Gradients of broadcasted scalars are stored to temporary arrays and
+  // summed up after the parallel loop to keep the order of additions.
+  std::vector<const float *> src(num_inputs);
+  std::vector<float *> grad(num_inputs);
+  std::vector<bool> bcast(num_inputs);
+  std::vector<unsigned> skip(num_inputs);
+  std::vector<std::vector<float>> scalar_grads(num_inputs);
+  for (unsigned j = 0; j < num_inputs; ++j) {
+    const Shape &s = xs[j]->shape();
+    src[j] = CDATA(*xs[j]);
+    grad[j] = DATA(*gxs[j]);
+    bcast[j] = s.volume() != size;
+    skip[j] = s.has_batch() * s.volume();
+    if (bcast[j]) scalar_grads[j].assign(size * bs, 0);
+  }
+  const float *src_y = CDATA(y);
+  const float *src_gy = CDATA(gy);
+
+  const unsigned cost = 2 * bs * prog.code.size();
+  parallel_for(size, cost, [&](unsigned begin, unsigned end) {
+    const unsigned B = ::ELEMENTWISE_BLOCK;
+    std::vector<float> buf(num_regs * B);
+    std::vector<float> gbuf(num_regs * B);
+    std::vector<float> tmp(B);
+    std::vector<const float *> reg(num_regs);
+    std::vector<float *> greg(num_regs);
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; i += B) {
+        const unsigned n = std::min(B, end - i);
+        const unsigned offset = batch * size + i;
+
+        // Recalculates values except the result.
+        for (unsigned j = 0; j < num_inputs; ++j) {
+          const float *p = src[j] + batch * skip[j];
+          if (bcast[j]) {
+            float *b = &buf[j * B];
+            std::fill(b, b + n, *p);
+            reg[j] = b;
+            greg[j] = &scalar_grads[j][offset];
+          } else {
+            reg[j] = p + i;
+            greg[j] = grad[j] + batch * skip[j] + i;
+          }
+        }
+        for (unsigned t = 0; t + 1 < prog.code.size(); ++t) {
+          const elementwise::Instruction &inst = prog.code[t];
+          const unsigned r = num_inputs + t;
+          float *out = &buf[r * B];
+          ::elementwise_fw_block(
+              inst, reg[inst.args[0]], reg[inst.args[1]], n, out);
+          reg[r] = out;
+          greg[r] = &gbuf[r * B];
+          std::fill(greg[r], greg[r] + n, 0);
+        }
+        reg[last] = src_y + offset;
+
+        // Propagates gradients in the reverse order.
+        for (unsigned t = prog.code.size(); t-- > 0; ) {
+          const elementwise::Instruction &inst = prog.code[t];
+          const unsigned r = num_inputs + t;
+          const float *pgy = r == last ? src_gy + offset : greg[r];
+          ::elementwise_bw_block(
+              inst, reg[inst.args[0]], reg[inst.args[1]], reg[r], pgy, n,
+              greg[inst.args[0]], greg[inst.args[1]], &tmp[0]);
+        }
+      }
+    }
+  });
+
+  for (unsigned j = 0; j < num_inputs; ++j) {
+    if (!bcast[j]) continue;
+    const bool has_batch = xs[j]->shape().has_batch();
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      const float *g = &scalar_grads[j][batch * size];
+      float sum = 0;
+      for (unsigned i = 0; i < size; ++i) sum += g[i];
+      grad[j][has_batch * batch] += sum;
+    }
   }
 }
 
@@ -516,26 +963,42 @@ void Naive::matmul_fw_impl(const Tensor &a, const Tensor &b, Tensor &y) {
   const unsigned d2 = a.shape()[1];
   const unsigned d3 = b.shape()[1];
   const unsigned bs = y.shape().batch();
-  const unsigned dest_shift = d1 * d3;
-  const unsigned src_a_shift = a.shape().has_batch() * d1 * d2;
-  const unsigned src_b_shift = b.shape().has_batch() * d2 * d3;
-
   float *dest = DATA(y);
   const float *src_a = CDATA(a);
   const float *src_b = CDATA(b);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    for (unsigned i = 0; i < d1; ++i) {
-      for (unsigned ky = 0, kb = 0; ky < dest_shift; ky += d1, kb += d2) {
-        float tmp = 0;
-        for (unsigned ja = 0, jb = 0; jb < d2; ja += d1, ++jb) {
-          tmp += src_a[i + ja] * src_b[jb + kb];
-        }
-        dest[i + ky] = tmp;
-      }
+
+  const cpu_features::Isa isa = cpu_features::max_isa();
+
+  if (!a.shape().has_batch()) {
+    // NOTE:
+    // Minibatched columns of `b` and `y` are placed contiguously, and they can
+    // be treated as one large matrix.
+    gemm::sgemm(
+        false, false, d1, d3 * bs, d2, src_a, d1, src_b, d2, false, dest, d1,
+        isa, pool_.get());
+    return;
+  }
+
+  const unsigned dest_shift = d1 * d3;
+  const unsigned src_a_shift = d1 * d2;
+  const unsigned src_b_shift = b.shape().has_batch() * d2 * d3;
+  auto fn = [&](unsigned begin, unsigned end) {
+    for (unsigned batch = begin; batch < end; ++batch) {
+      gemm::sgemm(
+          false, false, d1, d3, d2,
+          src_a + batch * src_a_shift, d1, src_b + batch * src_b_shift, d2,
+          false, dest + batch * dest_shift, d1, isa, pool_.get());
     }
-    dest += dest_shift;
-    src_a += src_a_shift;
-    src_b += src_b_shift;
+  };
+
+  // NOTE:
+  // Each product is parallelized by itself if there are not enough minibatches.
+  if (bs >= num_threads()) {
+    const unsigned cost = std::min<unsigned long long>(
+        1ull * d1 * d2 * d3, ::PARALLEL_GRAIN);
+    parallel_for(bs, cost, fn);
+  } else {
+    fn(0, bs);
   }
 }
 
@@ -548,9 +1011,69 @@ void Naive::transpose_bw_impl(
 void Naive::matmul_bw_impl(
     const Tensor &a, const Tensor &b, const Tensor &, const Tensor &gy,
     Tensor &ga, Tensor &gb) {
-  // TODO(odashi): This code could be slow and requires memory. Fix this.
-  inplace_add_impl(matmul_fw(gy, transpose_fw(b)), ga);
-  inplace_add_impl(matmul_fw(transpose_fw(a), gy), gb);
+  // ga += gy . b^T
+  // gb += a^T . gy
+  const unsigned d1 = a.shape()[0];
+  const unsigned d2 = a.shape()[1];
+  const unsigned d3 = b.shape()[1];
+  const unsigned bs = gy.shape().batch();
+  const float *src_a = CDATA(a);
+  const float *src_b = CDATA(b);
+  const float *src_gy = CDATA(gy);
+  float *dest_ga = DATA(ga);
+  float *dest_gb = DATA(gb);
+  const cpu_features::Isa isa = cpu_features::max_isa();
+  ThreadPool *pool = pool_.get();
+
+  if (!a.shape().has_batch()) {
+    // NOTE:
+    // Minibatched columns of `b`, `gy` and `gb` are placed contiguously, and
+    // the sum of `gy . b^T` over the minibatch becomes one large product.
+    gemm::sgemm(
+        false, true, d1, d2, d3 * bs, src_gy, d1, src_b, d2, true, dest_ga, d1,
+        isa, pool);
+    gemm::sgemm(
+        true, false, d2, d3 * bs, d1, src_a, d1, src_gy, d1, true, dest_gb, d2,
+        isa, pool);
+    return;
+  }
+
+  const unsigned a_shift = d1 * d2;
+  const bool b_has_batch = b.shape().has_batch();
+  const unsigned b_shift = b_has_batch * d2 * d3;
+  const unsigned gy_shift = d1 * d3;
+  auto fn_ga = [&](unsigned begin, unsigned end) {
+    for (unsigned batch = begin; batch < end; ++batch) {
+      gemm::sgemm(
+          false, true, d1, d2, d3,
+          src_gy + batch * gy_shift, d1, src_b + batch * b_shift, d2,
+          true, dest_ga + batch * a_shift, d1, isa, pool);
+    }
+  };
+  auto fn_gb = [&](unsigned begin, unsigned end) {
+    for (unsigned batch = begin; batch < end; ++batch) {
+      gemm::sgemm(
+          true, false, d2, d3, d1,
+          src_a + batch * a_shift, d1, src_gy + batch * gy_shift, d1,
+          true, dest_gb + batch * b_shift, d2, isa, pool);
+    }
+  };
+
+  // NOTE:
+  // Products of different minibatches are processed in parallel except the
+  // accumulation into the shared `gb`, which has to keep the minibatch order.
+  const unsigned cost = std::min<unsigned long long>(
+      1ull * d1 * d2 * d3, ::PARALLEL_GRAIN);
+  if (bs >= num_threads()) {
+    parallel_for(bs, cost, fn_ga);
+  } else {
+    fn_ga(0, bs);
+  }
+  if (b_has_batch && bs >= num_threads()) {
+    parallel_for(bs, cost, fn_gb);
+  } else {
+    fn_gb(0, bs);
+  }
 }
 
 void Naive::sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
@@ -560,36 +1083,246 @@ void Naive::sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
   const unsigned skip2 = skip1 * n;
   float *dest = DATA(y);
   const float *src = CDATA(x);
-  for (unsigned i = 0; i < repeat; ++i) {
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float tmp = 0;
-    for (unsigned j = 0; j < n; ++j) {
-      tmp += src[offset];
-      offset += skip1;
+  parallel_for(repeat, n, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      unsigned offset = i % skip1 + (i / skip1) * skip2;
+      float tmp = 0;
+      for (unsigned j = 0; j < n; ++j) {
+        tmp += src[offset];
+        offset += skip1;
+      }
+      dest[i] = tmp;
     }
-    dest[i] = tmp;
-  }
+  });
 }
 
 void Naive::logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
   const unsigned n = x.shape()[dim];
-  const unsigned repeat = y.shape().size();
-  const unsigned skip1 = y.shape().lower_volume(dim);
-  const unsigned skip2 = skip1 * n;
+  const unsigned skip = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / skip;
   float *dest = DATA(y);
   const float *src = CDATA(x);
-  for (unsigned i = 0; i < repeat; ++i) {
-    // TODO(odashi): This calculation might generate large errors.
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float tmp = src[offset];
-    for (unsigned j = 1; j < n; ++j) {
-      offset += skip1;
-      float arg = src[offset];
-      tmp = tmp > arg
-        ? tmp + std::log(1. + std::exp(arg - tmp))
-        : arg + std::log(1. + std::exp(tmp - arg));
+  parallel_for(repeat, n * skip, [&](unsigned begin, unsigned end) {
+    std::vector<float> sum(skip), buf(2 * ::SOFTMAX_BLOCK);
+    for (unsigned i = begin; i < end; ++i) {
+      float *m = dest + i * skip;
+      ::softmax_stats(src + i * n * skip, n, skip, m, sum.data(), buf.data());
+      for (unsigned k = 0; k < skip; ++k) m[k] += std::log(sum[k]);
+    }
+  });
+}
+
+void Naive::logsumexp_bw_impl(
+    const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  // gx += exp(x - y) * gy
+  const unsigned n = x.shape()[dim];
+  const unsigned skip = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / skip;
+  const float *src_x = CDATA(x);
+  const float *src_y = CDATA(y);
+  const float *src_gy = CDATA(gy);
+  float *dest = DATA(gx);
+  parallel_for(repeat, n * skip, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const float *px = src_x + i * n * skip;
+      const float *py = src_y + i * skip;
+      const float *pgy = src_gy + i * skip;
+      float *pgx = dest + i * n * skip;
+      ::softmax_exp_loop(
+          n * skip, skip,
+          [&](unsigned t, unsigned k) { return px[t] - py[k]; },
+          [&](unsigned t, unsigned k, float e) { pgx[t] += e * pgy[k]; });
+    }
+  });
+}
+
+void Naive::softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned skip = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / (n * skip);
+  const float *src = CDATA(x);
+  float *dest = DATA(y);
+  parallel_for(repeat, n * skip, [&](unsigned begin, unsigned end) {
+    std::vector<float> m(skip), sum(skip), buf(2 * ::SOFTMAX_BLOCK);
+    for (unsigned i = begin; i < end; ++i) {
+      const float *px = src + i * n * skip;
+      float *py = dest + i * n * skip;
+      ::softmax_stats(px, n, skip, m.data(), sum.data(), buf.data());
+      for (unsigned j = 0; j < n; ++j) {
+        for (unsigned k = 0; k < skip; ++k) {
+          py[j * skip + k] = px[j * skip + k] - m[k];
+        }
+      }
+      vmath::exp(n * skip, py, py);
+      for (unsigned k = 0; k < skip; ++k) sum[k] = 1 / sum[k];
+      for (unsigned j = 0; j < n; ++j) {
+        for (unsigned k = 0; k < skip; ++k) py[j * skip + k] *= sum[k];
+      }
+    }
+  });
+}
+
+void Naive::log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) {
+  const unsigned n = x.shape()[dim];
+  const unsigned skip = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().size() / (n * skip);
+  const float *src = CDATA(x);
+  float *dest = DATA(y);
+  parallel_for(repeat, n * skip, [&](unsigned begin, unsigned end) {
+    std::vector<float> m(skip), sum(skip), buf(2 * ::SOFTMAX_BLOCK);
+    for (unsigned i = begin; i < end; ++i) {
+      const float *px = src + i * n * skip;
+      float *py = dest + i * n * skip;
+      ::softmax_stats(px, n, skip, m.data(), sum.data(), buf.data());
+      for (unsigned k = 0; k < skip; ++k) sum[k] = std::log(sum[k]);
+      // NOTE: (x - m) - log(sum) is more accurate than
+      // x - (m + log(sum)) because x - m is exact around the maximum.
+      for (unsigned j = 0; j < n; ++j) {
+        for (unsigned k = 0; k < skip; ++k) {
+          py[j * skip + k] = (px[j * skip + k] - m[k]) - sum[k];
+        }
+      }
+    }
+  });
+}
+
+void Naive::softmax_cross_entropy_fw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  // y = logsumexp(x) - x[id]
+  const unsigned n = x.shape()[dim];
+  const unsigned skip = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().volume() / (n * skip);
+  const unsigned x_shift = x.shape().has_batch() * repeat;
+  const unsigned ids_shift = ids.size() > 1;
+  const float *src = CDATA(x);
+  float *dest = DATA(y);
+  parallel_for(
+      y.shape().size() / skip, n * skip, [&](unsigned begin, unsigned end) {
+    std::vector<float> sum(skip), buf(2 * ::SOFTMAX_BLOCK);
+    for (unsigned i = begin; i < end; ++i) {
+      const unsigned batch = i / repeat;
+      const float *px = src + (batch * x_shift + i % repeat) * n * skip;
+      const float *px_id = px + ids[batch * ids_shift] * skip;
+      float *py = dest + i * skip;
+      ::softmax_stats(px, n, skip, py, sum.data(), buf.data());
+      for (unsigned k = 0; k < skip; ++k) {
+        py[k] = (py[k] - px_id[k]) + std::log(sum[k]);
+      }
+    }
+  });
+}
+
+void Naive::softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  // gx += y * (gy - sum(gy * y))
+  const unsigned n = y.shape()[dim];
+  const unsigned skip = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / (n * skip);
+  const float *src_y = CDATA(y);
+  const float *src_gy = CDATA(gy);
+  float *dest = DATA(gx);
+  parallel_for(repeat, n * skip, [&](unsigned begin, unsigned end) {
+    std::vector<float> dot(skip);
+    for (unsigned i = begin; i < end; ++i) {
+      const unsigned offset = i * n * skip;
+      const float *py = src_y + offset;
+      const float *pgy = src_gy + offset;
+      float *pgx = dest + offset;
+      std::fill(dot.begin(), dot.end(), 0);
+      for (unsigned j = 0; j < n * skip; j += skip) {
+        for (unsigned k = 0; k < skip; ++k) dot[k] += pgy[j + k] * py[j + k];
+      }
+      for (unsigned j = 0; j < n * skip; j += skip) {
+        for (unsigned k = 0; k < skip; ++k) {
+          pgx[j + k] += py[j + k] * (pgy[j + k] - dot[k]);
+        }
+      }
     }
-    dest[i] = tmp;
+  });
+}
+
+void Naive::log_softmax_bw_impl(
+    const Tensor &, const Tensor &y, const Tensor &gy, unsigned dim,
+    Tensor &gx) {
+  // gx += gy - exp(y) * sum(gy)
+  const unsigned n = y.shape()[dim];
+  const unsigned skip = y.shape().lower_volume(dim);
+  const unsigned repeat = y.shape().size() / (n * skip);
+  const float *src_y = CDATA(y);
+  const float *src_gy = CDATA(gy);
+  float *dest = DATA(gx);
+  parallel_for(repeat, n * skip, [&](unsigned begin, unsigned end) {
+    std::vector<float> sum(skip);
+    for (unsigned i = begin; i < end; ++i) {
+      const unsigned offset = i * n * skip;
+      const float *py = src_y + offset;
+      const float *pgy = src_gy + offset;
+      float *pgx = dest + offset;
+      std::fill(sum.begin(), sum.end(), 0);
+      for (unsigned j = 0; j < n * skip; j += skip) {
+        for (unsigned k = 0; k < skip; ++k) sum[k] += pgy[j + k];
+      }
+      ::softmax_exp_loop(
+          n * skip, skip,
+          [&](unsigned t, unsigned) { return py[t]; },
+          [&](unsigned t, unsigned k, float e) {
+            pgx[t] += pgy[t] - e * sum[k];
+          });
+    }
+  });
+}
+
+void Naive::softmax_cross_entropy_bw_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, const Tensor &y,
+    const Tensor &gy, unsigned dim, Tensor &gx) {
+  // gx += gy * (softmax(x) - delta(id)), where softmax(x) = exp(x - y - x[id])
+  const unsigned n = x.shape()[dim];
+  const unsigned skip = x.shape().lower_volume(dim);
+  const unsigned repeat = x.shape().volume() / (n * skip);
+  const unsigned bs = y.shape().batch();
+  const unsigned x_shift = x.shape().has_batch() * repeat;
+  const unsigned ids_shift = ids.size() > 1;
+  const float *src_x = CDATA(x);
+  const float *src_y = CDATA(y);
+  const float *src_gy = CDATA(gy);
+  float *dest = DATA(gx);
+
+  auto fn = [&](unsigned i, float *lse) {
+    const unsigned batch = i / repeat;
+    const unsigned offset = (batch * x_shift + i % repeat) * n * skip;
+    const unsigned id = ids[batch * ids_shift];
+    const float *px = src_x + offset;
+    const float *py = src_y + i * skip;
+    const float *pgy = src_gy + i * skip;
+    float *pgx = dest + offset;
+    for (unsigned k = 0; k < skip; ++k) lse[k] = py[k] + px[id * skip + k];
+    ::softmax_exp_loop(
+        n * skip, skip,
+        [&](unsigned t, unsigned k) { return px[t] - lse[k]; },
+        [&](unsigned t, unsigned k, float e) { pgx[t] += e * pgy[k]; });
+    for (unsigned k = 0; k < skip; ++k) pgx[id * skip + k] -= pgy[k];
+  };
+
+  // NOTE:
+  // If `x` has no minibatch, gradients of all minibatches are accumulated to
+  // the same `gx`, and they are processed in order by the same task.
+  if (x_shift > 0 || bs == 1) {
+    parallel_for(bs * repeat, n * skip, [&](unsigned begin, unsigned end) {
+      std::vector<float> lse(skip);
+      for (unsigned i = begin; i < end; ++i) fn(i, lse.data());
+    });
+  } else {
+    parallel_for(repeat, bs * n * skip, [&](unsigned begin, unsigned end) {
+      std::vector<float> lse(skip);
+      for (unsigned i = begin; i < end; ++i) {
+        for (unsigned batch = 0; batch < bs; ++batch) {
+          fn(batch * repeat + i, lse.data());
+        }
+      }
+    });
   }
 }
 
@@ -600,14 +1333,16 @@ void Naive::broadcast_fw_impl(
   const unsigned skip2 = skip1 * size;
   float *dest = DATA(y);
   const float *src = CDATA(x);
-  for (unsigned i = 0; i < repeat; ++i) {
-    unsigned offset = i % skip1 + (i / skip1) * skip2;
-    float tmp = src[i];
-    for (unsigned j = 0; j < size; ++j) {
-      dest[offset] = tmp;
-      offset += skip1;
+  parallel_for(repeat, size, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      unsigned offset = i % skip1 + (i / skip1) * skip2;
+      float tmp = src[i];
+      for (unsigned j = 0; j < size; ++j) {
+        dest[offset] = tmp;
+        offset += skip1;
+      }
     }
-  }
+  });
 }
 
 void Naive::batch_sum_fw_impl(const Tensor &x, Tensor &y) {
@@ -615,19 +1350,23 @@ void Naive::batch_sum_fw_impl(const Tensor &x, Tensor &y) {
   const float *src = CDATA(x);
   const unsigned bs = x.shape().batch();
   const unsigned size = y.shape().size();
-  for (unsigned i = 0; i < size; ++i) {
-    float temp = 0;
-    for (unsigned batch = 0, pos = i; batch < bs; ++batch, pos += size) {
-      temp += src[pos];
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      float temp = 0;
+      for (unsigned batch = 0, pos = i; batch < bs; ++batch, pos += size) {
+        temp += src[pos];
+      }
+      dest[i] = temp;
     }
-    dest[i] = temp;
-  }
+  });
 }
 
 void Naive::inplace_multiply_const_impl(float k, Tensor &x) {
   const unsigned size = x.shape().size();
   float *dest = DATA(x);
-  REPEAT_OP(i, size, dest[i] *= k);
+  parallel_for(size, 1, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) dest[i] *= k;
+  });
 }
 
 void Naive::inplace_add_impl(const Tensor &x, Tensor &y) {
@@ -637,13 +1376,17 @@ void Naive::inplace_add_impl(const Tensor &x, Tensor &y) {
   const unsigned bs = std::max(sx.batch(), sy.batch());
   const unsigned b_skip_d = sy.has_batch() * size;
   const unsigned b_skip_s = sx.has_batch() * size;
-  float *dest = DATA(y);
-  const float *src = CDATA(x);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    REPEAT_OP(i, size, dest[i] += src[i]);
-    dest += b_skip_d;
-    src += b_skip_s;
-  }
+  float *dest_y = DATA(y);
+  const float *src_x = CDATA(x);
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    float *dest = dest_y;
+    const float *src = src_x;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) dest[i] += src[i];
+      dest += b_skip_d;
+      src += b_skip_s;
+    }
+  });
 }
 
 void Naive::inplace_subtract_impl(const Tensor &x, Tensor &y) {
@@ -653,12 +1396,215 @@ void Naive::inplace_subtract_impl(const Tensor &x, Tensor &y) {
   const unsigned bs = std::max(sx.batch(), sy.batch());
   const unsigned b_skip_d = sy.has_batch() * size;
   const unsigned b_skip_s = sx.has_batch() * size;
-  float *dest = DATA(y);
+  float *dest_y = DATA(y);
+  const float *src_x = CDATA(x);
+  parallel_for(size, bs, [&](unsigned begin, unsigned end) {
+    float *dest = dest_y;
+    const float *src = src_x;
+    for (unsigned batch = 0; batch < bs; ++batch) {
+      for (unsigned i = begin; i < end; ++i) dest[i] -= src[i];
+      dest += b_skip_d;
+      src += b_skip_s;
+    }
+  });
+}
+
+void Naive::inplace_pick_assign_impl(
+    const Tensor &x, const std::vector<unsigned> &ids, unsigned dim,
+    Tensor &y) {
+  const unsigned bs = x.shape().batch();
+  const unsigned skip_y = y.shape().has_batch() * y.shape().volume();
+  const unsigned skip_i = ids.size() > 1;
+  const unsigned base = x.shape().lower_volume(dim);
+  const unsigned skip = base * y.shape()[dim];
+  const unsigned repeat = x.shape().volume() / base;
   const float *src = CDATA(x);
-  for (unsigned batch = 0; batch < bs; ++batch) {
-    REPEAT_OP(i, size, dest[i] -= src[i]);
-    dest += b_skip_d;
-    src += b_skip_s;
+  float *dest = DATA(y);
+  parallel_for(bs, repeat * base, [&](unsigned begin, unsigned end) {
+    for (unsigned batch = begin; batch < end; ++batch) {
+      float *dp = dest + batch * skip_y + base * ids[batch * skip_i];
+      const float *sp = src + batch * repeat * base;
+      for (unsigned i = 0; i < repeat; ++i) {
+        std::copy(sp + i * base, sp + (i + 1) * base, dp + i * skip);
+      }
+    }
+  });
+}
+
+void Naive::sgd_update_impl(
+    float eta,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs) {
+  const std::vector<const float *> pg = ::cdata_list(gs);
+  const std::vector<float *> px = ::data_list(xs);
+  // NOTE:
+  // Hyperparameters are captured by value in following methods, otherwise
+  // they are reloaded in each iteration and loops are not vectorized.
+  multi_tensor_for(xs, 2, [&, eta](
+        unsigned t, unsigned begin, unsigned end) {
+    const float *g = pg[t];
+    float *x = px[t];
+    for (unsigned i = begin; i < end; ++i) x[i] -= eta * g[i];
+  });
+}
+
+void Naive::momentum_sgd_update_impl(
+    float eta, float momentum,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &ms) {
+  const std::vector<const float *> pg = ::cdata_list(gs);
+  const std::vector<float *> px = ::data_list(xs);
+  const std::vector<float *> pm = ::data_list(ms);
+  multi_tensor_for(xs, 4, [&, eta, momentum](
+        unsigned t, unsigned begin, unsigned end) {
+    const float *g = pg[t];
+    float *x = px[t];
+    float *m = pm[t];
+    for (unsigned i = begin; i < end; ++i) {
+      m[i] = momentum * m[i] - eta * g[i];
+      x[i] += m[i];
+    }
+  });
+}
+
+void Naive::adagrad_update_impl(
+    float eta, float eps,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &ms) {
+  const std::vector<const float *> pg = ::cdata_list(gs);
+  const std::vector<float *> px = ::data_list(xs);
+  const std::vector<float *> pm = ::data_list(ms);
+  multi_tensor_for(xs, 7, [&, eta, eps](
+        unsigned t, unsigned begin, unsigned end) {
+    const float *g = pg[t];
+    float *x = px[t];
+    float *m = pm[t];
+    for (unsigned i = begin; i < end; ++i) {
+      m[i] += g[i] * g[i];
+      x[i] -= eta * g[i] / (std::sqrt(m[i]) + eps);
+    }
+  });
+}
+
+void Naive::rmsprop_update_impl(
+    float eta, float alpha, float eps,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &ms) {
+  const std::vector<const float *> pg = ::cdata_list(gs);
+  const std::vector<float *> px = ::data_list(xs);
+  const std::vector<float *> pm = ::data_list(ms);
+  multi_tensor_for(xs, 9, [&, eta, alpha, eps](
+        unsigned t, unsigned begin, unsigned end) {
+    const float *g = pg[t];
+    float *x = px[t];
+    float *m = pm[t];
+    for (unsigned i = begin; i < end; ++i) {
+      m[i] = alpha * m[i] + (1 - alpha) * g[i] * g[i];
+      x[i] -= eta * g[i] / (std::sqrt(m[i]) + eps);
+    }
+  });
+}
+
+void Naive::adadelta_update_impl(
+    float scale, float rho, float eps,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) {
+  const std::vector<const float *> pg = ::cdata_list(gs);
+  const std::vector<float *> px = ::data_list(xs);
+  const std::vector<float *> pm1 = ::data_list(m1s);
+  const std::vector<float *> pm2 = ::data_list(m2s);
+  multi_tensor_for(xs, 16, [&, scale, rho, eps](
+        unsigned t, unsigned begin, unsigned end) {
+    const float *g = pg[t];
+    float *x = px[t];
+    float *m1 = pm1[t];
+    float *m2 = pm2[t];
+    for (unsigned i = begin; i < end; ++i) {
+      const float gi = g[i];
+      const float m2i = rho * m2[i] + (1 - rho) * gi * gi;
+      const float d = std::sqrt((m1[i] + eps) / (m2i + eps)) * gi;
+      m1[i] = rho * m1[i] + (1 - rho) * d * d;
+      m2[i] = m2i;
+      x[i] -= scale * d;
+    }
+  });
+}
+
+void Naive::adam_update_impl(
+    float alpha, float beta1, float beta2, float eps, float bias1, float bias2,
+    const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs,
+    const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) {
+  const std::vector<const float *> pg = ::cdata_list(gs);
+  const std::vector<float *> px = ::data_list(xs);
+  const std::vector<float *> pm1 = ::data_list(m1s);
+  const std::vector<float *> pm2 = ::data_list(m2s);
+  multi_tensor_for(xs, 13, [&, alpha, beta1, beta2, eps, bias1, bias2](
+        unsigned t, unsigned begin, unsigned end) {
+    const float *g = pg[t];
+    float *x = px[t];
+    float *m1 = pm1[t];
+    float *m2 = pm2[t];
+    for (unsigned i = begin; i < end; ++i) {
+      const float gi = g[i];
+      const float m1i = beta1 * m1[i] + (1 - beta1) * gi;
+      const float m2i = beta2 * m2[i] + (1 - beta2) * gi * gi;
+      m1[i] = m1i;
+      m2[i] = m2i;
+      x[i] -= alpha * (m1i / bias1) / (std::sqrt(m2i / bias2) + eps);
+    }
+  });
+}
+
+void Naive::squared_norm_impl(
+    const std::vector<const Tensor *> &xs, Tensor &y) {
+  // NOTE:
+  // Tensors are split into blocks with a fixed size, and partial sums are
+  // added in a fixed order to obtain the same result with any number of
+  // threads.
+  std::vector<const float *> ptrs;
+  std::vector<unsigned> sizes;
+  for (const Tensor *x : xs) {
+    const float *px = CDATA(*x);
+    const unsigned size = x->shape().size();
+    for (unsigned i = 0; i < size; i += ::REDUCTION_BLOCK) {
+      ptrs.emplace_back(px + i);
+      sizes.emplace_back(std::min(::REDUCTION_BLOCK, size - i));
+    }
+  }
+  std::vector<float> partials(ptrs.size());
+  parallel_for(
+      ptrs.size(), 2 * ::REDUCTION_BLOCK, [&](unsigned begin, unsigned end) {
+    for (unsigned b = begin; b < end; ++b) {
+      const float *x = ptrs[b];
+      const unsigned size = sizes[b];
+      float acc[::REDUCTION_LANES] = {};
+      unsigned i = 0;
+      for (; i + ::REDUCTION_LANES <= size; i += ::REDUCTION_LANES) {
+        for (unsigned j = 0; j < ::REDUCTION_LANES; ++j) {
+          acc[j] += x[i + j] * x[i + j];
+        }
+      }
+      float sum = 0;
+      for (; i < size; ++i) sum += x[i] * x[i];
+      for (unsigned j = 0; j < ::REDUCTION_LANES; ++j) sum += acc[j];
+      partials[b] = sum;
+    }
+  });
+  float sum = 0;
+  for (const float p : partials) sum += p;
+  DATA(y)[0] = sum;
+}
+
+void Naive::inplace_clip_by_norm_impl(
+    float threshold, const Tensor &sq_norm, const std::vector<Tensor *> &xs) {
+  const float sq = CDATA(sq_norm)[0];
+  if (sq > threshold * threshold) {
+    const float scale = threshold / std::sqrt(sq);
+    const std::vector<float *> px = ::data_list(xs);
+    multi_tensor_for(xs, 1, [&, scale](
+          unsigned t, unsigned begin, unsigned end) {
+      float *x = px[t];
+      for (unsigned i = begin; i < end; ++i) x[i] *= scale;
+    });
   }
 }
 
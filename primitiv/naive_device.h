@@ -1,8 +1,12 @@
 #ifndef PRIMITIV_NAIVE_DEVICE_H_
 #define PRIMITIV_NAIVE_DEVICE_H_
 
+#include <functional>
+#include <memory>
 #include <random>
 #include <primitiv/device.h>
+#include <primitiv/host_memory_pool.h>
+#include <primitiv/thread_pool.h>
 
 namespace primitiv {
 namespace devices {
@@ -25,12 +29,61 @@ public:
    */
   explicit Naive(unsigned rng_seed) : rng_(rng_seed) {}
 
+  /**
+   * Creates a Naive object which runs kernels on multiple threads.
+   * @param rng_seed The seed value of internal random number generator.
+   * @param num_threads Number of threads used by kernels, including the
+   *                    calling thread.
+   * @throw primitiv::Error `num_threads` is 0.
+   * @remarks Small tensors are always processed by the calling thread.
+   *          The results are identical to those with a single thread.
+   */
+  Naive(unsigned rng_seed, unsigned num_threads)
+    : rng_(rng_seed)
+    , pool_(num_threads != 1 ? new ThreadPool(num_threads) : nullptr) {}
+
   ~Naive() override = default;
 
   void dump_description() const override;
   Device::DeviceType type() const override { return Device::DEVICE_TYPE_CPU; }
 
+  /**
+   * Retrieves the number of threads used by kernels.
+   * @return Number of threads.
+   */
+  unsigned num_threads() const { return pool_ ? pool_->num_threads() : 1; }
+
+  /**
+   * Retrieves the memory pool which manages memories of tensors.
+   * @return Reference of the memory pool.
+   * @remarks The pool can be used to obtain statistics, limit reserved memories
+   *          or release them.
+   */
+  HostMemoryPool &memory_pool() { return memory_pool_; }
+
 private:
+  /**
+   * Calls `fn(begin, end)` for subranges of `[0, size)`, in parallel if the
+   * amount of work is large enough.
+   * @param size Number of independent work items.
+   * @param cost Approximate number of operations in each work item.
+   * @param fn Function to be called.
+   */
+  void parallel_for(
+      unsigned size, unsigned cost,
+      const std::function<void(unsigned, unsigned)> &fn);
+
+  /**
+   * Calls `fn(i, begin, end)` for subranges `[begin, end)` of elements of the
+   * `i`-th tensor, for all elements of given tensors in one parallel loop.
+   * @param xs Tensors to be processed.
+   * @param cost Approximate number of operations for each element.
+   * @param fn Function to be called.
+   */
+  void multi_tensor_for(
+      const std::vector<Tensor *> &xs, unsigned cost,
+      const std::function<void(unsigned, unsigned, unsigned)> &fn);
+
   std::shared_ptr<void> new_handle(const Shape &shape) override;
 
   std::vector<float> tensor_to_vector_impl(const Tensor &x) override;
@@ -126,18 +179,48 @@ private:
       const Tensor &a, const Tensor &b, const Tensor &y, const Tensor &gy,
       Tensor &ga, Tensor &gb) override;
 
+  void elementwise_fw_impl(
+      const std::vector<const Tensor *> &xs, const elementwise::Program &prog,
+      Tensor &y) override;
+  void elementwise_bw_impl(
+      const std::vector<const Tensor *> &xs, const Tensor &y, const Tensor &gy,
+      const elementwise::Program &prog, const std::vector<Tensor *> &gxs) override;
+
   void sum_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
   void logsumexp_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
   void broadcast_fw_impl(const Tensor &x, unsigned dim, unsigned size, Tensor &y) override;
   void batch_sum_fw_impl(const Tensor &x, Tensor &y) override;
 
+  void logsumexp_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
+  void softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void log_softmax_fw_impl(const Tensor &x, unsigned dim, Tensor &y) override;
+  void softmax_cross_entropy_fw_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+
+  void softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void log_softmax_bw_impl(const Tensor &x, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+  void softmax_cross_entropy_bw_impl(const Tensor &x, const std::vector<unsigned> &ids, const Tensor &y, const Tensor &gy, unsigned dim, Tensor &gx) override;
+
   void inplace_multiply_const_impl(float k, Tensor &x) override;
 
   void inplace_add_impl(const Tensor &x, Tensor &y) override;
   void inplace_subtract_impl(const Tensor &x, Tensor &y) override;
+  void inplace_pick_assign_impl(const Tensor &x, const std::vector<unsigned> &ids, unsigned dim, Tensor &y) override;
+
+  void sgd_update_impl(float eta, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs) override;
+  void momentum_sgd_update_impl(float eta, float momentum, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) override;
+  void adagrad_update_impl(float eta, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) override;
+  void rmsprop_update_impl(float eta, float alpha, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &ms) override;
+  void adadelta_update_impl(float scale, float rho, float eps, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) override;
+  void adam_update_impl(float alpha, float beta1, float beta2, float eps, float bias1, float bias2, const std::vector<const Tensor *> &gs, const std::vector<Tensor *> &xs, const std::vector<Tensor *> &m1s, const std::vector<Tensor *> &m2s) override;
+
+  void squared_norm_impl(const std::vector<const Tensor *> &xs, Tensor &y) override;
+  void inplace_clip_by_norm_impl(float threshold, const Tensor &sq_norm, const std::vector<Tensor *> &xs) override;
 
 private:
   std::mt19937 rng_;
+  std::unique_ptr<ThreadPool> pool_;
+  HostMemoryPool memory_pool_;
 };
 
 }  // namespace devices
@@ -243,12 +243,12 @@ Node logsumexp(const Node &x, unsigned dim) {
 
 template<>
 Node log_softmax(const Node &x, unsigned dim) {
-  return x - broadcast(logsumexp(x, dim), dim, x.shape()[dim]);
+  return REGX(x, LogSoftmax(dim), x);
 }
 
 template<>
 Node softmax(const Node &x, unsigned dim) {
-  return exp(log_softmax(x, dim));
+  return REGX(x, Softmax(dim), x);
 }
 
 template<>
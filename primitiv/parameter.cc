@@ -6,6 +6,7 @@
 #include <primitiv/initializer.h>
 #include <primitiv/messages.pb.h>
 #include <primitiv/parameter.h>
+#include <primitiv/shape_ops.h>
 
 using std::string;
 using std::vector;
@@ -94,7 +95,9 @@ Parameter::Parameter(const Shape &shape, Device &device)
 : shape_(shape)
 , device_(&device)
 , value_(device.new_tensor(shape))
-, grad_(device.new_tensor(shape)) {
+, grad_(device.new_tensor(shape))
+, sparse_grad_(false)
+, frozen_(false) {
   check_shape();
 }
 
@@ -105,7 +108,9 @@ Parameter::Parameter(
 : shape_(shape)
 , device_(&device)
 , value_(device.new_tensor(shape))
-, grad_(device.new_tensor(shape)) {
+, grad_(device.new_tensor(shape))
+, sparse_grad_(false)
+, frozen_(false) {
   check_shape();
   reset_value(value);
 }
@@ -117,7 +122,9 @@ Parameter::Parameter(
 : shape_(shape)
 , device_(&device)
 , value_(device.new_tensor(shape))
-, grad_(device.new_tensor(shape)) {
+, grad_(device.new_tensor(shape))
+, sparse_grad_(false)
+, frozen_(false) {
   check_shape();
   reset_value(init);
 }
@@ -129,6 +136,9 @@ void Parameter::initialize_by_data(
   shape_ = value_.shape();
   device_ = &value_.device();
   grad_ = value_.device().new_tensor(value_.shape());
+  sparse_grad_ = false;
+  grad_rows_.clear();
+  grad_row_flags_.clear();
   stats_ = std::move(stats);
   check_shape();
 }
@@ -145,7 +155,47 @@ void Parameter::reset_value(const Initializer &init) {
 
 void Parameter::reset_gradient() {
   if (!valid()) THROW_ERROR("Invalid parameter.");
-  grad_.reset(0);
+  if (!sparse_grad_) {
+    grad_.reset(0);
+  } else if (!grad_rows_.empty()) {
+    const unsigned dim = shape_.depth() - 1;
+    const Tensor zeros = device_->new_tensor(
+        shape_ops::pick(shape_, grad_rows_, dim), 0);
+    device_->inplace_pick_assign(zeros, grad_rows_, dim, grad_);
+  }
+  clear_gradient_rows();
+}
+
+void Parameter::clear_gradient_rows() {
+  for (const unsigned id : grad_rows_) grad_row_flags_[id] = false;
+  grad_rows_.clear();
+  sparse_grad_ = true;
+}
+
+Tensor &Parameter::gradient(unsigned dim, const vector<unsigned> &ids) {
+  if (!valid()) THROW_ERROR("Invalid parameter.");
+  const unsigned depth = shape_.depth();
+  if (!sparse_grad_ || dim + 1 != depth) {
+    sparse_grad_ = false;
+    return grad_;
+  }
+  const unsigned num_rows = shape_[dim];
+  if (grad_row_flags_.empty()) grad_row_flags_.assign(num_rows, false);
+  for (const unsigned id : ids) {
+    if (id >= num_rows) {
+      // NOTE: Invalid IDs are reported by the succeeding operation.
+      sparse_grad_ = false;
+      return grad_;
+    }
+    if (!grad_row_flags_[id]) {
+      grad_row_flags_[id] = true;
+      grad_rows_.emplace_back(id);
+    }
+  }
+  // NOTE:
+  // Dense operations are faster than sparse ones if many rows are touched.
+  if (2 * grad_rows_.size() > num_rows) sparse_grad_ = false;
+  return grad_;
 }
 
 void Parameter::add_stats(const string &name, const Shape &shape) {
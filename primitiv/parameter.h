@@ -12,19 +12,28 @@
 
 namespace primitiv {
 
+class DataParallelTrainer;
 class Initializer;
+class Trainer;
 
 /**
  * Class to manage a trainable tensor parameter.
  */
 class Parameter : mixins::Noncopyable<Parameter> {
+  friend DataParallelTrainer;
+  friend Trainer;
+
 public:
   Parameter(Parameter &&src)
     : shape_(std::move(src.shape_))
     , device_(src.device_)
     , value_(std::move(src.value_))
     , grad_(std::move(src.grad_))
-    , stats_(std::move(src.stats_)) {
+    , sparse_grad_(src.sparse_grad_)
+    , grad_rows_(std::move(src.grad_rows_))
+    , grad_row_flags_(std::move(src.grad_row_flags_))
+    , stats_(std::move(src.stats_))
+    , frozen_(src.frozen_) {
       src.device_ = nullptr;
     }
 
@@ -34,7 +43,11 @@ public:
       device_ = src.device_;
       value_ = std::move(src.value_);
       grad_ = std::move(src.grad_);
+      sparse_grad_ = src.sparse_grad_;
+      grad_rows_ = std::move(src.grad_rows_);
+      grad_row_flags_ = std::move(src.grad_row_flags_);
       stats_ = std::move(src.stats_);
+      frozen_ = src.frozen_;
       src.device_ = nullptr;
     }
     return *this;
@@ -43,7 +56,9 @@ public:
   /**
    * Creates an invalid parameter object.
    */
-  Parameter() : shape_(), device_(nullptr), value_(), grad_() {}
+  Parameter()
+    : shape_(), device_(nullptr), value_(), grad_(), sparse_grad_(false)
+    , frozen_(false) {}
 
   /**
    * Creates a new Parameter object.
@@ -98,6 +113,8 @@ public:
 
   /**
    * Set all gradients to 0.
+   * @remarks If the gradient is row-sparse, only the rows returned by
+   *          `gradient_rows()` are reset.
    */
   void reset_gradient();
 
@@ -118,6 +135,26 @@ public:
     return stats_.find(name) != stats_.end();
   }
 
+  /**
+   * Freezes or unfreezes the parameter.
+   * @param frozen Whether the parameter is frozen or not.
+   * @remarks Graph::backward() does not calculate gradients of frozen
+   *          parameters, and Trainer does not update them.
+   */
+  void set_frozen(bool frozen) {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    frozen_ = frozen;
+  }
+
+  /**
+   * Returns whether the parameter is frozen or not.
+   * @return true if the parameter is frozen, false otherwise.
+   */
+  bool is_frozen() const {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    return frozen_;
+  }
+
   /**
    * Returns the shape of the parameter.
    * @return Shape object.
@@ -157,6 +194,7 @@ public:
   /**
    * Returns the current gradient of the parameter.
    * @return A tensor representing the gradient of the value.
+   * @remarks This overload does not change whether the gradient is row-sparse.
    */
   const Tensor &gradient() const {
     if (!valid()) THROW_ERROR("Invalid parameter.");
@@ -166,10 +204,62 @@ public:
   /**
    * Returns the current gradient of the parameter.
    * @return A tensor representing the gradient of the value.
+   * @remarks Same as `dense_gradient()`: the gradient is no longer treated as
+   *          row-sparse until the next `reset_gradient()`, because any
+   *          elements may be updated through the returned tensor.
+   */
+  Tensor &gradient() { return dense_gradient(); }
+
+  /**
+   * Returns the current gradient of the parameter to update any elements.
+   * @return A tensor representing the gradient of the value.
+   * @remarks The gradient is no longer treated as row-sparse until the next
+   *          `reset_gradient()`.
+   */
+  Tensor &dense_gradient() {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    sparse_grad_ = false;
+    return grad_;
+  }
+
+  /**
+   * Returns the current gradient of the parameter to update only its slices.
+   * @param dim Dimension of the slices.
+   * @param ids Indices of the slices to be updated along `dim`.
+   * @return A tensor representing the gradient of the value.
+   * @remarks If `dim` is the last dimension of the parameter, `ids` are
+   *          registered to `gradient_rows()` and the gradient remains
+   *          row-sparse. Otherwise this function is equivalent to
+   *          `dense_gradient()`.
    */
-  Tensor &gradient() {
+  Tensor &gradient(unsigned dim, const std::vector<unsigned> &ids);
+
+  /**
+   * Returns whether the gradient is row-sparse or not.
+   * @return true if only the rows returned by `gradient_rows()` may have
+   *         nonzero gradients, false otherwise.
+   * @remarks Rows are the slices along the last dimension of the parameter,
+   *          e.g., each embedding vector of the lookup table with the shape
+   *          `{dim, vocab}`. The gradient becomes row-sparse by
+   *          `reset_gradient()`, and rows are added when the parameter is used
+   *          through `pick()` along the last dimension.
+   */
+  bool has_sparse_gradient() const {
     if (!valid()) THROW_ERROR("Invalid parameter.");
-    return grad_; }
+    return sparse_grad_;
+  }
+
+  /**
+   * Returns the rows of the gradient that may have nonzero values.
+   * @return List of row indices in the order of registration.
+   * @remarks This function is available only if `has_sparse_gradient()` is
+   *          true.
+   */
+  const std::vector<unsigned> &gradient_rows() const {
+    if (!valid()) THROW_ERROR("Invalid parameter.");
+    if (!sparse_grad_) THROW_ERROR("The gradient is not row-sparse.");
+    return grad_rows_;
+  }
 
   /**
    * Returns the current opotional statistics tensor specified by given name.
@@ -227,11 +317,22 @@ private:
    */
   void check_shape();
 
+  /**
+   * Makes the gradient row-sparse with no rows without resetting its values.
+   * @remarks The caller should guarantee that all values of the gradient are
+   *          0.
+   */
+  void clear_gradient_rows();
+
   Shape shape_;
   Device *device_;
   Tensor value_;
   Tensor grad_;
+  bool sparse_grad_;
+  std::vector<unsigned> grad_rows_;
+  std::vector<bool> grad_row_flags_;
   std::unordered_map<std::string, Tensor> stats_;
+  bool frozen_;
 };
 
 }  // namespace primitiv
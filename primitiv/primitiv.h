@@ -3,6 +3,7 @@
 
 // This header file describes some include directives and may help users to use
 // the primitiv library.
+#include <primitiv/data_parallel_trainer.h>
 #include <primitiv/error.h>
 #include <primitiv/function.h>
 #include <primitiv/graph.h>
@@ -10,6 +11,7 @@
 #include <primitiv/naive_device.h>
 #include <primitiv/operators.h>
 #include <primitiv/parameter.h>
+#include <primitiv/profiler.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
 #include <primitiv/trainer_impl.h>
@@ -0,0 +1,140 @@
+#include <config.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <primitiv/device.h>
+#include <primitiv/error.h>
+#include <primitiv/profiler.h>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Returns the name of the phase.
+const char *phase_name(primitiv::Profiler::Phase phase) {
+  return phase == primitiv::Profiler::FORWARD ? "forward" : "backward";
+}
+
+// Returns the name of the function without parameters.
+string kind_of(const string &name) {
+  return name.substr(0, name.find('('));
+}
+
+// Escapes a string for JSON.
+string escape(const string &src) {
+  string dest;
+  for (const char c : src) {
+    if (c == '"' || c == '\\') dest += '\\';
+    dest += c;
+  }
+  return dest;
+}
+
+}  // namespace
+
+namespace primitiv {
+
+void Profiler::clear() {
+  origin_ = std::chrono::steady_clock::now();
+  events_.clear();
+}
+
+string Profiler::dump(const string &format) const {
+  std::stringstream ss;
+  ss << std::fixed;
+
+  if (format == "table") {
+    struct Total {
+      string kind;
+      Phase phase;
+      std::uint64_t calls;
+      std::uint64_t duration_ns;
+      std::uint64_t bytes;
+    };
+    std::map<std::pair<string, int>, unsigned> ids;
+    vector<Total> totals;
+    std::uint64_t sum_ns = 0;
+    for (const Event &e : events_) {
+      const string kind = ::kind_of(e.name);
+      const auto it = ids.emplace(
+          std::make_pair(kind, static_cast<int>(e.phase)), totals.size());
+      if (it.second) totals.push_back({kind, e.phase, 0, 0, 0});
+      Total &t = totals[it.first->second];
+      t.calls += e.num_functions;
+      t.duration_ns += e.duration_ns;
+      t.bytes += e.bytes;
+      sum_ns += e.duration_ns;
+    }
+    std::stable_sort(
+        totals.begin(), totals.end(), [](const Total &a, const Total &b) {
+          return a.duration_ns > b.duration_ns;
+        });
+
+    ss << std::left << std::setw(24) << "function"
+       << std::setw(10) << "phase" << std::right
+       << std::setw(10) << "calls"
+       << std::setw(14) << "total[ms]"
+       << std::setw(12) << "mean[us]"
+       << std::setw(10) << "ratio[%]"
+       << std::setw(16) << "bytes" << '\n';
+    for (const Total &t : totals) {
+      ss << std::left << std::setw(24) << t.kind
+         << std::setw(10) << ::phase_name(t.phase) << std::right
+         << std::setw(10) << t.calls
+         << std::setw(14) << std::setprecision(3) << t.duration_ns * 1e-6
+         << std::setw(12) << std::setprecision(3)
+         << t.duration_ns * 1e-3 / t.calls
+         << std::setw(10) << std::setprecision(1)
+         << (sum_ns > 0 ? 100. * t.duration_ns / sum_ns : 0.)
+         << std::setw(16) << t.bytes << '\n';
+    }
+    return ss.str();
+  }
+
+  if (format == "chrome") {
+    // NOTE:
+    // Events on each device are shown in each thread lane.
+    vector<const Device *> devices;
+    ss << "{\"traceEvents\":[";
+    for (unsigned i = 0; i < events_.size(); ++i) {
+      const Event &e = events_[i];
+      const auto it = std::find(devices.begin(), devices.end(), e.device);
+      const unsigned tid = it - devices.begin();
+      if (it == devices.end()) devices.emplace_back(e.device);
+
+      string args;
+      for (const Shape &s : e.arg_shapes) {
+        if (!args.empty()) args += ", ";
+        args += s.to_string();
+      }
+      if (i > 0) ss << ',';
+      ss << "\n{\"name\":\"" << ::escape(::kind_of(e.name))
+         << "\",\"cat\":\"" << ::phase_name(e.phase)
+         << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+         << ",\"ts\":" << std::setprecision(3) << e.start_ns * 1e-3
+         << ",\"dur\":" << e.duration_ns * 1e-3
+         << ",\"args\":{\"function\":\"" << ::escape(e.name)
+         << "\",\"arguments\":\"" << args
+         << "\",\"result\":\"" << e.ret_shape.to_string()
+         << "\",\"functions\":" << e.num_functions
+         << ",\"bytes\":" << e.bytes << "}}";
+    }
+    for (unsigned tid = 0; tid < devices.size(); ++tid) {
+      const char *type =
+        devices[tid] && devices[tid]->type() == Device::DEVICE_TYPE_CUDA
+        ? "CUDA" : "CPU";
+      ss << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+         << tid << ",\"args\":{\"name\":\"" << type << ':' << tid << "\"}}";
+    }
+    ss << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return ss.str();
+  }
+
+  THROW_ERROR("Unknown format: " << format);
+}
+
+}  // namespace primitiv
@@ -0,0 +1,132 @@
+#ifndef PRIMITIV_PROFILER_H_
+#define PRIMITIV_PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <primitiv/mixins.h>
+#include <primitiv/shape.h>
+
+namespace primitiv {
+
+class Device;
+
+/**
+ * Recorder of the calculation time of each function in computation graphs.
+ * Set the object to a Graph by `Graph::set_profiler()` to record events of
+ * forward() and backward().
+ */
+class Profiler : mixins::Nonmovable<Profiler> {
+public:
+  /**
+   * Phase of the calculation.
+   *   FORWARD .... Calculation of the value.
+   *   BACKWARD ... Calculation of the gradients of the arguments.
+   */
+  enum Phase {
+    FORWARD,
+    BACKWARD,
+  };
+
+  /**
+   * Record of one calculation.
+   */
+  struct Event {
+    /**
+     * Name of the function.
+     */
+    std::string name;
+
+    /**
+     * Phase of the calculation.
+     */
+    Phase phase;
+
+    /**
+     * Shapes of the arguments.
+     */
+    std::vector<Shape> arg_shapes;
+
+    /**
+     * Shape of the result.
+     */
+    Shape ret_shape;
+
+    /**
+     * Device of the result.
+     */
+    const Device *device;
+
+    /**
+     * Number of functions calculated together by the automatic batching.
+     */
+    unsigned num_functions;
+
+    /**
+     * Start time in nanoseconds since the profiler is cleared.
+     */
+    std::uint64_t start_ns;
+
+    /**
+     * Elapsed time in nanoseconds.
+     */
+    std::uint64_t duration_ns;
+
+    /**
+     * Bytes allocated during the calculation on devices of the result and the
+     * arguments, including temporaries. Always 0 unless statistics of the
+     * devices are enabled by Device::set_profiling().
+     */
+    std::uint64_t bytes;
+  };
+
+  Profiler() : origin_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * Discards all events and resets the origin of the time.
+   */
+  void clear();
+
+  /**
+   * Returns the current time.
+   * @return Nanoseconds since the profiler is cleared.
+   */
+  std::uint64_t now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin_).count();
+  }
+
+  /**
+   * Adds a new event.
+   * @param event Event to be added.
+   */
+  void add_event(Event &&event) { events_.emplace_back(std::move(event)); }
+
+  /**
+   * Retrieves all recorded events.
+   * @return List of events in the recorded order.
+   */
+  const std::vector<Event> &get_events() const { return events_; }
+
+  /**
+   * Dumps recorded events.
+   * @param format Name of the format. Available options:
+   *                 "table" .... Table of the total time of each kind of
+   *                              functions and phases. Parameters of
+   *                              functions in parentheses are ignored.
+   *                 "chrome" ... JSON of the Trace Event Format, which can be
+   *                              loaded by chrome://tracing.
+   * @return A string that represents events using given format.
+   */
+  std::string dump(const std::string &format) const;
+
+private:
+  std::chrono::steady_clock::time_point origin_;
+  std::vector<Event> events_;
+};
+
+}  // namespace primitiv
+
+#endif  // PRIMITIV_PROFILER_H_
@@ -39,6 +39,25 @@ Shape elementwise(const Shape &a, const Shape &b) {
   return a.resize_batch(std::max(a.batch(), b.batch()));
 }
 
+Shape fused_elementwise(const std::vector<const Shape *> &xs) {
+  if (xs.empty()) {
+    THROW_ERROR("No shapes for the fused elementwise operation.");
+  }
+
+  Shape y = *xs[0];
+  for (const Shape *x : xs) {
+    if (y.is_scalar()) y = x->resize_batch(y.batch());
+    if ((!x->is_scalar() && !x->has_same_dims(y)) ||
+        !x->has_compatible_batch(y)) {
+      THROW_ERROR(
+          "Shape mismatched for the fused elementwise operation. "
+          "x: " << x->to_string() << " != y: " << y.to_string());
+    }
+    if (x->batch() > y.batch()) y = y.resize_batch(x->batch());
+  }
+  return y;
+}
+
 Shape slice(const Shape &x, unsigned dim, unsigned lower, unsigned upper) {
   if (lower >= upper || upper > x[dim]) {
     THROW_ERROR(
@@ -74,6 +93,38 @@ Shape concat(const std::vector<const Shape *> &xs, unsigned dim) {
   return s0;
 }
 
+Shape batch_slice(const Shape &x, unsigned lower, unsigned upper) {
+  if (lower >= upper || upper > x.batch()) {
+    THROW_ERROR(
+        "Invalid batch slice operation. shape: " << x.to_string()
+        << ", lower: " << lower << ", upper: " << upper);
+  }
+
+  return x.resize_batch(upper - lower);
+}
+
+Shape batch_concat(const std::vector<const Shape *> &xs) {
+  if (xs.empty()) {
+    THROW_ERROR("No tensors to be concatenated.");
+  }
+
+  unsigned sum = xs[0]->batch();
+
+  for (unsigned i = 1; i < xs.size(); ++i) {
+    if (!xs[i]->has_same_dims(*xs[0])) {
+      std::string dims_str = xs[0]->to_string();
+      for (unsigned i = 1; i < xs.size(); ++i) {
+        dims_str += ", " + xs[i]->to_string();
+      }
+      THROW_ERROR(
+          "Invalid shapes to concatenate along the batch: " << dims_str);
+    }
+    sum += xs[i]->batch();
+  }
+
+  return xs[0]->resize_batch(sum);
+}
+
 Shape broadcast(const Shape &x, unsigned dim, unsigned size) {
   if (x[dim] != 1 || size == 0) {
     THROW_ERROR(
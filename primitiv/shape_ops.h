@@ -39,6 +39,15 @@ Shape scalar_op(const Shape &x, const Shape &k);
  */
 Shape elementwise(const Shape &a, const Shape &b);
 
+/**
+ * Calculates the shape after the fused elementwise operation.
+ * @param xs A list of shapes.
+ * @return A shape.
+ * @remarks Each shape in `xs` should have the same dims or be a scalar, and
+ *          scalars are broadcasted.
+ */
+Shape fused_elementwise(const std::vector<const Shape *> &xs);
+
 /**
  * Calculates the shape of the slice.
  * @param x A shape.
@@ -57,6 +66,23 @@ Shape slice(const Shape &x, unsigned dim, unsigned lower, unsigned upper);
  */
 Shape concat(const std::vector<const Shape *> &xs, unsigned dim);
 
+/**
+ * Calculates the shape of the minibatch slice.
+ * @param x A shape.
+ * @param lower Lower bound of the minibatch.
+ * @param upper Upper bound of the minibatch.
+ * @return A shape.
+ */
+Shape batch_slice(const Shape &x, unsigned lower, unsigned upper);
+
+/**
+ * Calculates the shape concatenated along the minibatch.
+ * @param xs A list of shapes.
+ * @return A shape.
+ * @remarks Each shape in `xs` should have the same dims.
+ */
+Shape batch_concat(const std::vector<const Shape *> &xs);
+
 /**
  * Calculates the broadcasted shape.
  * @param x A shape.
@@ -239,12 +239,12 @@ Tensor logsumexp(const Tensor &x, unsigned dim) {
 
 template<>
 Tensor log_softmax(const Tensor &x, unsigned dim) {
-  return x - broadcast(logsumexp(x, dim), dim, x.shape()[dim]);
+  return x.device().log_softmax_fw(x, dim);
 }
 
 template<>
 Tensor softmax(const Tensor &x, unsigned dim) {
-  return exp(log_softmax(x, dim));
+  return x.device().softmax_fw(x, dim);
 }
 
 template<>
@@ -255,7 +255,7 @@ Tensor softmax_cross_entropy(const Tensor &x, const Tensor &t, unsigned dim) {
 template<>
 Tensor softmax_cross_entropy(
     const Tensor &x, const std::vector<unsigned> &ids, unsigned dim) {
-  return pick(-log_softmax(x, dim), ids, dim);
+  return x.device().softmax_cross_entropy_fw(x, ids, dim);
 }
 
 namespace batch {
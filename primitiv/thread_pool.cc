@@ -0,0 +1,146 @@
+#include <config.h>
+
+#include <algorithm>
+#include <primitiv/error.h>
+#include <primitiv/thread_pool.h>
+
+namespace {
+
+// Maximum number of subranges assigned to each thread by one parallel_for().
+const unsigned TASKS_PER_THREAD = 4;
+
+// Pool whose task is processed by the current thread.
+thread_local const primitiv::ThreadPool *current_pool = nullptr;
+
+}  // namespace
+
+namespace primitiv {
+
+ThreadPool::ThreadPool(unsigned num_threads) : num_queued_(0), stop_(false) {
+  if (num_threads == 0) {
+    THROW_ERROR("Number of threads should be greater than 0.");
+  }
+  for (unsigned i = 0; i < num_threads; ++i) {
+    queues_.emplace_back(new Queue());
+  }
+  // NOTE:
+  // The queue 0 is used by threads calling parallel_for().
+  for (unsigned i = 1; i < num_threads; ++i) {
+    workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mtx_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  for (std::thread &worker : workers_) worker.join();
+}
+
+void ThreadPool::parallel_for(
+    unsigned size, unsigned grain,
+    const std::function<void(unsigned, unsigned)> &fn) {
+  if (size == 0) return;
+  grain = std::max(1u, grain);
+  const unsigned max_tasks = (size - 1) / grain + 1;
+  const unsigned num_tasks = std::min(
+      max_tasks, num_threads() * ::TASKS_PER_THREAD);
+  if (num_tasks <= 1 || workers_.empty() || ::current_pool == this) {
+    fn(0, size);
+    return;
+  }
+
+  Job job;
+  job.fn = &fn;
+  job.remaining = num_tasks;
+
+  // Distributes tasks to all queues in round-robin order.
+  for (unsigned i = 0; i < num_tasks; ++i) {
+    const unsigned long long total = size;
+    const unsigned begin = total * i / num_tasks;
+    const unsigned end = total * (i + 1) / num_tasks;
+    Queue &q = *queues_[i % queues_.size()];
+    std::lock_guard<std::mutex> lock(q.mtx);
+    q.tasks.push_back(Task { &job, begin, end });
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mtx_);
+    num_queued_ += num_tasks;
+  }
+  wake_cv_.notify_all();
+
+  // The calling thread also processes tasks until the job finishes.
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(job.mtx);
+      if (job.remaining == 0) break;
+    }
+    Task task;
+    if (pop_task(0, task)) {
+      run_task(task);
+    } else {
+      std::unique_lock<std::mutex> lock(job.mtx);
+      job.cv.wait(lock, [&job]() { return job.remaining == 0; });
+      break;
+    }
+  }
+
+  if (job.error) std::rethrow_exception(job.error);
+}
+
+bool ThreadPool::pop_task(unsigned qid, Task &task) {
+  const unsigned nq = queues_.size();
+  for (unsigned i = 0; i < nq; ++i) {
+    Queue &q = *queues_[(qid + i) % nq];
+    std::lock_guard<std::mutex> lock(q.mtx);
+    if (q.tasks.empty()) continue;
+    // Takes the front of the own queue, or steals the back of others.
+    if (i == 0) {
+      task = q.tasks.front();
+      q.tasks.pop_front();
+    } else {
+      task = q.tasks.back();
+      q.tasks.pop_back();
+    }
+    --num_queued_;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::run_task(const Task &task) {
+  Job &job = *task.job;
+  std::exception_ptr error;
+  // NOTE:
+  // The task may call parallel_for() of other pools, e.g., devices used by
+  // each task, which are processed in parallel as usual.
+  const ThreadPool *prev_pool = ::current_pool;
+  ::current_pool = this;
+  try {
+    (*job.fn)(task.begin, task.end);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  ::current_pool = prev_pool;
+
+  std::lock_guard<std::mutex> lock(job.mtx);
+  if (error && !job.error) job.error = error;
+  if (--job.remaining == 0) job.cv.notify_all();
+}
+
+void ThreadPool::worker_loop(unsigned qid) {
+  for (;;) {
+    Task task;
+    if (pop_task(qid, task)) {
+      run_task(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mtx_);
+    wake_cv_.wait(lock, [this]() { return stop_ || num_queued_ > 0; });
+    if (stop_) return;
+  }
+}
+
+}  // namespace primitiv
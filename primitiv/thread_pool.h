@@ -0,0 +1,109 @@
+#ifndef PRIMITIV_THREAD_POOL_H_
+#define PRIMITIV_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <primitiv/mixins.h>
+
+namespace primitiv {
+
+/**
+ * Persistent pool of worker threads with per-thread work-stealing queues.
+ */
+class ThreadPool : mixins::Nonmovable<ThreadPool> {
+  ThreadPool() = delete;
+
+public:
+  /**
+   * Creates a thread pool.
+   * @param num_threads Number of threads used by `parallel_for()`, including
+   *                    the calling thread. `num_threads - 1` workers are
+   *                    launched.
+   * @throw primitiv::Error `num_threads` is 0.
+   */
+  explicit ThreadPool(unsigned num_threads);
+
+  ~ThreadPool();
+
+  /**
+   * Retrieves the number of threads including the calling thread.
+   * @return Number of threads.
+   */
+  unsigned num_threads() const { return queues_.size(); }
+
+  /**
+   * Calls `fn(begin, end)` for disjoint subranges which cover `[0, size)`.
+   * @param size Size of the whole range.
+   * @param grain Minimum size of each subrange.
+   * @param fn Function to be called. It may be called concurrently.
+   * @remarks This function blocks until all subranges are processed, and the
+   *          calling thread also processes subranges while waiting.
+   *          Subranges are determined only by `size`, `grain` and the number
+   *          of threads. Calls of the same pool from inside of `fn` are
+   *          processed serially, while other pools work in parallel.
+   *          If `fn` throws, the first exception is rethrown after all
+   *          subranges are finished.
+   */
+  void parallel_for(
+      unsigned size, unsigned grain,
+      const std::function<void(unsigned, unsigned)> &fn);
+
+private:
+  struct Job {
+    const std::function<void(unsigned, unsigned)> *fn;
+    unsigned remaining;
+    std::exception_ptr error;
+    std::mutex mtx;
+    std::condition_variable cv;
+  };
+
+  struct Task {
+    Job *job;
+    unsigned begin;
+    unsigned end;
+  };
+
+  struct Queue {
+    std::mutex mtx;
+    std::deque<Task> tasks;
+  };
+
+  /**
+   * Obtains a task from the own queue, or steals it from other queues.
+   * @param qid Queue ID of the current thread.
+   * @param task Obtained task.
+   * @return true if a task was obtained, false otherwise.
+   */
+  bool pop_task(unsigned qid, Task &task);
+
+  /**
+   * Processes a task and notifies its completion.
+   * @param task Task to be processed.
+   */
+  void run_task(const Task &task);
+
+  /**
+   * Main loop of worker threads.
+   * @param qid Queue ID of the worker.
+   */
+  void worker_loop(unsigned qid);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::mutex wake_mtx_;
+  std::condition_variable wake_cv_;
+  std::atomic<unsigned> num_queued_;
+  bool stop_;
+};
+
+}  // namespace primitiv
+
+#endif  // PRIMITIV_THREAD_POOL_H_
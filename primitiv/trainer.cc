@@ -1,6 +1,6 @@
 #include <config.h>
 
-#include <cmath>
+#include <algorithm>
 #include <fstream>
 #include <primitiv/error.h>
 #include <primitiv/messages.pb.h>
@@ -40,6 +40,20 @@ void write_proto(
   }
 }
 
+// Returns the dimension of rows of the parameter.
+unsigned get_row_dim(const primitiv::Parameter &param) {
+  return param.shape().depth() - 1;
+}
+
+// Checks whether some parameter has nonzero rows of a row-sparse gradient.
+bool has_gradient_rows(const std::vector<primitiv::Parameter *> &params) {
+  return std::any_of(
+      params.begin(), params.end(), [](const primitiv::Parameter *param) {
+        return param->has_sparse_gradient()
+          && !param->gradient_rows().empty();
+      });
+}
+
 }  // namespace
 
 namespace primitiv {
@@ -67,50 +81,259 @@ void Trainer::save(const std::string &path) const {
   ::write_proto(path, msg);
 }
 
+void Trainer::set_flat_buffer(bool enabled) {
+  flat_ = enabled;
+  flat_dirty_ = enabled;
+  if (!enabled) {
+    flat_buffers_.clear();
+    flat_views_.clear();
+  }
+}
+
 void Trainer::add_parameter(Parameter &param) {
-  if (params_.find(&param) != params_.end()) {
+  if (param_set_.find(&param) != param_set_.end()) {
     THROW_ERROR("Parameter '" << &param << "' is already registered.");
   }
-  params_.insert(&param);
+  param_set_.insert(&param);
+  params_.emplace_back(&param);
   configure_parameter(param);
+  flat_dirty_ = flat_;
+}
+
+void Trainer::prepare_flat_buffers() {
+  if (!flat_) return;
+  if (!flat_dirty_) {
+    for (const auto &view : flat_views_) {
+      if (view.first->data() != view.second) {
+        flat_dirty_ = true;
+        break;
+      }
+    }
+    if (!flat_dirty_) return;
+  }
+
+  flat_buffers_.clear();
+  flat_views_.clear();
+  for (Parameter *param : params_) {
+    Device *dev = &param->device();
+    const auto it = std::find_if(
+        flat_buffers_.begin(), flat_buffers_.end(),
+        [dev](const FlatBuffer &fb) { return fb.device == dev; });
+    if (it == flat_buffers_.end()) {
+      flat_buffers_.emplace_back(FlatBuffer { dev, { param }, {}, {} });
+    } else {
+      it->params.emplace_back(param);
+    }
+  }
+
+  for (FlatBuffer &fb : flat_buffers_) {
+    // NOTE:
+    // The buffer holds all values, all gradients and all statistics in this
+    // order, so that values and gradients can be regarded as flat tensors.
+    std::vector<Tensor *> targets;
+    for (Parameter *param : fb.params) targets.emplace_back(&param->value_);
+    for (Parameter *param : fb.params) targets.emplace_back(&param->grad_);
+    for (Parameter *param : fb.params) {
+      std::vector<std::string> names;
+      for (const auto &kv : param->stats_) names.emplace_back(kv.first);
+      std::sort(names.begin(), names.end());
+      for (const std::string &name : names) {
+        targets.emplace_back(&param->stats_.at(name));
+      }
+    }
+
+    std::vector<Tensor> flats;
+    std::vector<const Tensor *> args;
+    flats.reserve(targets.size());
+    for (const Tensor *x : targets) {
+      flats.emplace_back(x->flatten());
+      args.emplace_back(&flats.back());
+    }
+    const Tensor buffer = fb.device->concat_fw(args, 0);
+
+    unsigned offset = 0;
+    for (Tensor *x : targets) {
+      const Shape shape = x->shape();
+      *x = fb.device->new_tensor_view(buffer, offset, shape);
+      flat_views_.emplace_back(x, static_cast<const Tensor *>(x)->data());
+      offset += shape.size();
+    }
+
+    unsigned num_values = 0;
+    for (const Parameter *param : fb.params) {
+      num_values += param->shape().size();
+    }
+    fb.values = fb.device->new_tensor_view(buffer, 0, {num_values});
+    fb.gradients = fb.device->new_tensor_view(
+        buffer, num_values, {num_values});
+  }
+
+  flat_dirty_ = false;
 }
 
 void Trainer::reset_gradients() {
+  accum_count_ = 0;
+  prepare_flat_buffers();
+  if (flat_) {
+    for (FlatBuffer &fb : flat_buffers_) {
+      // NOTE:
+      // Resetting only nonzero rows is faster than resetting the whole buffer
+      // if there are large row-sparse gradients.
+      if (::has_gradient_rows(fb.params)) {
+        for (Parameter *param : fb.params) param->reset_gradient();
+      } else {
+        fb.gradients.reset(0);
+        for (Parameter *param : fb.params) param->clear_gradient_rows();
+      }
+    }
+    return;
+  }
   for (Parameter *param : params_) {
     param->reset_gradient();
   }
 }
 
+void Trainer::reset_gradients_at_boundary() {
+  if (accum_count_ == 0) reset_gradients();
+}
+
 void Trainer::update() {
+  if (++accum_count_ < accum_steps_) return;
+  accum_count_ = 0;
+  prepare_flat_buffers();
+
+  if (accum_steps_ > 1) {
+    // Normalization of accumulated gradients
+    const float scale = 1.f / accum_steps_;
+    const auto scale_param = [scale](Parameter *param) {
+      if (param->has_sparse_gradient()) {
+        const std::vector<unsigned> &rows = param->gradient_rows();
+        if (rows.empty()) return;
+        const unsigned dim = ::get_row_dim(*param);
+        Tensor &g = param->gradient(dim, rows);
+        g.device().inplace_pick_assign(
+            scale * operators::pick(g, rows, dim), rows, dim, g);
+      } else {
+        param->dense_gradient() *= scale;
+      }
+    };
+    if (flat_) {
+      for (FlatBuffer &fb : flat_buffers_) {
+        if (::has_gradient_rows(fb.params)) {
+          for (Parameter *param : fb.params) scale_param(param);
+        } else {
+          fb.gradients *= scale;
+        }
+      }
+    } else {
+      for (Parameter *param : params_) scale_param(param);
+    }
+  }
+
   if (l2_strength_ > 0) {
     // Weight decay
     for (Parameter *param : params_) {
-      param->gradient() += l2_strength_ * param->value();
+      if (param->is_frozen()) continue;
+      param->dense_gradient() += l2_strength_ * param->value();
     }
   }
 
   if (clip_threshold_ > 0) {
     // Gradient clipping
-    float sq_norm = 0;
-    for (const Parameter *param : params_) {
-      const Tensor &g = param->gradient();
-      sq_norm += operators::sum(operators::flatten(g * g), 0).to_float();
+    // NOTE:
+    // The norm is calculated and applied on each device without retrieving
+    // any value to the host. Row-sparse gradients are processed only at their
+    // nonzero rows, which are picked into temporary tensors. Flat buffers are
+    // processed as one tensor if they have no such rows.
+    std::vector<Device *> devs;
+    std::vector<std::vector<Tensor *>> grads;
+    std::vector<Parameter *> sparse_params;
+    std::vector<Tensor> sparse_rows;
+    sparse_rows.reserve(params_.size());
+    const auto add_gradient = [&](Tensor *g) {
+      Device *dev = &g->device();
+      const auto it = std::find(devs.begin(), devs.end(), dev);
+      if (it == devs.end()) {
+        devs.emplace_back(dev);
+        grads.emplace_back(1, g);
+      } else {
+        grads[it - devs.begin()].emplace_back(g);
+      }
+    };
+    const auto add_param = [&](Parameter *param) {
+      if (param->is_frozen()) return;
+      if (param->has_sparse_gradient()) {
+        const std::vector<unsigned> &rows = param->gradient_rows();
+        if (rows.empty()) return;
+        const unsigned dim = ::get_row_dim(*param);
+        sparse_params.emplace_back(param);
+        sparse_rows.emplace_back(
+            operators::pick(param->gradient(dim, rows), rows, dim));
+        add_gradient(&sparse_rows.back());
+      } else {
+        add_gradient(&param->dense_gradient());
+      }
+    };
+    if (flat_) {
+      for (FlatBuffer &fb : flat_buffers_) {
+        const bool has_frozen = std::any_of(
+            fb.params.begin(), fb.params.end(),
+            [](const Parameter *param) { return param->is_frozen(); });
+        if (has_frozen || ::has_gradient_rows(fb.params)) {
+          for (Parameter *param : fb.params) add_param(param);
+        } else {
+          add_gradient(&fb.gradients);
+        }
+      }
+    } else {
+      for (Parameter *param : params_) add_param(param);
     }
-    if (sq_norm > clip_threshold_ * clip_threshold_) {
-      float clip_scale = clip_threshold_ / std::sqrt(sq_norm);
-      for (Parameter *param : params_) {
-        param->gradient() *= clip_scale;
+
+    if (!devs.empty()) {
+      std::vector<Tensor> sq_norms;
+      sq_norms.reserve(devs.size());
+      for (unsigned i = 0; i < devs.size(); ++i) {
+        sq_norms.emplace_back(devs[i]->squared_norm(
+              std::vector<const Tensor *>(grads[i].begin(), grads[i].end())));
+      }
+      // NOTE:
+      // Norms on other devices are gathered to the first device, and the
+      // total is sent back to each device.
+      for (unsigned i = 1; i < devs.size(); ++i) {
+        sq_norms[0] += operators::copy(sq_norms[i], *devs[0]);
+      }
+      for (unsigned i = 0; i < devs.size(); ++i) {
+        const Tensor sq_norm = i == 0
+          ? sq_norms[0] : operators::copy(sq_norms[0], *devs[i]);
+        devs[i]->inplace_clip_by_norm(clip_threshold_, sq_norm, grads[i]);
+      }
+      for (unsigned i = 0; i < sparse_params.size(); ++i) {
+        Parameter &param = *sparse_params[i];
+        const std::vector<unsigned> &rows = param.gradient_rows();
+        const unsigned dim = ::get_row_dim(param);
+        Tensor &g = param.gradient(dim, rows);
+        g.device().inplace_pick_assign(sparse_rows[i], rows, dim, g);
       }
     }
   }
 
+  std::vector<Parameter *> params;
+  params.reserve(params_.size());
   for (Parameter *param : params_) {
-    update_parameter(lr_scale_, *param);
+    if (!param->is_frozen()) params.emplace_back(param);
   }
+  update_parameters(lr_scale_, params);
 
   ++epoch_;
 }
 
+void Trainer::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  for (Parameter *param : params) {
+    update_parameter(scale, *param);
+  }
+}
+
 void Trainer::get_configs(
     std::unordered_map<std::string, unsigned> &uint_configs,
     std::unordered_map<std::string, float> &float_configs) const {
@@ -3,19 +3,28 @@
 
 #include <memory>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 #include <primitiv/error.h>
 #include <primitiv/mixins.h>
+#include <primitiv/tensor.h>
 
 namespace primitiv {
 
+class DataParallelTrainer;
+class Device;
 class Parameter;
 
 /**
  * Abstract class for parameter optimizers.
  */
 class Trainer : mixins::Nonmovable<Trainer> {
+  friend DataParallelTrainer;
+
 public:
-  Trainer() : epoch_(0), lr_scale_(1), l2_strength_(0), clip_threshold_(0) {}
+  Trainer()
+    : epoch_(0), lr_scale_(1), l2_strength_(0), clip_threshold_(0)
+    , accum_steps_(1), accum_count_(0), flat_(false), flat_dirty_(false) {}
 
   virtual ~Trainer() = default;
 
@@ -94,19 +103,82 @@ public:
     clip_threshold_ = threshold;
   }
 
+  /**
+   * Retrieves whether the flat buffer is used or not.
+   * @return true if the flat buffer is enabled, false otherwise.
+   */
+  bool get_flat_buffer() const { return flat_; }
+
+  /**
+   * Enables or disables the flat buffer.
+   * @param enabled Whether the flat buffer is used or not.
+   * @remarks If enabled, values, gradients and statistics of all registered
+   *          parameters on each device are moved into one contiguous memory,
+   *          and each parameter refers to a part of it. Then gradients on each
+   *          device are reset and clipped by one operation. The buffer is
+   *          rebuilt if some tensor of parameters is detached from it, e.g.,
+   *          by writing to the tensor shared with other objects.
+   */
+  void set_flat_buffer(bool enabled);
+
+  /**
+   * Retrieves the number of micro-batches accumulated for each update.
+   * @return Number of micro-batches.
+   */
+  unsigned get_gradient_accumulation() const { return accum_steps_; }
+
+  /**
+   * Sets the number of micro-batches accumulated for each update.
+   * @param steps Number of micro-batches, or 1 to disable accumulation.
+   * @remarks If `steps > 1`, only every `steps`-th call of update() updates
+   *          parameters, and reset_gradients_at_boundary() keeps gradients
+   *          between them.
+   *          Accumulated gradients are divided by `steps` before weight decay,
+   *          gradient clipping and the update, so that they become the
+   *          average of losses of micro-batches. Each micro-batch can clear
+   *          its graph after the backward pass to release intermediate
+   *          values. Setting this value restarts the accumulation.
+   *          Could not set 0.
+   */
+  void set_gradient_accumulation(unsigned steps) {
+    if (steps == 0) THROW_ERROR(
+        "Could not set 0 to gradient_accumulation.");
+    accum_steps_ = steps;
+    accum_count_ = 0;
+  }
+
+  /**
+   * Retrieves the number of micro-batches accumulated since the last update.
+   * @return Number of micro-batches, which is less than
+   *         get_gradient_accumulation().
+   */
+  unsigned get_accumulated_steps() const { return accum_count_; }
+
   /**
    * Registers a parameter.
    * @param param Parameter to be optimized.
+   * @remarks Parameters are updated in the order of registration.
    */
   void add_parameter(Parameter &param);
 
   /**
    * Resets all gradients of registered parameters.
+   * @remarks This function also discards gradients accumulated since the last
+   *          update, and restarts the accumulation.
    */
   void reset_gradients();
 
   /**
-   * Updates parameter values.
+   * Resets all gradients of registered parameters only before the first
+   * micro-batch of each update, i.e., if get_accumulated_steps() is 0.
+   * @remarks This function is equivalent to reset_gradients() if the gradient
+   *          accumulation is disabled.
+   */
+  void reset_gradients_at_boundary();
+
+  /**
+   * Updates parameter values, or only counts the micro-batch while gradients
+   * are accumulated.
    */
   void update();
 
@@ -129,15 +201,38 @@ public:
       const std::unordered_map<std::string, float> &float_configs);
 
 private:
+  /**
+   * Contiguous memory holding all parameters on one device.
+   */
+  struct FlatBuffer {
+    Device *device;
+    std::vector<Parameter *> params;
+    Tensor values;
+    Tensor gradients;
+  };
+
   unsigned epoch_;
   float lr_scale_;
   float l2_strength_;
   float clip_threshold_;
+  unsigned accum_steps_;
+  unsigned accum_count_;
+  bool flat_;
+  bool flat_dirty_;
 
   // TODO(odashi):
   // This lookup table does not work if a different Parameter object is
   // allocated at the same pointer.
-  std::unordered_set<Parameter *> params_;
+  std::unordered_set<Parameter *> param_set_;
+  std::vector<Parameter *> params_;
+
+  std::vector<FlatBuffer> flat_buffers_;
+  std::vector<std::pair<const Tensor *, const void *>> flat_views_;
+
+  /**
+   * Builds flat buffers if parameters are not arranged in them.
+   */
+  void prepare_flat_buffers();
 
   /**
    * Event handler on adding a new parameter.
@@ -151,6 +246,17 @@ private:
    * @param scale Additional learning rate scaling factor.
    */
   virtual void update_parameter(float scale, Parameter &param) = 0;
+
+  /**
+   * Updates multiple parameters.
+   * @param scale Additional learning rate scaling factor.
+   * @param params Parameters to be updated.
+   * @remarks The default implementation calls `update_parameter()` for each
+   *          parameter. Trainers may override this method to update many
+   *          parameters together.
+   */
+  virtual void update_parameters(
+      float scale, const std::vector<Parameter *> &params);
 };
 
 }  // namespace primitiv
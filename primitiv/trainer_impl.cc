@@ -6,6 +6,69 @@
 #include <primitiv/parameter.h>
 #include <primitiv/trainer_impl.h>
 
+namespace {
+
+using primitiv::Parameter;
+using primitiv::Tensor;
+
+// Returns the gradient of the parameter without discarding its row-sparse
+// state.
+const Tensor &get_gradient(const Parameter &param) {
+  return param.gradient();
+}
+
+// Returns the dimension of rows of the parameter.
+unsigned get_row_dim(const Parameter &param) {
+  return param.shape().depth() - 1;
+}
+
+// Parameters on the same device, which are updated together.
+struct ParameterGroup {
+  primitiv::Device *device;
+  std::vector<const Tensor *> gs;
+  std::vector<Tensor *> xs;
+  std::vector<Parameter *> params;
+};
+
+// Groups parameters by their devices.
+std::vector<ParameterGroup> group_by_device(
+    const std::vector<Parameter *> &params) {
+  std::vector<ParameterGroup> groups;
+  for (Parameter *param : params) {
+    primitiv::Device *dev = &param->device();
+    auto it = std::find_if(
+        groups.begin(), groups.end(),
+        [dev](const ParameterGroup &group) { return group.device == dev; });
+    if (it == groups.end()) {
+      it = groups.insert(groups.end(), ParameterGroup { dev, {}, {}, {} });
+    }
+    it->gs.emplace_back(&::get_gradient(*param));
+    it->xs.emplace_back(&param->value());
+    it->params.emplace_back(param);
+  }
+  return groups;
+}
+
+// Retrieves the same statistics of all parameters in the group.
+std::vector<Tensor *> get_stats(
+    const ParameterGroup &group, const std::string &name) {
+  std::vector<Tensor *> ret;
+  ret.reserve(group.params.size());
+  for (Parameter *param : group.params) ret.emplace_back(&param->stats(name));
+  return ret;
+}
+
+// Returns the shape which has one value for each row of the parameter.
+primitiv::Shape get_row_shape(const Parameter &param) {
+  const primitiv::Shape &shape = param.shape();
+  if (shape.depth() == 0) return primitiv::Shape();
+  std::vector<unsigned> dims(shape.depth(), 1);
+  dims.back() = shape[shape.depth() - 1];
+  return primitiv::Shape(dims);
+}
+
+}  // namespace
+
 namespace primitiv {
 namespace trainers {
 
@@ -20,7 +83,29 @@ namespace trainers {
 void SGD::configure_parameter(Parameter &param) {}
 
 void SGD::update_parameter(float scale, Parameter &param) {
-  param.value() -= (scale * eta_) * param.gradient();
+  if (param.has_sparse_gradient()) {
+    // Updates only rows which have nonzero gradients.
+    const std::vector<unsigned> &rows = param.gradient_rows();
+    if (rows.empty()) return;
+    const unsigned dim = ::get_row_dim(param);
+    const Tensor g = operators::pick(::get_gradient(param), rows, dim);
+    param.device().pick_bw(-(scale * eta_) * g, rows, dim, param.value());
+    return;
+  }
+  param.device().sgd_update(
+      scale * eta_, { &::get_gradient(param) }, { &param.value() });
+}
+
+void SGD::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  std::vector<Parameter *> dense;
+  for (Parameter *param : params) {
+    if (param->has_sparse_gradient()) update_parameter(scale, *param);
+    else dense.emplace_back(param);
+  }
+  for (const ::ParameterGroup &group : ::group_by_device(dense)) {
+    group.device->sgd_update(scale * eta_, group.gs, group.xs);
+  }
 }
 
 void SGD::get_configs(
@@ -46,10 +131,18 @@ void MomentumSGD::configure_parameter(Parameter &param) {
 }
 
 void MomentumSGD::update_parameter(float scale, Parameter &param) {
-  Tensor &m = param.stats("momentumsgd-m");
-  m *= momentum_;
-  m -= (scale * eta_) * param.gradient();
-  param.value() += m;
+  param.device().momentum_sgd_update(
+      scale * eta_, momentum_, { &::get_gradient(param) }, { &param.value() },
+      { &param.stats("momentumsgd-m") });
+}
+
+void MomentumSGD::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  for (const ::ParameterGroup &group : ::group_by_device(params)) {
+    group.device->momentum_sgd_update(
+        scale * eta_, momentum_, group.gs, group.xs,
+        ::get_stats(group, "momentumsgd-m"));
+  }
 }
 
 void MomentumSGD::get_configs(
@@ -77,10 +170,40 @@ void AdaGrad::configure_parameter(Parameter &param) {
 }
 
 void AdaGrad::update_parameter(float scale, Parameter &param) {
-  const Tensor &g = param.gradient();
   Tensor &m = param.stats("adagrad-m");
-  m += g * g;
-  param.value() -= (scale * eta_) * g / (operators::sqrt(m) + eps_);
+  if (param.has_sparse_gradient()) {
+    // NOTE:
+    // Rows with zero gradients change neither `m` nor the value, so the
+    // result is same as the dense update.
+    const std::vector<unsigned> &rows = param.gradient_rows();
+    if (rows.empty()) return;
+    const unsigned dim = ::get_row_dim(param);
+    Device &dev = param.device();
+    const Tensor g = operators::pick(::get_gradient(param), rows, dim);
+    dev.pick_bw(g * g, rows, dim, m);
+    const Tensor mr = operators::pick(m, rows, dim);
+    dev.pick_bw(
+        -(scale * eta_) * g / (operators::sqrt(mr) + eps_),
+        rows, dim, param.value());
+    return;
+  }
+  param.device().adagrad_update(
+      scale * eta_, eps_, { &::get_gradient(param) }, { &param.value() },
+      { &m });
+}
+
+void AdaGrad::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  std::vector<Parameter *> dense;
+  for (Parameter *param : params) {
+    if (param->has_sparse_gradient()) update_parameter(scale, *param);
+    else dense.emplace_back(param);
+  }
+  for (const ::ParameterGroup &group : ::group_by_device(dense)) {
+    group.device->adagrad_update(
+        scale * eta_, eps_, group.gs, group.xs,
+        ::get_stats(group, "adagrad-m"));
+  }
 }
 
 void AdaGrad::get_configs(
@@ -108,10 +231,18 @@ void RMSProp::configure_parameter(Parameter &param) {
 }
 
 void RMSProp::update_parameter(float scale, Parameter &param) {
-  const Tensor &g = param.gradient();
-  Tensor &m = param.stats("rmsprop-m");
-  m = alpha_ * m + (1 - alpha_) * g * g;
-  param.value() -= (scale * eta_) * g / (operators::sqrt(m) + eps_);
+  param.device().rmsprop_update(
+      scale * eta_, alpha_, eps_, { &::get_gradient(param) },
+      { &param.value() }, { &param.stats("rmsprop-m") });
+}
+
+void RMSProp::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  for (const ::ParameterGroup &group : ::group_by_device(params)) {
+    group.device->rmsprop_update(
+        scale * eta_, alpha_, eps_, group.gs, group.xs,
+        ::get_stats(group, "rmsprop-m"));
+  }
 }
 
 void RMSProp::get_configs(
@@ -142,15 +273,18 @@ void AdaDelta::configure_parameter(Parameter &param) {
 }
 
 void AdaDelta::update_parameter(float scale, Parameter &param) {
-  const Tensor &g = param.gradient();
-  Tensor &m1 = param.stats("adadelta-m1");
-  Tensor &m2 = param.stats("adadelta-m2");
-  m2 *= rho_;
-  m2 += (1 - rho_) * g * g;
-  const Tensor dx = operators::sqrt((m1 + eps_) / (m2 + eps_)) * g;
-  m1 *= rho_;
-  m1 += (1 - rho_) * dx * dx;
-  param.value() -= scale * dx;
+  param.device().adadelta_update(
+      scale, rho_, eps_, { &::get_gradient(param) }, { &param.value() },
+      { &param.stats("adadelta-m1") }, { &param.stats("adadelta-m2") });
+}
+
+void AdaDelta::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  for (const ::ParameterGroup &group : ::group_by_device(params)) {
+    group.device->adadelta_update(
+        scale, rho_, eps_, group.gs, group.xs,
+        ::get_stats(group, "adadelta-m1"), ::get_stats(group, "adadelta-m2"));
+  }
 }
 
 void AdaDelta::get_configs(
@@ -179,15 +313,20 @@ void Adam::configure_parameter(Parameter &param) {
 }
 
 void Adam::update_parameter(float scale, Parameter &param) {
-  const unsigned epoch = get_epoch() + 1;
-  const Tensor &g = param.gradient();
-  Tensor &m1 = param.stats("adam-m1");
-  Tensor &m2 = param.stats("adam-m2");
-  m1 = beta1_ * m1 + (1 - beta1_) * g;
-  m2 = beta2_ * m2 + (1 - beta2_) * g * g;
-  const Tensor mm1 = m1 / (1 - std::pow(beta1_, epoch));
-  const Tensor mm2 = m2 / (1 - std::pow(beta2_, epoch));
-  param.value() -= (scale * alpha_) * mm1 / (operators::sqrt(mm2) + eps_);
+  param.device().adam_update(
+      scale * alpha_, beta1_, beta2_, eps_, get_epoch() + 1,
+      { &::get_gradient(param) }, { &param.value() },
+      { &param.stats("adam-m1") }, { &param.stats("adam-m2") });
+}
+
+void Adam::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  for (const ::ParameterGroup &group : ::group_by_device(params)) {
+    group.device->adam_update(
+        scale * alpha_, beta1_, beta2_, eps_, get_epoch() + 1,
+        group.gs, group.xs,
+        ::get_stats(group, "adam-m1"), ::get_stats(group, "adam-m2"));
+  }
 }
 
 void Adam::get_configs(
@@ -210,6 +349,127 @@ void Adam::set_configs(
   SET_CONFIG(eps_, float_configs, "Adam.eps");
 }
 
+void LazyAdam::configure_parameter(Parameter &param) {
+  for (const char *name : {"adam-m1", "adam-m2"}) {
+    if (!param.has_stats(name)) {
+      param.add_stats(name, param.shape());
+      param.stats(name).reset(0);
+    }
+  }
+  // NOTE:
+  // "lazyadam-t" holds the last epoch at which each row is updated, and is
+  // maintained regardless of `catch_up_` to allow switching it later.
+  const std::string name = "lazyadam-t";
+  if (!param.has_stats(name)) {
+    param.add_stats(name, ::get_row_shape(param));
+    param.stats(name).reset(0);
+  }
+}
+
+void LazyAdam::update_parameter(float scale, Parameter &param) {
+  const unsigned epoch = get_epoch() + 1;
+  const float skip_base = epoch - 1;
+  Tensor &m1 = param.stats("adam-m1");
+  Tensor &m2 = param.stats("adam-m2");
+  Tensor &last = param.stats("lazyadam-t");
+
+  if (param.has_sparse_gradient()) {
+    const std::vector<unsigned> &rows = param.gradient_rows();
+    if (rows.empty()) return;
+    const unsigned dim = ::get_row_dim(param);
+    Device &dev = param.device();
+    const Tensor g = operators::pick(::get_gradient(param), rows, dim);
+    Tensor m1r = operators::pick(m1, rows, dim);
+    Tensor m2r = operators::pick(m2, rows, dim);
+    if (catch_up_) {
+      // NOTE:
+      // Picked values of `last` are scalars arranged along the minibatch,
+      // which are broadcasted to each row.
+      const Tensor skip = skip_base - operators::pick(last, rows, dim);
+      m1r = operators::pow(beta1_, skip) * m1r;
+      m2r = operators::pow(beta2_, skip) * m2r;
+    }
+    m1r = beta1_ * m1r + (1 - beta1_) * g;
+    m2r = beta2_ * m2r + (1 - beta2_) * g * g;
+    dev.inplace_pick_assign(m1r, rows, dim, m1);
+    dev.inplace_pick_assign(m2r, rows, dim, m2);
+    dev.inplace_pick_assign(
+        operators::constant<Tensor>(
+          Shape({}, rows.size()), static_cast<float>(epoch), dev),
+        rows, dim, last);
+    const Tensor mm1 = m1r / (1 - std::pow(beta1_, epoch));
+    const Tensor mm2 = m2r / (1 - std::pow(beta2_, epoch));
+    dev.pick_bw(
+        -(scale * alpha_) * mm1 / (operators::sqrt(mm2) + eps_),
+        rows, dim, param.value());
+    return;
+  }
+
+  if (catch_up_) {
+    const Shape &shape = param.shape();
+    const Tensor skip = skip_base - last;
+    Tensor d1 = operators::pow(beta1_, skip);
+    Tensor d2 = operators::pow(beta2_, skip);
+    for (unsigned i = 0; i + 1 < shape.depth(); ++i) {
+      d1 = operators::broadcast(d1, i, shape[i]);
+      d2 = operators::broadcast(d2, i, shape[i]);
+    }
+    // NOTE: Moments are updated in place to keep views of flat buffers.
+    Device &dev = param.device();
+    dev.inplace_copy(d1 * m1, m1);
+    dev.inplace_copy(d2 * m2, m2);
+  }
+  param.device().adam_update(
+      scale * alpha_, beta1_, beta2_, eps_, epoch,
+      { &::get_gradient(param) }, { &param.value() }, { &m1 }, { &m2 });
+  last.reset(epoch);
+}
+
+void LazyAdam::update_parameters(
+    float scale, const std::vector<Parameter *> &params) {
+  // NOTE:
+  // The catch-up correction requires individual updates of moments.
+  std::vector<Parameter *> dense;
+  for (Parameter *param : params) {
+    if (catch_up_ || param->has_sparse_gradient()) {
+      update_parameter(scale, *param);
+    } else {
+      dense.emplace_back(param);
+    }
+  }
+  const unsigned epoch = get_epoch() + 1;
+  for (const ::ParameterGroup &group : ::group_by_device(dense)) {
+    group.device->adam_update(
+        scale * alpha_, beta1_, beta2_, eps_, epoch, group.gs, group.xs,
+        ::get_stats(group, "adam-m1"), ::get_stats(group, "adam-m2"));
+    for (Parameter *param : group.params) {
+      param->stats("lazyadam-t").reset(epoch);
+    }
+  }
+}
+
+void LazyAdam::get_configs(
+    std::unordered_map<std::string, unsigned> &uint_configs,
+    std::unordered_map<std::string, float> &float_configs) const {
+  Trainer::get_configs(uint_configs, float_configs);
+  float_configs.insert(std::make_pair("LazyAdam.alpha", alpha_));
+  float_configs.insert(std::make_pair("LazyAdam.beta1", beta1_));
+  float_configs.insert(std::make_pair("LazyAdam.beta2", beta2_));
+  float_configs.insert(std::make_pair("LazyAdam.eps", eps_));
+  uint_configs.insert(std::make_pair("LazyAdam.catch_up", catch_up_));
+}
+
+void LazyAdam::set_configs(
+    const std::unordered_map<std::string, unsigned> &uint_configs,
+    const std::unordered_map<std::string, float> &float_configs) {
+  Trainer::set_configs(uint_configs, float_configs);
+  SET_CONFIG(alpha_, float_configs, "LazyAdam.alpha");
+  SET_CONFIG(beta1_, float_configs, "LazyAdam.beta1");
+  SET_CONFIG(beta2_, float_configs, "LazyAdam.beta2");
+  SET_CONFIG(eps_, float_configs, "LazyAdam.eps");
+  SET_CONFIG(catch_up_, uint_configs, "LazyAdam.catch_up");
+}
+
 #undef SET_CONFIG
 
 }  // namespace trainers
@@ -16,7 +16,9 @@ public: \
       const std::unordered_map<std::string, float> &float_configs) override; \
 private: \
   void configure_parameter(Parameter &param) override; \
-  void update_parameter(float scale, Parameter &param) override;
+  void update_parameter(float scale, Parameter &param) override; \
+  void update_parameters( \
+      float scale, const std::vector<Parameter *> &params) override;
 
 /**
  * Simple stochastic gradient descent.
@@ -229,6 +231,69 @@ private:
   float eps_;
 };
 
+/**
+ * Adam optimizer which updates only rows with nonzero gradients.
+ * Rows of parameters with row-sparse gradients which are not used in the
+ * current step keep their moments and values, and the remaining rows and
+ * parameters with dense gradients are updated in the same way as Adam.
+ */
+class LazyAdam : public primitiv::Trainer {
+  DECL_DEFAULTS;
+
+public:
+  /**
+   * Creates a new LazyAdam object.
+   * @param alpha Learning rate.
+   * @param beta1 Decay factor of momentum history.
+   * @param beta2 Decay factor of power history.
+   * @param eps Bias of power.
+   * @param catch_up Whether or not to apply the decay of moments skipped
+   *                 since the last update of each row before updating it.
+   */
+  LazyAdam(
+      float alpha = 0.001, float beta1 = 0.9, float beta2 = 0.999,
+      float eps = 1e-8, bool catch_up = false)
+    : alpha_(alpha), beta1_(beta1), beta2_(beta2), eps_(eps)
+    , catch_up_(catch_up) {}
+
+  /**
+   * Returns the hyperparameter alpha.
+   * @return The value of alpha.
+   */
+  float alpha() const { return alpha_; }
+
+  /**
+   * Returns the hyperparameter beta1.
+   * @return The value of beta1.
+   */
+  float beta1() const { return beta1_; }
+
+  /**
+   * Returns the hyperparameter beta2.
+   * @return The value of beta2.
+   */
+  float beta2() const { return beta2_; }
+
+  /**
+   * Returns the hyperparameter eps.
+   * @return The value of eps.
+   */
+  float eps() const { return eps_; }
+
+  /**
+   * Returns whether the catch-up correction is enabled or not.
+   * @return true if the skipped decay of moments is applied, false otherwise.
+   */
+  bool catch_up() const { return catch_up_; }
+
+private:
+  float alpha_;
+  float beta1_;
+  float beta2_;
+  float eps_;
+  bool catch_up_;
+};
+
 #undef DECL_DEFAULTS
 
 }  // namespace trainers
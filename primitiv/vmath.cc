@@ -0,0 +1,242 @@
+#include <config.h>
+
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <primitiv/error.h>
+#include <primitiv/vmath.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PRIMITIV_VMATH_X86
+#endif
+
+/*
+ * NOTE:
+ * Each function is written once as a branch-free kernel on the vector
+ * extension types of GCC/Clang, and instantiated for 16-byte (SSE2 on x86),
+ * 32-byte (AVX2+FMA) and 64-byte (AVX-512F) vectors.
+ * The polynomials are taken from the single-precision Cephes library.
+ */
+
+#define VMATH_INLINE inline __attribute__((always_inline))
+
+namespace {
+
+using primitiv::cpu_features::Isa;
+
+template<typename F>
+VMATH_INLINE F vbroadcast(float k) {
+  return F() + k;
+}
+
+template<typename F, typename I>
+VMATH_INLINE F vselect(I mask, F a, F b) {
+  return (F)((mask & (I)a) | (~mask & (I)b));
+}
+
+template<typename F, typename I>
+VMATH_INLINE F vabs(F x) {
+  return (F)((I)x & 0x7fffffff);
+}
+
+// exp(x) = 2^n * exp(r), where n = round(x / log(2)), |r| <= log(2) / 2.
+template<typename F, typename I>
+VMATH_INLINE F exp_kernel(F x) {
+  const float LOG2E = 1.44269504088896341f;
+  const float LN2_HI = 0.693359375f;
+  const float LN2_LO = -2.12194440e-4f;
+  // Adding this value rounds floats in [-2^22, 2^22] to integers.
+  const float ROUND = 12582912.f;
+
+  // exp(x) underflows to 0 below -104 and overflows to inf above 89.
+  F xc = ::vselect<F, I>(x > -104.f, x, ::vbroadcast<F>(-104.f));
+  xc = ::vselect<F, I>(xc < 89.f, xc, ::vbroadcast<F>(89.f));
+
+  const F t = xc * LOG2E + ROUND;
+  const F n = t - ROUND;
+  const I ni = (I)t - (I)::vbroadcast<F>(ROUND);
+  F r = xc - n * LN2_HI;
+  r = r - n * LN2_LO;
+
+  F p = r * 1.9875691500e-4f + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * (r * r) + r + 1.f;
+
+  // 2^n is split into two factors to cover n in [-150, 128] including
+  // subnormal results.
+  const I n1 = ni >> 1;
+  const I n2 = ni - n1;
+  const F y = p * (F)((n1 + 127) << 23) * (F)((n2 + 127) << 23);
+  return ::vselect<F, I>(x == x, y, x);
+}
+
+// log(x) = e * log(2) + log(1 + m), where sqrt(1/2) <= 1 + m < sqrt(2).
+template<typename F, typename I>
+VMATH_INLINE F log_kernel(F x) {
+  const float SQRTHF = 0.707106781186547524f;
+  const float LN2_HI = 0.693359375f;
+  const float LN2_LO = -2.12194440e-4f;
+  const float INF = std::numeric_limits<float>::infinity();
+  const float NAN_ = std::numeric_limits<float>::quiet_NaN();
+
+  // Normalizes subnormal inputs.
+  const I subnormal = x < FLT_MIN;
+  const F xn = ::vselect<F, I>(subnormal, x * 8388608.f, x);
+  const I bits = (I)xn;
+  I e = ((bits >> 23) & 0xff) - 126 - (subnormal & 23);
+  // m in [0.5, 1)
+  F m = (F)((bits & 0x007fffff) | 0x3f000000);
+  const I small = m < SQRTHF;
+  e = e + small;
+  m = ::vselect<F, I>(small, m + m - 1.f, m - 1.f);
+
+  const F fe = __builtin_convertvector(e, F);
+  const F z = m * m;
+  F p = m * 7.0376836292e-2f - 1.1514610310e-1f;
+  p = p * m + 1.1676998740e-1f;
+  p = p * m - 1.2420140846e-1f;
+  p = p * m + 1.4249322787e-1f;
+  p = p * m - 1.6668057665e-1f;
+  p = p * m + 2.0000714765e-1f;
+  p = p * m - 2.4999993993e-1f;
+  p = p * m + 3.3333331174e-1f;
+  F y = p * m * z;
+  y = y + fe * LN2_LO;
+  y = y - .5f * z;
+  y = m + y;
+  y = y + fe * LN2_HI;
+
+  y = ::vselect<F, I>(x == INF, ::vbroadcast<F>(INF), y);
+  y = ::vselect<F, I>(x == 0.f, ::vbroadcast<F>(-INF), y);
+  y = ::vselect<F, I>(x < 0.f, ::vbroadcast<F>(NAN_), y);
+  return ::vselect<F, I>(x == x, y, x);
+}
+
+template<typename F, typename I>
+VMATH_INLINE F tanh_kernel(F x) {
+  const F ax = ::vabs<F, I>(x);
+
+  // Polynomial for small inputs.
+  const F z = x * x;
+  F p = z * -5.70498872745e-3f + 2.06390887954e-2f;
+  p = p * z - 5.37397155531e-2f;
+  p = p * z + 1.33314422036e-1f;
+  p = p * z - 3.33332819422e-1f;
+  const F ys = p * z * x + x;
+
+  // 1 - 2 / (exp(2|x|) + 1) for large inputs.
+  F yl = 1.f - 2.f / (::exp_kernel<F, I>(ax + ax) + 1.f);
+  yl = (F)((I)yl | ((I)x & (int)0x80000000));
+
+  return ::vselect<F, I>(ax < .625f, ys, yl);
+}
+
+// sigmoid(x) = 1/2 + tanh(x/2)/2 for x >= 0, and e^x / (1 + e^x) otherwise.
+// Both forms avoid cancellations.
+template<typename F, typename I>
+VMATH_INLINE F sigmoid_kernel(F x) {
+  const F yp = .5f + .5f * ::tanh_kernel<F, I>(.5f * x);
+  const F e = ::exp_kernel<F, I>(x);
+  const F yn = e / (1.f + e);
+  return ::vselect<F, I>(x < 0.f, yn, yp);
+}
+
+// softplus(x) = max(x, 0) + log1p(exp(-|x|))
+template<typename F, typename I>
+VMATH_INLINE F softplus_kernel(F x) {
+  const F u = ::exp_kernel<F, I>(-::vabs<F, I>(x));
+  const F w = 1.f + u;
+  // log1p(u) = log(w) * u / (w - 1) compensates the rounding error of w.
+  const F l = ::vselect<F, I>(
+      w == 1.f, u, ::log_kernel<F, I>(w) * (u / (w - 1.f)));
+  return ::vselect<F, I>(x > 0.f, x, F()) + l;
+}
+
+using Function = void (*)(unsigned, const float *, float *);
+
+// Applies the kernel to each vector. The last partial vector is padded.
+#define VMATH_LOOP(name, bytes) { \
+  typedef float F __attribute__((vector_size(bytes))); \
+  typedef std::int32_t I __attribute__((vector_size(bytes))); \
+  const unsigned n = bytes / sizeof(float); \
+  unsigned i = 0; \
+  for (; i + n <= size; i += n) { \
+    F v; \
+    std::memcpy(&v, x + i, bytes); \
+    v = ::name##_kernel<F, I>(v); \
+    std::memcpy(y + i, &v, bytes); \
+  } \
+  if (i < size) { \
+    F v = {}; \
+    std::memcpy(&v, x + i, (size - i) * sizeof(float)); \
+    v = ::name##_kernel<F, I>(v); \
+    std::memcpy(y + i, &v, (size - i) * sizeof(float)); \
+  } \
+}
+
+#ifdef PRIMITIV_VMATH_X86
+#define VMATH_DEFINE(name) \
+void name##_generic(unsigned size, const float *x, float *y) \
+VMATH_LOOP(name, 16) \
+__attribute__((target("avx2,fma"))) \
+void name##_avx2(unsigned size, const float *x, float *y) \
+VMATH_LOOP(name, 32) \
+__attribute__((target("avx512f"))) \
+void name##_avx512(unsigned size, const float *x, float *y) \
+VMATH_LOOP(name, 64) \
+Function name##_function(Isa isa) { \
+  switch (isa) { \
+    case primitiv::cpu_features::ISA_AVX512: return ::name##_avx512; \
+    case primitiv::cpu_features::ISA_AVX2: return ::name##_avx2; \
+    default: return ::name##_generic; \
+  } \
+}
+#else
+#define VMATH_DEFINE(name) \
+void name##_generic(unsigned size, const float *x, float *y) \
+VMATH_LOOP(name, 16) \
+Function name##_function(Isa) { return ::name##_generic; }
+#endif  // PRIMITIV_VMATH_X86
+
+VMATH_DEFINE(exp);
+VMATH_DEFINE(log);
+VMATH_DEFINE(tanh);
+VMATH_DEFINE(sigmoid);
+VMATH_DEFINE(softplus);
+
+#undef VMATH_LOOP
+#undef VMATH_DEFINE
+
+void check_isa(Isa isa) {
+  if (!primitiv::cpu_features::supports(isa)) {
+    THROW_ERROR(
+        "Instruction set '" << primitiv::cpu_features::isa_name(isa)
+        << "' is not supported on this CPU.");
+  }
+}
+
+}  // namespace
+
+namespace primitiv {
+namespace vmath {
+
+#define VMATH_FUNCTION(name) \
+void name(unsigned size, const float *x, float *y, cpu_features::Isa isa) { \
+  ::check_isa(isa); \
+  ::name##_function(isa)(size, x, y); \
+}
+
+VMATH_FUNCTION(exp);
+VMATH_FUNCTION(log);
+VMATH_FUNCTION(tanh);
+VMATH_FUNCTION(sigmoid);
+VMATH_FUNCTION(softplus);
+
+#undef VMATH_FUNCTION
+
+}  // namespace vmath
+}  // namespace primitiv
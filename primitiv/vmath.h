@@ -0,0 +1,83 @@
+#ifndef PRIMITIV_VMATH_H_
+#define PRIMITIV_VMATH_H_
+
+#include <primitiv/cpu_features.h>
+
+namespace primitiv {
+
+/**
+ * Vectorized elementwise math functions on float arrays.
+ *
+ * Each function calculates `y[i] = f(x[i])` for `i` in `[0, size)`. `x` and
+ * `y` may point to the same array. The error bounds below are measured
+ * against the correctly rounded results. Results whose magnitude is smaller
+ * than `FLT_MIN` are only guaranteed up to the absolute error `FLT_MIN`.
+ * NaN inputs produce NaN.
+ */
+namespace vmath {
+
+/**
+ * Calculates the natural exponential function.
+ * @param size Number of elements.
+ * @param x Input array.
+ * @param y Output array.
+ * @param isa Instruction set used by the implementation.
+ * @remarks Maximum error: 1 ULP. Overflows to `+inf` if `x > 88.72`.
+ */
+void exp(
+    unsigned size, const float *x, float *y,
+    cpu_features::Isa isa = cpu_features::max_isa());
+
+/**
+ * Calculates the natural logarithm.
+ * @param size Number of elements.
+ * @param x Input array.
+ * @param y Output array.
+ * @param isa Instruction set used by the implementation.
+ * @remarks Maximum error: 1 ULP. Returns `-inf` for 0 and NaN for negative
+ *          values.
+ */
+void log(
+    unsigned size, const float *x, float *y,
+    cpu_features::Isa isa = cpu_features::max_isa());
+
+/**
+ * Calculates the hyperbolic tangent.
+ * @param size Number of elements.
+ * @param x Input array.
+ * @param y Output array.
+ * @param isa Instruction set used by the implementation.
+ * @remarks Maximum error: 2 ULP.
+ */
+void tanh(
+    unsigned size, const float *x, float *y,
+    cpu_features::Isa isa = cpu_features::max_isa());
+
+/**
+ * Calculates the logistic sigmoid function `1 / (1 + exp(-x))`.
+ * @param size Number of elements.
+ * @param x Input array.
+ * @param y Output array.
+ * @param isa Instruction set used by the implementation.
+ * @remarks Maximum error: 2 ULP.
+ */
+void sigmoid(
+    unsigned size, const float *x, float *y,
+    cpu_features::Isa isa = cpu_features::max_isa());
+
+/**
+ * Calculates the softplus function `log(1 + exp(x))`.
+ * @param size Number of elements.
+ * @param x Input array.
+ * @param y Output array.
+ * @param isa Instruction set used by the implementation.
+ * @remarks Maximum error: 3 ULP.
+ */
+void softplus(
+    unsigned size, const float *x, float *y,
+    cpu_features::Isa isa = cpu_features::max_isa());
+
+}  // namespace vmath
+}  // namespace primitiv
+
+#endif  // PRIMITIV_VMATH_H_
@@ -1,10 +1,33 @@
+from libcpp cimport bool
+from libcpp.map cimport map
+from libcpp.string cimport string
+from libc.stdint cimport uint64_t
+
+
 cdef extern from "primitiv/device.h":
+    cdef cppclass CppOpStatistics "primitiv::Device::OpStatistics":
+        uint64_t num_calls
+        uint64_t num_elements
+        uint64_t num_flops
+        uint64_t duration_ns
+
+    cdef cppclass CppMemoryStatistics "primitiv::Device::MemoryStatistics":
+        uint64_t num_allocations
+        uint64_t bytes_allocated
+        uint64_t bytes_in_use
+        uint64_t peak_bytes_in_use
+
     cdef cppclass CppDevice "primitiv::Device":
         @staticmethod
         CppDevice &get_default() except +
         @staticmethod
         void set_default(CppDevice &dev) except +
         void dump_description() except +
+        void set_profiling(bool enabled) except +
+        bool is_profiling_enabled() except +
+        map[string, CppOpStatistics] get_op_statistics() except +
+        CppMemoryStatistics get_memory_statistics() except +
+        void reset_statistics() except +
 
 
 cdef class _Device:
@@ -1,4 +1,5 @@
 from libc.stdint cimport uintptr_t
+from libcpp.pair cimport pair
 
 from weakref import WeakValueDictionary
 
@@ -25,6 +26,39 @@ cdef class _Device:
         self.wrapped.dump_description()
         return
 
+    def set_profiling(self, bool enabled):
+        self.wrapped.set_profiling(enabled)
+        return
+
+    def is_profiling_enabled(self):
+        return self.wrapped.is_profiling_enabled()
+
+    def get_op_statistics(self):
+        cdef map[string, CppOpStatistics] stats = self.wrapped.get_op_statistics()
+        cdef pair[string, CppOpStatistics] kv
+        result = {}
+        for kv in stats:
+            result[kv.first.decode("utf-8")] = {
+                "num_calls": kv.second.num_calls,
+                "num_elements": kv.second.num_elements,
+                "num_flops": kv.second.num_flops,
+                "duration_ns": kv.second.duration_ns,
+            }
+        return result
+
+    def get_memory_statistics(self):
+        cdef CppMemoryStatistics stats = self.wrapped.get_memory_statistics()
+        return {
+            "num_allocations": stats.num_allocations,
+            "bytes_allocated": stats.bytes_allocated,
+            "bytes_in_use": stats.bytes_in_use,
+            "peak_bytes_in_use": stats.peak_bytes_in_use,
+        }
+
+    def reset_statistics(self):
+        self.wrapped.reset_statistics()
+        return
+
     def __copy__(self):
         raise NotImplementedError(type(self).__name__ + " does not support `__copy__` for now.")
 
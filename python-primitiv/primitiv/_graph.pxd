@@ -54,6 +54,11 @@ cdef extern from "primitiv/graph.h" nogil:
         CppDevice &get_device(const CppNode &node) except +
         string dump(const string &format) except +
         unsigned num_functions() except +
+        void set_inference_mode(bool enabled) except +
+        bool is_inference_mode() except +
+        void retain(const CppNode &node) except +
+        void set_input(const CppNode &node, const vector[float] &data) except +
+        void invalidate() except +
 
 
 cdef class _Node:
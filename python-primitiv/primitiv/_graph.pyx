@@ -5,6 +5,7 @@ from primitiv._device cimport _Device
 from primitiv._shape cimport wrapShape
 from primitiv._tensor cimport _Tensor
 from primitiv._operator cimport op_pow, op_ipow, op_matmul
+from utils cimport ndarrays_to_vector
 
 from weakref import WeakValueDictionary
 
@@ -214,6 +215,36 @@ cdef class _Graph:
     def num_functions(self):
         return self.wrapped.num_functions()
 
+    def set_inference_mode(self, bool enabled):
+        self.wrapped.set_inference_mode(enabled)
+        return
+
+    def is_inference_mode(self):
+        return self.wrapped.is_inference_mode()
+
+    def retain(self, _Node node):
+        self.wrapped.retain(node.wrapped)
+        return
+
+    def set_input(self, _Node node, data):
+        cdef vector[float] data_vector
+        if isinstance(data, np.ndarray):
+            data = [data]
+        elif not isinstance(data, list):
+            raise TypeError("Argument 'data' has incorrect type (list or numpy.ndarray)")
+        if len(data) == 0:
+            raise TypeError("data is a list, but it contains no item")
+        if isinstance(data[0], (float, int)):
+            data_vector = <vector[float]> data
+        else:
+            data_vector = ndarrays_to_vector(data)
+        self.wrapped.set_input(node.wrapped, data_vector)
+        return
+
+    def invalidate(self):
+        self.wrapped.invalidate()
+        return
+
     def __copy__(self):
         raise NotImplementedError(type(self).__name__ + " does not support `__copy__` for now.")
 
@@ -22,10 +22,15 @@ cdef extern from "primitiv/parameter.h":
         void reset_gradient() except +
         void add_stats(const string &name, const CppShape &shape) except +
         bool has_stats(const string &name) except +
+        void set_frozen(bool frozen) except +
+        bool is_frozen() except +
         const CppShape &shape() except +
         CppDevice &device() except +
         CppTensor &value() except +
         CppTensor &gradient() except +
+        CppTensor &dense_gradient() except +
+        bool has_sparse_gradient() except +
+        const vector[unsigned] &gradient_rows() except +
         CppTensor &stats(const string &name) except +
         void save(const string &path, bool with_stats) except +
 
@@ -101,6 +101,19 @@ cdef class _Parameter:
     # def has_stats(self, str name):
     #     return self.wrapped.has_stats(name.encode("utf-8"))
 
+    def set_frozen(self, bool frozen):
+        self.wrapped.set_frozen(frozen)
+        return
+
+    def is_frozen(self):
+        return self.wrapped.is_frozen()
+
+    def has_sparse_gradient(self):
+        return self.wrapped.has_sparse_gradient()
+
+    def gradient_rows(self):
+        return self.wrapped.gradient_rows()
+
     def shape(self):
         return wrapShape(self.wrapped.shape())
 
@@ -120,15 +133,21 @@ cdef class _Parameter:
 
     # NOTE(vbkaisetsu):
     # `gradient` function is replaced with a property in Python.
+    # NOTE:
+    # The returned tensor is writable, so the getter makes the gradient dense
+    # as same as `dense_gradient()`.
     @property
     def gradient(self):
         return _Tensor.get_wrapper(&self.wrapped.gradient())
 
     @gradient.setter
     def gradient(self, _Tensor value):
-        cdef CppTensor *tensor_p = &self.wrapped.gradient()
+        cdef CppTensor *tensor_p = &self.wrapped.dense_gradient()
         tensor_p[0] = value.wrapped[0]
 
+    def dense_gradient(self):
+        return _Tensor.get_wrapper(&self.wrapped.dense_gradient())
+
     # NOTE(vbkaisetsu):
     # This function is replaced with `stats` variable.
     # def stats(self, str name):
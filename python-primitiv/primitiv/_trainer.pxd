@@ -23,8 +23,14 @@ cdef extern from "primitiv/trainer.h":
         void set_weight_decay(float strength) except +
         float get_gradient_clipping() except +
         void set_gradient_clipping(float threshold) except +
+        bool get_flat_buffer() except +
+        void set_flat_buffer(bool enabled) except +
+        unsigned get_gradient_accumulation() except +
+        void set_gradient_accumulation(unsigned steps) except +
+        unsigned get_accumulated_steps() except +
         void add_parameter(CppParameter &param) except +
         void reset_gradients() except +
+        void reset_gradients_at_boundary() except +
         void update() except +
         void get_configs(unordered_map[string, unsigned] &uint_configs, unordered_map[string, float] &float_configs) except +
         void set_configs(const unordered_map[string, unsigned] &uint_configs, const unordered_map[string, float] &float_configs) except +
@@ -65,6 +65,23 @@ cdef class _Trainer:
         self.wrapped.set_gradient_clipping(threshold)
         return
 
+    def get_flat_buffer(self):
+        return self.wrapped.get_flat_buffer()
+
+    def set_flat_buffer(self, bool enabled):
+        self.wrapped.set_flat_buffer(enabled)
+        return
+
+    def get_gradient_accumulation(self):
+        return self.wrapped.get_gradient_accumulation()
+
+    def set_gradient_accumulation(self, unsigned steps):
+        self.wrapped.set_gradient_accumulation(steps)
+        return
+
+    def get_accumulated_steps(self):
+        return self.wrapped.get_accumulated_steps()
+
     def add_parameter(self, _Parameter param):
         self.wrapped.add_parameter(param.wrapped[0])
         return
@@ -73,6 +90,14 @@ cdef class _Trainer:
         self.wrapped.reset_gradients()
         return
 
+    # NOTE:
+    # `reset_gradients()` always resets gradients and restarts the gradient
+    # accumulation. Call this function at the beginning of each micro-batch to
+    # keep gradients until the update.
+    def reset_gradients_at_boundary(self):
+        self.wrapped.reset_gradients_at_boundary()
+        return
+
     def update(self):
         self.wrapped.update()
         return
@@ -5,6 +5,8 @@ cdef extern from "primitiv/naive_device.h":
     cdef cppclass CppNaive "primitiv::devices::Naive" (CppDevice):
         CppNaive() except +
         CppNaive(unsigned rng_seed) except +
+        CppNaive(unsigned rng_seed, unsigned num_threads) except +
+        unsigned num_threads()
 
 
 cdef class _Naive(_Device):
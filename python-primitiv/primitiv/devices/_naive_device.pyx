@@ -1,18 +1,27 @@
 from primitiv._device cimport _Device
 
+import random
+
 
 cdef class _Naive(_Device):
 
-    def __init__(self, rng_seed = None):
+    def __init__(self, rng_seed = None, num_threads = None):
         if self.wrapped is not NULL:
             raise MemoryError()
-        if rng_seed is None:
+        if num_threads is not None:
+            if rng_seed is None:
+                rng_seed = random.getrandbits(32)
+            self.wrapped = new CppNaive(<unsigned> rng_seed, <unsigned> num_threads)
+        elif rng_seed is None:
             self.wrapped = new CppNaive()
         else:
             self.wrapped = new CppNaive(<unsigned> rng_seed)
 
         _Device.register_wrapper(self.wrapped, self)
 
+    def num_threads(self):
+        return (<CppNaive*> self.wrapped).num_threads()
+
     def __dealloc__(self):
         if self.wrapped is not NULL:
             del self.wrapped
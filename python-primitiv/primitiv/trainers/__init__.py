@@ -4,6 +4,7 @@ from primitiv.trainers._trainer_impl import _AdaGrad as AdaGrad
 from primitiv.trainers._trainer_impl import _RMSProp as RMSProp
 from primitiv.trainers._trainer_impl import _AdaDelta as AdaDelta
 from primitiv.trainers._trainer_impl import _Adam as Adam
+from primitiv.trainers._trainer_impl import _LazyAdam as LazyAdam
 
 __all__ = [
     "SGD",
@@ -12,4 +13,5 @@ __all__ = [
     "RMSProp",
     "AdaDelta",
     "Adam",
+    "LazyAdam",
 ]
@@ -1,3 +1,4 @@
+from libcpp cimport bool
 from libcpp.string cimport string
 from libcpp.unordered_map cimport unordered_map
 
@@ -38,6 +39,14 @@ cdef extern from "primitiv/trainer_impl.h":
         float beta2()
         float eps()
 
+    cdef cppclass CppLazyAdam "primitiv::trainers::LazyAdam" (CppTrainer):
+        CppLazyAdam(float alpha, float beta1, float beta2, float eps, bool catch_up)
+        float alpha()
+        float beta1()
+        float beta2()
+        float eps()
+        bool catch_up()
+
 
 cdef class _SGD(_Trainer):
     pass
@@ -61,3 +70,7 @@ cdef class _AdaDelta(_Trainer):
 
 cdef class _Adam(_Trainer):
     pass
+
+
+cdef class _LazyAdam(_Trainer):
+    pass
@@ -1,3 +1,4 @@
+from libcpp cimport bool
 from libcpp.string cimport string
 
 
@@ -89,3 +90,26 @@ cdef class _Adam(_Trainer):
 
     def eps(self):
         return (<CppAdam*> self.wrapped).eps()
+
+
+cdef class _LazyAdam(_Trainer):
+
+    def __init__(self, float alpha = 0.001, float beta1 = 0.9, float beta2 = 0.999, float eps = 1e-8, bool catch_up = False):
+        if self.wrapped is not NULL:
+            raise MemoryError()
+        self.wrapped = new CppLazyAdam(alpha, beta1, beta2, eps, catch_up)
+
+    def alpha(self):
+        return (<CppLazyAdam*> self.wrapped).alpha()
+
+    def beta1(self):
+        return (<CppLazyAdam*> self.wrapped).beta1()
+
+    def beta2(self):
+        return (<CppLazyAdam*> self.wrapped).beta2()
+
+    def eps(self):
+        return (<CppLazyAdam*> self.wrapped).eps()
+
+    def catch_up(self):
+        return (<CppLazyAdam*> self.wrapped).catch_up()
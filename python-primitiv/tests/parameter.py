@@ -55,9 +55,13 @@ class ParameterTest(unittest.TestCase):
 
     def test_parameter_gradient(self):
         self.p.reset_gradient()
+        self.assertTrue(self.p.has_sparse_gradient())
         self.assertTrue((self.p.gradient.to_ndarrays() == np.zeros([8])).all())
+        self.assertFalse(self.p.has_sparse_gradient())
         grad = self.p.gradient
         self.p.gradient += tF.input(np.ones([8]))
         self.assertTrue((grad.to_ndarrays()[0] == np.ones([8])).all())
         with self.assertRaises(NotImplementedError):
             del self.p.gradient
+        self.p.dense_gradient().reset(2)
+        self.assertTrue((grad.to_ndarrays()[0] == np.full([8], 2)).all())
@@ -0,0 +1,279 @@
+#include <config.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/data_parallel_trainer.h>
+#include <primitiv/error.h>
+#include <primitiv/graph.h>
+#include <primitiv/naive_device.h>
+#include <primitiv/operators.h>
+#include <primitiv/parameter.h>
+#include <primitiv/trainer_impl.h>
+#include <test_utils.h>
+
+using std::vector;
+using test_utils::vector_match;
+using test_utils::vector_near;
+
+namespace primitiv {
+
+class DataParallelTrainerTest : public testing::Test {
+protected:
+  devices::Naive dev0;
+  devices::Naive dev1;
+  devices::Naive dev2;
+};
+
+TEST_F(DataParallelTrainerTest, CheckInvalidTrainers) {
+  trainers::SGD trainer0, trainer1;
+  EXPECT_THROW(DataParallelTrainer(vector<Trainer *>()), Error);
+  EXPECT_THROW(DataParallelTrainer({&trainer0, &trainer0}), Error);
+  EXPECT_THROW(DataParallelTrainer({&trainer0, &trainer1, &trainer0}), Error);
+  DataParallelTrainer dpt({&trainer0, &trainer1});
+  EXPECT_EQ(2u, dpt.num_replicas());
+}
+
+TEST_F(DataParallelTrainerTest, CheckInconsistentParameters) {
+  Parameter p0({2}, dev0);
+  Parameter p1({2}, dev1);
+  Parameter p2({3}, dev2);
+  Parameter p3({2}, dev0);
+  {
+    trainers::SGD trainer0, trainer1;
+    trainer0.add_parameter(p0);
+    DataParallelTrainer dpt({&trainer0, &trainer1});
+    EXPECT_THROW(dpt.all_reduce_gradients(), Error);
+    EXPECT_THROW(dpt.broadcast_parameters(), Error);
+  }
+  {
+    trainers::SGD trainer0, trainer1;
+    trainer0.add_parameter(p0);
+    trainer1.add_parameter(p2);
+    DataParallelTrainer dpt({&trainer0, &trainer1});
+    EXPECT_THROW(dpt.all_reduce_gradients(), Error);
+    EXPECT_THROW(dpt.broadcast_parameters(), Error);
+  }
+  {
+    trainers::SGD trainer0, trainer1;
+    trainer0.add_parameter(p0);
+    trainer1.add_parameter(p3);
+    DataParallelTrainer dpt({&trainer0, &trainer1});
+    EXPECT_THROW(dpt.all_reduce_gradients(), Error);
+    EXPECT_THROW(dpt.broadcast_parameters(), Error);
+  }
+  {
+    trainers::SGD trainer0, trainer1;
+    trainer0.add_parameter(p0);
+    trainer1.add_parameter(p1);
+    DataParallelTrainer dpt({&trainer0, &trainer1});
+    EXPECT_NO_THROW(dpt.all_reduce_gradients());
+    EXPECT_NO_THROW(dpt.broadcast_parameters());
+  }
+}
+
+TEST_F(DataParallelTrainerTest, CheckAllReduce) {
+  Device *devs[] {&dev0, &dev1, &dev2};
+  // NOTE:
+  // Each bit of `flat_mask` enables the flat buffer of the replica.
+  for (const unsigned flat_mask : {0u, 1u, 7u}) {
+    vector<std::unique_ptr<Parameter>> params1, params2;
+    vector<std::unique_ptr<Trainer>> trainers;
+    vector<Trainer *> ptrs;
+    for (unsigned i = 0; i < 3; ++i) {
+      params1.emplace_back(new Parameter({2, 2}, *devs[i]));
+      params2.emplace_back(new Parameter({3}, *devs[i]));
+      trainers.emplace_back(new trainers::SGD());
+      trainers[i]->set_flat_buffer(flat_mask >> i & 1);
+      trainers[i]->add_parameter(*params1[i]);
+      trainers[i]->add_parameter(*params2[i]);
+      ptrs.emplace_back(trainers[i].get());
+    }
+    DataParallelTrainer dpt(ptrs);
+    dpt.reset_gradients();
+    for (unsigned i = 0; i < 3; ++i) {
+      const float k = i + 1;
+      params1[i]->dense_gradient().reset_by_vector({k, 2 * k, 3 * k, 4 * k});
+      params2[i]->dense_gradient().reset_by_vector({-k, 0, k});
+    }
+    dpt.all_reduce_gradients();
+    for (unsigned i = 0; i < 3; ++i) {
+      EXPECT_TRUE(vector_match(
+            vector<float> {2, 4, 6, 8}, params1[i]->gradient().to_vector()));
+      EXPECT_TRUE(vector_match(
+            vector<float> {-2, 0, 2}, params2[i]->gradient().to_vector()));
+    }
+  }
+}
+
+TEST_F(DataParallelTrainerTest, CheckAllReduceSparseGradients) {
+  const vector<float> init {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  Parameter p0({2, 5}, init, dev0);
+  Parameter p1({2, 5}, init, dev1);
+  trainers::SGD trainer0, trainer1;
+  trainer0.add_parameter(p0);
+  trainer1.add_parameter(p1);
+  DataParallelTrainer dpt({&trainer0, &trainer1});
+
+  dpt.reset_gradients();
+  const vector<unsigned> ids0 {0}, ids1 {2};
+  dev0.pick_bw(dev0.new_tensor_by_vector({2}, {2, 4}), ids0, 1,
+      p0.gradient(1, ids0));
+  dev1.pick_bw(dev1.new_tensor_by_vector({2}, {6, 8}), ids1, 1,
+      p1.gradient(1, ids1));
+  dev0.set_profiling(true);
+  dev1.set_profiling(true);
+  dpt.all_reduce_gradients();
+  for (Device *dev : {&dev0, &dev1}) {
+    // Each replica receives a half of the 2 rows at each phase.
+    const auto stats = dev->get_op_statistics();
+    EXPECT_EQ(2u, stats.at("copy_tensor").num_elements);
+    EXPECT_EQ(2u, stats.at("inplace_copy").num_elements);
+    dev->set_profiling(false);
+  }
+  for (const Parameter *p : {&p0, &p1}) {
+    EXPECT_TRUE(p->has_sparse_gradient());
+    vector<unsigned> rows = p->gradient_rows();
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ((vector<unsigned> {0, 2}), rows);
+  }
+  for (Parameter *p : {&p0, &p1}) {
+    EXPECT_TRUE(vector_match(
+          vector<float> {1, 2, 0, 0, 3, 4, 0, 0, 0, 0},
+          p->gradient().to_vector()));
+  }
+
+  dpt.reset_gradients();
+  dev0.pick_bw(dev0.new_tensor_by_vector({2}, {2, 4}), ids0, 1,
+      p0.gradient(1, ids0));
+  p1.dense_gradient() += dev1.new_tensor({2, 5}, 2);
+  dpt.all_reduce_gradients();
+  for (Parameter *p : {&p0, &p1}) {
+    EXPECT_FALSE(p->has_sparse_gradient());
+    EXPECT_TRUE(vector_match(
+          vector<float> {2, 3, 1, 1, 1, 1, 1, 1, 1, 1},
+          p->gradient().to_vector()));
+  }
+}
+
+TEST_F(DataParallelTrainerTest, CheckBroadcastParameters) {
+  Parameter p0({2}, {1, 2}, dev0);
+  Parameter p1({2}, {3, 4}, dev1);
+  trainers::Adam trainer0, trainer1;
+  trainer0.add_parameter(p0);
+  trainer1.add_parameter(p1);
+  trainer0.reset_gradients();
+  p0.dense_gradient().reset_by_vector({1, -1});
+  trainer0.update();
+  DataParallelTrainer dpt({&trainer0, &trainer1});
+  dpt.broadcast_parameters();
+  EXPECT_EQ(1u, trainer1.get_epoch());
+  EXPECT_TRUE(vector_match(p0.value().to_vector(), p1.value().to_vector()));
+  for (const char *name : {"adam-m1", "adam-m2"}) {
+    EXPECT_TRUE(vector_match(
+          p0.stats(name).to_vector(), p1.stats(name).to_vector()));
+  }
+}
+
+TEST_F(DataParallelTrainerTest, CheckGradientAccumulation) {
+  Parameter p0({2}, {1, 2}, dev0);
+  Parameter p1({2}, {1, 2}, dev1);
+  Parameter p2({2}, {1, 2}, dev2);
+  trainers::SGD trainer0, trainer1, trainer2;
+  trainer0.add_parameter(p0);
+  trainer1.add_parameter(p1);
+  trainer2.add_parameter(p2);
+  trainer0.set_gradient_accumulation(2);
+  trainer1.set_gradient_accumulation(3);
+  DataParallelTrainer dpt({&trainer0, &trainer1});
+  EXPECT_THROW(dpt.update(), Error);
+  EXPECT_EQ(0u, trainer0.get_accumulated_steps());
+  trainer1.set_gradient_accumulation(2);
+
+  // The accumulation over replicas is equal to that over micro-batches.
+  trainer2.set_gradient_accumulation(4);
+  const vector<vector<float>> grads {{1, 2}, {-3, 4}, {5, 0}, {2, -2}};
+  for (unsigned step = 0; step < 2; ++step) {
+    dpt.reset_gradients_at_boundary();
+    dpt.run([&](unsigned i) {
+      Parameter &p = i == 0 ? p0 : p1;
+      p.dense_gradient() +=
+        p.device().new_tensor_by_vector({2}, grads[2 * step + i]);
+    });
+    dpt.update();
+  }
+  for (const vector<float> &grad : grads) {
+    trainer2.reset_gradients_at_boundary();
+    p2.dense_gradient() += dev2.new_tensor_by_vector({2}, grad);
+    trainer2.update();
+  }
+  EXPECT_EQ(1u, trainer0.get_epoch());
+  EXPECT_EQ(1u, trainer2.get_epoch());
+  for (const Parameter *p : {&p0, &p1}) {
+    EXPECT_TRUE(vector_near(
+          p2.value().to_vector(), p->value().to_vector(), 1e-6));
+  }
+}
+
+TEST_F(DataParallelTrainerTest, CheckTraining) {
+  namespace F = operators;
+  const vector<float> w_init {1, -1, 2, 0, .5, -2};
+  const vector<float> x_data {1, 2, -1, 0, 3, 1, 2, -2};
+  const vector<float> t_data {1, 0, 2, 1, -1, 3, 0, 2, 1, 1, -2, 0};
+  // Returns the mean squared error of examples in `[begin, begin + size)`.
+  const auto loss = [&](
+      Parameter &w, unsigned begin, unsigned size, Device &dev, Graph &g) {
+    const Node x = F::input(
+        Shape({2}, size),
+        vector<float>(&x_data[2 * begin], &x_data[2 * (begin + size)]),
+        dev, g);
+    const Node t = F::input(
+        Shape({3}, size),
+        vector<float>(&t_data[3 * begin], &t_data[3 * (begin + size)]),
+        dev, g);
+    const Node d = F::matmul(F::parameter(w, g), x) - t;
+    return F::batch::mean(F::sum(d * d, 0));
+  };
+
+  Parameter w({3, 2}, w_init, dev0);
+  trainers::Adam trainer;
+  trainer.add_parameter(w);
+
+  Parameter w0({3, 2}, dev1);
+  Parameter w1({3, 2}, w_init, dev2);
+  trainers::Adam trainer0, trainer1;
+  // NOTE: Replicas may differ in whether they use flat buffers.
+  trainer0.set_flat_buffer(true);
+  trainer0.add_parameter(w1);
+  trainer1.add_parameter(w0);
+  DataParallelTrainer dpt({&trainer0, &trainer1});
+  dpt.broadcast_parameters();
+  Parameter *replicas[] {&w1, &w0};
+  Device *devs[] {&dev2, &dev1};
+
+  for (unsigned step = 0; step < 3; ++step) {
+    {
+      Graph g;
+      trainer.reset_gradients();
+      const Node y = loss(w, 0, 4, dev0, g);
+      g.forward(y);
+      g.backward(y);
+      trainer.update();
+    }
+    dpt.reset_gradients();
+    dpt.run([&](unsigned i) {
+      Graph g;
+      const Node y = loss(*replicas[i], 2 * i, 2, *devs[i], g);
+      g.forward(y);
+      g.backward(y);
+    });
+    dpt.update();
+    for (const Parameter *p : replicas) {
+      EXPECT_TRUE(vector_near(
+            w.value().to_vector(), p->value().to_vector(), 1e-6));
+    }
+  }
+}
+
+}  // namespace primitiv
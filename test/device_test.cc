@@ -1,7 +1,11 @@
 #include <config.h>
 
+#include <vector>
 #include <gtest/gtest.h>
 #include <primitiv/naive_device.h>
+#include <primitiv/operators.h>
+
+using std::vector;
 
 namespace primitiv {
 
@@ -26,4 +30,104 @@ TEST_F(DeviceTest, CheckDefault) {
   EXPECT_THROW(Device::get_default(), Error);
 }
 
+TEST_F(DeviceTest, CheckOpStatistics) {
+  devices::Naive dev;
+  EXPECT_FALSE(dev.is_profiling_enabled());
+  const Tensor a =
+    dev.new_tensor_by_vector(Shape({2, 3}, 2), vector<float>(12, 1));
+  const Tensor b = dev.new_tensor_by_vector({3, 4}, vector<float>(12, 1));
+
+  // Nothing is recorded while disabled.
+  dev.matmul_fw(a, b);
+  EXPECT_TRUE(dev.get_op_statistics().empty());
+
+  dev.set_profiling(true);
+  EXPECT_TRUE(dev.is_profiling_enabled());
+  dev.matmul_fw(a, b);
+  dev.matmul_fw(a, b);
+  dev.tanh_fw(a);
+  dev.set_profiling(false);
+  dev.tanh_fw(a);
+
+  const auto stats = dev.get_op_statistics();
+  ASSERT_EQ(2u, stats.size());
+  const Device::OpStatistics &mm = stats.at("matmul_fw");
+  EXPECT_EQ(2u, mm.num_calls);
+  EXPECT_EQ(2u * 16, mm.num_elements);
+  EXPECT_EQ(2u * 2 * 16 * 3, mm.num_flops);
+  const Device::OpStatistics &th = stats.at("tanh_fw");
+  EXPECT_EQ(1u, th.num_calls);
+  EXPECT_EQ(12u, th.num_elements);
+  EXPECT_EQ(12u, th.num_flops);
+
+  dev.reset_statistics();
+  EXPECT_TRUE(dev.get_op_statistics().empty());
+}
+
+TEST_F(DeviceTest, CheckOpStatisticsOfResets) {
+  devices::Naive dev;
+  Tensor x = dev.new_tensor({3});
+  const float values[] {1, 2, 3};
+  dev.set_profiling(true);
+  x.reset_by_array(values);
+  x.reset_by_array(values);
+  x.reset_by_vector({1, 2, 3});
+
+  const auto stats = dev.get_op_statistics();
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_EQ(2u, stats.at("reset_tensor_by_array").num_calls);
+  EXPECT_EQ(1u, stats.at("reset_tensor_by_vector").num_calls);
+}
+
+TEST_F(DeviceTest, CheckMemoryStatistics) {
+  devices::Naive dev;
+  const Tensor untracked = dev.new_tensor({10});
+  Device::MemoryStatistics ms = dev.get_memory_statistics();
+  EXPECT_EQ(0u, ms.num_allocations);
+  EXPECT_EQ(0u, ms.bytes_in_use);
+
+  dev.set_profiling(true);
+  {
+    const Tensor a = dev.new_tensor({4});
+    {
+      const Tensor b = dev.new_tensor({2}, 1);
+      ms = dev.get_memory_statistics();
+      EXPECT_EQ(2u, ms.num_allocations);
+      EXPECT_EQ(24u, ms.bytes_allocated);
+      EXPECT_EQ(24u, ms.bytes_in_use);
+      EXPECT_EQ(24u, ms.peak_bytes_in_use);
+    }
+    ms = dev.get_memory_statistics();
+    EXPECT_EQ(16u, ms.bytes_in_use);
+    EXPECT_EQ(24u, ms.peak_bytes_in_use);
+
+    dev.reset_statistics();
+    ms = dev.get_memory_statistics();
+    EXPECT_EQ(0u, ms.num_allocations);
+    EXPECT_EQ(0u, ms.bytes_allocated);
+    EXPECT_EQ(16u, ms.bytes_in_use);
+    EXPECT_EQ(16u, ms.peak_bytes_in_use);
+
+    // Copy-on-write allocates a new memory.
+    Tensor c = a;
+    c *= 2;
+    EXPECT_EQ(1u, dev.get_memory_statistics().num_allocations);
+    EXPECT_EQ(32u, dev.get_memory_statistics().bytes_in_use);
+  }
+  ms = dev.get_memory_statistics();
+  EXPECT_EQ(0u, ms.bytes_in_use);
+  EXPECT_EQ(32u, ms.peak_bytes_in_use);
+}
+
+TEST_F(DeviceTest, CheckStatisticsAfterDeletingDevice) {
+  // Tensors may be released after the device.
+  Tensor x;
+  {
+    devices::Naive dev;
+    dev.set_profiling(true);
+    x = dev.new_tensor({2}, 1);
+  }
+  EXPECT_NO_THROW(x = Tensor());
+}
+
 }  // namespace primitiv
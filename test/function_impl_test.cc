@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <gtest/gtest.h>
+#include <primitiv/error.h>
 #include <primitiv/function_impl.h>
 #include <primitiv/initializer_impl.h>
 #include <primitiv/naive_device.h>
@@ -172,6 +173,16 @@ protected:
   EXPECT_TRUE(vector_match(ret_data, cur_value.to_vector())); \
   EXPECT_TRUE(vector_match(bw_grads[0], arg_grads[0]->to_vector())); \
   EXPECT_TRUE(vector_match(bw_grads[1], arg_grads[1]->to_vector())); \
+  for (unsigned i = 0; i < 2; ++i) { \
+    reset_gradients(); \
+    vector<Tensor *> partial_grads(2, nullptr); \
+    partial_grads[i] = arg_grads[i]; \
+    node.backward(cur_value, cur_grad, arg_values, partial_grads); \
+    EXPECT_TRUE(vector_match(bw_grads[i], arg_grads[i]->to_vector())); \
+    EXPECT_TRUE(vector_match( \
+          vector<float>(arg_shapes[1 - i]->size(), 0), \
+          arg_grads[1 - i]->to_vector())); \
+  } \
 }
 
 TEST_F(FunctionImplTest, CheckInput) {
@@ -189,6 +200,16 @@ TEST_F(FunctionImplTest, CheckInput) {
   EXPECT_TRUE(vector_match(ret_data, cur_value.to_vector()));
 }
 
+TEST_F(FunctionImplTest, CheckInputResetData) {
+  const Shape ret_shape({2}, 2);
+  Input node(ret_shape, {1, 2, 3, 4}, *dev);
+  node.reset_data({5, 6, 7, 8});
+  EXPECT_TRUE(vector_match(
+        vector<float> {5, 6, 7, 8}, node.forward(arg_values).to_vector()));
+  EXPECT_THROW(node.reset_data({1, 2, 3}), Error);
+  EXPECT_THROW(Input(ret_shape, {1, 2, 3}, *dev), Error);
+}
+
 TEST_F(FunctionImplTest, CheckParameterInput) {
   const Shape ret_shape {2, 2};
   const initializers::Constant init(42);
@@ -213,6 +234,10 @@ TEST_F(FunctionImplTest, CheckParameterInput) {
   EXPECT_TRUE(vector_match(vector<float>(4, 42), param.value().to_vector()));
   EXPECT_TRUE(vector_match(vector<float>(4, 1), param.gradient().to_vector()));
   EXPECT_EQ(&param.value(), cur_value);
+
+  EXPECT_TRUE(node.requires_grad());
+  param.set_frozen(true);
+  EXPECT_FALSE(node.requires_grad());
 }
 
 TEST_F(FunctionImplTest, CheckCopy) {
@@ -886,6 +911,38 @@ TEST_F(FunctionImplTest, CheckMatrixMultiply) {
   TEST_2ARGS(MatrixMultiply);
 }
 
+TEST_F(FunctionImplTest, CheckMatrixMultiplyPartialGradientsWithBroadcast) {
+  // Either argument has no minibatch.
+  auto make_values = [](const Shape &shape, float start) {
+    vector<float> ret(shape.size());
+    for (float &x : ret) x = start++;
+    return ret;
+  };
+  const vector<vector<Shape>> shapes {
+    {Shape({2, 3}), Shape({3, 2}, 3)},
+    {Shape({2, 3}, 3), Shape({3, 2})},
+  };
+  for (const auto &ss : shapes) {
+    const Tensor a = dev->new_tensor_by_vector(ss[0], make_values(ss[0], 1));
+    const Tensor b = dev->new_tensor_by_vector(ss[1], make_values(ss[1], -4));
+    MatrixMultiply node;
+    const Tensor y = node.forward({&a, &b});
+    const Tensor gy = dev->new_tensor_by_vector(
+        y.shape(), make_values(y.shape(), 2));
+    Tensor ga = dev->new_tensor(ss[0], 0);
+    Tensor gb = dev->new_tensor(ss[1], 0);
+    node.backward(y, gy, {&a, &b}, {&ga, &gb});
+    for (unsigned i = 0; i < 2; ++i) {
+      Tensor partial = dev->new_tensor(ss[i], 0);
+      vector<Tensor *> gxs(2, nullptr);
+      gxs[i] = &partial;
+      node.backward(y, gy, {&a, &b}, gxs);
+      EXPECT_TRUE(vector_match(
+            (i == 0 ? ga : gb).to_vector(), partial.to_vector()));
+    }
+  }
+}
+
 TEST_F(FunctionImplTest, CheckSqrt) {
   // y = sqrt(x)
   // dy/dx = 1/(2y)
@@ -1185,6 +1242,79 @@ TEST_F(FunctionImplTest, CheckLogSumExp) {
   }
 }
 
+TEST_F(FunctionImplTest, CheckSoftmax) {
+  // y = softmax(x, dim)
+  // dy/dx = y * (gy - sum(gy * y, dim))
+  setup_1arg();
+  struct TestCase {
+    unsigned dim;
+    vector<float> ret_data;
+    vector<float> bw_grad;
+  };
+  const vector<TestCase> test_cases {
+    {0,
+      {0.26894142, 0.73105858, 0.26894142, 0.73105858,
+        .5, .5, .5, .5,
+        0.73105858, 0.26894142, 0.73105858, 0.26894142},
+      {-0.19661193, 0.19661193, -0.19661193, 0.19661193,
+        0, 0, 0, 0,
+        0.19661193, -0.19661193, 0.19661193, -0.19661193}},
+    {2,
+      {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
+      {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+  };
+  for (const TestCase &tc : test_cases) {
+    Softmax node(tc.dim);
+    const Shape cur_shape = node.forward_shape(arg_shapes);
+    const Tensor cur_value = node.forward(arg_values);
+    // NOTE: Uses x itself as gy to check non-uniform gradients.
+    const Tensor cur_grad = *arg_values[0];
+    reset_gradients();
+    node.backward(cur_value, cur_grad, arg_values, arg_grads);
+    EXPECT_EQ("Softmax(" + std::to_string(tc.dim) + ')', node.name());
+    EXPECT_EQ(*arg_shapes[0], cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_match(tc.ret_data, cur_value.to_vector()));
+    EXPECT_TRUE(vector_match(tc.bw_grad, arg_grads[0]->to_vector()));
+  }
+}
+
+TEST_F(FunctionImplTest, CheckLogSoftmax) {
+  // y = log_softmax(x, dim)
+  // dy/dx = gy - exp(y) * sum(gy, dim)
+  setup_1arg();
+  struct TestCase {
+    unsigned dim;
+    vector<float> ret_data;
+    vector<float> bw_grad;
+  };
+  const vector<TestCase> test_cases {
+    {0,
+      {-1.31326169, -0.31326169, -1.31326169, -0.31326169,
+        -0.69314718, -0.69314718, -0.69314718, -0.69314718,
+        -0.31326169, -1.31326169, -0.31326169, -1.31326169},
+      {0.46211716, -0.46211716, 0.46211716, -0.46211716,
+        0, 0, 0, 0,
+        -0.46211716, 0.46211716, -0.46211716, 0.46211716}},
+    {2,
+      {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+      {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+  };
+  for (const TestCase &tc : test_cases) {
+    LogSoftmax node(tc.dim);
+    const Shape cur_shape = node.forward_shape(arg_shapes);
+    const Tensor cur_value = node.forward(arg_values);
+    const Tensor cur_grad = dev->new_tensor(cur_shape, 1);
+    reset_gradients();
+    node.backward(cur_value, cur_grad, arg_values, arg_grads);
+    EXPECT_EQ("LogSoftmax(" + std::to_string(tc.dim) + ')', node.name());
+    EXPECT_EQ(*arg_shapes[0], cur_shape);
+    EXPECT_EQ(nullptr, node.get_device());
+    EXPECT_TRUE(vector_match(tc.ret_data, cur_value.to_vector()));
+    EXPECT_TRUE(vector_match(tc.bw_grad, arg_grads[0]->to_vector()));
+  }
+}
+
 TEST_F(FunctionImplTest, CheckBroadcast) {
   // y = broadcast(x, dim, size)
   // dy/dx = sum(1, dim)
@@ -1266,6 +1396,35 @@ TEST_F(FunctionImplTest, CheckSoftmaxCrossEntropy) {
   EXPECT_TRUE(vector_near(bw_grads[1], arg_grads[1]->to_vector(), 1e-6));
 }
 
+TEST_F(FunctionImplTest, CheckPartialGradients) {
+  // backward() skips gradients of arguments given by nullptr.
+  using namespace elementwise;
+  setup_2args_softmax_cross_entropy();
+  Concat concat(1);
+  SoftmaxCrossEntropy sce(0);
+  Elementwise fused(
+      Shape({2, 2}, 3),
+      { 2, { { MULTIPLY, 0, { 0, 1 } }, { EXP, 0, { 2, 0 } } } });
+  for (Function *node : vector<Function *> { &concat, &sce, &fused }) {
+    const Tensor cur_value = node->forward(arg_values);
+    const Tensor cur_grad = dev->new_tensor(cur_value.shape(), 1);
+    reset_gradients();
+    node->backward(cur_value, cur_grad, arg_values, arg_grads);
+    const vector<float> expected0 = arg_grads[0]->to_vector();
+    const vector<float> expected1 = arg_grads[1]->to_vector();
+
+    reset_gradients();
+    node->backward(cur_value, cur_grad, arg_values, { arg_grads[0], nullptr });
+    EXPECT_TRUE(vector_match(expected0, arg_grads[0]->to_vector()));
+    EXPECT_TRUE(vector_match(vector<float>(12, 0), arg_grads[1]->to_vector()));
+
+    reset_gradients();
+    node->backward(cur_value, cur_grad, arg_values, { nullptr, arg_grads[1] });
+    EXPECT_TRUE(vector_match(vector<float>(12, 0), arg_grads[0]->to_vector()));
+    EXPECT_TRUE(vector_match(expected1, arg_grads[1]->to_vector()));
+  }
+}
+
 TEST_F(FunctionImplTest, CheckSparseSoftmaxCrossEntropy) {
   struct TestCase {
     unsigned dim;
@@ -1317,5 +1476,22 @@ TEST_F(FunctionImplTest, CheckSparseSoftmaxCrossEntropy) {
   }
 }
 
+TEST_F(FunctionImplTest, CheckCanBatchWith) {
+  EXPECT_TRUE(Tanh().can_batch_with(Tanh()));
+  EXPECT_FALSE(Tanh().can_batch_with(Sigmoid()));
+  EXPECT_TRUE(AddConst(1).can_batch_with(AddConst(1)));
+  EXPECT_FALSE(AddConst(1).can_batch_with(AddConst(2)));
+  EXPECT_FALSE(AddConst(1).can_batch_with(MultiplyConst(1)));
+  EXPECT_TRUE(MatrixMultiply().can_batch_with(MatrixMultiply()));
+  EXPECT_TRUE(Slice(0, 1, 2).can_batch_with(Slice(0, 1, 2)));
+  EXPECT_FALSE(Slice(0, 1, 2).can_batch_with(Slice(0, 1, 3)));
+  EXPECT_TRUE(Sum(0).can_batch_with(Sum(0)));
+  EXPECT_FALSE(Sum(0).can_batch_with(Sum(1)));
+  EXPECT_TRUE(Reshape({4}).can_batch_with(Reshape({4})));
+  EXPECT_FALSE(Reshape(Shape({4}, 2)).can_batch_with(Reshape(Shape({4}, 2))));
+  EXPECT_FALSE(BatchSum().can_batch_with(BatchSum()));
+  EXPECT_FALSE(Pick({0}, 0).can_batch_with(Pick({0}, 0)));
+}
+
 }  // namespace functions
 }  // namespace primitiv
@@ -0,0 +1,181 @@
+#include <config.h>
+
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/cpu_features.h>
+#include <primitiv/error.h>
+#include <primitiv/gemm.h>
+#include <test_utils.h>
+
+using std::vector;
+using test_utils::vector_match;
+using test_utils::vector_near;
+
+namespace primitiv {
+namespace gemm {
+
+class GemmTest : public testing::Test {
+protected:
+  vector<cpu_features::Isa> isas;
+
+  void SetUp() override {
+    for (cpu_features::Isa isa : {
+        cpu_features::ISA_GENERIC,
+        cpu_features::ISA_AVX2,
+        cpu_features::ISA_AVX512}) {
+      if (cpu_features::supports(isa)) isas.emplace_back(isa);
+    }
+  }
+
+  static vector<float> make_random(unsigned size, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> dist(-1, 1);
+    vector<float> ret(size);
+    for (float &x : ret) x = dist(rng);
+    return ret;
+  }
+
+  static vector<float> reference(
+      bool trans_a, bool trans_b, unsigned m, unsigned n, unsigned k,
+      const vector<float> &a, unsigned lda,
+      const vector<float> &b, unsigned ldb,
+      const vector<float> &c, unsigned ldc) {
+    vector<float> ret = c;
+    for (unsigned j = 0; j < n; ++j) {
+      for (unsigned i = 0; i < m; ++i) {
+        double tmp = ret[i + j * ldc];
+        for (unsigned p = 0; p < k; ++p) {
+          const float aip = trans_a ? a[p + i * lda] : a[i + p * lda];
+          const float bpj = trans_b ? b[j + p * ldb] : b[p + j * ldb];
+          tmp += static_cast<double>(aip) * bpj;
+        }
+        ret[i + j * ldc] = tmp;
+      }
+    }
+    return ret;
+  }
+};
+
+TEST_F(GemmTest, CheckSmall) {
+  const vector<float> a_data {1, 2, 3, 4, 5, 6};
+  const vector<float> b_data {1, 0, 1, 0, 1, 1};
+  const vector<float> y_data {6, 8, 8, 10};
+  for (cpu_features::Isa isa : isas) {
+    vector<float> y(4);
+    sgemm(
+        false, false, 2, 2, 3, a_data.data(), 2, b_data.data(), 3,
+        false, y.data(), 2, isa);
+    EXPECT_TRUE(vector_match(y_data, y));
+  }
+}
+
+TEST_F(GemmTest, CheckBlocked) {
+  // Sizes including remainders of every blocking factor.
+  struct TestCase { unsigned m, n, k; };
+  const vector<TestCase> test_cases {
+    {64, 64, 64},
+    {33, 47, 65},
+    {129, 7, 300},
+    {17, 4103, 3},
+    {200, 100, 513},
+  };
+  std::mt19937 rng(12345);
+  for (const TestCase &tc : test_cases) {
+    const vector<float> a = make_random(tc.m * tc.k, rng);
+    const vector<float> b = make_random(tc.k * tc.n, rng);
+    const vector<float> expected = reference(
+        false, false, tc.m, tc.n, tc.k, a, tc.m, b, tc.k,
+        vector<float>(tc.m * tc.n, 0), tc.m);
+    for (cpu_features::Isa isa : isas) {
+      vector<float> c(tc.m * tc.n, 12345);
+      sgemm(
+          false, false, tc.m, tc.n, tc.k, a.data(), tc.m, b.data(), tc.k,
+          false, c.data(), tc.m, isa);
+      EXPECT_TRUE(vector_near(expected, c, 1e-3))
+        << "isa: " << cpu_features::isa_name(isa)
+        << ", m: " << tc.m << ", n: " << tc.n << ", k: " << tc.k;
+    }
+  }
+}
+
+TEST_F(GemmTest, CheckLeadingDimensions) {
+  const unsigned m = 70, n = 50, k = 90;
+  const unsigned lda = 75, ldb = 95, ldc = 80;
+  std::mt19937 rng(12345);
+  const vector<float> a = make_random(lda * k, rng);
+  const vector<float> b = make_random(ldb * n, rng);
+  const vector<float> expected = reference(
+      false, false, m, n, k, a, lda, b, ldb, vector<float>(ldc * n, 0), ldc);
+  for (cpu_features::Isa isa : isas) {
+    vector<float> c(ldc * n, 0);
+    sgemm(
+        false, false, m, n, k, a.data(), lda, b.data(), ldb,
+        false, c.data(), ldc, isa);
+    EXPECT_TRUE(vector_near(expected, c, 1e-3))
+      << "isa: " << cpu_features::isa_name(isa);
+  }
+}
+
+TEST_F(GemmTest, CheckTransposeAndAccumulate) {
+  struct TestCase { unsigned m, n, k; };
+  const vector<TestCase> test_cases {
+    {3, 4, 5},
+    {33, 47, 65},
+    {129, 7, 300},
+    {200, 100, 513},
+  };
+  std::mt19937 rng(12345);
+  for (const TestCase &tc : test_cases) {
+    for (unsigned flags = 0; flags < 8; ++flags) {
+      const bool trans_a = flags & 1;
+      const bool trans_b = flags & 2;
+      const bool accumulate = flags & 4;
+      const unsigned lda = trans_a ? tc.k : tc.m;
+      const unsigned ldb = trans_b ? tc.n : tc.k;
+      const vector<float> a = make_random(tc.m * tc.k, rng);
+      const vector<float> b = make_random(tc.k * tc.n, rng);
+      const vector<float> c0 = make_random(tc.m * tc.n, rng);
+      const vector<float> expected = reference(
+          trans_a, trans_b, tc.m, tc.n, tc.k, a, lda, b, ldb,
+          accumulate ? c0 : vector<float>(tc.m * tc.n, 0), tc.m);
+      for (cpu_features::Isa isa : isas) {
+        vector<float> c = c0;
+        sgemm(
+            trans_a, trans_b, tc.m, tc.n, tc.k, a.data(), lda, b.data(), ldb,
+            accumulate, c.data(), tc.m, isa);
+        EXPECT_TRUE(vector_near(expected, c, 1e-3))
+          << "isa: " << cpu_features::isa_name(isa)
+          << ", m: " << tc.m << ", n: " << tc.n << ", k: " << tc.k
+          << ", trans_a: " << trans_a << ", trans_b: " << trans_b
+          << ", accumulate: " << accumulate;
+      }
+    }
+  }
+}
+
+TEST_F(GemmTest, CheckAccumulateEmpty) {
+  const vector<float> c_data {1, 2, 3, 4};
+  for (cpu_features::Isa isa : isas) {
+    vector<float> c = c_data;
+    sgemm(
+        false, false, 2, 2, 0, nullptr, 2, nullptr, 1, true, c.data(), 2, isa);
+    EXPECT_TRUE(vector_match(c_data, c));
+    sgemm(
+        false, false, 2, 2, 0, nullptr, 2, nullptr, 1, false, c.data(), 2,
+        isa);
+    EXPECT_TRUE(vector_match(vector<float>(4, 0), c));
+  }
+}
+
+TEST_F(GemmTest, CheckInvalidIsa) {
+  if (cpu_features::max_isa() == cpu_features::ISA_AVX512) return;
+  float a = 1, b = 1, c = 0;
+  EXPECT_THROW(
+      sgemm(
+        false, false, 1, 1, 1, &a, 1, &b, 1, false, &c, 1,
+        cpu_features::ISA_AVX512),
+      Error);
+}
+
+}  // namespace gemm
+}  // namespace primitiv
@@ -1,6 +1,8 @@
 #include <config.h>
 
+#include <cmath>
 #include <sstream>
+#include <string>
 #include <vector>
 #include <gtest/gtest.h>
 #include <primitiv/error.h>
@@ -18,6 +20,39 @@ using test_utils::vector_near;
 
 namespace primitiv {
 
+namespace {
+
+// Tanh function which counts calls of forward() and optionally backward().
+class CountingTanh : public Function {
+public:
+  explicit CountingTanh(unsigned &counter, unsigned *bw_counter = nullptr)
+    : counter_(counter), bw_counter_(bw_counter) {}
+  Shape forward_shape(const vector<const Shape *> &args) const override {
+    return *args[0];
+  }
+  Tensor forward(const vector<const Tensor *> &args) override {
+    ++counter_;
+    return args[0]->device().tanh_fw(*args[0]);
+  }
+  void backward(
+      const Tensor &cur_value, const Tensor &cur_grad,
+      const vector<const Tensor *> &arg_values,
+      const vector<Tensor *> &arg_grads) const override {
+    if (bw_counter_) ++*bw_counter_;
+    cur_value.device().tanh_bw(
+        *arg_values[0], cur_value, cur_grad, *arg_grads[0]);
+  }
+  bool can_batch_with(const Function &other) const override {
+    return !!dynamic_cast<const CountingTanh *>(&other);
+  }
+  std::string name() const override { return "CountingTanh"; }
+private:
+  unsigned &counter_;
+  unsigned *bw_counter_;
+};
+
+}  // namespace
+
 class GraphTest : public testing::Test {
 protected:
   devices::Naive dev;
@@ -246,6 +281,686 @@ TEST_F(GraphTest, CheckForwardBackward) {
 #endif
 }
 
+TEST_F(GraphTest, CheckInferenceMode) {
+  // Uses a new device to obtain the memory usage of only this test.
+  devices::Naive dev3;
+  Device::set_default(dev3);
+  const HostMemoryPool &pool = dev3.memory_pool();
+
+  Graph g;
+  Graph::set_default(g);
+  EXPECT_FALSE(g.is_inference_mode());
+  g.set_inference_mode(true);
+  EXPECT_TRUE(g.is_inference_mode());
+
+  // 1024 bytes for each value.
+  Node x = operators::input<Node>({256}, vector<float>(256, 1));
+  for (unsigned i = 0; i < 100; ++i) {
+    x = 2 * x - 1;
+  }
+  EXPECT_TRUE(vector_match(vector<float>(256, 1), g.forward(x).to_vector()));
+
+  // Only a few values are kept at the same time.
+  EXPECT_GE(4096u, pool.get_statistics().peak_bytes_in_use);
+  EXPECT_EQ(1024u, pool.get_statistics().bytes_in_use);
+
+  g.clear();
+  g.set_inference_mode(false);
+  x = operators::input<Node>({256}, vector<float>(256, 1));
+  for (unsigned i = 0; i < 100; ++i) {
+    x = 2 * x - 1;
+  }
+  EXPECT_TRUE(vector_match(vector<float>(256, 1), g.forward(x).to_vector()));
+
+  // All values are kept.
+  EXPECT_EQ(201u * 1024u, pool.get_statistics().bytes_in_use);
+}
+
+TEST_F(GraphTest, CheckInferenceModeRetain) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+  g.set_inference_mode(true);
+
+  const Node a = operators::input<Node>({2}, {1, 2});
+  const Node b = a + 1;
+  const Node c = b * 2;
+  g.retain(b);
+  const Node d = c * c;
+  EXPECT_TRUE(vector_match(vector<float> {16, 36}, g.forward(d).to_vector()));
+
+  // `b` is retained and `c` is discarded.
+  // The value of `c` is recalculated if required.
+  const Node e = b + c;
+  EXPECT_TRUE(vector_match(vector<float> {6, 9}, g.forward(e).to_vector()));
+  const Node f = a * c;
+  EXPECT_TRUE(vector_match(vector<float> {4, 12}, g.forward(f).to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {2, 3}, b.to_vector()));
+}
+
+TEST_F(GraphTest, CheckInferenceModeRecalculation) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+  g.set_inference_mode(true);
+
+  const Node a = operators::input<Node>({2}, {1, 2});
+  const Node b = a + 1;
+  const Node c = b * 2;
+  const Node d = b * 3;
+  const Node e = c + d;
+  EXPECT_TRUE(vector_match(vector<float> {10, 15}, g.forward(e).to_vector()));
+
+  // Both `c` and `d` are recalculated from the discarded `b`.
+  const Node f = c * d;
+  EXPECT_TRUE(vector_match(vector<float> {24, 54}, g.forward(f).to_vector()));
+}
+
+TEST_F(GraphTest, CheckCheckpointing) {
+  vector<float> w_data(256);
+  for (unsigned i = 0; i < 256; ++i) w_data[i] = .1 * (i % 7) - .3;
+
+  // Calculates gradients of a deep network and returns the peak memory usage.
+  auto run = [&](
+      Graph::CheckpointingMode mode,
+      vector<float> &loss, vector<float> &grad) {
+    devices::Naive dev3;
+    Device::set_default(dev3);
+    Parameter w({256}, w_data);
+    w.reset_gradient();
+
+    Graph g;
+    Graph::set_default(g);
+    g.set_checkpointing_mode(mode);
+    EXPECT_EQ(mode, g.get_checkpointing_mode());
+
+    const Node wn = operators::parameter<Node>(w);
+    Node x = operators::input<Node>({256}, vector<float>(256, .5));
+    for (unsigned i = 0; i < 64; ++i) {
+      x = operators::tanh(wn * x + 1);
+      if (mode == Graph::CHECKPOINTING_MANUAL && i % 8 == 7) g.checkpoint(x);
+    }
+    const Node y = operators::sum(x, 0);
+    loss = y.to_vector();
+    y.backward();
+    grad = w.gradient().to_vector();
+    return dev3.memory_pool().get_statistics().peak_bytes_in_use;
+  };
+
+  vector<float> loss1, grad1, loss2, grad2, loss3, grad3;
+  const std::uint64_t peak1 = run(Graph::CHECKPOINTING_DISABLED, loss1, grad1);
+  const std::uint64_t peak2 = run(Graph::CHECKPOINTING_MANUAL, loss2, grad2);
+  const std::uint64_t peak3 = run(Graph::CHECKPOINTING_AUTO, loss3, grad3);
+
+  // Recalculation does not change the results.
+  EXPECT_EQ(loss1, loss2);
+  EXPECT_EQ(grad1, grad2);
+  EXPECT_EQ(loss1, loss3);
+  EXPECT_EQ(grad1, grad3);
+
+  // 1024 bytes for each value.
+  EXPECT_LE(3 * 64 * 1024u, peak1);
+  EXPECT_GE(48 * 1024u, peak2);
+  EXPECT_GE(48 * 1024u, peak3);
+}
+
+TEST_F(GraphTest, CheckCheckpointingRandom) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+  g.set_checkpointing_mode(Graph::CHECKPOINTING_MANUAL);
+
+  Parameter w({256}, vector<float>(256, 1));
+  w.reset_gradient();
+
+  // The mask is never discarded and recalculated.
+  const Node mask = operators::random::bernoulli<Node>({256}, .5);
+  const Node y = operators::sum(2 * (operators::parameter<Node>(w) * mask), 0);
+  y.backward();
+  vector<float> expected = mask.to_vector();
+  for (float &x : expected) x *= 2;
+  EXPECT_TRUE(vector_match(expected, w.gradient().to_vector()));
+}
+
+TEST_F(GraphTest, CheckElementwiseFusion) {
+  const vector<float> w_data {.1, -.2, .3, -.4};
+  const vector<float> b_data {.5, 0, -.5, 1};
+
+  // Calculates gradients of LSTM-like elementwise operations and returns the
+  // number of allocations.
+  auto run = [&](
+      bool enabled, vector<float> &loss,
+      vector<float> &gw, vector<float> &gb, std::string &dump) {
+    devices::Naive dev3;
+    Device::set_default(dev3);
+    Parameter w({4}, w_data);
+    Parameter b({4}, b_data);
+    w.reset_gradient();
+    b.reset_gradient();
+
+    Graph g;
+    Graph::set_default(g);
+    g.set_elementwise_fusion(enabled);
+    EXPECT_EQ(enabled, g.is_elementwise_fusion_enabled());
+
+    const Node x = operators::input<Node>(
+        Shape({4}, 2), {1, 2, 3, 4, -1, -2, -3, -4});
+    const Node s = operators::input<Node>(Shape({}, 2), {2, -.5});
+    const Node u =
+      operators::parameter<Node>(w) * x + operators::parameter<Node>(b);
+    const Node i = operators::sigmoid(u);
+    const Node f = operators::sigmoid(u + 1);
+    const Node o = operators::tanh(2 * u - .5);
+    const Node c = f * x + i * o;
+    const Node h = o * operators::tanh(c) / s;
+    const Node y = operators::batch::sum(operators::sum(h * h, 0));
+    loss = y.to_vector();
+    y.backward();
+    gw = w.gradient().to_vector();
+    gb = b.gradient().to_vector();
+    dump = g.dump("dot");
+    return dev3.memory_pool().get_statistics().num_allocations;
+  };
+
+  vector<float> loss1, gw1, gb1, loss2, gw2, gb2;
+  std::string dump1, dump2;
+  const std::uint64_t n1 = run(false, loss1, gw1, gb1, dump1);
+  const std::uint64_t n2 = run(true, loss2, gw2, gb2, dump2);
+  EXPECT_TRUE(vector_near(loss1, loss2, 1e-5));
+  EXPECT_TRUE(vector_near(gw1, gw2, 1e-5));
+  EXPECT_TRUE(vector_near(gb1, gb2, 1e-5));
+  EXPECT_EQ(std::string::npos, dump1.find("Elementwise"));
+  EXPECT_NE(std::string::npos, dump2.find("Elementwise"));
+  EXPECT_GT(n1, 2 * n2);
+}
+
+TEST_F(GraphTest, CheckElementwiseFusionIntermediate) {
+  Device::set_default(dev);
+
+  for (const bool retain : {false, true}) {
+    Graph g;
+    Graph::set_default(g);
+    g.set_elementwise_fusion(true);
+
+    const Node a = operators::input<Node>({2}, {1, 2});
+    const Node b = a + 1;
+    const Node c = b * 2;
+    const Node d = c * c;
+    if (retain) g.retain(b);
+    EXPECT_TRUE(vector_match(vector<float> {16, 36}, d.to_vector()));
+
+    // Retained nodes are not fused.
+    const std::string dump = g.dump("dot");
+    if (retain) {
+      EXPECT_NE(
+          std::string::npos,
+          dump.find("Elementwise(MultiplyConst,Multiply)"));
+    } else {
+      EXPECT_NE(
+          std::string::npos,
+          dump.find("Elementwise(AddConst,MultiplyConst,Multiply)"));
+    }
+
+    // Fused nodes are calculated if required.
+    EXPECT_TRUE(vector_match(vector<float> {4, 6}, c.to_vector()));
+    const Node e = b + c;
+    EXPECT_TRUE(vector_match(vector<float> {6, 9}, e.to_vector()));
+  }
+}
+
+TEST_F(GraphTest, CheckElementwiseFusionInferenceMode) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+  g.set_elementwise_fusion(true);
+  g.set_inference_mode(true);
+
+  // Non-elementwise functions split the chain.
+  const Node a = operators::input<Node>(Shape({2}, 2), {1, 2, 3, 4});
+  const Node b = operators::exp(a * 2 - 1);
+  const Node c = operators::sum(b, 0);
+  const Node d = -operators::log(b) + c;
+  const vector<float> expected {
+    std::exp(1.f) + std::exp(3.f) - 1, std::exp(1.f) + std::exp(3.f) - 3,
+    std::exp(5.f) + std::exp(7.f) - 5, std::exp(5.f) + std::exp(7.f) - 7,
+  };
+  EXPECT_TRUE(vector_match(expected, d.to_vector()));
+  EXPECT_TRUE(vector_match(expected, g.forward(d).to_vector()));
+}
+
+TEST_F(GraphTest, CheckAutobatch) {
+  const vector<float> w_data {.1, -.2, .3, -.4, .5, -.6};
+  const vector<float> b_data {.5, 0, -.5};
+
+  // Calculates gradients of per-example operations and returns the number of
+  // calculations of tanh.
+  auto run = [&](
+      bool enabled, vector<float> &loss, vector<float> &gw, vector<float> &gb) {
+    Device::set_default(dev);
+    Parameter w({3, 2}, w_data);
+    Parameter b({3}, b_data);
+    w.reset_gradient();
+    b.reset_gradient();
+
+    Graph g;
+    Graph::set_default(g);
+    g.set_autobatch(enabled);
+    EXPECT_EQ(enabled, g.is_autobatch_enabled());
+
+    unsigned counter = 0;
+    const Node pw = operators::parameter<Node>(w);
+    const Node pb = operators::parameter<Node>(b);
+    vector<Node> xs {
+      operators::input<Node>({2}, {1, 2}),
+      operators::input<Node>({2}, {-1, 3}),
+      operators::input<Node>({2}, {0, -2}),
+      operators::input<Node>(Shape({2}, 2), {4, 1, -3, 2}),
+    };
+    Node y = operators::input<Node>({}, {0});
+    for (const Node &x : xs) {
+      const Node u = operators::matmul(pw, x) + pb;
+      const Node h = g.add_function(
+          std::unique_ptr<Function>(new CountingTanh(counter)), {u});
+      y = y + operators::batch::sum(operators::sum(h * h, 0));
+    }
+    loss = y.to_vector();
+    y.backward();
+    gw = w.gradient().to_vector();
+    gb = b.gradient().to_vector();
+    return counter;
+  };
+
+  // Non-minibatched examples are calculated at once.
+  vector<float> loss1, gw1, gb1, loss2, gw2, gb2;
+  EXPECT_EQ(4u, run(false, loss1, gw1, gb1));
+  EXPECT_EQ(2u, run(true, loss2, gw2, gb2));
+  EXPECT_TRUE(vector_near(loss1, loss2, 1e-5));
+  EXPECT_TRUE(vector_near(gw1, gw2, 1e-5));
+  EXPECT_TRUE(vector_near(gb1, gb2, 1e-5));
+}
+
+TEST_F(GraphTest, CheckAutobatchSharedArguments) {
+  Device::set_default(dev);
+
+  for (const bool inference : {false, true}) {
+    Graph g;
+    Graph::set_default(g);
+    g.set_autobatch(true);
+    g.set_inference_mode(inference);
+
+    const Node a = operators::input<Node>(Shape({2}, 2), {1, 2, 3, 4});
+    const Node b = operators::input<Node>({2}, {5, 6});
+    const Node c = operators::input<Node>(Shape({2}, 2), {7, 8, 9, 10});
+
+    // Minibatched arguments are concatenated even if they are shared.
+    const Node d1 = a + b;
+    const Node d2 = a + b;
+    const Node d3 = c + b;
+    // Functions with only shared arguments have the same value.
+    const Node e1 = b * 2;
+    const Node e2 = b * 2;
+    // Arguments with different batch sizes are not concatenated.
+    const Node f1 = b + b;
+    const Node f2 = a + a;
+    const Node y = (d1 + d2) * d3 + (e1 + e2) * (f1 + f2);
+    if (!inference) {
+      g.retain(d1);
+      g.retain(d2);
+      g.retain(d3);
+      g.retain(e1);
+      g.retain(e2);
+    }
+
+    EXPECT_TRUE(vector_match(
+          vector<float> {384, 608, 544, 800}, y.to_vector()));
+    if (!inference) {
+      EXPECT_TRUE(vector_match(
+            vector<float> {6, 8, 8, 10}, g.forward(d1).to_vector()));
+      EXPECT_TRUE(vector_match(
+            vector<float> {6, 8, 8, 10}, g.forward(d2).to_vector()));
+      EXPECT_TRUE(vector_match(
+            vector<float> {12, 14, 14, 16}, g.forward(d3).to_vector()));
+      EXPECT_TRUE(vector_match(
+            vector<float> {10, 12}, g.forward(e1).to_vector()));
+      EXPECT_TRUE(vector_match(
+            vector<float> {10, 12}, g.forward(e2).to_vector()));
+    }
+  }
+}
+
+TEST_F(GraphTest, CheckReplay) {
+  Device::set_default(dev);
+  const vector<vector<float>> xs_data {{1, 2}, {-1, 3}, {0, -2}};
+  const vector<vector<float>> ws_data {{1, 2, 3, 4}, {-1, 0, .5, 2}};
+
+  // Returns the loss and the gradient of `w` of a newly built graph.
+  auto run = [&](
+      const vector<float> &x_data, const vector<float> &w_data,
+      vector<float> &gw) {
+    Parameter w({2, 2}, w_data);
+    w.reset_gradient();
+    Graph g;
+    Graph::set_default(g);
+    const Node x = operators::input<Node>({2}, x_data);
+    const Node h = operators::tanh(operators::matmul(
+          operators::parameter<Node>(w), x));
+    const Node y = operators::sum(h * h, 0);
+    const float loss = y.to_float();
+    y.backward();
+    gw = w.gradient().to_vector();
+    return loss;
+  };
+
+  for (const bool fusion : {false, true}) {
+    Parameter w({2, 2}, ws_data[0]);
+    Graph g;
+    Graph::set_default(g);
+    g.set_elementwise_fusion(fusion);
+    const Node x = operators::input<Node>({2}, {0, 0});
+    const Node h = operators::tanh(operators::matmul(
+          operators::parameter<Node>(w), x));
+    const Node y = operators::sum(h * h, 0);
+    const unsigned num_functions = g.num_functions();
+
+    for (const vector<float> &w_data : ws_data) {
+      w.reset_value(w_data);
+      g.invalidate();
+      for (const vector<float> &x_data : xs_data) {
+        vector<float> expected_gw;
+        const float expected = run(x_data, w_data, expected_gw);
+        Graph::set_default(g);
+        w.reset_gradient();
+        g.set_input(x, x_data);
+        EXPECT_FLOAT_EQ(expected, y.to_float());
+        y.backward();
+        EXPECT_TRUE(vector_near(expected_gw, w.gradient().to_vector(), 1e-6));
+        EXPECT_EQ(num_functions, g.num_functions());
+      }
+    }
+  }
+}
+
+TEST_F(GraphTest, CheckReplayInferenceMode) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  g.set_inference_mode(true);
+
+  const Node a = operators::input<Node>({2}, {1, 2});
+  const Node b = operators::input<Node>({2}, {3, 4});
+  const Node c = a * 2;
+  const Node d = c + b;
+  g.retain(c);
+  EXPECT_TRUE(vector_match(vector<float> {5, 8}, d.to_vector()));
+
+  // Only values which depend on the new data are recalculated.
+  g.set_input(b, {-1, -2});
+  EXPECT_TRUE(vector_match(vector<float> {1, 2}, d.to_vector()));
+  g.set_input(a, {0, 1});
+  EXPECT_TRUE(vector_match(vector<float> {-1, 0}, d.to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {0, 2}, c.to_vector()));
+}
+
+TEST_F(GraphTest, CheckInvalidSetInput) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  const Node a = operators::input<Node>({2}, {1, 2});
+  const Node b = a + 1;
+  EXPECT_THROW(g.set_input(a, {1, 2, 3}), Error);
+  EXPECT_THROW(g.set_input(b, {1, 2}), Error);
+  EXPECT_TRUE(vector_match(vector<float> {2, 3}, b.to_vector()));
+}
+
+TEST_F(GraphTest, CheckBackwardPruning) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  Parameter w({2, 2}, {1, 2, 3, 4});
+  Parameter e({2}, {1, 1});
+  const float t = std::tanh(1.f);
+
+  for (const bool frozen : {false, true}) {
+    g.clear();
+    w.reset_gradient();
+    e.reset_gradient();
+    e.set_frozen(frozen);
+    unsigned fw_counter = 0;
+    unsigned bw_counter = 0;
+
+    // h does not depend on any parameters.
+    const Node x = operators::input<Node>({2}, {1, -1});
+    const Node h = g.add_function(
+        std::unique_ptr<Function>(new CountingTanh(fw_counter, &bw_counter)),
+        {x});
+    const Node pe = operators::parameter<Node>(e);
+    const Node he = g.add_function(
+        std::unique_ptr<Function>(new CountingTanh(fw_counter, &bw_counter)),
+        {pe});
+    const Node y = operators::matmul(operators::parameter<Node>(w), h + pe);
+    const Node loss = operators::sum(y + he, 0);
+    loss.backward();
+
+    EXPECT_EQ(2u, fw_counter);
+    EXPECT_EQ(frozen ? 0u : 1u, bw_counter);
+    EXPECT_TRUE(vector_match(
+          vector<float> {1 + t, 1 + t, 1 - t, 1 - t},
+          w.gradient().to_vector()));
+    if (frozen) {
+      EXPECT_TRUE(vector_match(vector<float> {0, 0}, e.gradient().to_vector()));
+    } else {
+      EXPECT_TRUE(vector_match(
+            vector<float> {4 - t * t, 8 - t * t}, e.gradient().to_vector()));
+    }
+  }
+
+  // Nothing is calculated if all parameters are frozen.
+  g.clear();
+  w.reset_gradient();
+  w.set_frozen(true);
+  const Node y = operators::matmul(
+      operators::parameter<Node>(w), operators::input<Node>({2}, {1, 1}));
+  EXPECT_NO_THROW(operators::sum(y, 0).backward());
+  EXPECT_TRUE(vector_match(vector<float>(4, 0), w.gradient().to_vector()));
+}
+
+TEST_F(GraphTest, CheckSparseParameterGradient) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  Parameter e({2, 4}, {1, 2, 3, 4, 5, 6, 7, 8});
+  Parameter w({2, 2}, {1, 2, 3, 4});
+  e.reset_gradient();
+  w.reset_gradient();
+
+  // y = sum(w . e[ids]) = 3 * e[0, ids] + 7 * e[1, ids]
+  const Node x = operators::pick(operators::parameter<Node>(e), {3, 1, 3}, 1);
+  const Node y = operators::matmul(operators::parameter<Node>(w), x);
+  operators::batch::sum(operators::sum(y, 0)).backward();
+
+  // Gradients of picked parameters are accumulated only to picked rows.
+  ASSERT_TRUE(e.has_sparse_gradient());
+  EXPECT_EQ(vector<unsigned>({3, 1}), e.gradient_rows());
+  EXPECT_TRUE(vector_match(
+        vector<float> {0, 0, 3, 7, 0, 0, 6, 14},
+        e.gradient().to_vector()));
+  EXPECT_FALSE(w.has_sparse_gradient());
+}
+
+TEST_F(GraphTest, CheckProfiler) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  EXPECT_EQ(nullptr, g.get_profiler());
+
+  Profiler prof;
+  g.set_profiler(&prof);
+  EXPECT_EQ(&prof, g.get_profiler());
+  dev.set_profiling(true);
+
+  Parameter w({2}, {1, 2});
+  const Node x = operators::input<Node>(Shape({2}, 3), {1, 2, 3, 4, 5, 6});
+  const Node y = operators::tanh(x * operators::parameter<Node>(w));
+  const Node z = operators::batch::sum(operators::sum(y, 0));
+  z.backward();
+
+  struct TestCase {
+    std::string name;
+    Profiler::Phase phase;
+    Shape ret_shape;
+    std::uint64_t bytes;
+  };
+  const vector<TestCase> test_cases {
+    // Values of parameters are not calculated.
+    {"Input", Profiler::FORWARD, Shape({2}, 3), 24},
+    {"Multiply", Profiler::FORWARD, Shape({2}, 3), 24},
+    {"Tanh", Profiler::FORWARD, Shape({2}, 3), 24},
+    {"Sum(0)", Profiler::FORWARD, Shape({}, 3), 12},
+    {"BatchSum", Profiler::FORWARD, {}, 4},
+    {"BatchSum", Profiler::BACKWARD, {}, 12},
+    // The gradient of the argument and a broadcasted temporary.
+    {"Sum(0)", Profiler::BACKWARD, Shape({}, 3), 48},
+    {"Tanh", Profiler::BACKWARD, Shape({2}, 3), 24},
+    // The gradient of the input is not required, and that of the parameter
+    // is accumulated directly into the parameter after a temporary product.
+    {"Multiply", Profiler::BACKWARD, Shape({2}, 3), 24},
+  };
+  const vector<Profiler::Event> &events = prof.get_events();
+  ASSERT_EQ(test_cases.size(), events.size());
+  for (unsigned i = 0; i < test_cases.size(); ++i) {
+    const TestCase &tc = test_cases[i];
+    const Profiler::Event &e = events[i];
+    EXPECT_EQ(tc.name, e.name);
+    EXPECT_EQ(tc.phase, e.phase);
+    EXPECT_EQ(tc.ret_shape, e.ret_shape);
+    EXPECT_EQ(tc.bytes, e.bytes);
+    EXPECT_EQ(&dev, e.device);
+    EXPECT_EQ(1u, e.num_functions);
+    if (i > 0) EXPECT_LE(events[i - 1].start_ns, e.start_ns);
+  }
+  EXPECT_EQ(2u, events[1].arg_shapes.size());
+
+  // Nothing is recorded after removing the profiler.
+  g.set_profiler(nullptr);
+  g.invalidate();
+  z.to_float();
+  EXPECT_EQ(test_cases.size(), prof.get_events().size());
+}
+
+TEST_F(GraphTest, CheckProfilerWithAutobatch) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  g.set_autobatch(true);
+  Profiler prof;
+  g.set_profiler(&prof);
+  dev.set_profiling(true);
+
+  const Node a = operators::tanh(operators::input<Node>({2}, {1, 2}));
+  const Node b = operators::tanh(operators::input<Node>({2}, {3, 4}));
+  (a + b).to_vector();
+
+  unsigned num_tanh = 0;
+  for (const Profiler::Event &e : prof.get_events()) {
+    if (e.name != "Tanh") continue;
+    ++num_tanh;
+    EXPECT_EQ(2u, e.num_functions);
+    // Concatenated arguments, the batched result and its two slices.
+    EXPECT_EQ(48u, e.bytes);
+  }
+  EXPECT_EQ(1u, num_tanh);
+}
+
+TEST_F(GraphTest, CheckMemoryPlan) {
+  Device::set_default(dev);
+
+  for (const bool inference : {false, true}) {
+    Graph g;
+    Graph::set_default(g);
+    g.set_inference_mode(inference);
+
+    const Node a = operators::input<Node>({4}, {0, 1, 2, 3});
+    const Node b = operators::exp(a + 1);
+    const Node c = b * 2;
+    const Node d = operators::sum(c, 0);
+    const Graph::MemoryPlan plan = g.plan_memory(d);
+    EXPECT_EQ(68u, plan.naive_peak_bytes);
+    if (inference) {
+      // b, exp(b) and c are calculated in the memory of a.
+      EXPECT_EQ(20u, plan.planned_peak_bytes);
+      EXPECT_EQ(2u, plan.num_slots);
+      EXPECT_EQ(3u, plan.num_inplace);
+    } else {
+      EXPECT_EQ(68u, plan.planned_peak_bytes);
+      EXPECT_EQ(5u, plan.num_slots);
+      EXPECT_EQ(0u, plan.num_inplace);
+    }
+
+    const float expected = 2 * (
+        std::exp(1.f) + std::exp(2.f) + std::exp(3.f) + std::exp(4.f));
+    EXPECT_FLOAT_EQ(expected, d.to_float());
+
+    // Values calculated already are not counted.
+    const Graph::MemoryPlan plan2 = g.plan_memory(d);
+    EXPECT_EQ(0u, plan2.naive_peak_bytes);
+    EXPECT_EQ(0u, plan2.planned_peak_bytes);
+  }
+}
+
+TEST_F(GraphTest, CheckInplaceForward) {
+  Device::set_default(dev);
+  Graph g;
+  Graph::set_default(g);
+  g.set_inference_mode(true);
+
+  const Node a = operators::input<Node>({2}, {1, 2});
+  const Node b = a * 2;
+  const Node c = b + 1;
+  const Node d = c * c;
+  const Node e = operators::tanh(d);
+  g.retain(d);
+
+  // Tensors obtained from the graph are not overwritten.
+  const Tensor tb = g.forward(b);
+  EXPECT_TRUE(vector_match(
+        vector<float> {std::tanh(9.f), std::tanh(25.f)}, e.to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {2, 4}, tb.to_vector()));
+
+  // Retained values are not overwritten.
+  EXPECT_TRUE(vector_match(vector<float> {9, 25}, g.forward(d).to_vector()));
+}
+
+TEST_F(GraphTest, CheckDeepGraph) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+
+  // Recursive implementations may cause stack overflow.
+  Node x = operators::input<Node>({}, {0});
+  for (unsigned i = 0; i < 300000; ++i) x = x + 1;
+  EXPECT_EQ(300000, x.to_float());
+}
+
+TEST_F(GraphTest, CheckInferenceModeBackward) {
+  Device::set_default(dev);
+
+  Graph g;
+  Graph::set_default(g);
+  g.set_inference_mode(true);
+
+  const Node x = operators::input<Node>({}, {1});
+  const Node y = 2 * x;
+  EXPECT_THROW(y.backward(), Error);
+
+  g.set_inference_mode(false);
+  EXPECT_NO_THROW(y.backward());
+}
+
 TEST_F(GraphTest, CheckXor) {
   Device::set_default(dev);
 
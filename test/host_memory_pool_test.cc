@@ -0,0 +1,206 @@
+#include <config.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/error.h>
+#include <primitiv/host_memory_pool.h>
+
+using std::vector;
+
+namespace primitiv {
+
+class HostMemoryPoolTest : public testing::Test {};
+
+TEST_F(HostMemoryPoolTest, CheckPoolIDs) {
+  HostMemoryPool pool0;
+  std::uint64_t base = pool0.get_pool_id();
+
+  HostMemoryPool pool1;
+  EXPECT_EQ(base + 1, pool1.get_pool_id());
+  {
+    HostMemoryPool pool2;
+    EXPECT_EQ(base + 2, pool2.get_pool_id());
+  }
+  HostMemoryPool pool3;
+  EXPECT_EQ(base + 3, pool3.get_pool_id());
+}
+
+TEST_F(HostMemoryPoolTest, CheckAllocate) {
+  HostMemoryPool pool;
+  void *p1, *p2, *p3, *p4;
+  {
+    // Allocates new pointers.
+    const auto sp1 = pool.allocate(1llu);
+    const auto sp2 = pool.allocate(1llu << 8);
+    const auto sp3 = pool.allocate(1llu << 16);
+    const auto sp4 = pool.allocate(1llu << 24);
+    p1 = sp1.get();
+    p2 = sp2.get();
+    p3 = sp3.get();
+    p4 = sp4.get();
+  }
+  // sp1-4 are released at the end of above scope, but the raw pointer is kept
+  // in the pool object.
+  {
+    // Allocates existing pointers.
+    const auto sp1 = pool.allocate(1llu);
+    const auto sp2 = pool.allocate(1llu << 8);
+    const auto sp3 = pool.allocate(1llu << 16);
+    const auto sp4 = pool.allocate(1llu << 24);
+    EXPECT_EQ(p1, sp1.get());
+    EXPECT_EQ(p2, sp2.get());
+    EXPECT_EQ(p3, sp3.get());
+    EXPECT_EQ(p4, sp4.get());
+    // Allocates other pointers.
+    const auto sp11 = pool.allocate(1llu);
+    const auto sp22 = pool.allocate(1llu << 8);
+    const auto sp33 = pool.allocate(1llu << 16);
+    const auto sp44 = pool.allocate(1llu << 24);
+    EXPECT_NE(p1, sp11.get());
+    EXPECT_NE(p2, sp22.get());
+    EXPECT_NE(p3, sp33.get());
+    EXPECT_NE(p4, sp44.get());
+  }
+}
+
+TEST_F(HostMemoryPoolTest, CheckSizeClasses) {
+  HostMemoryPool pool;
+  void *p;
+  {
+    const auto sp = pool.allocate(1000);
+    p = sp.get();
+  }
+  // Sizes in the same class reuse the block.
+  EXPECT_EQ(p, pool.allocate(513).get());
+  EXPECT_EQ(p, pool.allocate(1024).get());
+  // Other classes do not.
+  EXPECT_NE(p, pool.allocate(1025).get());
+  EXPECT_NE(p, pool.allocate(512).get());
+}
+
+TEST_F(HostMemoryPoolTest, CheckAlignment) {
+  HostMemoryPool pool;
+  vector<std::shared_ptr<void>> sps;
+  for (std::uint64_t size : {0, 1, 3, 64, 100, 4096, 12345}) {
+    sps.emplace_back(pool.allocate(size));
+    EXPECT_EQ(
+        0u,
+        reinterpret_cast<std::uintptr_t>(sps.back().get())
+          % HostMemoryPool::ALIGNMENT);
+  }
+}
+
+TEST_F(HostMemoryPoolTest, CheckInvalidAllocate) {
+  HostMemoryPool pool;
+  // Available maximum size of the memory: 2^63 bytes.
+  EXPECT_THROW(pool.allocate((1llu << 63) + 1), Error);
+}
+
+TEST_F(HostMemoryPoolTest, CheckStatistics) {
+  HostMemoryPool pool;
+  HostMemoryPool::Statistics st = pool.get_statistics();
+  EXPECT_EQ(0u, st.num_allocations);
+  EXPECT_EQ(0u, st.num_hits);
+  EXPECT_EQ(0u, st.bytes_in_use);
+  EXPECT_EQ(0u, st.bytes_reserved);
+  EXPECT_EQ(0u, st.peak_bytes_in_use);
+  EXPECT_EQ(0, st.hit_rate());
+
+  {
+    const auto sp1 = pool.allocate(100);  // 128 bytes
+    const auto sp2 = pool.allocate(1000);  // 1024 bytes
+    st = pool.get_statistics();
+    EXPECT_EQ(2u, st.num_allocations);
+    EXPECT_EQ(0u, st.num_hits);
+    EXPECT_EQ(1152u, st.bytes_in_use);
+    EXPECT_EQ(0u, st.bytes_reserved);
+    EXPECT_EQ(1152u, st.peak_bytes_in_use);
+  }
+  st = pool.get_statistics();
+  EXPECT_EQ(0u, st.bytes_in_use);
+  EXPECT_EQ(1152u, st.bytes_reserved);
+  EXPECT_EQ(1152u, st.peak_bytes_in_use);
+
+  {
+    const auto sp1 = pool.allocate(100);
+    st = pool.get_statistics();
+    EXPECT_EQ(3u, st.num_allocations);
+    EXPECT_EQ(1u, st.num_hits);
+    EXPECT_EQ(128u, st.bytes_in_use);
+    EXPECT_EQ(1024u, st.bytes_reserved);
+    EXPECT_EQ(1152u, st.peak_bytes_in_use);
+    EXPECT_DOUBLE_EQ(1. / 3, st.hit_rate());
+  }
+}
+
+TEST_F(HostMemoryPoolTest, CheckReleaseReservedBlocks) {
+  HostMemoryPool pool;
+  {
+    const auto sp = pool.allocate(1000);
+    EXPECT_EQ(0u, pool.get_statistics().bytes_reserved);
+  }
+  EXPECT_EQ(1024u, pool.get_statistics().bytes_reserved);
+  pool.release_reserved_blocks();
+  EXPECT_EQ(0u, pool.get_statistics().bytes_reserved);
+
+  // The next allocation does not reuse the block.
+  pool.allocate(1000);
+  const HostMemoryPool::Statistics st = pool.get_statistics();
+  EXPECT_EQ(2u, st.num_allocations);
+  EXPECT_EQ(0u, st.num_hits);
+}
+
+TEST_F(HostMemoryPoolTest, CheckMaxReservedBytes) {
+  HostMemoryPool pool(2048);
+  EXPECT_EQ(2048u, pool.get_max_reserved_bytes());
+  {
+    const auto sp1 = pool.allocate(1024);
+    const auto sp2 = pool.allocate(1024);
+    const auto sp3 = pool.allocate(1024);
+  }
+  // One block exceeds the bound.
+  EXPECT_EQ(2048u, pool.get_statistics().bytes_reserved);
+
+  pool.set_max_reserved_bytes(1500);
+  EXPECT_EQ(1500u, pool.get_max_reserved_bytes());
+  EXPECT_EQ(1024u, pool.get_statistics().bytes_reserved);
+
+  pool.set_max_reserved_bytes(0);
+  EXPECT_EQ(0u, pool.get_statistics().bytes_reserved);
+  pool.allocate(1024);
+  EXPECT_EQ(0u, pool.get_statistics().bytes_reserved);
+  EXPECT_EQ(0u, pool.get_statistics().num_hits);
+}
+
+TEST_F(HostMemoryPoolTest, CheckOutlivingMemory) {
+  std::shared_ptr<void> sp;
+  {
+    HostMemoryPool pool;
+    sp = pool.allocate(1000);
+  }
+  // Releasing the memory after destroying the pool does nothing.
+  EXPECT_NO_THROW(sp.reset());
+}
+
+TEST_F(HostMemoryPoolTest, CheckMultipleThreads) {
+  HostMemoryPool pool;
+  vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool]() {
+      vector<std::shared_ptr<void>> sps;
+      for (unsigned i = 0; i < 1000; ++i) {
+        sps.emplace_back(pool.allocate(64 << (i % 8)));
+        if (i % 3 == 0) sps.erase(sps.begin() + i % sps.size());
+      }
+    });
+  }
+  for (std::thread &th : threads) th.join();
+  const HostMemoryPool::Statistics st = pool.get_statistics();
+  EXPECT_EQ(4000u, st.num_allocations);
+  EXPECT_EQ(0u, st.bytes_in_use);
+}
+
+}  // namespace primitiv
@@ -5,6 +5,7 @@
 #include <thread>
 #include <vector>
 #include <gtest/gtest.h>
+#include <primitiv/error.h>
 #include <primitiv/naive_device.h>
 #include <primitiv/shape.h>
 #include <primitiv/tensor.h>
@@ -22,6 +23,138 @@ TEST_F(NaiveDeviceTest, CheckDeviceType) {
   EXPECT_EQ(Device::DEVICE_TYPE_CPU, dev.type());
 }
 
+TEST_F(NaiveDeviceTest, CheckNumThreads) {
+  EXPECT_EQ(1u, devices::Naive().num_threads());
+  EXPECT_EQ(1u, devices::Naive(12345).num_threads());
+  EXPECT_EQ(1u, devices::Naive(12345, 1).num_threads());
+  EXPECT_EQ(4u, devices::Naive(12345, 4).num_threads());
+  EXPECT_THROW(devices::Naive(12345, 0), Error);
+}
+
+TEST_F(NaiveDeviceTest, CheckMultithreadedResults) {
+  devices::Naive dev1(12345);
+  devices::Naive dev4(12345, 4);
+  // Large enough to be processed in parallel.
+  const Shape sa({64, 96}, 8);
+  const Shape sb({96, 80}, 8);
+  const Shape sy({64, 80}, 8);
+  const vector<float> a_data = dev1.random_normal(sa, 0, 1).to_vector();
+  const vector<float> b_data = dev1.random_normal(sb, 0, 1).to_vector();
+  const vector<float> w_data =
+    dev1.random_normal(Shape({64, 96}), 0, 1).to_vector();
+  const vector<float> gy_data = dev1.random_normal(sy, 0, 1).to_vector();
+  const vector<unsigned> ids {0, 3, 5, 7, 11, 13, 17, 19};
+
+  // Calculates various operations and returns all results in one vector.
+  auto calculate = [&](Device &dev) {
+    const Tensor a = dev.new_tensor_by_vector(sa, a_data);
+    const Tensor b = dev.new_tensor_by_vector(sb, b_data);
+    const Tensor w = dev.new_tensor_by_vector(Shape({64, 96}), w_data);
+    const Tensor gy = dev.new_tensor_by_vector(sy, gy_data);
+    vector<Tensor> rets {
+      dev.tanh_fw(a),
+      dev.elu_fw(a, .5),
+      dev.add_fw(a, w),
+      dev.multiply_scalar_fw(a, dev.new_tensor(Shape({}, 8), 3)),
+      dev.sum_fw(a, 0),
+      dev.sum_fw(a, 1),
+      dev.logsumexp_fw(a, 0),
+      dev.logsumexp_fw(a, 1),
+      dev.softmax_fw(a, 0),
+      dev.softmax_fw(a, 1),
+      dev.log_softmax_fw(a, 1),
+      dev.softmax_cross_entropy_fw(a, ids, 0),
+      dev.broadcast_fw(dev.sum_fw(a, 1), 1, 96),
+      dev.batch_sum_fw(a),
+      dev.pick_fw(a, ids, 1),
+      dev.slice_fw(a, 0, 8, 40),
+      dev.concat_fw({&a, &w, &a}, 1),
+      dev.matmul_fw(a, b),
+      dev.matmul_fw(w, b),
+    };
+    for (const Tensor *x : {&a, &w}) {
+      Tensor ga = dev.new_tensor(x->shape(), 1);
+      Tensor gb = dev.new_tensor(sb, 1);
+      dev.matmul_bw(*x, b, gy, gy, ga, gb);
+      rets.emplace_back(ga);
+      rets.emplace_back(gb);
+    }
+    Tensor gw = dev.new_tensor(w.shape(), 1);
+    Tensor ga = dev.new_tensor(sa, 1);
+    dev.multiply_bw(a, w, a, a, ga, gw);
+    {
+      using namespace elementwise;
+      // y = tanh(a * w) / k + exp(a)
+      const Tensor k = dev.new_tensor_by_vector(
+          Shape({}, 8), {1, 2, 3, 4, 5, 6, 7, 8});
+      const Program prog { 3, {
+        { MULTIPLY, 0, { 0, 1 } },
+        { TANH, 0, { 3, 3 } },
+        { DIVIDE, 0, { 4, 2 } },
+        { EXP, 0, { 0, 0 } },
+        { ADD, 0, { 5, 6 } },
+      } };
+      const Tensor y = dev.elementwise_fw({&a, &w, &k}, prog);
+      Tensor gk = dev.new_tensor(k.shape(), 1);
+      dev.elementwise_bw({&a, &w, &k}, y, a, prog, {&ga, &gw, &gk});
+      rets.emplace_back(y);
+      rets.emplace_back(gk);
+    }
+    {
+      const Tensor y = dev.softmax_fw(a, 1);
+      const Tensor ly = dev.log_softmax_fw(a, 0);
+      const Tensor ce = dev.softmax_cross_entropy_fw(a, ids, 0);
+      dev.softmax_bw(a, y, a, 1, ga);
+      dev.log_softmax_bw(a, ly, a, 0, ga);
+      dev.softmax_cross_entropy_bw(a, ids, ce, ce, 0, ga);
+      const Tensor lse = dev.logsumexp_fw(a, 1);
+      dev.logsumexp_bw(a, lse, lse, 1, ga);
+    }
+    dev.pick_bw(dev.pick_fw(a, ids, 1), ids, 1, gw);
+    dev.slice_bw(dev.slice_fw(a, 0, 8, 40), 0, 8, gw);
+    dev.inplace_add(a, gw);
+    rets.emplace_back(ga);
+    rets.emplace_back(gw);
+    {
+      // Updates tensors with different sizes at once.
+      const Tensor g2 = dev.batch_sum_fw(a);
+      Tensor x1 = dev.new_tensor(sb, 1);
+      Tensor x2 = dev.new_tensor(w.shape(), 2);
+      Tensor m11 = dev.new_tensor(sb, 0);
+      Tensor m12 = dev.new_tensor(w.shape(), 0);
+      Tensor m21 = dev.new_tensor(sb, 0);
+      Tensor m22 = dev.new_tensor(w.shape(), 0);
+      Tensor m31 = dev.new_tensor(sb, 0);
+      Tensor m32 = dev.new_tensor(w.shape(), 0);
+      dev.adam_update(
+          .1, .9, .999, 1e-8, 1,
+          {&b, &g2}, {&x1, &x2}, {&m11, &m12}, {&m21, &m22});
+      dev.adadelta_update(
+          .1, .9, 1e-6, {&b, &g2}, {&x1, &x2}, {&m21, &m22}, {&m31, &m32});
+      const Tensor sq = dev.squared_norm({&x1, &x2, &m32});
+      dev.inplace_clip_by_norm(1, sq, {&x1, &x2, &m32});
+      rets.insert(rets.end(), {x1, x2, m11, m12, m21, m22, m31, m32, sq});
+    }
+
+    vector<float> ret;
+    for (const Tensor &x : rets) {
+      const vector<float> v = x.to_vector();
+      ret.insert(ret.end(), v.begin(), v.end());
+    }
+    return ret;
+  };
+
+  const vector<float> expected = calculate(dev1);
+  const vector<float> actual = calculate(dev4);
+  ASSERT_EQ(expected.size(), actual.size());
+  unsigned num_diffs = 0;
+  for (unsigned i = 0; i < expected.size(); ++i) {
+    // Results should be bit-identical.
+    num_diffs += expected[i] != actual[i];
+  }
+  EXPECT_EQ(0u, num_diffs);
+}
+
 TEST_F(NaiveDeviceTest, CheckNewDelete) {
   {
     devices::Naive dev;
@@ -49,6 +182,27 @@ TEST_F(NaiveDeviceTest, CheckDanglingTensor) {
   SUCCEED();
 }
 
+TEST_F(NaiveDeviceTest, CheckMemoryPool) {
+  devices::Naive dev;
+  HostMemoryPool &pool = dev.memory_pool();
+  const void *p;
+  {
+    Tensor x = dev.new_tensor(Shape({16, 16}));
+    p = x.data();
+    EXPECT_EQ(1024u, pool.get_statistics().bytes_in_use);
+  }
+  EXPECT_EQ(0u, pool.get_statistics().bytes_in_use);
+  EXPECT_EQ(1024u, pool.get_statistics().bytes_reserved);
+  {
+    // Reuses the memory of the same size class.
+    Tensor x = dev.new_tensor(Shape({15, 16}));
+    EXPECT_EQ(p, x.data());
+    EXPECT_EQ(1u, pool.get_statistics().num_hits);
+  }
+  pool.release_reserved_blocks();
+  EXPECT_EQ(0u, pool.get_statistics().bytes_reserved);
+}
+
 #ifdef PRIMITIV_BUILD_TESTS_PROBABILISTIC
 TEST_F(NaiveDeviceTest, CheckRandomBernoulli) {
   vector<vector<float>> history;
@@ -128,6 +128,23 @@ TEST_F(ParameterTest, CheckMove) {
   EXPECT_TRUE(vector_match({1, 2, 3, 4}, p3.value().to_vector()));
 }
 
+TEST_F(ParameterTest, CheckFrozen) {
+  Device::set_default(dev);
+  Parameter p1({2, 2});
+  EXPECT_FALSE(p1.is_frozen());
+  p1.set_frozen(true);
+  EXPECT_TRUE(p1.is_frozen());
+
+  Parameter p2 = std::move(p1);
+  EXPECT_TRUE(p2.is_frozen());
+  p2.set_frozen(false);
+  EXPECT_FALSE(p2.is_frozen());
+
+  Parameter invalid;
+  EXPECT_THROW(invalid.set_frozen(true), Error);
+  EXPECT_THROW(invalid.is_frozen(), Error);
+}
+
 TEST_F(ParameterTest, CheckInvalidNew) {
   Device::set_default(dev);
   EXPECT_THROW(Parameter(Shape({}, 3)), Error);
@@ -161,6 +178,67 @@ TEST_F(ParameterTest, CheckResetGradient) {
   EXPECT_TRUE(vector_match(expected, p.gradient().to_vector()));
 }
 
+TEST_F(ParameterTest, CheckSparseGradient) {
+  Device::set_default(dev);
+  Parameter p({2, 6});
+  const Parameter &cp = p;
+  EXPECT_FALSE(p.has_sparse_gradient());
+  EXPECT_THROW(p.gradient_rows(), Error);
+
+  p.reset_gradient();
+  EXPECT_TRUE(p.has_sparse_gradient());
+  EXPECT_TRUE(p.gradient_rows().empty());
+
+  // Rows are registered without duplication.
+  p.gradient(1, {4, 1, 4});
+  p.gradient(1, {1, 0});
+  EXPECT_TRUE(p.has_sparse_gradient());
+  EXPECT_EQ(vector<unsigned>({4, 1, 0}), p.gradient_rows());
+
+  // Only registered rows are reset.
+  p.gradient(1, {0}).reset(1);
+  p.reset_gradient();
+  EXPECT_TRUE(p.has_sparse_gradient());
+  EXPECT_TRUE(p.gradient_rows().empty());
+  EXPECT_TRUE(vector_match(
+        vector<float> {0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1},
+        cp.gradient().to_vector()));
+
+  // Updating more than half of rows makes the gradient dense.
+  p.gradient(1, {0, 1, 2});
+  EXPECT_TRUE(p.has_sparse_gradient());
+  p.gradient(1, {3});
+  EXPECT_FALSE(p.has_sparse_gradient());
+  p.reset_gradient();
+  EXPECT_TRUE(vector_match(
+        vector<float>(12, 0),
+        cp.gradient().to_vector()));
+
+  // Reading the gradient through the const overload keeps it row-sparse.
+  p.reset_gradient();
+  cp.gradient();
+  EXPECT_TRUE(p.has_sparse_gradient());
+
+  // Slices along other dimensions, invalid rows, the mutable gradient() and
+  // dense_gradient() make the gradient dense.
+  p.reset_gradient();
+  p.gradient(0, {1});
+  EXPECT_FALSE(p.has_sparse_gradient());
+  p.reset_gradient();
+  p.gradient(1, {6});
+  EXPECT_FALSE(p.has_sparse_gradient());
+  p.reset_gradient();
+  p.gradient();
+  EXPECT_FALSE(p.has_sparse_gradient());
+  p.reset_gradient();
+  p.dense_gradient();
+  EXPECT_FALSE(p.has_sparse_gradient());
+
+  Parameter invalid;
+  EXPECT_THROW(invalid.has_sparse_gradient(), Error);
+  EXPECT_THROW(invalid.gradient(1, {0}), Error);
+}
+
 TEST_F(ParameterTest, CheckAddValue) {
   Device::set_default(dev);
   const Shape shape {2, 2};
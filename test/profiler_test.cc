@@ -0,0 +1,101 @@
+#include <config.h>
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/error.h>
+#include <primitiv/naive_device.h>
+#include <primitiv/profiler.h>
+
+using std::string;
+using std::vector;
+
+namespace primitiv {
+
+class ProfilerTest : public testing::Test {
+protected:
+  devices::Naive dev;
+};
+
+TEST_F(ProfilerTest, CheckNew) {
+  Profiler prof;
+  EXPECT_TRUE(prof.get_events().empty());
+  const std::uint64_t t1 = prof.now();
+  const std::uint64_t t2 = prof.now();
+  EXPECT_LE(t1, t2);
+}
+
+TEST_F(ProfilerTest, CheckAddEventAndClear) {
+  Profiler prof;
+  prof.add_event({
+      "Add", Profiler::FORWARD, {{2}, {2}}, {2}, &dev, 1, 10, 20, 8});
+  ASSERT_EQ(1u, prof.get_events().size());
+  const Profiler::Event &e = prof.get_events()[0];
+  EXPECT_EQ("Add", e.name);
+  EXPECT_EQ(Profiler::FORWARD, e.phase);
+  EXPECT_EQ(2u, e.arg_shapes.size());
+  EXPECT_EQ(Shape({2}), e.ret_shape);
+  EXPECT_EQ(&dev, e.device);
+  EXPECT_EQ(20u, e.duration_ns);
+  EXPECT_EQ(8u, e.bytes);
+
+  prof.clear();
+  EXPECT_TRUE(prof.get_events().empty());
+}
+
+TEST_F(ProfilerTest, CheckDumpTable) {
+  Profiler prof;
+  prof.add_event({
+      "AddConst(1.000000)", Profiler::FORWARD, {{2}}, {2}, &dev,
+      1, 0, 1000, 8});
+  prof.add_event({
+      "AddConst(2.000000)", Profiler::FORWARD, {{2}}, {2}, &dev,
+      2, 1000, 3000, 16});
+  prof.add_event({
+      "Tanh", Profiler::FORWARD, {{2}}, {2}, &dev, 1, 4000, 6000, 8});
+  prof.add_event({
+      "Tanh", Profiler::BACKWARD, {{2}}, {2}, &dev, 1, 10000, 2000, 8});
+
+  const string table = prof.dump("table");
+  vector<string> lines;
+  for (std::size_t pos = 0; pos < table.size(); ) {
+    const std::size_t next = table.find('\n', pos);
+    lines.emplace_back(table.substr(pos, next - pos));
+    pos = next + 1;
+  }
+  ASSERT_EQ(4u, lines.size());
+  EXPECT_EQ(0u, lines[0].find("function"));
+  // Sorted by the total time, and parameters are ignored.
+  EXPECT_EQ(0u, lines[1].find("Tanh                    forward"));
+  EXPECT_NE(string::npos, lines[1].find(" 6.000 "));
+  EXPECT_EQ(0u, lines[2].find("AddConst                forward"));
+  EXPECT_NE(string::npos, lines[2].find(" 3 "));
+  EXPECT_NE(string::npos, lines[2].find(" 1.333 "));
+  EXPECT_NE(string::npos, lines[2].find(" 33.3 "));
+  EXPECT_NE(string::npos, lines[2].find(" 24"));
+  EXPECT_EQ(0u, lines[3].find("Tanh                    backward"));
+}
+
+TEST_F(ProfilerTest, CheckDumpChrome) {
+  Profiler prof;
+  prof.add_event({
+      "Tanh", Profiler::FORWARD, {Shape({2}, 3)}, Shape({2}, 3), &dev,
+      1, 1500, 2500, 24});
+  const string expected =
+    "{\"traceEvents\":[\n"
+    "{\"name\":\"Tanh\",\"cat\":\"forward\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+    "\"ts\":1.500,\"dur\":2.500,\"args\":{\"function\":\"Tanh\","
+    "\"arguments\":\"[2]x3\",\"result\":\"[2]x3\",\"functions\":1,"
+    "\"bytes\":24}},\n"
+    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+    "\"args\":{\"name\":\"CPU:0\"}}\n"
+    "],\"displayTimeUnit\":\"ns\"}\n";
+  EXPECT_EQ(expected, prof.dump("chrome"));
+}
+
+TEST_F(ProfilerTest, CheckInvalidDump) {
+  Profiler prof;
+  EXPECT_THROW(prof.dump("foo"), Error);
+}
+
+}  // namespace primitiv
@@ -146,6 +146,39 @@ TEST_F(ShapeOpsTest, CheckInvalidElementwise) {
   }
 }
 
+TEST_F(ShapeOpsTest, CheckFusedElementwise) {
+  struct TestCase { vector<Shape> xs; Shape expected; };
+  const vector<TestCase> test_cases {
+    {{{}}, {}},
+    {{{1, 2, 3}}, {1, 2, 3}},
+    {{{}, Shape({}, 4)}, Shape({}, 4)},
+    {{{1, 2, 3}, Shape({1, 2, 3}, 4), {1, 2, 3}}, Shape({1, 2, 3}, 4)},
+    {{{}, {1, 2, 3}}, {1, 2, 3}},
+    {{Shape({}, 4), {1, 2, 3}}, Shape({1, 2, 3}, 4)},
+    {{{1, 2, 3}, Shape({}, 4), {}}, Shape({1, 2, 3}, 4)},
+  };
+  for (const TestCase &tc : test_cases) {
+    vector<const Shape *> xs;
+    for (const Shape &x : tc.xs) xs.emplace_back(&x);
+    EXPECT_EQ(tc.expected, fused_elementwise(xs));
+  }
+}
+
+TEST_F(ShapeOpsTest, CheckInvalidFusedElementwise) {
+  const vector<vector<Shape>> test_cases {
+    {},
+    {{1, 2}, {1, 2, 3}},
+    {{}, {1, 2}, {1, 2, 3}},
+    {Shape({}, 4), Shape({}, 5)},
+    {Shape({1, 2, 3}, 4), Shape({}, 5)},
+  };
+  for (const vector<Shape> &tc : test_cases) {
+    vector<const Shape *> xs;
+    for (const Shape &x : tc) xs.emplace_back(&x);
+    EXPECT_THROW(fused_elementwise(xs), Error);
+  }
+}
+
 TEST_F(ShapeOpsTest, CheckSlice) {
   struct TestCase {
     unsigned dim, lower, upper;
@@ -229,6 +262,67 @@ TEST_F(ShapeOpsTest, CheckInvalidConcat) {
   }
 }
 
+TEST_F(ShapeOpsTest, CheckBatchSlice) {
+  struct TestCase {
+    Shape input;
+    unsigned lower, upper;
+    Shape expected;
+  };
+  const vector<TestCase> test_cases {
+    {{}, 0, 1, {}},
+    {Shape({2, 3}, 4), 0, 4, Shape({2, 3}, 4)},
+    {Shape({2, 3}, 4), 1, 2, {2, 3}},
+    {Shape({2, 3}, 4), 1, 3, Shape({2, 3}, 2)},
+  };
+  for (const TestCase &tc : test_cases) {
+    EXPECT_EQ(tc.expected, batch_slice(tc.input, tc.lower, tc.upper));
+  }
+}
+
+TEST_F(ShapeOpsTest, CheckInvalidBatchSlice) {
+  struct TestCase {
+    Shape input;
+    unsigned lower, upper;
+  };
+  const vector<TestCase> test_cases {
+    {{}, 0, 0}, {{}, 1, 1}, {{}, 0, 2}, {{}, 1, 0},
+    {Shape({2, 3}, 4), 2, 2}, {Shape({2, 3}, 4), 3, 5},
+  };
+  for (const TestCase &tc : test_cases) {
+    EXPECT_THROW(batch_slice(tc.input, tc.lower, tc.upper), Error);
+  }
+}
+
+TEST_F(ShapeOpsTest, CheckBatchConcat) {
+  struct TestCase {
+    vector<Shape> inputs;
+    Shape expected;
+  };
+  const vector<TestCase> test_cases {
+    {{{}}, {}},
+    {{{}, {}, {}}, Shape({}, 3)},
+    {{{2, 3}, Shape({2, 3}, 3), {2, 3}}, Shape({2, 3}, 5)},
+  };
+  for (const TestCase &tc : test_cases) {
+    vector<const Shape *>xs;
+    for (const Shape &x : tc.inputs) xs.emplace_back(&x);
+    EXPECT_EQ(tc.expected, batch_concat(xs));
+  }
+}
+
+TEST_F(ShapeOpsTest, CheckInvalidBatchConcat) {
+  const vector<vector<Shape>> test_cases {
+    {},
+    {{}, {2}},
+    {{2, 3}, Shape({3, 2}, 2)},
+  };
+  for (const vector<Shape> &tc : test_cases) {
+    vector<const Shape *>xs;
+    for (const Shape &x : tc) xs.emplace_back(&x);
+    EXPECT_THROW(batch_concat(xs), Error);
+  }
+}
+
 TEST_F(ShapeOpsTest, CheckPick) {
   struct TestCase {
     Shape input;
@@ -963,6 +963,24 @@ TEST_F(TensorBackwardTest, CheckMatMul11) {
   }
 }
 
+TEST_F(TensorBackwardTest, CheckMatMulAccumulate) {
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {1, 2, 3, 4, -1, -2, -3, -4});
+    const Tensor b = dev->new_tensor_by_vector({2, 2}, {1, 0, 0, 2});
+    const Tensor y = dev->matmul_fw(a, b);
+    const Tensor gy = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {1, -1, 2, -2, 2, -2, 1, -1});
+    Tensor ga = dev->new_tensor(a.shape(), 1);
+    Tensor gb = dev->new_tensor(b.shape(), -1);
+    dev->matmul_bw(a, b, y, gy, ga, gb);
+    const vector<float> ga_val {2, 0, 5, -3, 3, -1, 3, -1};
+    const vector<float> gb_val {0, 0, -2, -2};
+    EXPECT_TRUE(vector_match(ga_val, ga.to_vector()));
+    EXPECT_TRUE(vector_match(gb_val, gb.to_vector()));
+  }
+}
+
 TEST_F(TensorBackwardTest, CheckMatMulNN) {
   for (Device *dev : devices) {
     const Tensor a = dev->new_tensor_by_vector(
@@ -1018,4 +1036,159 @@ TEST_F(TensorBackwardTest, CheckMatMulN1) {
   }
 }
 
+TEST_F(TensorBackwardTest, CheckElementwise) {
+  using namespace elementwise;
+  const vector<Opcode> opcodes {
+    POSITIVE, NEGATIVE, SQRT, EXP, LOG, TANH, SIGMOID, SOFTPLUS, SIN, COS, TAN,
+    ADD_CONST, SUBTRACT_CONST_R, SUBTRACT_CONST_L, MULTIPLY_CONST,
+    DIVIDE_CONST_R, DIVIDE_CONST_L, PRELU, ELU, ADD, SUBTRACT, MULTIPLY, DIVIDE,
+  };
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {.1, 1, 2, 3, .5, 1.5, 2.5, .25});
+    const Tensor b = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {2, -1, .5, 3, -2, 1, 4, -.5});
+    const Tensor gy = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {1, -1, 2, -2, 2, -2, 1, -1});
+    for (const Opcode op : opcodes) {
+      // Each operation should be same as the corresponding operation.
+      const float k = -.5;
+      Tensor y, ga = dev->new_tensor(a.shape(), 0);
+      Tensor gb = dev->new_tensor(b.shape(), 0);
+      switch (op) {
+#define CASE_X(opcode, name) \
+        case opcode: \
+          y = dev->name##_fw(a); \
+          dev->name##_bw(a, y, gy, ga); \
+          break;
+#define CASE_X_CONST(opcode, name) \
+        case opcode: \
+          y = dev->name##_fw(a, k); \
+          dev->name##_bw(a, y, gy, k, ga); \
+          break;
+#define CASE_AB(opcode, name) \
+        case opcode: \
+          y = dev->name##_fw(a, b); \
+          dev->name##_bw(a, b, y, gy, ga, gb); \
+          break;
+        case POSITIVE: y = a; ga += gy; break;
+        case NEGATIVE: y = dev->negate_fw(a); ga -= gy; break;
+        CASE_X(SQRT, sqrt);
+        CASE_X(EXP, exp);
+        CASE_X(LOG, log);
+        CASE_X(TANH, tanh);
+        CASE_X(SIGMOID, sigmoid);
+        CASE_X(SOFTPLUS, softplus);
+        CASE_X(SIN, sin);
+        CASE_X(COS, cos);
+        CASE_X(TAN, tan);
+        CASE_X_CONST(ADD_CONST, add_const);
+        CASE_X_CONST(SUBTRACT_CONST_R, subtract_const_r);
+        CASE_X_CONST(SUBTRACT_CONST_L, subtract_const_l);
+        CASE_X_CONST(MULTIPLY_CONST, multiply_const);
+        CASE_X_CONST(DIVIDE_CONST_R, divide_const_r);
+        CASE_X_CONST(DIVIDE_CONST_L, divide_const_l);
+        CASE_X_CONST(PRELU, prelu);
+        CASE_X_CONST(ELU, elu);
+        CASE_AB(ADD, add);
+        CASE_AB(SUBTRACT, subtract);
+        CASE_AB(MULTIPLY, multiply);
+        CASE_AB(DIVIDE, divide);
+#undef CASE_X
+#undef CASE_X_CONST
+#undef CASE_AB
+      }
+
+      const Program prog { 2, { { op, k, { 0, 1 } } } };
+      const Tensor fy = dev->elementwise_fw({&a, &b}, prog);
+      Tensor fga = dev->new_tensor(a.shape(), 0);
+      Tensor fgb = dev->new_tensor(b.shape(), 0);
+      dev->elementwise_bw({&a, &b}, fy, gy, prog, {&fga, &fgb});
+      EXPECT_TRUE(vector_match(y.to_vector(), fy.to_vector()));
+      EXPECT_TRUE(vector_match(ga.to_vector(), fga.to_vector()));
+      EXPECT_TRUE(vector_match(gb.to_vector(), fgb.to_vector()));
+    }
+  }
+}
+
+TEST_F(TensorBackwardTest, CheckElementwiseBroadcast) {
+  using namespace elementwise;
+  // y = (tanh(x * w) / s + 1) ^ 2
+  const Program prog { 3, {
+    { MULTIPLY, 0, { 0, 1 } },
+    { TANH, 0, { 3, 3 } },
+    { DIVIDE, 0, { 4, 2 } },
+    { ADD_CONST, 1, { 5, 5 } },
+    { MULTIPLY, 0, { 6, 6 } },
+  } };
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {1, 2, 3, 4, -1, -2, -3, -4});
+    const Tensor w = dev->new_tensor_by_vector({2, 2}, {.1, -.2, .3, -.4});
+    const Tensor s = dev->new_tensor_by_vector(Shape({}, 2), {2, -.5});
+    const Tensor gy = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {1, -1, 2, -2, 2, -2, 1, -1});
+
+    const Tensor t3 = dev->multiply_fw(x, w);
+    const Tensor t4 = dev->tanh_fw(t3);
+    const Tensor t5 = dev->divide_scalar_r_fw(t4, s);
+    const Tensor t6 = dev->add_const_fw(t5, 1);
+    const Tensor y = dev->multiply_fw(t6, t6);
+    Tensor g6 = dev->new_tensor(t6.shape(), 0);
+    dev->multiply_bw(t6, t6, y, gy, g6, g6);
+    const Tensor g4 = dev->divide_scalar_r_fw(g6, s);
+    const Tensor gs = dev->negate_fw(
+        dev->sum_fw(dev->multiply_fw(g4, t5).flatten(), 0));
+    Tensor g3 = dev->new_tensor(t3.shape(), 0);
+    dev->tanh_bw(t3, t4, g4, g3);
+    Tensor gx = dev->new_tensor(x.shape(), 0);
+    Tensor gw = dev->new_tensor(w.shape(), 0);
+    dev->multiply_bw(x, w, t3, g3, gx, gw);
+
+    const Tensor fy = dev->elementwise_fw({&x, &w, &s}, prog);
+    EXPECT_EQ(y.shape(), fy.shape());
+    EXPECT_TRUE(vector_near(y.to_vector(), fy.to_vector(), 1e-6));
+
+    // Gradients are accumulated.
+    Tensor fgx = dev->new_tensor(x.shape(), 1);
+    Tensor fgw = dev->new_tensor(w.shape(), 1);
+    Tensor fgs = dev->new_tensor(s.shape(), 1);
+    dev->elementwise_bw({&x, &w, &s}, fy, gy, prog, {&fgx, &fgw, &fgs});
+    gx += dev->new_tensor(x.shape(), 1);
+    gw += dev->new_tensor(w.shape(), 1);
+    const Tensor gs1 = dev->add_const_fw(gs, 1);
+    EXPECT_TRUE(vector_near(gx.to_vector(), fgx.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(gw.to_vector(), fgw.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(gs1.to_vector(), fgs.to_vector(), 1e-5));
+  }
+}
+
+TEST_F(TensorBackwardTest, CheckInvalidElementwise) {
+  using namespace elementwise;
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor({2, 2}, 1);
+    const Tensor b = dev->new_tensor({2, 3}, 1);
+    const Tensor s = dev->new_tensor(Shape({}, 3), 1);
+    const Tensor c = dev->new_tensor(Shape({2, 2}, 2), 1);
+    const Program prog { 2, { { ADD, 0, { 0, 1 } } } };
+    EXPECT_NO_THROW(dev->elementwise_fw({&a, &s}, prog));
+    EXPECT_THROW(dev->elementwise_fw({&a}, prog), Error);
+    EXPECT_THROW(dev->elementwise_fw({&a, &b}, prog), Error);
+    EXPECT_THROW(dev->elementwise_fw({&c, &s}, prog), Error);
+    EXPECT_THROW(dev->elementwise_fw({&a, &a}, { 2, {} }), Error);
+    EXPECT_THROW(
+        dev->elementwise_fw({&a, &a}, { 2, { { ADD, 0, { 0, 2 } } } }), Error);
+    EXPECT_NO_THROW(
+        dev->elementwise_fw({&a, &a}, { 2, { { EXP, 0, { 0, 2 } } } }));
+
+    const Tensor y = dev->elementwise_fw({&a, &a}, prog);
+    Tensor ga = dev->new_tensor(a.shape(), 0);
+    Tensor gb = dev->new_tensor(b.shape(), 0);
+    EXPECT_NO_THROW(dev->elementwise_bw({&a, &a}, y, y, prog, {&ga, &ga}));
+    EXPECT_THROW(dev->elementwise_bw({&a, &a}, y, y, prog, {&ga}), Error);
+    EXPECT_THROW(dev->elementwise_bw({&a, &a}, y, y, prog, {&ga, &gb}), Error);
+    EXPECT_THROW(dev->elementwise_bw({&a, &a}, y, c, prog, {&ga, &ga}), Error);
+  }
+}
+
 }  // namespace primitiv
@@ -190,6 +190,57 @@ TEST_F(TensorOpsTest, CheckInvalidPick) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckInplacePickAssign) {
+  struct TestCase {
+    Shape a_shape;
+    vector<float> a_data;
+    Shape b_shape;
+    vector<float> b_data;
+    unsigned dim;
+    vector<unsigned> ids;
+    vector<float> y_data;
+  };
+  const vector<TestCase> test_cases {
+    {{2, 2}, {0, 1, 2, 3}, Shape({1, 2}, 2), {5, 6, 7, 8}, 0, {1, 0},
+      {7, 5, 8, 6}},
+    {{2, 2}, {0, 1, 2, 3}, Shape({2}, 2), {5, 6, 7, 8}, 1, {1, 0},
+      {7, 8, 5, 6}},
+    {{2, 2}, {0, 1, 2, 3}, {2}, {5, 6}, 1, {1},
+      {0, 1, 5, 6}},
+    {Shape({2, 2}, 2), {0, 1, 2, 3, 4, 5, 6, 7}, Shape({2}, 2),
+      {10, 11, 12, 13}, 1, {1, 0},
+      {0, 1, 10, 11, 12, 13, 6, 7}},
+    {Shape({2, 2}, 2), {0, 1, 2, 3, 4, 5, 6, 7}, Shape({2}, 2),
+      {10, 11, 12, 13}, 1, {0},
+      {10, 11, 2, 3, 12, 13, 6, 7}},
+  };
+  for (Device *dev : devices) {
+    for (const TestCase &tc : test_cases) {
+      Tensor a = dev->new_tensor_by_vector(tc.a_shape, tc.a_data);
+      const Tensor b = dev->new_tensor_by_vector(tc.b_shape, tc.b_data);
+      const Tensor copied = a;
+      dev->inplace_pick_assign(b, tc.ids, tc.dim, a);
+      EXPECT_TRUE(vector_match(tc.y_data, a.to_vector()));
+      EXPECT_TRUE(vector_match(tc.a_data, copied.to_vector()));
+    }
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInvalidInplacePickAssign) {
+  for (Device *dev : devices) {
+    Tensor a = dev->new_tensor({2, 2}, 0);
+    // Out-of-range IDs.
+    EXPECT_THROW(
+        dev->inplace_pick_assign(dev->new_tensor({2}, 0), {2}, 1, a), Error);
+    // Shape mismatched.
+    EXPECT_THROW(
+        dev->inplace_pick_assign(dev->new_tensor({3}, 0), {0}, 1, a), Error);
+    EXPECT_THROW(
+        dev->inplace_pick_assign(
+          dev->new_tensor({2}, 0), {0, 1}, 1, a), Error);
+  }
+}
+
 TEST_F(TensorOpsTest, CheckSlice) {
   vector<float> x_data(3 * 3 * 2 * 4);
   std::iota(x_data.begin(), x_data.end(), 0);
@@ -438,6 +489,46 @@ TEST_F(TensorOpsTest, CheckInvalidConcat) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckBatchSliceAndConcat) {
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    const Tensor b = dev->new_tensor_by_vector(
+        Shape({2, 2}, 2), {5, 6, 7, 8, 9, 10, 11, 12});
+    const Tensor c = dev->new_tensor_by_vector({2, 2}, {13, 14, 15, 16});
+    const Tensor y = dev->batch_concat_fw({&a, &b, &c});
+    EXPECT_EQ(Shape({2, 2}, 4), y.shape());
+    EXPECT_TRUE(vector_match(
+          vector<float> {
+            1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+          },
+          y.to_vector()));
+
+    const Tensor y1 = dev->batch_slice_fw(y, 0, 1);
+    const Tensor y2 = dev->batch_slice_fw(y, 1, 3);
+    const Tensor y3 = dev->batch_slice_fw(y, 3, 4);
+    EXPECT_EQ(a.shape(), y1.shape());
+    EXPECT_EQ(b.shape(), y2.shape());
+    EXPECT_EQ(c.shape(), y3.shape());
+    EXPECT_TRUE(vector_match(a.to_vector(), y1.to_vector()));
+    EXPECT_TRUE(vector_match(b.to_vector(), y2.to_vector()));
+    EXPECT_TRUE(vector_match(c.to_vector(), y3.to_vector()));
+
+    // Sources are not modified.
+    EXPECT_TRUE(vector_match(vector<float> {1, 2, 3, 4}, a.to_vector()));
+  }
+}
+
+TEST_F(TensorOpsTest, CheckInvalidBatchSliceAndConcat) {
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor({2, 2}, 0);
+    const Tensor b = dev->new_tensor(Shape({2}, 2), 0);
+    EXPECT_THROW(dev->batch_concat_fw({}), Error);
+    EXPECT_THROW(dev->batch_concat_fw({&a, &b}), Error);
+    EXPECT_THROW(dev->batch_slice_fw(b, 1, 1), Error);
+    EXPECT_THROW(dev->batch_slice_fw(b, 0, 3), Error);
+  }
+}
+
 TEST_F(TensorOpsTest, CheckReshape) {
   const vector<Shape> shapes {
     {6}, {1, 6}, {1, 1, 6}, {1, 1, 1, 6},
@@ -1856,5 +1947,24 @@ TEST_F(TensorOpsTest, CheckInvalidSparseSoftmaxCrossEntropy) {
   }
 }
 
+TEST_F(TensorOpsTest, CheckElementwiseInplace) {
+  using namespace elementwise;
+  for (Device *dev : devices) {
+    Tensor a = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    const Tensor b = dev->new_tensor_by_vector({2, 2}, {5, 6, 7, 8});
+    const Tensor s = dev->new_tensor(Shape({}, 3), 1);
+    const Program prog { 2, {
+      { MULTIPLY, 0, { 0, 1 } },
+      { ADD, 0, { 2, 0 } },
+    } };
+    dev->elementwise_fw({&a, &b}, prog, a);
+    EXPECT_TRUE(vector_match(vector<float> {6, 14, 24, 36}, a.to_vector()));
+
+    Tensor c = dev->new_tensor({2, 3}, 0);
+    EXPECT_THROW(dev->elementwise_fw({&a, &b}, prog, c), Error);
+    EXPECT_THROW(dev->elementwise_fw({&a, &s}, prog, a), Error);
+  }
+}
+
 }  // namespace operators
 }  // namespace primitiv
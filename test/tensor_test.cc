@@ -18,6 +18,7 @@
 
 using std::vector;
 using test_utils::vector_match;
+using test_utils::vector_near;
 
 namespace primitiv {
 
@@ -376,6 +377,37 @@ TEST_F(TensorTest, CheckUnique) {
   }
 }
 
+TEST_F(TensorTest, CheckNewTensorView) {
+  for (Device *dev : devices) {
+    const Tensor x = dev->new_tensor_by_vector({6}, {1, 2, 3, 4, 5, 6});
+    const float *base = static_cast<const float *>(x.data());
+    Tensor v1 = dev->new_tensor_view(x, 0, {2});
+    Tensor v2 = dev->new_tensor_view(x, 2, {2, 2});
+    EXPECT_EQ(Shape({2}), v1.shape());
+    EXPECT_EQ(Shape({2, 2}), v2.shape());
+    EXPECT_TRUE(vector_match(vector<float> {1, 2}, v1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {3, 4, 5, 6}, v2.to_vector()));
+
+    // Views are written without duplicating the memory.
+    v1.reset(-1);
+    v2 *= 2;
+    EXPECT_EQ(base, v1.data());
+    EXPECT_EQ(base + 2, v2.data());
+    EXPECT_TRUE(vector_match(
+          vector<float> {-1, -1, 6, 8, 10, 12}, x.to_vector()));
+
+    // Copies of views are duplicated at writing.
+    const Tensor copied = v2;
+    v2.reset(0);
+    EXPECT_NE(base + 2, v2.data());
+    EXPECT_TRUE(vector_match(
+          vector<float> {-1, -1, 6, 8, 10, 12}, x.to_vector()));
+
+    EXPECT_THROW(dev->new_tensor_view(x, 5, {2}), Error);
+    EXPECT_THROW(dev->new_tensor_view(Tensor(), 0, {}), Error);
+  }
+}
+
 TEST_F(TensorTest, CheckResetValuesByConstant) {
   for (Device *dev : devices) {
     {
@@ -588,6 +620,258 @@ TEST_F(TensorTest, CheckCopyAndInplaceSubtract) {
   }
 }
 
+TEST_F(TensorTest, CheckSGDUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g1 = dev->new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    const Tensor g2 = dev->new_tensor_by_vector({2}, {.5, -.5});
+    Tensor x1 = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    Tensor x2 = dev->new_tensor_by_vector({2}, {5, 6});
+    dev->sgd_update(.5, {&g1, &g2}, {&x1, &x2});
+    EXPECT_TRUE(vector_match(vector<float> {.5, 2.5, 2, 5}, x1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {4.75, 6.25}, x2.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckSGDUpdateMany) {
+  // Updates many tensors with various sizes at once.
+  for (Device *dev : devices) {
+    vector<Tensor> gs, xs;
+    vector<vector<float>> expected;
+    for (unsigned n = 1; n <= 1000; n += 37) {
+      vector<float> g_data(n), x_data(n), y_data(n);
+      for (unsigned i = 0; i < n; ++i) {
+        g_data[i] = i % 7;
+        x_data[i] = n + i;
+        y_data[i] = x_data[i] - 2 * g_data[i];
+      }
+      gs.emplace_back(dev->new_tensor_by_vector({n}, g_data));
+      xs.emplace_back(dev->new_tensor_by_vector({n}, x_data));
+      expected.emplace_back(std::move(y_data));
+    }
+    vector<const Tensor *> pgs;
+    vector<Tensor *> pxs;
+    for (unsigned i = 0; i < gs.size(); ++i) {
+      pgs.emplace_back(&gs[i]);
+      pxs.emplace_back(&xs[i]);
+    }
+    dev->sgd_update(2, pgs, pxs);
+    for (unsigned i = 0; i < xs.size(); ++i) {
+      EXPECT_TRUE(vector_match(expected[i], xs[i].to_vector()));
+    }
+  }
+}
+
+TEST_F(TensorTest, CheckMomentumSGDUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g1 = dev->new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    const Tensor g2 = dev->new_tensor_by_vector({2}, {.5, -.5});
+    Tensor x1 = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    Tensor x2 = dev->new_tensor_by_vector({2}, {5, 6});
+    Tensor m1 = dev->new_tensor({2, 2}, 1);
+    Tensor m2 = dev->new_tensor({2}, 1);
+    dev->momentum_sgd_update(.5, .9, {&g1, &g2}, {&x1, &x2}, {&m1, &m2});
+    EXPECT_TRUE(vector_match(
+          vector<float> {1.4, 3.4, 2.9, 5.9}, x1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {5.65, 7.15}, x2.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {.4, 1.4, -.1, 1.9}, m1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {.65, 1.15}, m2.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckAdaGradUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g1 = dev->new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    const Tensor g2 = dev->new_tensor_by_vector({2}, {.5, -.5});
+    Tensor x1 = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    Tensor x2 = dev->new_tensor_by_vector({2}, {5, 6});
+    Tensor m1 = dev->new_tensor({2, 2}, 1);
+    Tensor m2 = dev->new_tensor({2}, 1);
+    dev->adagrad_update(.5, 1e-8, {&g1, &g2}, {&x1, &x2}, {&m1, &m2});
+    EXPECT_TRUE(vector_match(
+          vector<float> {.64644661, 2.3535534, 2.5527864, 4.4472136},
+          x1.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {4.7763932, 6.2236068}, x2.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {2, 2, 5, 5}, m1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {1.25, 1.25}, m2.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckRMSPropUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g1 = dev->new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    const Tensor g2 = dev->new_tensor_by_vector({2}, {.5, -.5});
+    Tensor x1 = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    Tensor x2 = dev->new_tensor_by_vector({2}, {5, 6});
+    Tensor m1 = dev->new_tensor({2, 2}, 1);
+    Tensor m2 = dev->new_tensor({2}, 1);
+    dev->rmsprop_update(.5, .9, 1e-8, {&g1, &g2}, {&x1, &x2}, {&m1, &m2});
+    EXPECT_TRUE(vector_match(
+          vector<float> {.5, 2.5, 2.122942, 4.877058}, x1.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {4.7400624, 6.2599376}, x2.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {1, 1, 1.3, 1.3}, m1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {.925, .925}, m2.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckAdaDeltaUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g1 = dev->new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    const Tensor g2 = dev->new_tensor_by_vector({2}, {.5, -.5});
+    Tensor x1 = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    Tensor x2 = dev->new_tensor_by_vector({2}, {5, 6});
+    Tensor m11 = dev->new_tensor({2, 2}, 1);
+    Tensor m12 = dev->new_tensor({2}, 1);
+    Tensor m21 = dev->new_tensor({2, 2}, 2);
+    Tensor m22 = dev->new_tensor({2}, 2);
+    dev->adadelta_update(
+        .5, .9, 1e-6, {&g1, &g2}, {&x1, &x2}, {&m11, &m12}, {&m21, &m22});
+    EXPECT_TRUE(vector_match(
+          vector<float> {.63726179, 2.3627382, 2.3258, 4.6742},
+          x1.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {4.8149417, 6.1850583}, x2.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {.9526316, .9526316, 1.0818183, 1.0818183},
+          m11.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {.91369864, .91369864}, m12.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {1.9, 1.9, 2.2, 2.2}, m21.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {1.825, 1.825}, m22.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckAdamUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g1 = dev->new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+    const Tensor g2 = dev->new_tensor_by_vector({2}, {.5, -.5});
+    Tensor x1 = dev->new_tensor_by_vector({2, 2}, {1, 2, 3, 4});
+    Tensor x2 = dev->new_tensor_by_vector({2}, {5, 6});
+    Tensor m11 = dev->new_tensor({2, 2}, 1);
+    Tensor m12 = dev->new_tensor({2}, 1);
+    Tensor m21 = dev->new_tensor({2, 2}, 2);
+    Tensor m22 = dev->new_tensor({2}, 2);
+    dev->adam_update(
+        .5, .9, .999, 1e-8, 2,
+        {&g1, &g2}, {&x1, &x2}, {&m11, &m12}, {&m21, &m22});
+    EXPECT_TRUE(vector_near(
+          vector<float> {.91678217, 1.9334257, 2.908529, 3.9417912},
+          x1.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(
+          vector<float> {4.9209282, 5.9292516}, x2.to_vector(), 1e-5));
+    EXPECT_TRUE(vector_match(
+          vector<float> {1, .8, 1.1, .7}, m11.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {.95, .85}, m12.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {1.999, 1.999, 2.002, 2.002}, m21.to_vector()));
+    EXPECT_TRUE(vector_match(
+          vector<float> {1.99825, 1.99825}, m22.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckCopyAndAdamUpdate) {
+  for (Device *dev : devices) {
+    const Tensor g = dev->new_tensor({2}, 1);
+    Tensor x = dev->new_tensor({2}, 1);
+    Tensor m1 = dev->new_tensor({2}, 0);
+    Tensor m2 = dev->new_tensor({2}, 0);
+    const Tensor copied_x = x;
+    const Tensor copied_m1 = m1;
+    dev->adam_update(.5, .9, .999, 1e-8, 1, {&g}, {&x}, {&m1}, {&m2});
+    EXPECT_TRUE(vector_match(vector<float>(2, .5), x.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float>(2, 1), copied_x.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float>(2, .1), m1.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float>(2, 0), copied_m1.to_vector()));
+  }
+}
+
+TEST_F(TensorTest, CheckInvalidOptimizerUpdate) {
+  devices::Naive other;
+  for (Device *dev : devices) {
+    const Tensor g = dev->new_tensor({2}, 0);
+    Tensor x = dev->new_tensor({2}, 0);
+    Tensor m = dev->new_tensor({2}, 0);
+    Tensor x3 = dev->new_tensor({3}, 0);
+    Tensor xo = other.new_tensor({2}, 0);
+    // Number of tensors mismatched.
+    EXPECT_THROW(dev->sgd_update(1, {&g}, {}), Error);
+    EXPECT_THROW(dev->sgd_update(1, {&g}, {&x, &x}), Error);
+    EXPECT_THROW(dev->momentum_sgd_update(1, 1, {&g}, {&x}, {}), Error);
+    // Shape mismatched.
+    EXPECT_THROW(dev->sgd_update(1, {&g}, {&x3}), Error);
+    EXPECT_THROW(dev->adagrad_update(1, 1, {&g}, {&x}, {&x3}), Error);
+    // Device mismatched.
+    EXPECT_THROW(dev->sgd_update(1, {&g}, {&xo}), Error);
+    EXPECT_THROW(dev->rmsprop_update(1, 1, 1, {&g}, {&x}, {&xo}), Error);
+    EXPECT_THROW(
+        dev->adam_update(1, 1, 1, 1, 1, {&g}, {&x}, {&m}, {&xo}), Error);
+    // No tensors.
+    EXPECT_NO_THROW(dev->adadelta_update(1, 1, 1, {}, {}, {}, {}));
+  }
+}
+
+TEST_F(TensorTest, CheckSquaredNorm) {
+  for (Device *dev : devices) {
+    const Tensor a = dev->new_tensor_by_vector({2, 2}, {1, -2, 3, -4});
+    const Tensor b = dev->new_tensor_by_vector(Shape({}, 3), {5, -6, 7});
+    const Tensor y1 = dev->squared_norm({&a, &b});
+    EXPECT_EQ(Shape(), y1.shape());
+    EXPECT_FLOAT_EQ(140, y1.to_float());
+    const Tensor y2 = dev->squared_norm({&b});
+    EXPECT_FLOAT_EQ(110, y2.to_float());
+    const Tensor y3 = dev->squared_norm({});
+    EXPECT_FLOAT_EQ(0, y3.to_float());
+  }
+}
+
+TEST_F(TensorTest, CheckSquaredNormLarge) {
+  for (Device *dev : devices) {
+    // NOTE: 100 * 1000 + 1 * 10000 = 110000
+    const Tensor a = dev->new_tensor(Shape({10, 10}, 10), 10);
+    const Tensor b = dev->new_tensor({100, 100}, 1);
+    EXPECT_FLOAT_EQ(110000, dev->squared_norm({&a, &b}).to_float());
+  }
+}
+
+TEST_F(TensorTest, CheckInplaceClipByNorm) {
+  for (Device *dev : devices) {
+    Tensor a = dev->new_tensor_by_vector({2}, {3, 0});
+    Tensor b = dev->new_tensor_by_vector(Shape({}, 2), {0, -4});
+    const Tensor sq = dev->squared_norm({&a, &b});
+
+    // Not clipped.
+    dev->inplace_clip_by_norm(5, sq, {&a, &b});
+    EXPECT_TRUE(vector_match(vector<float> {3, 0}, a.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {0, -4}, b.to_vector()));
+
+    // Clipped.
+    dev->inplace_clip_by_norm(2.5, sq, {&a, &b});
+    EXPECT_TRUE(vector_match(vector<float> {1.5, 0}, a.to_vector()));
+    EXPECT_TRUE(vector_match(vector<float> {0, -2}, b.to_vector()));
+
+    // No tensors.
+    EXPECT_NO_THROW(dev->inplace_clip_by_norm(1, sq, {}));
+  }
+}
+
+TEST_F(TensorTest, CheckInvalidClipByNorm) {
+  devices::Naive other;
+  for (Device *dev : devices) {
+    Tensor a = dev->new_tensor({2}, 0);
+    const Tensor ao = other.new_tensor({2}, 0);
+    const Tensor sq = dev->new_tensor({}, 0);
+    const Tensor sq2 = dev->new_tensor({2}, 0);
+    const Tensor sqo = other.new_tensor({}, 0);
+    EXPECT_THROW(dev->squared_norm({&a, &ao}), Error);
+    EXPECT_THROW(dev->inplace_clip_by_norm(1, sq2, {&a}), Error);
+    EXPECT_THROW(dev->inplace_clip_by_norm(1, sqo, {&a}), Error);
+    EXPECT_NO_THROW(dev->inplace_clip_by_norm(1, sq, {&a}));
+  }
+}
+
 TEST_F(TensorTest, CheckInvalidInplaceOps) {
   for (Device *dev : devices) {
     vector<Shape> shapes {
@@ -0,0 +1,129 @@
+#include <config.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/error.h>
+#include <primitiv/thread_pool.h>
+
+using std::pair;
+using std::vector;
+
+namespace primitiv {
+
+class ThreadPoolTest : public testing::Test {};
+
+TEST_F(ThreadPoolTest, CheckNumThreads) {
+  for (unsigned n : {1u, 2u, 4u}) {
+    ThreadPool pool(n);
+    EXPECT_EQ(n, pool.num_threads());
+  }
+}
+
+TEST_F(ThreadPoolTest, CheckInvalidNumThreads) {
+  EXPECT_THROW(ThreadPool(0), Error);
+}
+
+TEST_F(ThreadPoolTest, CheckParallelFor) {
+  for (unsigned n : {1u, 2u, 4u}) {
+    ThreadPool pool(n);
+    for (unsigned size : {0u, 1u, 7u, 100u, 12345u}) {
+      for (unsigned grain : {0u, 1u, 10u, 1000u}) {
+        vector<unsigned> counts(size, 0);
+        pool.parallel_for(size, grain, [&](unsigned begin, unsigned end) {
+          for (unsigned i = begin; i < end; ++i) ++counts[i];
+        });
+        EXPECT_EQ(vector<unsigned>(size, 1), counts)
+          << "threads: " << n << ", size: " << size << ", grain: " << grain;
+      }
+    }
+  }
+}
+
+TEST_F(ThreadPoolTest, CheckSubranges) {
+  ThreadPool pool(4);
+  std::mutex mtx;
+  vector<pair<unsigned, unsigned>> ranges;
+  pool.parallel_for(1000, 100, [&](unsigned begin, unsigned end) {
+    std::lock_guard<std::mutex> lock(mtx);
+    ranges.emplace_back(begin, end);
+  });
+  EXPECT_GT(ranges.size(), 1u);
+  for (const auto &r : ranges) {
+    EXPECT_LE(100u, r.second - r.first);
+  }
+}
+
+TEST_F(ThreadPoolTest, CheckSerialIfSmall) {
+  ThreadPool pool(4);
+  const std::thread::id caller = std::this_thread::get_id();
+  unsigned num_calls = 0;
+  pool.parallel_for(100, 100, [&](unsigned begin, unsigned end) {
+    EXPECT_EQ(caller, std::this_thread::get_id());
+    EXPECT_EQ(0u, begin);
+    EXPECT_EQ(100u, end);
+    ++num_calls;
+  });
+  EXPECT_EQ(1u, num_calls);
+}
+
+TEST_F(ThreadPoolTest, CheckNested) {
+  ThreadPool pool(4);
+  std::atomic<unsigned> sum(0);
+  pool.parallel_for(16, 1, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      pool.parallel_for(16, 1, [&](unsigned begin2, unsigned end2) {
+        sum += end2 - begin2;
+      });
+    }
+  });
+  EXPECT_EQ(256u, sum);
+}
+
+TEST_F(ThreadPoolTest, CheckNestedOtherPool) {
+  ThreadPool outer(2);
+  ThreadPool inner(4);
+  std::atomic<unsigned> sum(0);
+  std::atomic<unsigned> num_parallel(0);
+  outer.parallel_for(2, 1, [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      const std::thread::id caller = std::this_thread::get_id();
+      std::atomic<bool> parallel(false);
+      inner.parallel_for(16, 1, [&](unsigned begin2, unsigned end2) {
+        // NOTE: Waits to let workers take some tasks.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (std::this_thread::get_id() != caller) parallel = true;
+        sum += end2 - begin2;
+      });
+      if (parallel) ++num_parallel;
+    }
+  });
+  EXPECT_EQ(32u, sum);
+  EXPECT_EQ(2u, num_parallel);
+}
+
+TEST_F(ThreadPoolTest, CheckException) {
+  ThreadPool pool(4);
+  std::atomic<unsigned> processed(0);
+  EXPECT_THROW(
+      pool.parallel_for(100, 1, [&](unsigned begin, unsigned end) {
+        processed += end - begin;
+        if (begin == 0) throw std::runtime_error("test");
+      }),
+      std::runtime_error);
+  EXPECT_EQ(100u, processed);
+
+  // The pool is still available.
+  std::atomic<unsigned> sum(0);
+  pool.parallel_for(100, 1, [&](unsigned begin, unsigned end) {
+    sum += end - begin;
+  });
+  EXPECT_EQ(100u, sum);
+}
+
+}  // namespace primitiv
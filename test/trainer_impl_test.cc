@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 #include <primitiv/error.h>
 #include <primitiv/naive_device.h>
+#include <primitiv/operators.h>
 #include <primitiv/parameter.h>
 #include <primitiv/trainer_impl.h>
 #include <test_utils.h>
@@ -46,6 +47,13 @@ TEST_F(TrainerImplTest, CheckDefaultHyperparameters) {
   EXPECT_FLOAT_EQ(.9, adam.beta1());
   EXPECT_FLOAT_EQ(.999, adam.beta2());
   EXPECT_FLOAT_EQ(1e-8, adam.eps());
+
+  LazyAdam lazyadam;
+  EXPECT_FLOAT_EQ(.001, lazyadam.alpha());
+  EXPECT_FLOAT_EQ(.9, lazyadam.beta1());
+  EXPECT_FLOAT_EQ(.999, lazyadam.beta2());
+  EXPECT_FLOAT_EQ(1e-8, lazyadam.eps());
+  EXPECT_FALSE(lazyadam.catch_up());
 }
 
 TEST_F(TrainerImplTest, CheckGivenHyperparameters) {
@@ -74,6 +82,13 @@ TEST_F(TrainerImplTest, CheckGivenHyperparameters) {
   EXPECT_FLOAT_EQ(2, adam.beta1());
   EXPECT_FLOAT_EQ(3, adam.beta2());
   EXPECT_FLOAT_EQ(4, adam.eps());
+
+  LazyAdam lazyadam(1, 2, 3, 4, true);
+  EXPECT_FLOAT_EQ(1, lazyadam.alpha());
+  EXPECT_FLOAT_EQ(2, lazyadam.beta1());
+  EXPECT_FLOAT_EQ(3, lazyadam.beta2());
+  EXPECT_FLOAT_EQ(4, lazyadam.eps());
+  EXPECT_TRUE(lazyadam.catch_up());
 }
 
 TEST_F(TrainerImplTest, CheckInvalidLoad) {
@@ -194,6 +209,33 @@ TEST_F(TrainerImplTest, CheckSGDUpdate) {
   }
 }
 
+TEST_F(TrainerImplTest, CheckSGDSparseUpdate) {
+  // Updates with row-sparse gradients should be same as dense updates.
+  const vector<float> init {1, 2, 3, 4, 5, 6, 7, 8};
+  Parameter sparse({2, 4}, init, dev);
+  Parameter dense({2, 4}, init, dev);
+  SGD trainer;
+  trainer.set_learning_rate_scaling(.1);
+  trainer.add_parameter(sparse);
+  trainer.add_parameter(dense);
+
+  const vector<vector<unsigned>> rows {{1, 3}, {}, {0}};
+  for (const vector<unsigned> &r : rows) {
+    trainer.reset_gradients();
+    ASSERT_TRUE(sparse.has_sparse_gradient());
+    for (const unsigned i : r) {
+      const vector<unsigned> ids {i};
+      const Tensor g = operators::pick(sparse.value(), ids, 1);
+      dev.pick_bw(g, ids, 1, sparse.gradient(1, ids));
+      dev.pick_bw(g, ids, 1, dense.dense_gradient());
+    }
+    ASSERT_TRUE(sparse.has_sparse_gradient());
+    trainer.update();
+    EXPECT_TRUE(vector_match(
+          dense.value().to_vector(), sparse.value().to_vector()));
+  }
+}
+
 TEST_F(TrainerImplTest, CheckMomentumSGDSaveLoad) {
   MomentumSGD trainer(1, 2);
   trainer.set_epoch(3);
@@ -413,6 +455,36 @@ TEST_F(TrainerImplTest, CheckAdaGradUpdate) {
   }
 }
 
+TEST_F(TrainerImplTest, CheckAdaGradSparseUpdate) {
+  // Updates with row-sparse gradients should be same as dense updates.
+  const vector<float> init {1, 2, 3, 4, 5, 6, 7, 8};
+  Parameter sparse({2, 4}, init, dev);
+  Parameter dense({2, 4}, init, dev);
+  AdaGrad trainer;
+  trainer.set_learning_rate_scaling(.1);
+  trainer.add_parameter(sparse);
+  trainer.add_parameter(dense);
+
+  const vector<vector<unsigned>> rows {{1, 3}, {}, {3, 0}};
+  for (const vector<unsigned> &r : rows) {
+    trainer.reset_gradients();
+    ASSERT_TRUE(sparse.has_sparse_gradient());
+    for (const unsigned i : r) {
+      const vector<unsigned> ids {i};
+      const Tensor g = operators::pick(sparse.value(), ids, 1);
+      dev.pick_bw(g, ids, 1, sparse.gradient(1, ids));
+      dev.pick_bw(g, ids, 1, dense.dense_gradient());
+    }
+    ASSERT_TRUE(sparse.has_sparse_gradient());
+    trainer.update();
+    EXPECT_TRUE(vector_match(
+          dense.value().to_vector(), sparse.value().to_vector()));
+    EXPECT_TRUE(vector_match(
+          dense.stats("adagrad-m").to_vector(),
+          sparse.stats("adagrad-m").to_vector()));
+  }
+}
+
 TEST_F(TrainerImplTest, CheckRMSPropSaveLoad) {
   RMSProp trainer(1, 2, 3);
   trainer.set_epoch(4);
@@ -780,5 +852,223 @@ TEST_F(TrainerImplTest, CheckAdamUpdate) {
   }
 }
 
+TEST_F(TrainerImplTest, CheckLazyAdamSaveLoad) {
+  LazyAdam trainer(1, 2, 3, 4, true);
+  trainer.set_epoch(5);
+  trainer.set_learning_rate_scaling(6);
+  trainer.set_weight_decay(7);
+  trainer.set_gradient_clipping(8);
+
+  const std::string path = "/tmp/primitiv_TrainerImplTest_CheckLazyAdamSaveLoad.data";
+  trainer.save(path);
+
+  LazyAdam trainer2;
+  trainer2.load(path);
+  std::remove(path.c_str());
+
+  EXPECT_EQ(1, trainer2.alpha());
+  EXPECT_EQ(2, trainer2.beta1());
+  EXPECT_EQ(3, trainer2.beta2());
+  EXPECT_EQ(4, trainer2.eps());
+  EXPECT_TRUE(trainer2.catch_up());
+  EXPECT_EQ(5, trainer2.get_epoch());
+  EXPECT_EQ(6, trainer2.get_learning_rate_scaling());
+  EXPECT_EQ(7, trainer2.get_weight_decay());
+  EXPECT_EQ(8, trainer2.get_gradient_clipping());
+}
+
+TEST_F(TrainerImplTest, CheckLazyAdamGetConfigs) {
+  LazyAdam trainer(1, 2, 3, 4, true);
+  trainer.set_epoch(5);
+  trainer.set_learning_rate_scaling(6);
+  trainer.set_weight_decay(7);
+  trainer.set_gradient_clipping(8);
+
+  std::unordered_map<std::string, unsigned> uint_configs;
+  std::unordered_map<std::string, float> float_configs;
+  trainer.get_configs(uint_configs, float_configs);
+
+  EXPECT_EQ(2u, uint_configs.size());
+  EXPECT_EQ(7u, float_configs.size());
+  EXPECT_EQ(1, float_configs.at("LazyAdam.alpha"));
+  EXPECT_EQ(2, float_configs.at("LazyAdam.beta1"));
+  EXPECT_EQ(3, float_configs.at("LazyAdam.beta2"));
+  EXPECT_EQ(4, float_configs.at("LazyAdam.eps"));
+  EXPECT_EQ(1u, uint_configs.at("LazyAdam.catch_up"));
+  EXPECT_EQ(5, uint_configs.at("Trainer.epoch"));
+  EXPECT_EQ(6, float_configs.at("Trainer.lr_scale"));
+  EXPECT_EQ(7, float_configs.at("Trainer.l2_strength"));
+  EXPECT_EQ(8, float_configs.at("Trainer.clip_threshold"));
+}
+
+TEST_F(TrainerImplTest, CheckLazyAdamSetConfigs) {
+  LazyAdam trainer(0, 0, 0, 0, false);
+  trainer.set_epoch(0);
+  trainer.set_learning_rate_scaling(0);
+  trainer.set_weight_decay(0);
+  trainer.set_gradient_clipping(0);
+
+  std::unordered_map<std::string, unsigned> uint_configs {
+    std::make_pair("LazyAdam.catch_up", 1),
+    std::make_pair("Trainer.epoch", 5),
+  };
+  std::unordered_map<std::string, float> float_configs {
+    std::make_pair("LazyAdam.alpha", 1),
+    std::make_pair("LazyAdam.beta1", 2),
+    std::make_pair("LazyAdam.beta2", 3),
+    std::make_pair("LazyAdam.eps", 4),
+    std::make_pair("Trainer.lr_scale", 6),
+    std::make_pair("Trainer.l2_strength", 7),
+    std::make_pair("Trainer.clip_threshold", 8),
+  };
+  trainer.set_configs(uint_configs, float_configs);
+
+  EXPECT_EQ(1, trainer.alpha());
+  EXPECT_EQ(2, trainer.beta1());
+  EXPECT_EQ(3, trainer.beta2());
+  EXPECT_EQ(4, trainer.eps());
+  EXPECT_TRUE(trainer.catch_up());
+  EXPECT_EQ(5, trainer.get_epoch());
+  EXPECT_EQ(6, trainer.get_learning_rate_scaling());
+  EXPECT_EQ(7, trainer.get_weight_decay());
+  EXPECT_EQ(8, trainer.get_gradient_clipping());
+}
+
+TEST_F(TrainerImplTest, CheckLazyAdamDenseUpdate) {
+  // Updates with dense gradients should be same as Adam.
+  const vector<float> init {1, 2, 3, 4};
+  for (const bool catch_up : {false, true}) {
+    Parameter lazy({2, 2}, init, dev);
+    Parameter ref({2, 2}, init, dev);
+    LazyAdam trainer(.001, .9, .999, 1e-8, catch_up);
+    Adam ref_trainer;
+    trainer.set_flat_buffer(true);
+    trainer.add_parameter(lazy);
+    ref_trainer.add_parameter(ref);
+    ASSERT_TRUE(lazy.has_stats("adam-m1"));
+    ASSERT_TRUE(lazy.has_stats("adam-m2"));
+    ASSERT_TRUE(lazy.has_stats("lazyadam-t"));
+    EXPECT_EQ(Shape({1, 2}), lazy.stats("lazyadam-t").shape());
+
+    for (unsigned i = 0; i < 5; ++i) {
+      trainer.reset_gradients();
+      ref_trainer.reset_gradients();
+      // NOTE: Moments should remain in the flat buffer after updates.
+      const Parameter &c = lazy;
+      const void *m1_data = c.stats("adam-m1").data();
+      const void *m2_data = c.stats("adam-m2").data();
+      lazy.dense_gradient() += lazy.value();  // Squared loss
+      ref.dense_gradient() += ref.value();
+      trainer.update();
+      ref_trainer.update();
+      EXPECT_EQ(m1_data, c.stats("adam-m1").data());
+      EXPECT_EQ(m2_data, c.stats("adam-m2").data());
+      EXPECT_TRUE(vector_match(
+            ref.value().to_vector(), lazy.value().to_vector()));
+      EXPECT_TRUE(vector_match(
+            ref.stats("adam-m1").to_vector(),
+            lazy.stats("adam-m1").to_vector()));
+      EXPECT_TRUE(vector_match(
+            ref.stats("adam-m2").to_vector(),
+            lazy.stats("adam-m2").to_vector()));
+      EXPECT_TRUE(vector_match(
+            vector<float>(2, i + 1), lazy.stats("lazyadam-t").to_vector()));
+    }
+  }
+}
+
+TEST_F(TrainerImplTest, CheckLazyAdamSparseUpdate) {
+  const vector<vector<float>> expected_v {
+    {1, 2, 2.999, 3.999, 5, 6, 6.999, 7.999},
+    {1, 2, 2.999, 3.999, 5, 6, 6.999, 7.999},
+    {9.99361186e-01, 1.99936119e+00, 2.999, 3.999,
+      5, 6, 6.99814154e+00, 7.99814154e+00},
+  };
+  const vector<vector<float>> expected_m1 {
+    {0, 0, .3, .4, 0, 0, .7, .8},
+    {0, 0, .3, .4, 0, 0, .7, .8},
+    {.1, .2, .3, .4, 0, 0, 1.3299, 1.5199},
+  };
+  const vector<vector<float>> expected_m2 {
+    {0, 0, .009, .016, 0, 0, .049, .064},
+    {0, 0, .009, .016, 0, 0, .049, .064},
+    {.001, .004, .009, .016, 0, 0, 9.79370010e-02, 1.27920001e-01},
+  };
+  const vector<vector<float>> expected_t {
+    {0, 1, 0, 1},
+    {0, 1, 0, 1},
+    {3, 1, 0, 3},
+  };
+
+  Parameter param({2, 4}, {1, 2, 3, 4, 5, 6, 7, 8}, dev);
+  LazyAdam trainer;
+  trainer.add_parameter(param);
+
+  const vector<vector<unsigned>> rows {{1, 3}, {}, {3, 0}};
+  for (unsigned i = 0; i < rows.size(); ++i) {
+    trainer.reset_gradients();
+    for (const unsigned r : rows[i]) {
+      const vector<unsigned> ids {r};
+      dev.pick_bw(
+          operators::pick(param.value(), ids, 1),  // Squared loss
+          ids, 1, param.gradient(1, ids));
+    }
+    ASSERT_TRUE(param.has_sparse_gradient());
+    trainer.update();
+    EXPECT_TRUE(vector_near(
+          expected_v[i], param.value().to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(
+          expected_m1[i], param.stats("adam-m1").to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(
+          expected_m2[i], param.stats("adam-m2").to_vector(), 1e-5));
+    EXPECT_TRUE(vector_match(
+          expected_t[i], param.stats("lazyadam-t").to_vector()));
+  }
+}
+
+TEST_F(TrainerImplTest, CheckLazyAdamSparseUpdateWithCatchUp) {
+  // Moments of the row 3 skipped at the 2nd step are decayed before the 3rd
+  // update.
+  const vector<vector<float>> expected_v {
+    {1, 2, 2.999, 3.999, 5, 6, 6.999, 7.999},
+    {1, 2, 2.999, 3.999, 5, 6, 6.999, 7.999},
+    {9.99361186e-01, 1.99936119e+00, 2.999, 3.999,
+      5, 6, 6.99818200e+00, 7.99818200e+00},
+  };
+  const vector<vector<float>> expected_m1 {
+    {0, 0, .3, .4, 0, 0, .7, .8},
+    {0, 0, .3, .4, 0, 0, .7, .8},
+    {.1, .2, .3, .4, 0, 0, 1.2669, 1.4479},
+  };
+  const vector<vector<float>> expected_m2 {
+    {0, 0, .009, .016, 0, 0, .049, .064},
+    {0, 0, .009, .016, 0, 0, .049, .064},
+    {.001, .004, .009, .016, 0, 0, 9.78880500e-02, 1.27856065e-01},
+  };
+
+  Parameter param({2, 4}, {1, 2, 3, 4, 5, 6, 7, 8}, dev);
+  LazyAdam trainer(.001, .9, .999, 1e-8, true);
+  trainer.add_parameter(param);
+
+  const vector<vector<unsigned>> rows {{1, 3}, {}, {3, 0}};
+  for (unsigned i = 0; i < rows.size(); ++i) {
+    trainer.reset_gradients();
+    for (const unsigned r : rows[i]) {
+      const vector<unsigned> ids {r};
+      dev.pick_bw(
+          operators::pick(param.value(), ids, 1),  // Squared loss
+          ids, 1, param.gradient(1, ids));
+    }
+    ASSERT_TRUE(param.has_sparse_gradient());
+    trainer.update();
+    EXPECT_TRUE(vector_near(
+          expected_v[i], param.value().to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(
+          expected_m1[i], param.stats("adam-m1").to_vector(), 1e-5));
+    EXPECT_TRUE(vector_near(
+          expected_m2[i], param.stats("adam-m2").to_vector(), 1e-5));
+  }
+}
+
 }  // namespace trainers
 }  // namespace primitiv
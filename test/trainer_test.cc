@@ -1,20 +1,72 @@
 #include <config.h>
 
+#include <functional>
 #include <gtest/gtest.h>
 #include <primitiv/error.h>
+#include <primitiv/graph.h>
 #include <primitiv/naive_device.h>
+#include <primitiv/operators.h>
 #include <primitiv/parameter.h>
 #include <primitiv/trainer_impl.h>
 #include <test_utils.h>
 
 using std::vector;
 using test_utils::vector_match;
+using test_utils::vector_near;
 
 namespace primitiv {
 
 class TrainerTest : public testing::Test {
 protected:
   devices::Naive dev;
+
+  // Updates two parameters with the same values by trainers configured by
+  // `configure`, and checks that row-sparse gradients give the same results as
+  // dense gradients. `ids[i]` are the rows of the gradient at the `i`-th step.
+  void check_sparse_gradient(
+      const vector<vector<unsigned>> &ids,
+      const std::function<void(Trainer &)> &configure) {
+    Device::set_default(dev);
+    const vector<float> init {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    const vector<float> g_data {1, 2, -3, -4};
+    Parameter sparse({2, 5}, init);
+    Parameter dense({2, 5}, init);
+    const Parameter &cs = sparse;
+    trainers::SGD trainer1, trainer2;
+    configure(trainer1);
+    configure(trainer2);
+    trainer1.add_parameter(sparse);
+    trainer2.add_parameter(dense);
+    for (const vector<unsigned> &rows : ids) {
+      trainer1.reset_gradients_at_boundary();
+      trainer2.reset_gradients_at_boundary();
+      const Tensor g = dev.new_tensor_by_vector(
+          Shape({2}, rows.size()),
+          vector<float>(g_data.begin(), g_data.begin() + 2 * rows.size()));
+      dev.pick_bw(g, rows, 1, sparse.gradient(1, rows));
+      dev.pick_bw(g, rows, 1, dense.dense_gradient());
+      ASSERT_TRUE(sparse.has_sparse_gradient());
+      trainer1.update();
+      trainer2.update();
+      EXPECT_TRUE(sparse.has_sparse_gradient());
+      EXPECT_TRUE(vector_match(
+            dense.gradient().to_vector(), cs.gradient().to_vector()));
+      EXPECT_TRUE(vector_match(
+            dense.value().to_vector(), sparse.value().to_vector()));
+    }
+  }
+};
+
+// Trainer that records the order of updated parameters.
+class OrderRecorder : public Trainer {
+public:
+  vector<const Parameter *> order;
+
+private:
+  void configure_parameter(Parameter &) override {}
+  void update_parameter(float, Parameter &param) override {
+    order.emplace_back(&param);
+  }
 };
 
 TEST_F(TrainerTest, CheckAddParameter) {
@@ -37,6 +89,24 @@ TEST_F(TrainerTest, CheckAddParameter) {
   EXPECT_THROW(trainer.add_parameter(param3), Error);
 }
 
+TEST_F(TrainerTest, CheckParameterOrder) {
+  Device::set_default(dev);
+  vector<Parameter> params;
+  for (unsigned i = 0; i < 64; ++i) params.emplace_back(Shape({2}));
+  OrderRecorder trainer;
+  vector<const Parameter *> expected;
+  for (unsigned i = 0; i < params.size(); ++i) {
+    Parameter &param = params[(i * 37) % params.size()];
+    trainer.add_parameter(param);
+    expected.emplace_back(&param);
+  }
+  for (unsigned i = 0; i < 2; ++i) {
+    trainer.order.clear();
+    trainer.update();
+    EXPECT_EQ(expected, trainer.order);
+  }
+}
+
 TEST_F(TrainerTest, CheckEpoch) {
   trainers::SGD trainer;
   ASSERT_EQ(0u, trainer.get_epoch());
@@ -139,4 +209,273 @@ TEST_F(TrainerTest, CheckGradientClipping) {
   EXPECT_THROW(trainer.set_gradient_clipping(-1), Error);
 }
 
+TEST_F(TrainerTest, CheckGradientClippingWithSparseGradient) {
+  check_sparse_gradient(
+      {{2, 0}}, [](Trainer &trainer) { trainer.set_gradient_clipping(1); });
+}
+
+TEST_F(TrainerTest, CheckGradientClippingOverDevices) {
+  devices::Naive dev2;
+  Parameter param1({2}, {1, 2}, dev);
+  Parameter param2({2}, {3, 4}, dev2);
+  trainers::SGD trainer;
+  trainer.set_gradient_clipping(2);
+  trainer.add_parameter(param1);
+  trainer.add_parameter(param2);
+
+  // The global norm is 4.
+  param1.dense_gradient().reset_by_vector({2, 2});
+  param2.dense_gradient().reset_by_vector({-2, -2});
+  trainer.update();
+  EXPECT_TRUE(vector_match(
+        vector<float> {1, 1}, param1.gradient().to_vector()));
+  EXPECT_TRUE(vector_match(
+        vector<float> {-1, -1}, param2.gradient().to_vector()));
+  EXPECT_TRUE(vector_match(
+        vector<float> {.9, 1.9}, param1.value().to_vector()));
+  EXPECT_TRUE(vector_match(
+        vector<float> {3.1, 4.1}, param2.value().to_vector()));
+}
+
+TEST_F(TrainerTest, CheckFrozenParameter) {
+  Device::set_default(dev);
+  trainers::SGD trainer;
+  trainer.set_weight_decay(1);
+
+  Parameter param1({2}, {1, 2});
+  Parameter param2({2}, {3, 4});
+  trainer.add_parameter(param1);
+  trainer.add_parameter(param2);
+  param2.set_frozen(true);
+
+  param1.dense_gradient().reset_by_vector({1, 1});
+  param2.dense_gradient().reset_by_vector({1, 1});
+  trainer.update();
+  EXPECT_TRUE(vector_match(vector<float> {.8, 1.7}, param1.value().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {3, 4}, param2.value().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {1, 1}, param2.gradient().to_vector()));
+}
+
+TEST_F(TrainerTest, CheckFlatBuffer) {
+  Device::set_default(dev);
+  Parameter param1({2, 2}, {1, 2, 3, 4});
+  Parameter param2({3}, {5, 6, 7});
+  trainers::Adam trainer;
+  ASSERT_FALSE(trainer.get_flat_buffer());
+  trainer.set_flat_buffer(true);
+  EXPECT_TRUE(trainer.get_flat_buffer());
+  trainer.add_parameter(param1);
+  trainer.add_parameter(param2);
+  param1.dense_gradient().reset(1);
+  trainer.reset_gradients();
+
+  const Parameter &c1 = param1;
+  const Parameter &c2 = param2;
+  const float *base = static_cast<const float *>(c1.value().data());
+  EXPECT_EQ(base + 4, c2.value().data());
+  EXPECT_EQ(base + 7, c1.gradient().data());
+  EXPECT_EQ(base + 11, c2.gradient().data());
+  EXPECT_EQ(base + 14, c1.stats("adam-m1").data());
+  EXPECT_EQ(base + 18, c1.stats("adam-m2").data());
+  EXPECT_EQ(base + 22, c2.stats("adam-m1").data());
+  EXPECT_EQ(base + 25, c2.stats("adam-m2").data());
+  EXPECT_TRUE(vector_match(vector<float> {1, 2, 3, 4}, c1.value().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float> {5, 6, 7}, c2.value().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float>(4, 0), c1.gradient().to_vector()));
+  EXPECT_TRUE(vector_match(vector<float>(3, 0), c2.gradient().to_vector()));
+  EXPECT_TRUE(c1.has_sparse_gradient());
+
+  // Parameters remain available after disabling the flat buffer.
+  trainer.set_flat_buffer(false);
+  EXPECT_FALSE(trainer.get_flat_buffer());
+  param1.dense_gradient().reset(1);
+  trainer.reset_gradients();
+  EXPECT_TRUE(vector_match(vector<float>(4, 0), c1.gradient().to_vector()));
+}
+
+TEST_F(TrainerTest, CheckFlatBufferUpdate) {
+  Device::set_default(dev);
+  vector<vector<float>> results;
+  for (const bool flat : {false, true}) {
+    Parameter param1({2, 2}, {1, 2, 3, 4});
+    Parameter param2({3}, {5, 6, 7});
+    trainers::Adam trainer;
+    trainer.set_flat_buffer(flat);
+    trainer.set_weight_decay(.1);
+    trainer.set_gradient_clipping(1);
+    trainer.add_parameter(param1);
+    trainer.add_parameter(param2);
+    for (unsigned i = 0; i < 3; ++i) {
+      trainer.reset_gradients();
+      if (flat) {
+        const Parameter &c1 = param1;
+        const Parameter &c2 = param2;
+        EXPECT_EQ(
+            static_cast<const float *>(c1.value().data()) + 4,
+            c2.value().data());
+      }
+      param1.dense_gradient() +=
+        dev.new_tensor_by_vector({2, 2}, {1, -1, 2, -2});
+      param2.dense_gradient() += dev.new_tensor_by_vector({3}, {3, 0, -3});
+      // NOTE:
+      // The copy of the value makes the updated value detached from the flat
+      // buffer, and the buffer is rebuilt at the next reset.
+      const Tensor prev = param1.value();
+      trainer.update();
+      const Parameter &c1 = param1;
+      EXPECT_NE(prev.data(), c1.value().data());
+    }
+    vector<float> result;
+    for (const Parameter *param : {&param1, &param2}) {
+      for (const char *name : {"adam-m1", "adam-m2"}) {
+        const vector<float> v = param->stats(name).to_vector();
+        result.insert(result.end(), v.begin(), v.end());
+      }
+      const vector<float> v = param->value().to_vector();
+      result.insert(result.end(), v.begin(), v.end());
+    }
+    results.emplace_back(std::move(result));
+  }
+  EXPECT_TRUE(vector_match(results[0], results[1]));
+}
+
+TEST_F(TrainerTest, CheckFlatBufferWithSparseGradient) {
+  check_sparse_gradient({{2, 0}, {2, 0}}, [](Trainer &trainer) {
+    trainer.set_flat_buffer(true);
+    trainer.set_gradient_clipping(1);
+  });
+}
+
+TEST_F(TrainerTest, CheckGradientAccumulationSteps) {
+  Device::set_default(dev);
+  Parameter param({2}, {1, 2});
+  trainers::SGD trainer;
+  trainer.add_parameter(param);
+  EXPECT_EQ(1u, trainer.get_gradient_accumulation());
+  EXPECT_THROW(trainer.set_gradient_accumulation(0), Error);
+  EXPECT_EQ(1u, trainer.get_gradient_accumulation());
+  trainer.set_gradient_accumulation(3);
+  EXPECT_EQ(3u, trainer.get_gradient_accumulation());
+
+  for (unsigned i = 0; i < 7; ++i) {
+    EXPECT_EQ(i % 3, trainer.get_accumulated_steps());
+    trainer.reset_gradients_at_boundary();
+    param.dense_gradient() += dev.new_tensor_by_vector({2}, {1, 1});
+    // NOTE: Gradients are kept between updates.
+    EXPECT_TRUE(vector_match(
+          vector<float>(2, i % 3 + 1), param.gradient().to_vector()));
+    trainer.update();
+    EXPECT_EQ(i / 3 + (i % 3 == 2), trainer.get_epoch());
+  }
+
+  trainer.set_gradient_accumulation(2);
+  EXPECT_EQ(0u, trainer.get_accumulated_steps());
+  trainer.reset_gradients_at_boundary();
+  EXPECT_TRUE(vector_match(vector<float>(2, 0), param.gradient().to_vector()));
+
+  // reset_gradients() discards accumulated gradients.
+  param.dense_gradient() += dev.new_tensor_by_vector({2}, {1, 1});
+  trainer.update();
+  EXPECT_EQ(1u, trainer.get_accumulated_steps());
+  trainer.reset_gradients_at_boundary();
+  EXPECT_TRUE(vector_match(vector<float>(2, 1), param.gradient().to_vector()));
+  trainer.reset_gradients();
+  EXPECT_EQ(0u, trainer.get_accumulated_steps());
+  EXPECT_TRUE(vector_match(vector<float>(2, 0), param.gradient().to_vector()));
+}
+
+TEST_F(TrainerTest, CheckGradientAccumulation) {
+  Device::set_default(dev);
+  const vector<vector<float>> micro_grads {
+    {1, -1, 2, -2}, {3, 1, 0, -4}, {-2, 2, 1, 1}, {0, 4, -1, 3},
+  };
+  Parameter param1({2, 2}, {1, 2, 3, 4});
+  Parameter param2({2, 2}, {1, 2, 3, 4});
+  trainers::Adam trainer1, trainer2;
+  for (Trainer *trainer : {&trainer1, &trainer2}) {
+    trainer->set_weight_decay(.1);
+    trainer->set_gradient_clipping(1);
+  }
+  // NOTE: The flat buffer does not change results, which is checked by
+  // CheckFlatBufferUpdate, so only the accumulating trainer uses it to cover
+  // both features together.
+  trainer2.set_flat_buffer(true);
+  trainer2.set_gradient_accumulation(2);
+  trainer1.add_parameter(param1);
+  trainer2.add_parameter(param2);
+  for (unsigned i = 0; i < 4; i += 2) {
+    trainer1.reset_gradients();
+    for (unsigned j = i; j < i + 2; ++j) {
+      param1.dense_gradient() +=
+        .5 * dev.new_tensor_by_vector({2, 2}, micro_grads[j]);
+    }
+    trainer1.update();
+    for (unsigned j = i; j < i + 2; ++j) {
+      trainer2.reset_gradients_at_boundary();
+      param2.dense_gradient() +=
+        dev.new_tensor_by_vector({2, 2}, micro_grads[j]);
+      trainer2.update();
+    }
+    EXPECT_EQ(trainer1.get_epoch(), trainer2.get_epoch());
+    EXPECT_TRUE(vector_near(
+          param1.value().to_vector(), param2.value().to_vector(), 1e-6));
+    for (const char *name : {"adam-m1", "adam-m2"}) {
+      EXPECT_TRUE(vector_near(
+            param1.stats(name).to_vector(), param2.stats(name).to_vector(),
+            1e-6));
+    }
+  }
+}
+
+TEST_F(TrainerTest, CheckGradientAccumulationWithSparseGradient) {
+  check_sparse_gradient({{2}, {0}, {2}}, [](Trainer &trainer) {
+    trainer.set_gradient_accumulation(3);
+  });
+}
+
+TEST_F(TrainerTest, CheckGradientAccumulationWithCheckpointing) {
+  const vector<float> x_data {1, 2, -1, 0, 3, 1, 2, -2};
+  // Returns the mean of tanh(w . x) over examples in `[begin, begin + size)`.
+  const auto loss = [&](
+      Parameter &w, unsigned begin, unsigned size, Graph &g) {
+    const Node x = operators::input(
+        Shape({2}, size),
+        vector<float>(&x_data[2 * begin], &x_data[2 * (begin + size)]),
+        dev, g);
+    const Node h = operators::tanh(operators::parameter(w, g) * x);
+    return operators::batch::mean(operators::sum(h, 0));
+  };
+
+  Parameter w1({2}, {.5, -1}, dev);
+  Parameter w2({2}, {.5, -1}, dev);
+  trainers::SGD trainer1(.5), trainer2(.5);
+  trainer1.add_parameter(w1);
+  trainer2.add_parameter(w2);
+  trainer2.set_gradient_accumulation(4);
+  for (unsigned step = 0; step < 2; ++step) {
+    {
+      Graph g;
+      trainer1.reset_gradients();
+      const Node y = loss(w1, 0, 4, g);
+      g.forward(y);
+      g.backward(y);
+      trainer1.update();
+    }
+    // NOTE:
+    // Each micro-batch discards its graph after the backward pass.
+    Graph g;
+    g.set_checkpointing_mode(Graph::CHECKPOINTING_AUTO);
+    for (unsigned i = 0; i < 4; ++i) {
+      trainer2.reset_gradients_at_boundary();
+      const Node y = loss(w2, i, 1, g);
+      g.forward(y);
+      g.backward(y);
+      g.clear();
+      trainer2.update();
+    }
+    EXPECT_TRUE(vector_near(
+          w1.value().to_vector(), w2.value().to_vector(), 1e-6));
+  }
+}
+
 }  // namespace primitiv
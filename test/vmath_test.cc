@@ -0,0 +1,177 @@
+#include <config.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <primitiv/cpu_features.h>
+#include <primitiv/error.h>
+#include <primitiv/vmath.h>
+
+using std::vector;
+
+namespace primitiv {
+namespace vmath {
+
+class VMathTest : public testing::Test {
+protected:
+  using Function = void (*)(unsigned, const float *, float *, cpu_features::Isa);
+  using Reference = std::function<double(double)>;
+
+  struct TestCase {
+    const char *name;
+    Function fn;
+    Reference ref;
+    unsigned max_ulps;
+  };
+
+  vector<cpu_features::Isa> isas;
+  vector<TestCase> test_cases;
+
+  void SetUp() override {
+    for (cpu_features::Isa isa : {
+        cpu_features::ISA_GENERIC,
+        cpu_features::ISA_AVX2,
+        cpu_features::ISA_AVX512}) {
+      if (cpu_features::supports(isa)) isas.emplace_back(isa);
+    }
+    // The error bounds are the same as the documentation in vmath.h.
+    test_cases = {
+      {"exp", vmath::exp, [](double x) { return std::exp(x); }, 1},
+      {"log", vmath::log, [](double x) { return std::log(x); }, 1},
+      {"tanh", vmath::tanh, [](double x) { return std::tanh(x); }, 2},
+      {"sigmoid", vmath::sigmoid,
+        [](double x) { return 1. / (1. + std::exp(-x)); }, 2},
+      {"softplus", vmath::softplus,
+        [](double x) {
+          return x > 0
+            ? x + std::log1p(std::exp(-x))
+            : std::log1p(std::exp(x));
+        }, 3},
+    };
+  }
+
+  // Generates inputs over the whole range of float including special values.
+  static vector<float> make_inputs() {
+    vector<float> ret {
+      0.f, -0.f, FLT_MIN, -FLT_MIN, FLT_MAX, -FLT_MAX,
+      std::numeric_limits<float>::denorm_min(),
+      std::numeric_limits<float>::infinity(),
+      -std::numeric_limits<float>::infinity(),
+      std::numeric_limits<float>::quiet_NaN(),
+      88.72f, 88.73f, -87.34f, -103.9f, -104.f, .625f, -.625f,
+    };
+    // All bit patterns with a fixed stride.
+    for (std::uint64_t bits = 0; bits < (1ull << 32); bits += 4099) {
+      const std::uint32_t b = bits;
+      float x;
+      std::memcpy(&x, &b, sizeof(x));
+      ret.emplace_back(x);
+    }
+    // Dense samples around the origin.
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> dist(-30, 30);
+    for (unsigned i = 0; i < 100000; ++i) ret.emplace_back(dist(rng));
+    return ret;
+  }
+
+  // Distance between two floats in ULPs.
+  static std::int64_t ulp_distance(float a, float b) {
+    auto key = [](float x) {
+      std::int32_t i;
+      std::memcpy(&i, &x, sizeof(i));
+      return i < 0
+        ? -static_cast<std::int64_t>(i & 0x7fffffff)
+        : static_cast<std::int64_t>(i);
+    };
+    const std::int64_t d = key(a) - key(b);
+    return d >= 0 ? d : -d;
+  }
+};
+
+TEST_F(VMathTest, CheckAccuracy) {
+  const vector<float> xs = make_inputs();
+  vector<float> ys(xs.size());
+  for (const TestCase &tc : test_cases) {
+    for (cpu_features::Isa isa : isas) {
+      tc.fn(xs.size(), xs.data(), ys.data(), isa);
+      unsigned num_errors = 0;
+      for (unsigned i = 0; i < xs.size(); ++i) {
+        const float expected = tc.ref(xs[i]);
+        const float actual = ys[i];
+        bool ok;
+        if (std::isnan(expected)) {
+          ok = std::isnan(actual);
+        } else if (std::fabs(expected) < FLT_MIN) {
+          ok = std::fabs(actual - expected) <= FLT_MIN;
+        } else {
+          ok = ulp_distance(expected, actual) <= tc.max_ulps;
+        }
+        if (!ok && ++num_errors <= 10) {
+          ADD_FAILURE()
+            << tc.name << '(' << xs[i] << "): expected: " << expected
+            << ", actual: " << actual
+            << ", isa: " << cpu_features::isa_name(isa);
+        }
+      }
+      EXPECT_EQ(0u, num_errors)
+        << tc.name << ", isa: " << cpu_features::isa_name(isa);
+    }
+  }
+}
+
+TEST_F(VMathTest, CheckPartialVectors) {
+  // Every position of every size should give the same result.
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> dist(-10, 10);
+  vector<float> xs(100);
+  for (float &x : xs) x = std::fabs(dist(rng));
+  for (const TestCase &tc : test_cases) {
+    for (cpu_features::Isa isa : isas) {
+      vector<float> expected(xs.size());
+      tc.fn(xs.size(), xs.data(), expected.data(), isa);
+      for (unsigned offset = 0; offset < 20; ++offset) {
+        for (unsigned size = 0; offset + size <= 80; size += 7) {
+          vector<float> ys(xs.size(), -1);
+          tc.fn(size, xs.data() + offset, ys.data() + offset, isa);
+          for (unsigned i = 0; i < ys.size(); ++i) {
+            const bool inside = offset <= i && i < offset + size;
+            EXPECT_EQ(inside ? expected[i] : -1, ys[i])
+              << tc.name << ", isa: " << cpu_features::isa_name(isa)
+              << ", offset: " << offset << ", size: " << size << ", i: " << i;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(VMathTest, CheckInplace) {
+  const vector<float> xs {0, .25, .5, 1, 2, 3, 4, 5, 6, 7, 8};
+  for (const TestCase &tc : test_cases) {
+    for (cpu_features::Isa isa : isas) {
+      vector<float> expected(xs.size());
+      tc.fn(xs.size(), xs.data(), expected.data(), isa);
+      vector<float> ys = xs;
+      tc.fn(ys.size(), ys.data(), ys.data(), isa);
+      EXPECT_EQ(expected, ys)
+        << tc.name << ", isa: " << cpu_features::isa_name(isa);
+    }
+  }
+}
+
+TEST_F(VMathTest, CheckInvalidIsa) {
+  if (cpu_features::max_isa() == cpu_features::ISA_AVX512) return;
+  float x = 1, y;
+  for (const TestCase &tc : test_cases) {
+    EXPECT_THROW(tc.fn(1, &x, &y, cpu_features::ISA_AVX512), Error);
+  }
+}
+
+}  // namespace vmath
+}  // namespace primitiv